@@ -45,10 +45,13 @@ class Multiplexer {
     return id_to_return;
   }
 
+  // Queues return false from Push() when the item did not add to their size,
+  // e.g. because it was dropped or replaced an older one.
   void Push(const int idx, T&& t) {
     CheckIdx(idx);
-    queues_[idx]->Push(std::move(t));
-    sem_items_.SemPost();
+    if (queues_[idx]->Push(std::move(t))) {
+      sem_items_.SemPost();
+    }
   }
 
   T Pop(QueueSelector selector) {
@@ -18,8 +18,9 @@
 
 #include <sys/epoll.h>
 
+#include <chrono>
+#include <map>
 #include <optional>
-#include <set>
 #include <shared_mutex>
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
@@ -44,6 +45,9 @@ class Epoll {
   Result<void> AddOrModify(SharedFD fd, uint32_t events);
   Result<void> Delete(SharedFD fd);
   Result<std::optional<EpollEvent>> Wait();
+  // Returns an empty optional if nothing happened before `timeout`. A negative
+  // timeout waits indefinitely.
+  Result<std::optional<EpollEvent>> Wait(std::chrono::milliseconds timeout);
 
  private:
   Epoll(SharedFD);
@@ -51,10 +55,11 @@ class Epoll {
   SharedFD epoll_fd_;
   /**
    * This read-write mutex is read-locked when interacting with it as a const
-   * std::set, and write-locked when interacting with it as a std::set.
+   * std::map, and write-locked when interacting with it as a std::map.
    */
   std::shared_mutex watched_mutex_;
-  std::set<SharedFD> watched_;
+  // Keyed by the file descriptor number, which is what epoll reports back.
+  std::map<int, SharedFD> watched_;
 };
 
 }  // namespace cuttlefish
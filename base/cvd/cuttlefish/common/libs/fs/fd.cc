@@ -31,6 +31,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
 #include <algorithm>
 #include <sstream>
 #include <string>
@@ -125,6 +129,7 @@ Fd::Fd() : Fd(-1, 0) {}
 Fd::Fd(Fd&& other) : Fd() {
   std::swap(fd_, other.fd_);
   std::swap(errno_, other.errno_);
+  std::swap(is_regular_file_, other.is_regular_file_);
 }
 
 Fd::~Fd() { Close(); }
@@ -133,6 +138,7 @@ Fd& Fd::operator=(Fd&& other) {
   Close();
   std::swap(fd_, other.fd_);
   std::swap(errno_, other.errno_);
+  std::swap(is_regular_file_, other.is_regular_file_);
   return *this;
 }
 
@@ -178,6 +184,18 @@ Result<Fd> Fd::ShmOpen(std::string_view name, int oflag, int mode) {
              ::cuttlefish::StrError(errno));
   return Fd(fd, 0);
 }
+
+Result<Fd> Fd::PidfdOpen(pid_t pid) {
+  // There is no glibc wrapper for pidfd_open before glibc 2.36.
+#ifndef SYS_pidfd_open
+  constexpr int SYS_pidfd_open = 434;
+#endif
+  // pidfds are always close-on-exec.
+  const int fd = syscall(SYS_pidfd_open, pid, /* flags */ 0);
+  CF_EXPECTF(fd >= 0, "pidfd_open({}) failed: {}", pid,
+             ::cuttlefish::StrError(errno));
+  return Fd(fd, 0);
+}
 #endif
 
 Result<Fd> Fd::MemfdCreate(std::string_view name, unsigned int flags) {
@@ -532,6 +550,70 @@ bool Fd::SendFile(Fd& in, off_t* offset, size_t count) {
   return true;
 }
 
+#ifdef __linux__
+ssize_t Fd::CopyFileRange(Fd& in, off_t* in_offset, off_t* out_offset,
+                          size_t length) {
+  LocalErrno record_errno(errno_);
+
+  return TEMP_FAILURE_RETRY(
+      copy_file_range(in.fd_, in_offset, fd_, out_offset, length, 0));
+}
+
+int Fd::CloneRange(Fd& in, uint64_t in_offset, uint64_t length,
+                   uint64_t out_offset) {
+  LocalErrno record_errno(errno_);
+
+  struct file_clone_range range = {
+      .src_fd = in.fd_,
+      .src_offset = in_offset,
+      .src_length = length,
+      .dest_offset = out_offset,
+  };
+  return TEMP_FAILURE_RETRY(ioctl(fd_, FICLONERANGE, &range));
+}
+
+int64_t Fd::DedupeRange(Fd& in, uint64_t in_offset, uint64_t length,
+                        uint64_t out_offset) {
+  LocalErrno record_errno(errno_);
+
+  // file_dedupe_range ends with a flexible array of destinations.
+  alignas(struct file_dedupe_range) char
+      request[sizeof(struct file_dedupe_range) +
+              sizeof(struct file_dedupe_range_info)] = {};
+  auto* range = reinterpret_cast<struct file_dedupe_range*>(request);
+  range->src_offset = in_offset;
+  range->src_length = length;
+  range->dest_count = 1;
+  range->info[0].dest_fd = fd_;
+  range->info[0].dest_offset = out_offset;
+  // Unlike FICLONERANGE, the request goes to the source file.
+  if (TEMP_FAILURE_RETRY(ioctl(in.fd_, FIDEDUPERANGE, range)) < 0) {
+    return -1;
+  }
+  if (range->info[0].status < 0) {
+    errno = -range->info[0].status;
+    return -1;
+  }
+  return range->info[0].status == FILE_DEDUPE_RANGE_SAME
+             ? static_cast<int64_t>(range->info[0].bytes_deduped)
+             : 0;
+}
+
+ssize_t Fd::Splice(Fd& in, off_t* in_offset, off_t* out_offset, size_t length,
+                   unsigned int flags) {
+  LocalErrno record_errno(errno_);
+
+  return TEMP_FAILURE_RETRY(
+      splice(in.fd_, in_offset, fd_, out_offset, length, flags));
+}
+
+int Fd::Fallocate(int mode, off_t offset, off_t length) {
+  LocalErrno record_errno(errno_);
+
+  return TEMP_FAILURE_RETRY(fallocate(fd_, mode, offset, length));
+}
+#endif
+
 void Fd::Close() {
   std::stringstream message;
   if (fd_ == -1) {
@@ -133,6 +133,8 @@ class Fd : public ReaderWriterSeeker {
   static Result<Fd> Event(int initval = 0, int flags = 0);
   static Result<Fd> InotifyFd();
   static Result<Fd> ShmOpen(std::string_view name, int oflag, int mode);
+  // Becomes readable when the child process `pid` exits.
+  static Result<Fd> PidfdOpen(pid_t pid);
   // For binding in vsock, svm_cid from `cid` param would be either
   // VMADDR_CID_ANY, VMADDR_CID_LOCAL, VMADDR_CID_HOST or their own CID, and it
   // is used for indicating connections which it accepts from.
@@ -174,6 +176,27 @@ class Fd : public ReaderWriterSeeker {
   // Same as CopyFrom, but reads from input until EOF is reached.
   bool CopyAllFrom(Fd& in, Fd* stop = nullptr);
   bool SendFile(Fd& in, off_t* offset, size_t count);
+#ifdef __linux__
+  // Has the semantics of copy_file_range(2), with this file as the output.
+  ssize_t CopyFileRange(Fd& in, off_t* in_offset, off_t* out_offset,
+                        size_t length);
+  // Shares the extents of `length` bytes of `in` starting at `in_offset` with
+  // this file at `out_offset`, with the semantics of ioctl_ficlonerange(2). A
+  // `length` of zero clones everything up to the end of `in`.
+  int CloneRange(Fd& in, uint64_t in_offset, uint64_t length,
+                 uint64_t out_offset);
+  // Shares the extents of `length` bytes of `in` starting at `in_offset` with
+  // this file at `out_offset` if both ranges hold the same data, with the
+  // semantics of ioctl_fideduperange(2). Returns the number of bytes that
+  // were deduplicated, or -1.
+  int64_t DedupeRange(Fd& in, uint64_t in_offset, uint64_t length,
+                      uint64_t out_offset);
+  // Has the semantics of splice(2), with this file as the output.
+  ssize_t Splice(Fd& in, off_t* in_offset, off_t* out_offset, size_t length,
+                 unsigned int flags);
+  // Has the semantics of fallocate(2).
+  int Fallocate(int mode, off_t offset, off_t length);
+#endif
 
   int UNMANAGED_Dup();
   int UNMANAGED_Dup2(int newfd);
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/common/libs/utils/task_graph.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+TaskGraph::Id TaskGraph::Add(std::string name,
+                             std::function<Result<void>()> step,
+                             std::vector<Id> dependencies) {
+  const Id id = steps_.size();
+  for (const Id dependency : dependencies) {
+    CHECK_LT(dependency, id) << "Unknown dependency of '" << name << "'";
+    steps_[dependency].dependents.emplace_back(id);
+  }
+  steps_.emplace_back(Step{
+      .name = std::move(name),
+      .run = std::move(step),
+      .dependency_count = dependencies.size(),
+      .dependents = {},
+  });
+  return id;
+}
+
+Result<void> TaskGraph::Run(const size_t max_threads) {
+  CF_EXPECT_GT(max_threads, 0);
+
+  std::mutex mutex;
+  std::condition_variable state_changed;
+  std::vector<size_t> waiting_on;
+  std::deque<Id> ready;
+  for (Id id = 0; id < steps_.size(); id++) {
+    waiting_on.emplace_back(steps_[id].dependency_count);
+    if (steps_[id].dependency_count == 0) {
+      ready.emplace_back(id);
+    }
+  }
+  size_t running = 0;
+  Result<void> failure;
+  std::string failed_step;
+
+  auto worker = [&]() {
+    std::unique_lock lock(mutex);
+    while (true) {
+      state_changed.wait(lock, [&]() {
+        return !failure.has_value() || !ready.empty() || running == 0;
+      });
+      // With nothing ready and nothing running, every step that can run has.
+      if (!failure.has_value() || ready.empty()) {
+        return;
+      }
+      const Id id = ready.front();
+      ready.pop_front();
+      running++;
+      lock.unlock();
+
+      const Step& step = steps_[id];
+      const auto start = std::chrono::steady_clock::now();
+      Result<void> result = step.run();
+      const auto duration =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start);
+      VLOG(0) << "Step '" << step.name << "' took " << duration.count()
+              << " ms";
+
+      lock.lock();
+      running--;
+      if (!result.has_value()) {
+        if (failure.has_value()) {
+          failure = std::move(result);
+          failed_step = step.name;
+        }
+      } else {
+        for (const Id dependent : step.dependents) {
+          if (--waiting_on[dependent] == 0) {
+            ready.emplace_back(dependent);
+          }
+        }
+      }
+      state_changed.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < std::min(max_threads, steps_.size()); i++) {
+    threads.emplace_back(worker);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  CF_EXPECTF(std::move(failure), "Step '{}' failed", failed_step);
+  return {};
+}
+
+Result<void> TaskGraph::Run() {
+  CF_EXPECT(Run(std::max(std::thread::hardware_concurrency(), 1u)));
+  return {};
+}
+
+}  // namespace cuttlefish
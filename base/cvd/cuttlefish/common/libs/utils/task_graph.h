@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <stddef.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+/**
+ * A set of steps with dependencies between them, run on a bounded number of
+ * threads.
+ *
+ * A step starts once every step it depends on has finished successfully.
+ * Steps without a path between them in the graph may run at the same time.
+ */
+class TaskGraph {
+ public:
+  using Id = size_t;
+
+  /**
+   * Adds a step that runs after all of `dependencies`, which must be values
+   * returned by earlier calls on the same graph.
+   */
+  Id Add(std::string name, std::function<Result<void>()> step,
+         std::vector<Id> dependencies = {});
+
+  /**
+   * Runs every step on at most `max_threads` threads, logging the wall-clock
+   * time each one took.
+   *
+   * After a step fails no more steps are started, and its error is returned
+   * once the steps that were already running have finished.
+   */
+  Result<void> Run(size_t max_threads);
+  /** Runs every step with one thread per CPU. */
+  Result<void> Run();
+
+ private:
+  struct Step {
+    std::string name;
+    std::function<Result<void>()> run;
+    size_t dependency_count;
+    std::vector<Id> dependents;
+  };
+
+  std::vector<Step> steps_;
+};
+
+}  // namespace cuttlefish
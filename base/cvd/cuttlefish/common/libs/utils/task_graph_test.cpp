@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/common/libs/utils/task_graph.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+TEST(TaskGraph, EmptyGraph) { EXPECT_THAT(TaskGraph().Run(4), IsOk()); }
+
+TEST(TaskGraph, RunsDependenciesFirst) {
+  std::mutex mutex;
+  std::vector<std::string> order;
+  auto record = [&](std::string name) {
+    return [&mutex, &order, name]() -> Result<void> {
+      std::lock_guard lock(mutex);
+      order.emplace_back(name);
+      return {};
+    };
+  };
+
+  TaskGraph graph;
+  const TaskGraph::Id a = graph.Add("a", record("a"));
+  const TaskGraph::Id b = graph.Add("b", record("b"), {a});
+  graph.Add("c", record("c"), {a, b});
+
+  ASSERT_THAT(graph.Run(4), IsOk());
+  EXPECT_THAT(order, testing::ElementsAre("a", "b", "c"));
+}
+
+TEST(TaskGraph, RunsIndependentStepsConcurrently) {
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t arrived = 0;
+  // Each step waits until both have started.
+  auto rendezvous = [&]() -> Result<void> {
+    std::unique_lock lock(mutex);
+    arrived++;
+    cv.notify_all();
+    CF_EXPECT(cv.wait_for(lock, std::chrono::seconds(10),
+                          [&]() { return arrived == 2; }),
+              "Steps did not run concurrently");
+    return {};
+  };
+
+  TaskGraph graph;
+  graph.Add("first", rendezvous);
+  graph.Add("second", rendezvous);
+
+  EXPECT_THAT(graph.Run(2), IsOk());
+}
+
+TEST(TaskGraph, LimitsThreads) {
+  std::atomic<size_t> running = 0;
+  std::atomic<size_t> max_running = 0;
+  auto step = [&]() -> Result<void> {
+    const size_t now = ++running;
+    size_t max = max_running;
+    while (now > max && !max_running.compare_exchange_weak(max, now)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    running--;
+    return {};
+  };
+
+  TaskGraph graph;
+  for (int i = 0; i < 16; i++) {
+    graph.Add("step", step);
+  }
+
+  ASSERT_THAT(graph.Run(3), IsOk());
+  EXPECT_LE(max_running, 3);
+  EXPECT_GE(max_running, 1);
+}
+
+TEST(TaskGraph, StopsAfterFailure) {
+  bool ran_dependent = false;
+
+  TaskGraph graph;
+  const TaskGraph::Id failing =
+      graph.Add("failing", []() -> Result<void> { return CF_ERR("failed"); });
+  graph.Add(
+      "dependent",
+      [&]() -> Result<void> {
+        ran_dependent = true;
+        return {};
+      },
+      {failing});
+
+  EXPECT_THAT(graph.Run(1), IsError());
+  EXPECT_FALSE(ran_dependent);
+}
+
+TEST(TaskGraph, RejectsZeroThreads) {
+  TaskGraph graph;
+  graph.Add("step", []() -> Result<void> { return {}; });
+
+  EXPECT_THAT(graph.Run(0), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -87,6 +87,7 @@
 #include "cuttlefish/host/commands/assemble_cvd/required_directories.h"
 #include "cuttlefish/host/commands/assemble_cvd/resolve_instance_files.h"
 #include "cuttlefish/host/commands/assemble_cvd/touchpad.h"
+#include "cuttlefish/host/libs/command_util/snapshot_manifest.h"
 #include "cuttlefish/host/libs/command_util/snapshot_utils.h"
 #include "cuttlefish/host/libs/config/adb/adb.h"
 #include "cuttlefish/host/libs/config/ap_boot_flow.h"
@@ -201,7 +202,19 @@ Result<void> RestoreHostFiles(const std::string& cuttlefish_root_dir,
     }
     return !Contains(guest_snapshot_dirs, src_dir);
   };
-  // cp -r snapshot_dir_path HOME
+  if (HasSnapshotManifest(snapshot_dir_path)) {
+    // Only copies the files that changed since the snapshot was taken or
+    // last restored.
+    SnapshotCopyStats stats = CF_EXPECT(
+        RestoreFromSnapshot(snapshot_dir_path, cuttlefish_root_dir,
+                            {.predicate = std::move(filter_guest_dir)}));
+    LOG(INFO) << fmt::format(
+        "Restored {} of {} host files: {} bytes reflinked, {} bytes copied",
+        stats.files - stats.files_unchanged, stats.files, stats.bytes_cloned,
+        stats.bytes_copied);
+    return {};
+  }
+  // cp -r snapshot_dir_path HOME, for snapshots without a manifest
   CF_EXPECT(CopyDirectoryRecursively(snapshot_dir_path, cuttlefish_root_dir,
                                      /* delete destination first */ false,
                                      filter_guest_dir));
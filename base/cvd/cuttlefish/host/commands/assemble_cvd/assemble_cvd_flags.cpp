@@ -327,6 +327,9 @@ DEFINE_vec(
 DEFINE_string(secure_hals, CF_DEFAULTS_SECURE_HALS,
               "Which HALs to use enable host security features for. Supports "
               "keymint and gatekeeper at the moment.");
+DEFINE_bool(keymint_key_pool, CF_DEFAULTS_KEYMINT_KEY_POOL,
+            "Generate host KeyMint private keys in the background, ahead of "
+            "the requests for them. Only applies to the tpm KeyMint.");
 
 DEFINE_vec(use_sdcard, CF_DEFAULTS_USE_SDCARD ? "true" : "false",
            "Create blank SD-Card image and expose to guest");
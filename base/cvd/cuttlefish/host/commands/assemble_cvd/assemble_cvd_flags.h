@@ -153,6 +153,7 @@ DECLARE_vec(vsock_guest_cid);
 DECLARE_vec(vsock_guest_group);
 
 DECLARE_string(secure_hals);
+DECLARE_bool(keymint_key_pool);
 
 DECLARE_vec(use_sdcard);
 
@@ -30,8 +30,10 @@
 
 #include "absl/log/log.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 
 #include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/common/libs/utils/task_graph.h"
 #include "cuttlefish/files/file_exists.h"
 #include "cuttlefish/host/commands/assemble_cvd/android_build/android_builds.h"
 #include "cuttlefish/host/commands/assemble_cvd/boot_config.h"
@@ -99,6 +101,67 @@ Result<BuildArchive> FindImgZip(const FetcherConfig& fetcher_config,
   return CF_ERR("No img zip found");
 }
 
+// Check if filling in the sparse image would run out of disk space.
+Result<void> CheckDataImageSpace(
+    const CuttlefishConfig::InstanceSpecific& instance) {
+  std::string data_image = instance.data_image();
+  auto existing_sizes = SparseFileSizes(data_image);
+  if (existing_sizes.sparse_size == 0 && existing_sizes.disk_size == 0) {
+    data_image = instance.new_data_image();
+    existing_sizes = SparseFileSizes(data_image);
+    CF_EXPECT(existing_sizes.sparse_size > 0 || existing_sizes.disk_size > 0,
+              "Unable to determine size of \""
+                  << data_image << "\". Does this file exist?");
+  }
+  if (existing_sizes.sparse_size > 0 || existing_sizes.disk_size > 0) {
+    auto available_space = AvailableSpaceAtPath(data_image);
+    if (available_space <
+        existing_sizes.sparse_size - existing_sizes.disk_size) {
+      // TODO(schuffelen): Duplicate this check in run_cvd when it can run on
+      // a separate machine
+      return CF_ERR("Not enough space remaining in fs containing \""
+                    << data_image << "\", wanted "
+                    << (existing_sizes.sparse_size - existing_sizes.disk_size)
+                    << ", got " << available_space);
+    } else {
+      VLOG(0) << "Available space: " << available_space;
+      VLOG(0) << "Sparse size of \"" << data_image
+              << "\": " << existing_sizes.sparse_size;
+      VLOG(0) << "Disk size of \"" << data_image
+              << "\": " << existing_sizes.disk_size;
+    }
+  }
+  return {};
+}
+
+Result<void> ResetBlankImages(
+    const CuttlefishConfig::InstanceSpecific& instance) {
+  const std::string access_kregistry = AccessKregistryPath(instance);
+  if (FileExists(access_kregistry)) {
+    CF_EXPECTF(CreateBlankEmptyImage(access_kregistry, 2 /* mb */),
+               "Failed for '{}'", access_kregistry);
+  }
+  const std::string hwcomposer_pmem = HwcomposerPmemPath(instance);
+  if (FileExists(hwcomposer_pmem)) {
+    CF_EXPECTF(CreateBlankEmptyImage(hwcomposer_pmem, 2 /* mb */),
+               "Failed for '{}'", hwcomposer_pmem);
+  }
+  if (FileExists(PstorePath(instance))) {
+    CF_EXPECT(CreateBlankEmptyImage(PstorePath(instance), 2 /* mb */),
+              "Failed for\"" << PstorePath(instance) << "\"");
+  }
+  return {};
+}
+
+/** Values passed between the disk assembly steps of one instance. */
+struct InstanceDisks {
+  std::optional<ChromeOsStateImage> chrome_os_state;
+  DiskBuilder os_disk_builder;
+  bool os_built_composite = false;
+  std::optional<BootConfigPartition> boot_config;
+  DiskBuilder ap_disk_builder;
+};
+
 }  // namespace
 
 Result<void> CreateDynamicDiskFiles(
@@ -107,8 +170,31 @@ Result<void> CreateDynamicDiskFiles(
     const SystemImageDirFlag& system_image_dirs) {
   std::vector<std::vector<std::unique_ptr<ImageFile>>> image_files =
       InstanceImageFiles(config, boot_image);
-  size_t instance_index = 0;
-  for (const auto& instance : config.Instances()) {
+  const std::vector<CuttlefishConfig::InstanceSpecific> instances =
+      config.Instances();
+  CF_EXPECT_LE(instances.size(), image_files.size());
+  std::vector<InstanceDisks> instance_disks(instances.size());
+
+  // Independent images are built at the same time, within and across
+  // instances. Instances share the assembly directory, which the kernel and
+  // ramdisk repacking use as scratch space, and possibly an `AndroidBuild`, so
+  // the steps using those are serialized.
+  TaskGraph graph;
+  std::optional<TaskGraph::Id> last_assembly_dir_step;
+  std::optional<TaskGraph::Id> last_os_composite_disk_step;
+  auto after = [](std::vector<TaskGraph::Id> dependencies,
+                  std::optional<TaskGraph::Id> serialized_with) {
+    if (serialized_with.has_value()) {
+      dependencies.emplace_back(*serialized_with);
+    }
+    return dependencies;
+  };
+
+  for (size_t instance_index = 0; instance_index < instances.size();
+       instance_index++) {
+    const CuttlefishConfig::InstanceSpecific& instance =
+        instances[instance_index];
+    InstanceDisks& disks = instance_disks[instance_index];
     const FetcherConfig& fetcher_config =
         fetcher_configs.ForInstance(instance_index);
     std::string system_image_dir = system_image_dirs.ForIndex(instance_index);
@@ -122,143 +208,195 @@ Result<void> CreateDynamicDiskFiles(
       VLOG(0) << img_zip.error();
     }
 
-    std::optional<ChromeOsStateImage> chrome_os_state =
-        CF_EXPECT(ChromeOsStateImage::CreateIfNecessary(instance));
-
-    CF_EXPECT(RebuildSuperImageIfNecessary(fetcher_config, instance));
-    CF_EXPECT(RepackKernelRamdisk(config, instance));
-    CF_EXPECT(VbmetaEnforceMinimumSize(instance));
-    CF_EXPECT(BootloaderPresentCheck(instance));
-    CF_EXPECT(
-        Gem5ImageUnpacker(config, boot_image));  // Requires RepackKernelRamdisk
-    CF_EXPECT(InitializeEspImage(config, instance));
-
-    CF_EXPECT(InitializeAccessKregistryImage(instance));
-    CF_EXPECT(InitializeHwcomposerPmemImage(instance));
-    CF_EXPECT(InitializePstore(instance));
-    CF_EXPECT(InitializeSdCard(config, instance));
-    CF_EXPECT(InitializeDataImage(instance));
-    CF_EXPECT(InitializePflash(instance));
-
-    // Check if filling in the sparse image would run out of disk space.
-    std::string data_image = instance.data_image();
-    auto existing_sizes = SparseFileSizes(data_image);
-    if (existing_sizes.sparse_size == 0 && existing_sizes.disk_size == 0) {
-      data_image = instance.new_data_image();
-      existing_sizes = SparseFileSizes(data_image);
-      CF_EXPECT(existing_sizes.sparse_size > 0 || existing_sizes.disk_size > 0,
-                "Unable to determine size of \""
-                    << data_image << "\". Does this file exist?");
-    }
-    if (existing_sizes.sparse_size > 0 || existing_sizes.disk_size > 0) {
-      auto available_space = AvailableSpaceAtPath(data_image);
-      if (available_space <
-          existing_sizes.sparse_size - existing_sizes.disk_size) {
-        // TODO(schuffelen): Duplicate this check in run_cvd when it can run on
-        // a separate machine
-        return CF_ERR("Not enough space remaining in fs containing \""
-                      << data_image << "\", wanted "
-                      << (existing_sizes.sparse_size - existing_sizes.disk_size)
-                      << ", got " << available_space);
-      } else {
-        VLOG(0) << "Available space: " << available_space;
-        VLOG(0) << "Sparse size of \"" << data_image
-                << "\": " << existing_sizes.sparse_size;
-        VLOG(0) << "Disk size of \"" << data_image
-                << "\": " << existing_sizes.disk_size;
-      }
-    }
+    auto name = [&instance](std::string_view step) {
+      return absl::StrCat(step, " (instance ", instance.id(), ")");
+    };
+
+    // Everything the composite disks are assembled from.
+    std::vector<TaskGraph::Id> inputs;
+
+    inputs.emplace_back(graph.Add(
+        name("ChromeOsStateImage"), [&disks, &instance]() -> Result<void> {
+          disks.chrome_os_state =
+              CF_EXPECT(ChromeOsStateImage::CreateIfNecessary(instance));
+          return {};
+        }));
+    const TaskGraph::Id super_image =
+        graph.Add(name("RebuildSuperImageIfNecessary"),
+                  [&fetcher_config, &instance]() {
+                    return RebuildSuperImageIfNecessary(fetcher_config,
+                                                        instance);
+                  });
+    inputs.emplace_back(super_image);
+    const TaskGraph::Id kernel_ramdisk = graph.Add(
+        name("RepackKernelRamdisk"),
+        [&config, &instance]() {
+          return RepackKernelRamdisk(config, instance);
+        },
+        after({super_image}, last_assembly_dir_step));
+    inputs.emplace_back(kernel_ramdisk);
+    inputs.emplace_back(graph.Add(
+        name("VbmetaEnforceMinimumSize"),
+        [&instance]() { return VbmetaEnforceMinimumSize(instance); },
+        {kernel_ramdisk}));
+    inputs.emplace_back(graph.Add(
+        name("BootloaderPresentCheck"),
+        [&instance]() { return BootloaderPresentCheck(instance); }));
+    last_assembly_dir_step = graph.Add(
+        name("Gem5ImageUnpacker"),
+        [&config, &boot_image]() {
+          return Gem5ImageUnpacker(config, boot_image);
+        },
+        {kernel_ramdisk});  // Requires RepackKernelRamdisk
+    inputs.emplace_back(*last_assembly_dir_step);
+    inputs.emplace_back(graph.Add(
+        name("InitializeEspImage"),
+        [&config, &instance]() { return InitializeEspImage(config, instance); },
+        {kernel_ramdisk}));
+
+    inputs.emplace_back(graph.Add(
+        name("InitializeAccessKregistryImage"),
+        [&instance]() { return InitializeAccessKregistryImage(instance); }));
+    inputs.emplace_back(graph.Add(
+        name("InitializeHwcomposerPmemImage"),
+        [&instance]() { return InitializeHwcomposerPmemImage(instance); }));
+    inputs.emplace_back(
+        graph.Add(name("InitializePstore"),
+                  [&instance]() { return InitializePstore(instance); }));
+    inputs.emplace_back(graph.Add(
+        name("InitializeSdCard"),
+        [&config, &instance]() { return InitializeSdCard(config, instance); }));
+    const TaskGraph::Id data_image =
+        graph.Add(name("InitializeDataImage"),
+                  [&instance]() { return InitializeDataImage(instance); });
+    inputs.emplace_back(graph.Add(
+        name("CheckDataImageSpace"),
+        [&instance]() { return CheckDataImageSpace(instance); },
+        {data_image}));
+    inputs.emplace_back(
+        graph.Add(name("InitializePflash"),
+                  [&instance]() { return InitializePflash(instance); }));
 
-    CF_EXPECT_LE(instance_index, image_files.size());
     const std::vector<std::unique_ptr<ImageFile>>& instance_image_files =
         image_files[instance_index];
-
-    for (auto& image_file : instance_image_files) {
-      CF_EXPECT(image_file->Generate());
+    for (const auto& image_file : instance_image_files) {
+      inputs.emplace_back(graph.Add(
+          name(image_file->Name()),
+          [&image_file]() -> Result<void> {
+            CF_EXPECT(image_file->Generate());
+            return {};
+          },
+          {kernel_ramdisk}));
     }
 
-    DiskBuilder os_disk_builder = CF_EXPECT(OsCompositeDiskBuilder(
-        config, instance, chrome_os_state, instance_image_files,
-        android_builds.ForIndex(instance_index), system_image_dirs));
-    const auto os_built_composite =
-        CF_EXPECT(os_disk_builder.BuildCompositeDiskIfNecessary());
-
-    BootloaderEnvPartition bootloader_env_partition =
-        CF_EXPECT(BootloaderEnvPartition::Create(config, instance));
-
-    std::optional<ApBootloaderEnvPartition> ap_bootloader_env_partition =
-        CF_EXPECT(ApBootloaderEnvPartition::Create(config, instance));
-
-    FactoryResetProtectedImage factory_reset_protected =
-        CF_EXPECT(FactoryResetProtectedImage::Create(instance));
-
-    std::optional<BootConfigPartition> boot_config =
-        CF_EXPECT(BootConfigPartition::CreateIfNeeded(config, instance));
-
-    PersistentVbmeta persistent_vbmeta = CF_EXPECT(PersistentVbmeta::Create(
-        boot_config, bootloader_env_partition, instance));
-
-    std::optional<ApPersistentVbmeta> ap_persistent_vbmeta =
-        ap_bootloader_env_partition.has_value()
-            ? CF_EXPECT(ApPersistentVbmeta::Create(*ap_bootloader_env_partition,
-                                                   boot_config, instance))
-            : std::nullopt;
-
-    FactoryResetProtectedImage factory_reset_protected_image =
-        CF_EXPECT(FactoryResetProtectedImage::Create(instance));
-
-    // TODO: schuffelen - do something with these types
-    CF_EXPECT(InstanceCompositeDisk::Create(
-        boot_config, config, instance, bootloader_env_partition,
-        factory_reset_protected, persistent_vbmeta));
-    CF_EXPECT(ApCompositeDisk::Create(ap_persistent_vbmeta, config, instance));
-
-    auto ap_disk_builder = ApCompositeDiskBuilder(config, instance);
-    if (instance.ap_boot_flow() != APBootFlow::None) {
-      CF_EXPECT(ap_disk_builder.BuildCompositeDiskIfNecessary());
-    }
-
-    if (os_built_composite) {
-      const std::string access_kregistry = AccessKregistryPath(instance);
-      if (FileExists(access_kregistry)) {
-        CF_EXPECTF(CreateBlankEmptyImage(access_kregistry, 2 /* mb */),
-                   "Failed for '{}'", access_kregistry);
-      }
-      const std::string hwcomposer_pmem = HwcomposerPmemPath(instance);
-      if (FileExists(hwcomposer_pmem)) {
-        CF_EXPECTF(CreateBlankEmptyImage(hwcomposer_pmem, 2 /* mb */),
-                   "Failed for '{}'", hwcomposer_pmem);
-      }
-      if (FileExists(PstorePath(instance))) {
-        CF_EXPECT(CreateBlankEmptyImage(PstorePath(instance), 2 /* mb */),
-                  "Failed for\"" << PstorePath(instance) << "\"");
-      }
-    }
-
-    os_disk_builder.OverlayPath(instance.PerInstancePath("overlay.img"));
-    CF_EXPECT(os_disk_builder.BuildOverlayIfNecessary());
-    if (instance.ap_boot_flow() != APBootFlow::None) {
-      ap_disk_builder.OverlayPath(instance.PerInstancePath("ap_overlay.img"));
-      CF_EXPECT(ap_disk_builder.BuildOverlayIfNecessary());
-    }
-
-    // Check that the files exist
-    for (const auto& file : instance.virtual_disk_paths()) {
-      if (!file.empty()) {
-        CF_EXPECT(FileHasContent(file), "File not found: \"" << file << "\"");
-      }
-    }
+    const TaskGraph::Id os_composite_disk = graph.Add(
+        name("OsCompositeDisk"),
+        [&, instance_index]() -> Result<void> {
+          disks.os_disk_builder = CF_EXPECT(OsCompositeDiskBuilder(
+              config, instance, disks.chrome_os_state, instance_image_files,
+              android_builds.ForIndex(instance_index), system_image_dirs));
+          disks.os_built_composite =
+              CF_EXPECT(disks.os_disk_builder.BuildCompositeDiskIfNecessary());
+          return {};
+        },
+        after(inputs, last_os_composite_disk_step));
+    last_os_composite_disk_step = os_composite_disk;
+
+    const TaskGraph::Id instance_composite_disks = graph.Add(
+        name("InstanceCompositeDisks"),
+        [&config, &instance, &disks]() -> Result<void> {
+          BootloaderEnvPartition bootloader_env_partition =
+              CF_EXPECT(BootloaderEnvPartition::Create(config, instance));
+
+          std::optional<ApBootloaderEnvPartition> ap_bootloader_env_partition =
+              CF_EXPECT(ApBootloaderEnvPartition::Create(config, instance));
+
+          FactoryResetProtectedImage factory_reset_protected =
+              CF_EXPECT(FactoryResetProtectedImage::Create(instance));
+
+          disks.boot_config =
+              CF_EXPECT(BootConfigPartition::CreateIfNeeded(config, instance));
+
+          PersistentVbmeta persistent_vbmeta =
+              CF_EXPECT(PersistentVbmeta::Create(
+                  disks.boot_config, bootloader_env_partition, instance));
+
+          std::optional<ApPersistentVbmeta> ap_persistent_vbmeta =
+              ap_bootloader_env_partition.has_value()
+                  ? CF_EXPECT(ApPersistentVbmeta::Create(
+                        *ap_bootloader_env_partition, disks.boot_config,
+                        instance))
+                  : std::nullopt;
+
+          // TODO: schuffelen - do something with these types
+          CF_EXPECT(InstanceCompositeDisk::Create(
+              disks.boot_config, config, instance, bootloader_env_partition,
+              factory_reset_protected, persistent_vbmeta));
+          CF_EXPECT(
+              ApCompositeDisk::Create(ap_persistent_vbmeta, config, instance));
+
+          disks.ap_disk_builder = ApCompositeDiskBuilder(config, instance);
+          if (instance.ap_boot_flow() != APBootFlow::None) {
+            CF_EXPECT(disks.ap_disk_builder.BuildCompositeDiskIfNecessary());
+          }
+          return {};
+        },
+        inputs);
+
+    const TaskGraph::Id os_overlay = graph.Add(
+        name("OsOverlay"),
+        [&instance, &disks]() -> Result<void> {
+          if (disks.os_built_composite) {
+            CF_EXPECT(ResetBlankImages(instance));
+          }
+          disks.os_disk_builder.OverlayPath(
+              instance.PerInstancePath("overlay.img"));
+          CF_EXPECT(disks.os_disk_builder.BuildOverlayIfNecessary());
+          return {};
+        },
+        {os_composite_disk});
+    const TaskGraph::Id ap_overlay = graph.Add(
+        name("ApOverlay"),
+        [&instance, &disks]() -> Result<void> {
+          if (instance.ap_boot_flow() != APBootFlow::None) {
+            disks.ap_disk_builder.OverlayPath(
+                instance.PerInstancePath("ap_overlay.img"));
+            CF_EXPECT(disks.ap_disk_builder.BuildOverlayIfNecessary());
+          }
+          return {};
+        },
+        {instance_composite_disks});
+
+    const TaskGraph::Id virtual_disks = graph.Add(
+        name("CheckVirtualDisks"),
+        [&instance]() -> Result<void> {
+          // Check that the files exist
+          for (const auto& file : instance.virtual_disk_paths()) {
+            if (!file.empty()) {
+              CF_EXPECT(FileHasContent(file),
+                        "File not found: \"" << file << "\"");
+            }
+          }
+          return {};
+        },
+        {os_overlay, ap_overlay});
 
     // Gem5 Simulate per-instance what the bootloader would usually do
     // Since on other devices this runs every time, just do it here every time
     if (VmManagerIsGem5(config)) {
-      CF_EXPECT(RepackGem5BootImage(instance.PerInstancePath("initrd.img"),
-                                    boot_config, config.assembly_dir(),
-                                    instance.initramfs_path()));
+      last_assembly_dir_step = graph.Add(
+          name("RepackGem5BootImage"),
+          [&config, &instance, &disks]() -> Result<void> {
+            CF_EXPECT(RepackGem5BootImage(
+                instance.PerInstancePath("initrd.img"), disks.boot_config,
+                config.assembly_dir(), instance.initramfs_path()));
+            return {};
+          },
+          after({virtual_disks}, last_assembly_dir_step));
     }
-    ++instance_index;
   }
 
+  CF_EXPECT(graph.Run());
   return {};
 }
 
@@ -57,7 +57,6 @@ DiskBuilder ApCompositeDiskBuilder(
       .ReadOnly(FLAGS_use_overlay)
       .Partitions(GetApCompositeDiskConfig(config, instance))
       .VmManager(config.vm_manager())
-      .CrosvmPath(instance.crosvm_binary())
       .ConfigPath(instance.PerInstancePath("ap_composite_disk_config.txt"))
       .HeaderPath(instance.PerInstancePath("ap_composite_gpt_header.img"))
       .FooterPath(instance.PerInstancePath("ap_composite_gpt_footer.img"))
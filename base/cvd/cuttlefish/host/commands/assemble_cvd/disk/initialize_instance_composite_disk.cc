@@ -94,7 +94,6 @@ Result<InstanceCompositeDisk> InstanceCompositeDisk::Create(
                                                     bootconfig_partition, frp,
                                                     persistent_vbmeta))
           .VmManager(config.vm_manager())
-          .CrosvmPath(instance.crosvm_binary())
           .ConfigPath(ipath("persistent_composite_disk_config.txt"))
           .HeaderPath(ipath("persistent_composite_gpt_header.img"))
           .FooterPath(ipath("persistent_composite_gpt_footer.img"))
@@ -128,7 +127,6 @@ Result<std::optional<ApCompositeDisk>> ApCompositeDisk::Create(
           .Partitions(
               PersistentAPCompositeDiskConfig(instance, *ap_persistent_vbmeta))
           .VmManager(config.vm_manager())
-          .CrosvmPath(instance.crosvm_binary())
           .ConfigPath(ipath("ap_persistent_composite_disk_config.txt"))
           .HeaderPath(ipath("ap_persistent_composite_gpt_header.img"))
           .FooterPath(ipath("ap_persistent_composite_gpt_footer.img"))
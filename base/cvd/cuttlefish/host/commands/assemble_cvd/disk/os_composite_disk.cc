@@ -73,7 +73,6 @@ Result<DiskBuilder> OsCompositeDiskBuilder(
   auto builder =
       DiskBuilder()
           .VmManager(config.vm_manager())
-          .CrosvmPath(instance.crosvm_binary())
           .ConfigPath(instance.PerInstancePath("os_composite_disk_config.txt"))
           .ReadOnly(FLAGS_use_overlay)
           .ResumeIfPossible(FLAGS_resume);
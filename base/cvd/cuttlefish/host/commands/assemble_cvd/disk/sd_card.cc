@@ -16,11 +16,16 @@
 
 #include "cuttlefish/host/commands/assemble_cvd/disk/sd_card.h"
 
+#include <stdint.h>
+
+#include <memory>
 #include <string>
 
 #include "cuttlefish/files/file_exists.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 #include "cuttlefish/host/libs/config/data_image.h"
+#include "cuttlefish/host/libs/image_aggregator/disk_image.h"
+#include "cuttlefish/host/libs/image_aggregator/image_from_file.h"
 #include "cuttlefish/host/libs/image_aggregator/qcow2.h"
 #include "cuttlefish/result/result.h"
 
@@ -39,8 +44,10 @@ Result<void> InitializeSdCard(
                                     instance.blank_sdcard_image_mb()),
              "Failed to create '{}'", instance.sdcard_path());
   if (VmManagerIsQemu(config)) {
-    const std::string crosvm_path = instance.crosvm_binary();
-    CF_EXPECT(Qcow2Image::Create(crosvm_path, instance.sdcard_path(),
+    std::unique_ptr<DiskImage> sdcard =
+        CF_EXPECT(ImageFromFile(instance.sdcard_path()));
+    const uint64_t sdcard_size = CF_EXPECT(sdcard->VirtualSizeBytes());
+    CF_EXPECT(Qcow2Image::Create(instance.sdcard_path(), sdcard_size,
                                  instance.sdcard_overlay_path()));
   }
   return {};
@@ -15,7 +15,10 @@
 
 #include "cuttlefish/host/commands/assemble_cvd/disk_builder.h"
 
+#include <stdint.h>
+
 #include <chrono>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -26,7 +29,9 @@
 
 #include "cuttlefish/common/libs/utils/files.h"
 #include "cuttlefish/host/libs/config/vmm_mode.h"
+#include "cuttlefish/host/libs/image_aggregator/disk_image.h"
 #include "cuttlefish/host/libs/image_aggregator/image_aggregator.h"
+#include "cuttlefish/host/libs/image_aggregator/image_from_file.h"
 #include "cuttlefish/host/libs/image_aggregator/qcow2.h"
 #include "cuttlefish/result/result.h"
 
@@ -86,15 +91,6 @@ DiskBuilder DiskBuilder::FooterPath(std::string footer_path) && {
   return *this;
 }
 
-DiskBuilder& DiskBuilder::CrosvmPath(std::string crosvm_path) & {
-  crosvm_path_ = std::move(crosvm_path);
-  return *this;
-}
-DiskBuilder DiskBuilder::CrosvmPath(std::string crosvm_path) && {
-  crosvm_path_ = std::move(crosvm_path);
-  return *this;
-}
-
 DiskBuilder& DiskBuilder::VmManager(VmmMode vm_manager) & {
   vm_manager_ = std::move(vm_manager);
   return *this;
@@ -257,9 +253,12 @@ Result<bool> DiskBuilder::BuildOverlayIfNecessary() {
     return false;
   }
 
-  CF_EXPECT(!crosvm_path_.empty(), "crosvm binary missing");
-  CF_EXPECT(
-      Qcow2Image::Create(crosvm_path_, composite_disk_path_, overlay_path_));
+  std::unique_ptr<DiskImage> composite_disk =
+      CF_EXPECT(ImageFromFile(composite_disk_path_));
+  const uint64_t composite_disk_size =
+      CF_EXPECT(composite_disk->VirtualSizeBytes());
+  CF_EXPECT(Qcow2Image::Create(composite_disk_path_, composite_disk_size,
+                               overlay_path_));
 
   return true;
 #endif
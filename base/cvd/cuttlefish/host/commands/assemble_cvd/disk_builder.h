@@ -38,9 +38,6 @@ class DiskBuilder {
   DiskBuilder& FooterPath(std::string footer_path) &;
   DiskBuilder FooterPath(std::string footer_path) &&;
 
-  DiskBuilder& CrosvmPath(std::string crosvm_path) &;
-  DiskBuilder CrosvmPath(std::string crosvm_path) &&;
-
   DiskBuilder& VmManager(VmmMode vm_manager) &;
   DiskBuilder VmManager(VmmMode vm_manager) &&;
 
@@ -73,7 +70,6 @@ class DiskBuilder {
   std::string header_path_;
   std::string footer_path_;
   VmmMode vm_manager_ = VmmMode::kUnknown;
-  std::string crosvm_path_;
   std::string config_path_;
   std::string composite_disk_path_;
   std::string overlay_path_;
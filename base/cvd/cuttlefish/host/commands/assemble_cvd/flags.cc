@@ -428,6 +428,7 @@ Result<CuttlefishConfig> InitializeCuttlefishConfiguration(
   auto secure_hals = CF_EXPECT(ParseSecureHals(FLAGS_secure_hals));
   CF_EXPECT(ValidateSecureHals(secure_hals));
   tmp_config_obj.set_secure_hals(secure_hals);
+  tmp_config_obj.set_keymint_key_pool(FLAGS_keymint_key_pool);
 
   ExtraKernelCmdlineFlag extra_kernel_cmdline_value =
       ExtraKernelCmdlineFlag::FromGlobalGflags();
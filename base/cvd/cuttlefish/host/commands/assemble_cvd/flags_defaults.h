@@ -98,6 +98,7 @@
 #define CF_DEFAULTS_SERIAL_NUMBER \
   cuttlefish::ForCurrentInstance("CUTTLEFISHCVD")
 #define CF_DEFAULTS_SECURE_HALS CF_DEFAULTS_DYNAMIC_STRING
+#define CF_DEFAULTS_KEYMINT_KEY_POOL false
 #define CF_DEFAULTS_PROTECTED_VM false
 #define CF_DEFAULTS_MTE false
 #define CF_DEFAULTS_ENABLE_PKVM false
@@ -17,6 +17,7 @@
 #include "cuttlefish/host/commands/cvd/cache/cache.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <algorithm>
 #include <chrono>
@@ -29,29 +30,41 @@
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "fmt/format.h"
 
 #include "cuttlefish/common/libs/utils/disk_usage.h"
 #include "cuttlefish/common/libs/utils/files.h"
 #include "cuttlefish/files/recursively_remove_directory.h"
+#include "cuttlefish/host/libs/web/artifact_store.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
 namespace {
 
+constexpr uint64_t kBytesPerGigabyte = uint64_t{1} << 30;
+
+// Rounds up, like `du --block-size=1G`
+size_t ToGigabytes(const uint64_t bytes) {
+  return (bytes + kBytesPerGigabyte - 1) / kBytesPerGigabyte;
+}
+
 Result<std::vector<std::string>> CacheFilesDesc(
     const std::string& cache_directory) {
   std::vector<std::string> contents = CF_EXPECTF(
       DirectoryContentsPaths(cache_directory),
       "Failure retrieving contents of directory at \"{}\"", cache_directory);
 
-  auto not_self_or_parent_directory = [](std::string_view filepath) {
-    return !absl::EndsWith(filepath, ".") && !absl::EndsWith(filepath, "..");
+  // The artifact store is pruned separately, as it tracks its own contents.
+  const std::string store_suffix = absl::StrCat("/", kArtifactStoreDirectory);
+  auto prunable = [&store_suffix](std::string_view filepath) {
+    return !absl::EndsWith(filepath, ".") && !absl::EndsWith(filepath, "..") &&
+           !absl::EndsWith(filepath, store_suffix);
   };
   std::vector<std::string> filtered;
   std::copy_if(contents.begin(), contents.end(), std::back_inserter(filtered),
-               not_self_or_parent_directory);
+               prunable);
 
   using ModTimePair =
       std::pair<std::string, std::chrono::system_clock::time_point>;
@@ -89,26 +102,37 @@ Result<size_t> GetCacheSize(const std::string& cache_directory) {
 Result<PruneResult> PruneCache(const std::string& cache_directory,
                                const size_t allowed_size_gb) {
   CF_EXPECT(EnsureDirectoryExists(cache_directory));
-  size_t cache_size = CF_EXPECT(GetDiskUsageGigabytes(cache_directory));
+  // Measured once, then kept up to date by subtracting what gets deleted.
+  uint64_t cache_size = CF_EXPECT(GetDiskUsageBytes(cache_directory));
   PruneResult result{
-      .before = cache_size,
+      .before = ToGigabytes(cache_size),
   };
+  const uint64_t allowed_size = allowed_size_gb * kBytesPerGigabyte;
+  if (cache_size > allowed_size) {
+    ArtifactStore store = CF_EXPECT(ArtifactStore::Open(
+        absl::StrCat(cache_directory, "/", kArtifactStoreDirectory)));
+    const uint64_t excess = cache_size - allowed_size;
+    const uint64_t store_size = CF_EXPECT(store.Size());
+    cache_size -=
+        CF_EXPECT(store.Evict(store_size > excess ? store_size - excess : 0));
+  }
   // Descending because elements are removed from the back
   std::vector<std::string> cache_files =
       CF_EXPECT(CacheFilesDesc(cache_directory));
-  while (cache_size > allowed_size_gb) {
+  while (cache_size > allowed_size) {
     CHECK(!cache_files.empty()) << fmt::format(
-        "Cache size is {} of {}, but there are no more files for pruning.",
-        cache_size, allowed_size_gb);
+        "Cache size is {} of {}GB, but there are no more files for pruning.",
+        ToGigabytes(cache_size), allowed_size_gb);
 
     std::string next = cache_files.back();
     cache_files.pop_back();
+    const uint64_t next_size = CF_EXPECT(GetDiskUsageBytes(next));
     VLOG(0) << fmt::format("Deleting \"{}\" for prune", next);
     // handles removal of non-directory top-level files as well
     CF_EXPECT(RecursivelyRemoveDirectory(next));
-    cache_size = CF_EXPECT(GetDiskUsageGigabytes(cache_directory));
+    cache_size -= std::min(next_size, cache_size);
   }
-  result.after = cache_size;
+  result.after = ToGigabytes(cache_size);
   return result;
 }
 
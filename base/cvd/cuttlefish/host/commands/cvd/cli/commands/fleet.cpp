@@ -16,6 +16,7 @@
 
 #include "cuttlefish/host/commands/cvd/cli/commands/fleet.h"
 
+#include <future>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -62,9 +63,14 @@ Result<void> CvdFleetCommandHandler::Handle(const CommandRequest& request) {
   CF_EXPECT(ConsumeFlags({}, args, {.fail_on_unexpected_argument = true}));
 
   auto all_groups = CF_EXPECT(instance_manager_.FindGroups({}));
-  Json::Value groups_json(Json::arrayValue);
+  std::vector<std::future<Result<Json::Value>>> statuses;
   for (auto& group : all_groups) {
-    groups_json.append(CF_EXPECT(group.FetchStatus()));
+    statuses.emplace_back(std::async(
+        std::launch::async, [&group]() { return group.FetchStatus(); }));
+  }
+  Json::Value groups_json(Json::arrayValue);
+  for (auto& status : statuses) {
+    groups_json.append(CF_EXPECT(status.get()));
   }
   Json::Value output_json(Json::objectValue);
   output_json["groups"] = groups_json;
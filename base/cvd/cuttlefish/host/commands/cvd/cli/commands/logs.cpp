@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <optional>
@@ -15,6 +16,7 @@
 #include "android-base/file.h"
 
 #include "cuttlefish/ansi_codes/ansi_codes.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/flag_parser/flag.h"
 #include "cuttlefish/flag_parser/gflags_compat.h"
 #include "cuttlefish/host/commands/cvd/cli/command_request.h"
@@ -23,12 +25,16 @@
 #include "cuttlefish/host/commands/cvd/instances/instance_manager.h"
 #include "cuttlefish/host/commands/cvd/instances/local_instance.h"
 #include "cuttlefish/host/commands/cvd/instances/local_instance_group.h"
+#include "cuttlefish/host/libs/logcat/logcat_index.h"
+#include "cuttlefish/host/libs/logcat/logcat_segments.h"
+#include "cuttlefish/io/shared_fd.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 namespace {
 
 constexpr char kSummaryHelpText[] = "List and display log files";
+constexpr char kLogcatBasename[] = "logcat";
 
 bool IsGroupLevelLog(const std::string& log_name) {
   std::vector<std::string> basenames = LocalInstanceGroup::GroupLogBasenames();
@@ -78,6 +84,31 @@ Result<void> PrintLog(const std::string& filename, const bool use_pager) {
   return CF_ERR("execlp failed: " << strerror(errno));
 }
 
+Result<std::optional<uint64_t>> ParseTimestampFlag(
+    const std::optional<std::string>& flag, bool end_of_second) {
+  if (!flag) {
+    return std::nullopt;
+  }
+  std::optional<uint64_t> timestamp = ParseLogcatTimestamp(*flag);
+  CF_EXPECTF(timestamp.has_value(),
+             "Invalid timestamp '{}', expected 'MM-DD hh:mm:ss[.mmm]'", *flag);
+  // "--until 10:00:00" includes the lines logged during that second.
+  if (end_of_second && flag->find('.') == std::string::npos) {
+    *timestamp += 999;
+  }
+  return timestamp;
+}
+
+// Prints the logcat lines in a time range from all of the rotated segments,
+// seeking to the range with the segment indexes.
+Result<void> PrintLogcatRange(const std::string& filename,
+                              std::optional<uint64_t> since,
+                              std::optional<uint64_t> until) {
+  SharedFdIo out(SharedFD::Dup(STDOUT_FILENO));
+  CF_EXPECT(CopyLogcatRange(filename, since, until, out));
+  return {};
+}
+
 Result<void> PrintLogsTree(
     const std::vector<std::pair<LocalInstanceGroup,
                                 std::vector<LocalInstance>>>& found_instances) {
@@ -192,6 +223,12 @@ Result<void> CvdLogsHandler::HandlePrint(const CommandRequest& request) {
   if (print_target_flag_.value().empty()) {
     return CF_ERR("Invalid log file name: ''");
   }
+  const std::optional<uint64_t> since =
+      CF_EXPECT(ParseTimestampFlag(since_flag_, false));
+  const std::optional<uint64_t> until =
+      CF_EXPECT(ParseTimestampFlag(until_flag_, true));
+  CF_EXPECTF(!(since || until) || *print_target_flag_ == kLogcatBasename,
+             "--since and --until only apply to `{}`", kLogcatBasename);
   std::vector<std::string> log_filenames;
   if (IsGroupLevelLog(*print_target_flag_)) {
     const LocalInstanceGroup group =
@@ -206,10 +243,15 @@ Result<void> CvdLogsHandler::HandlePrint(const CommandRequest& request) {
   log_filenames = RemoveInaccessibleFilenames(std::move(log_filenames));
   for (const std::string& filename : log_filenames) {
     const std::string basename = android::base::Basename(filename);
-    if (basename == *print_target_flag_) {
+    if (basename != *print_target_flag_) {
+      continue;
+    }
+    if (since || until) {
+      CF_EXPECT(PrintLogcatRange(filename, since, until));
+    } else {
       CF_EXPECT(PrintLog(filename, pager_));
-      return {};
     }
+    return {};
   }
   return CF_ERRF("Could not find `{}` in the logs directories",
                  *print_target_flag_);
@@ -291,6 +333,11 @@ std::vector<HelpParagraph> CvdLogsHandler::Description() const {
           R"(  Print the launcher.log file without a pager:
     $ cvd logs -p launcher.log --nopager)"),
 
+      HelpParagraph::Raw(
+          R"(  Print the logcat lines logged in a time range, including the rotated
+  and compressed logcat segments:
+    $ cvd logs -p logcat --since "06-01 10:00:00" --until "06-01 10:05:00")"),
+
       HelpParagraph::Raw(
           R"(  Print the kernel.log for a specific instance 'cvd-2' in group 'mygroup':
     $ cvd -group_name mygroup -instance_name cvd-2 logs -p kernel.log)"),
@@ -310,6 +357,15 @@ Result<std::vector<Flag>> CvdLogsHandler::Flags(const CommandRequest&) {
       GflagsCompatFlag("pager", pager_)
           .Help("Use a pager when printing log files. The default when output "
                 "is a terminal."),
+      GflagsCompatFlag("since", since_flag_)
+          .ValueNameHint("TIMESTAMP")
+          .Help("Print the logcat lines logged from this 'MM-DD hh:mm:ss[.mmm]' "
+                "timestamp on, without a pager. Only applies to 'logcat'."),
+      GflagsCompatFlag("until", until_flag_)
+          .ValueNameHint("TIMESTAMP")
+          .Help("Print the logcat lines logged up to this 'MM-DD "
+                "hh:mm:ss[.mmm]' timestamp, without a pager. Only applies to "
+                "'logcat'."),
   };
 }
 
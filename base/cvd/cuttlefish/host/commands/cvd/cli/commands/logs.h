@@ -27,6 +27,8 @@ class CvdLogsHandler : public CvdCommandHandler {
 
   InstanceManager& instance_manager_;
   std::optional<std::string> print_target_flag_;
+  std::optional<std::string> since_flag_;
+  std::optional<std::string> until_flag_;
   bool pretty_;
   bool pager_;
 };
@@ -16,6 +16,7 @@
 
 #include "cuttlefish/host/commands/cvd/cli/commands/monitor/file_monitor_source.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -41,6 +42,8 @@
 #include "cuttlefish/host/commands/cvd/cli/format_byte_size.h"
 #include "cuttlefish/io/io.h"
 #include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/result/expect.h"
 #include "cuttlefish/result/result_type.h"
 
@@ -49,6 +52,7 @@ namespace {
 
 constexpr size_t kChunkReadSize = 1 << 20;
 constexpr size_t kMaximumScrollback = 1 << 24;
+constexpr uint32_t kWatchEvents = IN_DELETE_SELF | IN_MODIFY | IN_MOVE_SELF;
 
 struct FileData {
   std::vector<std::string> last_lines;
@@ -115,7 +119,8 @@ FileMonitorSource::FileMonitorSource(
       filter_line_(std::move(filter_line)) {
   inotify_fd_ = Fd::InotifyFd().value_or(Fd());
   CHECK(inotify_fd_->IsOpen()) << inotify_fd_->StrError();
-  CHECK_GE(inotify_fd_->InotifyAddWatch(path_, IN_DELETE_SELF | IN_MODIFY), 0);
+  watch_ = inotify_fd_->InotifyAddWatch(path_, kWatchEvents);
+  CHECK_GE(watch_, 0);
   const int flags = inotify_fd_->Fcntl(F_GETFL, 0);
   CHECK_GE(inotify_fd_->Fcntl(F_SETFL, flags | O_NONBLOCK), 0);
 }
@@ -124,6 +129,12 @@ FileMonitorSource::~FileMonitorSource() = default;
 
 MonitorOutput FileMonitorSource::Report(size_t rows, size_t) {
   const std::string basename = android::base::Basename(path_);
+  // Drained before reading, so that no modification is missed.
+  Result<uint32_t> events = DrainInotifyEvents(inotify_fd_);
+  if ((events.has_value() && (*events & IN_MOVE_SELF)) || reopen_pending_) {
+    // The replacement may not be created yet, so keep showing the old file.
+    reopen_pending_ = !Reopen().has_value();
+  }
   Result<FileData> file_data =
       GetLastNLines(*file_io_, rows, filter_line_, basename);
   if (!file_data.has_value()) {
@@ -135,11 +146,21 @@ MonitorOutput FileMonitorSource::Report(size_t rows, size_t) {
     line = colorize_line_(line).value_or(line);
   }
   std::string size = FormatByteSize(file_data->total_size);
-  Result<uint32_t> unused = DrainInotifyEvents(inotify_fd_);
   return MonitorOutput(absl::StrCat(basename, " (", size, ")"),
                        file_data->last_lines);
 }
 
 SharedFD FileMonitorSource::ReadyFd() { return inotify_fd_; }
 
+Result<void> FileMonitorSource::Reopen() {
+  SharedFD fd = SharedFD::Open(path_, O_RDONLY);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", path_, fd->StrError());
+  const int watch = inotify_fd_->InotifyAddWatch(path_, kWatchEvents);
+  CF_EXPECTF(watch >= 0, "Failed to watch '{}': {}", path_, StrError(errno));
+  inotify_fd_->InotifyRmWatch(watch_);
+  watch_ = watch;
+  file_io_ = std::make_unique<SharedFdIo>(fd);
+  return {};
+}
+
 }  // namespace cuttlefish
@@ -43,11 +43,17 @@ class FileMonitorSource : public MonitorSource {
   SharedFD ReadyFd() override;
 
  private:
+  // Follows `path_` to the new file after the old one is renamed, as when
+  // logcat segments are rotated.
+  Result<void> Reopen();
+
   std::string path_;
   std::unique_ptr<ReaderSeeker> file_io_;
   std::function<Result<std::string>(std::string_view)> colorize_line_;
   std::function<Result<bool>(std::string_view)> filter_line_;
   SharedFD inotify_fd_;
+  int watch_ = -1;
+  bool reopen_pending_ = false;
 };
 
 }  // namespace cuttlefish
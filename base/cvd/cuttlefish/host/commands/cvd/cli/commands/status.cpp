@@ -18,15 +18,20 @@
 
 #include <chrono>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "absl/log/log.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/strip.h"
 #include "json/value.h"
+#include "json/writer.h"
 
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/fs/shared_select.h"
 #include "cuttlefish/flag_parser/flag.h"
 #include "cuttlefish/flag_parser/gflags_compat.h"
 #include "cuttlefish/host/commands/cvd/cli/command_request.h"
@@ -34,6 +39,9 @@
 #include "cuttlefish/host/commands/cvd/cli/utils.h"
 #include "cuttlefish/host/commands/cvd/instances/instance_manager.h"
 #include "cuttlefish/host/commands/cvd/instances/local_instance.h"
+#include "cuttlefish/host/commands/cvd/instances/status_fetcher.h"
+#include "cuttlefish/host/libs/command_util/runner/run_cvd.pb.h"
+#include "cuttlefish/host/libs/command_util/util.h"
 #include "cuttlefish/host/libs/config/config_constants.h"
 #include "cuttlefish/result/result.h"
 
@@ -71,6 +79,11 @@ Args:
                          information to stdout instead of CHECK.
                          (Current value: "false", Required: Android > 12)
 
+  --watch                Keeps running after the status is fetched, and
+                         prints a line of JSON each time the status of one of
+                         the selected instances changes, until they all stop.
+                         (Current value: "false")
+
   --help                 List this message
 
 )";
@@ -88,6 +101,7 @@ struct StatusCommandOptions {
   int wait_for_launcher_seconds;
   std::string instance_name;
   bool print;
+  bool watch;
   bool help;
 };
 
@@ -96,12 +110,14 @@ Result<StatusCommandOptions> ParseFlags(std::vector<std::string>& args) {
       .wait_for_launcher_seconds = 5,
       .instance_name = "",
       .print = false,
+      .watch = false,
       .help = false,
   };
   std::vector<Flag> flags = {
       GflagsCompatFlag("wait_for_launcher", ret.wait_for_launcher_seconds),
       GflagsCompatFlag("instance_name", ret.instance_name),
       GflagsCompatFlag("print", ret.print),
+      GflagsCompatFlag("watch", ret.watch),
   };
 
   CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
@@ -109,6 +125,60 @@ Result<StatusCommandOptions> ParseFlags(std::vector<std::string>& args) {
   return ret;
 }
 
+std::string ToSingleLineJson(const Json::Value& value) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, value);
+}
+
+// Streams the status of the running instances until their launchers close
+// the connection.
+Result<void> WatchStatus(const std::vector<LocalInstance>& instances,
+                         std::chrono::seconds timeout) {
+  std::vector<std::pair<SharedFD, const LocalInstance*>> streams;
+  for (const LocalInstance& instance : instances) {
+    if (!instance.IsActive()) {
+      continue;
+    }
+    SharedFD monitor = CF_EXPECT(instance.GetLauncherMonitor(timeout));
+    run_cvd::InstanceStatus status = CF_EXPECTF(
+        QueryLauncherStatus(monitor, /* watch */ true, timeout.count()),
+        "Failed to watch \"{}\"", instance.Name());
+    std::cout << ToSingleLineJson(InstanceStatusToJson(instance, status))
+              << std::endl;
+    streams.emplace_back(std::move(monitor), &instance);
+  }
+  while (!streams.empty()) {
+    SharedFDSet read_set;
+    for (const auto& [monitor, instance] : streams) {
+      read_set.Set(monitor);
+    }
+    CF_EXPECT_GE(Select(&read_set, nullptr, nullptr, nullptr), 0);
+    std::vector<std::pair<SharedFD, const LocalInstance*>> open_streams;
+    for (auto& [monitor, instance] : streams) {
+      if (!read_set.IsSet(monitor)) {
+        open_streams.emplace_back(std::move(monitor), instance);
+        continue;
+      }
+      Result<std::optional<run_cvd::InstanceStatus>> status =
+          ReadLauncherStatus(monitor);
+      if (!status.has_value()) {
+        LOG(WARNING) << "Stopped watching \"" << instance->Name()
+                     << "\": " << status.error().Message();
+        continue;
+      }
+      if (!status->has_value()) {
+        continue;
+      }
+      std::cout << ToSingleLineJson(InstanceStatusToJson(*instance, **status))
+                << std::endl;
+      open_streams.emplace_back(std::move(monitor), instance);
+    }
+    streams = std::move(open_streams);
+  }
+  return {};
+}
+
 }  // namespace
 
 std::vector<std::string> CvdStatusCommandHandler::CmdList() const {
@@ -143,6 +213,7 @@ Result<void> CvdStatusCommandHandler::Handle(const CommandRequest& request) {
   }
 
   Json::Value status_array(Json::arrayValue);
+  std::vector<LocalInstance> selected_instances;
 
   if (!request.Selectors().instance_names && flags.instance_name.empty()) {
     // No attempt at selecting an instance, get group status instead
@@ -150,6 +221,7 @@ Result<void> CvdStatusCommandHandler::Handle(const CommandRequest& request) {
         CF_EXPECT(selector::SelectGroup(instance_manager_, request));
     status_array = CF_EXPECT(group.FetchStatus(
         std::chrono::seconds(flags.wait_for_launcher_seconds)));
+    selected_instances = group.Instances();
     // TODO: b/471069557 - diagnose unused
     Result<void> unused = instance_manager_.UpdateInstanceGroup(group);
   } else {
@@ -163,6 +235,7 @@ Result<void> CvdStatusCommandHandler::Handle(const CommandRequest& request) {
     LocalInstanceGroup group = pair.second;
     status_array.append(CF_EXPECT(instance.FetchStatus(
         std::chrono::seconds(flags.wait_for_launcher_seconds))));
+    selected_instances.push_back(instance);
     // TODO: b/471069557 - diagnose unused
     Result<void> unused = instance_manager_.UpdateInstanceGroup(group);
   }
@@ -170,6 +243,11 @@ Result<void> CvdStatusCommandHandler::Handle(const CommandRequest& request) {
   if (flags.print) {
     std::cout << status_array.toStyledString();
   }
+  if (flags.watch) {
+    CF_EXPECT(WatchStatus(
+        selected_instances,
+        std::chrono::seconds(flags.wait_for_launcher_seconds)));
+  }
 
   return {};
 }
@@ -68,6 +68,11 @@ std::vector<Flag> BuildApiFlags::Flags() {
           .Help("Max allowed size(in gigabytes) of the local fetch file cache. "
                 " If the cache grows beyond this size it will be pruned after "
                 "the fetches complete."));
+  flags.emplace_back(
+      GflagsCompatFlag("download_connections", this->download_connections)
+          .Help("Number of concurrent range requests used to download each "
+                "artifact or to read each remote archive, and of targets "
+                "fetched at the same time."));
 
   for (Flag flag : this->credential_flags.Flags()) {
     flags.emplace_back(std::move(flag));
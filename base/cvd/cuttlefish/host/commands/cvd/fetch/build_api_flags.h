@@ -35,6 +35,7 @@ inline constexpr char kDefaultProjectID[] = "";
 inline constexpr std::chrono::seconds kDefaultWaitRetryPeriod =
     std::chrono::seconds(20);
 inline constexpr bool kDefaultEnableCaching = true;
+inline constexpr size_t kDefaultDownloadConnections = 4;
 
 struct BuildApiFlags {
   std::vector<Flag> Flags();
@@ -47,6 +48,7 @@ struct BuildApiFlags {
   std::string api_base_url = kAndroidBuildServiceUrl;
   bool enable_caching = kDefaultEnableCaching;
   size_t max_cache_size_gb = kDefaultCacheSizeGb;
+  size_t download_connections = kDefaultDownloadConnections;
   CasDownloaderFlags cas_downloader_flags;
 };
 
@@ -30,6 +30,7 @@
 #include "cuttlefish/host/libs/web/credential_source.h"
 #include "cuttlefish/host/libs/web/http_client/curl_http_client.h"
 #include "cuttlefish/host/libs/web/http_client/http_client.h"
+#include "cuttlefish/host/libs/web/http_client/http_file.h"
 #include "cuttlefish/host/libs/web/http_client/retrying_http_client.h"
 #include "cuttlefish/host/libs/web/luci_build_api.h"
 #include "cuttlefish/host/libs/web/oauth2_consent.h"
@@ -90,11 +91,13 @@ Result<Downloaders> Downloaders::Create(const BuildApiFlags& flags,
   impl->android_build_api_ = std::make_unique<AndroidBuildApi>(
       *impl->retrying_http_client_, *impl->android_build_url_,
       impl->android_creds_.get(), flags.wait_retry_period,
-      impl->cas_downloader_.get());
+      impl->cas_downloader_.get(),
+      RangedDownloadOptions{.connections = flags.download_connections});
 
   if (flags.enable_caching) {
     impl->caching_build_api_ = std::make_unique<CachingBuildApi>(
-        *impl->android_build_api_, cache_base_path);
+        *impl->android_build_api_, cache_base_path,
+        flags.download_connections);
   }
 
   impl->luci_credential_source_ = CF_EXPECT(GetCredentialSourceFromFlags(
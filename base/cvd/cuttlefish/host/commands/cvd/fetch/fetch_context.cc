@@ -96,11 +96,23 @@ Result<ReadableZip*> FetchArtifact::AsZip() {
   if (!zip_) {
     zip_ = CF_EXPECT(
         ::cuttlefish::OpenZip(fetch_build_context_.fetch_context_.build_api_,
-                              fetch_build_context_.build_, artifact_name_));
+                              fetch_build_context_.build_, artifact_name_,
+                              prefetch_members_));
   }
   return &*zip_;
 }
 
+Result<void> FetchArtifact::PrefetchMembers(std::vector<std::string> members) {
+  prefetch_members_ = std::move(members);
+  if (zip_ && downloaded_path_.empty()) {
+    // The members are only passed on when the archive is opened. What was
+    // read through the old handle stays in the cache.
+    zip_.reset();
+    CF_EXPECT(AsZip());
+  }
+  return {};
+}
+
 Result<void> FetchArtifact::ExtractAll() {
   CF_EXPECT(ExtractAll(""));
   return {};
@@ -40,6 +40,10 @@ class FetchArtifact {
 
   Result<ReadableZip*> AsZip();
 
+  /* Declares the members that will be extracted next, in order, so that an
+   * archive read from the build server can fetch them ahead of time. */
+  Result<void> PrefetchMembers(std::vector<std::string> members);
+
   Result<void> ExtractAll();
   Result<void> ExtractAll(const std::string& local_path);
 
@@ -58,6 +62,7 @@ class FetchArtifact {
   std::string artifact_name_;
   std::string downloaded_path_;
   std::optional<ReadableZip> zip_;
+  std::vector<std::string> prefetch_members_;
 };
 
 /**
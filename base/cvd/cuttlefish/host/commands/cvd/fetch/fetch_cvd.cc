@@ -18,6 +18,8 @@
 #include <stddef.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <future>
 #include <memory>
@@ -33,6 +35,7 @@
 #include "cuttlefish/common/libs/utils/archive.h"
 #include "cuttlefish/common/libs/utils/contains.h"
 #include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/common/libs/utils/task_graph.h"
 #include "cuttlefish/host/commands/cvd/fetch/build_strings.h"
 #include "cuttlefish/host/commands/cvd/fetch/builds.h"
 #include "cuttlefish/host/commands/cvd/fetch/download_flags.h"
@@ -235,26 +238,30 @@ Result<void> FetchDefaultTarget(FetchBuildContext& context,
     CF_EXPECT(target_files.DownloadTo(download_location));
   }
   if (flags.dynamic_super_image) {
-    ReadableZip* target_files_zip = CF_EXPECT(target_files.AsZip());
-    std::unique_ptr<ReaderSeeker> ab_partitions_source =
-        CF_EXPECT(target_files_zip->OpenReadOnly("META/ab_partitions.txt"));
-    CF_EXPECT(ab_partitions_source.get());
-    std::string ab_partitions_contents =
-        CF_EXPECT(ReadToString(*ab_partitions_source));
+    std::string ab_partitions_contents;
+    {
+      // Closed before `PrefetchMembers`, which may reopen the archive.
+      ReadableZip* target_files_zip = CF_EXPECT(target_files.AsZip());
+      std::unique_ptr<ReaderSeeker> ab_partitions_source =
+          CF_EXPECT(target_files_zip->OpenReadOnly("META/ab_partitions.txt"));
+      CF_EXPECT(ab_partitions_source.get());
+      ab_partitions_contents = CF_EXPECT(ReadToString(*ab_partitions_source));
+    }
 
     CF_EXPECT(target_files.ExtractOneTo("META/ab_partitions.txt",
                                         "default/ab_partitions.txt"));
 
     std::vector<std::string_view> ab_files =
-        absl::StrSplit(ab_partitions_contents, '\n');
+        absl::StrSplit(ab_partitions_contents, '\n', absl::SkipEmpty());
     ab_files.emplace_back("super_empty");
+    std::vector<std::string> members;
     for (std::string_view ab_file : ab_files) {
-      if (ab_file.empty()) {
-        continue;
-      }
-      std::string member = fmt::format("IMAGES/{}.img", ab_file);
-      std::string output = fmt::format("default/{}.img", ab_file);
-      CF_EXPECT(target_files.ExtractOneTo(member, output));
+      members.emplace_back(fmt::format("IMAGES/{}.img", ab_file));
+    }
+    CF_EXPECT(target_files.PrefetchMembers(members));
+    for (size_t i = 0; i < members.size(); i++) {
+      std::string output = fmt::format("default/{}.img", ab_files[i]);
+      CF_EXPECT(target_files.ExtractOneTo(members[i], output));
     }
   }
   return {};
@@ -483,32 +490,45 @@ Result<FetchResult> Fetch(const FetchFlags& flags,
         std::cref(flags.keep_downloaded_archives),
         std::cref(flags.host_substitutions), tracer.NewTrace("Host Package"));
   }
-  size_t count = 1;
+  // Targets go to separate directories, so they are fetched side by side.
   FetchResult fetch_result;
-  for (const auto& target : targets) {
-    FetcherConfig config;
-    FetchContext fetch_context(downloaders.AndroidBuild(), target.directories,
-                               target.builds, config, tracer);
-    LOG(INFO) << "Starting fetch to \"" << target.directories.root << "\"";
-    CF_EXPECT(FetchTarget(fetch_context, target.download_flags,
-                          flags.keep_downloaded_archives));
-
-    if (target.builds.chrome_os) {
-      CF_EXPECT(FetchChromeOsTarget(
-          downloaders.Luci(), *target.builds.chrome_os, target.directories,
-          flags.keep_downloaded_archives, config, tracer.NewTrace("ChromeOS")));
-    }
+  fetch_result.fetch_artifacts.resize(targets.size());
+  std::atomic<size_t> completed = 0;
+  TaskGraph target_fetches;
+  for (size_t i = 0; i < targets.size(); i++) {
+    const Target& target = targets[i];
+    auto fetch = [&, i]() -> Result<void> {
+      FetcherConfig config;
+      FetchContext fetch_context(downloaders.AndroidBuild(), target.directories,
+                                 target.builds, config, tracer);
+      LOG(INFO) << "Starting fetch to \"" << target.directories.root << "\"";
+      CF_EXPECT(FetchTarget(fetch_context, target.download_flags,
+                            flags.keep_downloaded_archives));
+
+      if (target.builds.chrome_os) {
+        CF_EXPECT(FetchChromeOsTarget(downloaders.Luci(),
+                                      *target.builds.chrome_os,
+                                      target.directories,
+                                      flags.keep_downloaded_archives, config,
+                                      tracer.NewTrace("ChromeOS")));
+      }
 
-    const std::string config_path =
-        CF_EXPECT(SaveConfig(config, target.directories.root));
-    fetch_result.fetch_artifacts.emplace_back(FetchArtifacts{
-        .fetcher_config_path = config_path,
-        .builds = target.builds,
-    });
-    LOG(INFO) << "Completed target fetch to '" << target.directories.root
-              << "' (" << count << " out of " << targets.size() << ")";
-    count++;
+      const std::string config_path =
+          CF_EXPECT(SaveConfig(config, target.directories.root));
+      fetch_result.fetch_artifacts[i] = FetchArtifacts{
+          .fetcher_config_path = config_path,
+          .builds = target.builds,
+      };
+      LOG(INFO) << "Completed target fetch to '" << target.directories.root
+                << "' (" << ++completed << " out of " << targets.size()
+                << ")";
+      return {};
+    };
+    target_fetches.Add(fmt::format("Fetch to '{}'", target.directories.root),
+                       std::move(fetch));
   }
+  CF_EXPECT(target_fetches.Run(
+      std::max<size_t>(flags.build_api_flags.download_connections, 1)));
   VLOG(0) << "Waiting for host package fetch";
   CF_EXPECT(host_package_future.get());
   VLOG(0) << "Performance stats:\n" << tracer.ToStyledString();
@@ -136,9 +136,14 @@ InstanceManager::AllocateAndLockInstanceIds(
           CF_EXPECT(lock_manager_.AcquireLock(id)));
     }
   }
+  // The rest get consecutive ids, reserved in one go
+  std::vector<InstanceLockFile> unused_lock_files =
+      CF_EXPECT(lock_manager_.AcquireUnusedLocks(
+          instances.size() - requested_lock_files.size()));
   std::vector<InternalInstanceDesc> ret;
   ret.reserve(instances.size());
   auto requested_it = requested_lock_files.begin();
+  auto unused_it = unused_lock_files.begin();
   for (auto& instance : instances) {
     if (instance.instance_id.has_value()) {
       CF_EXPECT(requested_it != requested_lock_files.end());
@@ -148,10 +153,12 @@ InstanceManager::AllocateAndLockInstanceIds(
       });
       ++requested_it;
     } else {
+      CF_EXPECT(unused_it != unused_lock_files.end());
       ret.emplace_back(InternalInstanceDesc{
-          .lock_file = CF_EXPECT(lock_manager_.AcquireUnusedLock()),
+          .lock_file = std::move(*unused_it),
           .name = std::move(instance.per_instance_name),
       });
+      ++unused_it;
     }
   }
   return ret;
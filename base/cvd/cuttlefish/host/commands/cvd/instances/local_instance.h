@@ -77,12 +77,14 @@ class LocalInstance {
   // Return list of filenames of instance-level log files.
   Result<std::vector<std::string>> LogsFilenames() const;
 
+  // Connects to run_cvd's monitor socket, waiting at most timeout seconds.
+  Result<SharedFD> GetLauncherMonitor(std::chrono::seconds timeout) const;
+
  private:
   LocalInstance(std::shared_ptr<cvd::InstanceGroup> group_proto,
                 cvd::Instance* instance_proto);
 
   std::string config_file_path() const;
-  Result<SharedFD> GetLauncherMonitor(std::chrono::seconds timeout) const;
   Result<Json::Value> ReadJsonConfig() const;
   Result<const CuttlefishConfig*> LoadConfig();
   Result<const CuttlefishConfig::InstanceSpecific> GetInstanceConfig();
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <future>
 #include <iterator>
 #include <set>
 #include <string>
@@ -225,10 +226,18 @@ std::vector<std::string> LocalInstanceGroup::GroupLogBasenames() {
 
 Result<Json::Value> LocalInstanceGroup::FetchStatus(
     std::chrono::seconds timeout) {
-  Json::Value instances_json(Json::arrayValue);
+  // Instances are queried concurrently, so unresponsive ones don't add up
+  // their timeouts.
+  std::vector<std::future<Result<Json::Value>>> statuses;
   for (auto& instance : Instances()) {
-    auto instance_status_json = CF_EXPECT(instance.FetchStatus(timeout));
-    instances_json.append(instance_status_json);
+    statuses.emplace_back(
+        std::async(std::launch::async, [&instance, timeout]() {
+          return instance.FetchStatus(timeout);
+        }));
+  }
+  Json::Value instances_json(Json::arrayValue);
+  for (auto& status : statuses) {
+    instances_json.append(CF_EXPECT(status.get()));
   }
   Json::Value group_json;
   group_json["group_name"] = GroupName();
@@ -16,23 +16,46 @@
 
 #include "cuttlefish/host/commands/cvd/instances/lock/instance_lock.h"
 
+#include <fcntl.h>
+#include <stdint.h>
 #include <sys/file.h>
+#include <sys/stat.h>
 
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "absl/log/log.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/strip.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/files/directory_contents.h"
+#include "cuttlefish/host/commands/cvd/instances/lock/instance_number_map.h"
 #include "cuttlefish/posix/remove.h"
 #include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
+namespace {
+
+constexpr std::string_view kLockFilePrefix = "local-instance-";
+constexpr std::string_view kLockFileSuffix = ".lock";
+constexpr char kNumberMapName[] = "instance_numbers.map";
 
-InstanceLockFile::InstanceLockFile(LockFile&& lock_file,
-                                   const unsigned instance_num)
-    : lock_file_(std::move(lock_file)), instance_num_(instance_num) {}
+}  // namespace
+
+InstanceLockFile::InstanceLockFile(
+    LockFile&& lock_file, const unsigned instance_num,
+    std::shared_ptr<InstanceNumberMap> number_map)
+    : lock_file_(std::move(lock_file)),
+      instance_num_(instance_num),
+      number_map_(std::move(number_map)) {}
 
 unsigned InstanceLockFile::Instance() const { return instance_num_; }
 
@@ -43,6 +66,16 @@ Result<InUseState> InstanceLockFile::Status() const {
 
 Result<void> InstanceLockFile::Status(InUseState state) {
   CF_EXPECT(lock_file_.Status(state));
+  if (!number_map_) {
+    return {};
+  }
+  // The lock file was updated, so a stale map only costs an extra lookup.
+  Result<InstanceNumberMap::Locked> map = number_map_->Lock();
+  if (!map.has_value()) {
+    LOG(WARNING) << "Failed to update instance number map: " << map.error();
+    return {};
+  }
+  map->SetInUse(instance_num_, state == InUseState::kInUse);
   return {};
 }
 
@@ -55,23 +88,82 @@ Result<std::string> InstanceLockFileManager::LockFilePath(
   std::stringstream path;
   path << instance_locks_path_;
   CF_EXPECT(EnsureDirectoryExists(path.str()));
-  path << "local-instance-" << instance_num << ".lock";
+  path << kLockFilePrefix << instance_num << kLockFileSuffix;
   return path.str();
 }
 
 Result<void> InstanceLockFileManager::RemoveLockFile(unsigned instance_num) {
   const auto lock_file_path = CF_EXPECT(LockFilePath(instance_num));
+  Result<InstanceNumberMap::Locked> map = LockNumberMap();
   CF_EXPECT(RemoveFile(lock_file_path), StrError(errno));
+  if (!map.has_value()) {
+    LOG(WARNING) << "Failed to update instance number map: " << map.error();
+    return {};
+  }
+  map->SetInUse(instance_num, false);
+  map->Stamp(CF_EXPECT(LockDirectoryStamp()));
   return {};
 }
 
 Result<InstanceLockFile> InstanceLockFileManager::AcquireUnusedLock() {
-  for (unsigned i = 1;; i++) {
-    auto lock = CF_EXPECT(TryAcquireLock(i));
+  std::vector<InstanceLockFile> locks = CF_EXPECT(AcquireUnusedLocks(1));
+  CF_EXPECT_EQ(locks.size(), 1u);
+  return std::move(locks.front());
+}
+
+Result<std::vector<InstanceLockFile>>
+InstanceLockFileManager::AcquireUnusedLocks(unsigned count) {
+  if (count == 0) {
+    return {};
+  }
+  Result<InstanceNumberMap::Locked> map = LockNumberMap();
+  if (!map.has_value()) {
+    LOG(WARNING) << "Scanning the instance lock files, the instance number "
+                 << "map is unavailable: " << map.error();
+    return CF_EXPECT(ScanForUnusedLocks(1, count));
+  }
+
+  std::vector<InstanceLockFile> locks;
+  unsigned start = 1;
+  while (locks.size() < count) {
+    std::optional<unsigned> first = map->FindFree(start, count);
+    if (!first) {
+      return CF_EXPECT(
+          ScanForUnusedLocks(InstanceNumberMap::kCapacity + 1, count));
+    }
+    locks.clear();
+    for (unsigned num = *first; num < *first + count; num++) {
+      std::optional<InstanceLockFile> lock = CF_EXPECT(TryAcquireLock(num));
+      if (!lock) {
+        // Another cvd process is still setting this instance up.
+        break;
+      }
+      if (CF_EXPECT(lock->Status()) == InUseState::kInUse) {
+        // Taken by a cvd version that doesn't update the map.
+        map->SetInUse(num, true);
+        break;
+      }
+      locks.emplace_back(std::move(*lock));
+    }
+    start = *first + locks.size() + 1;
+  }
+  // Lock files may have been created for numbers never used before.
+  map->Stamp(CF_EXPECT(LockDirectoryStamp()));
+  return locks;
+}
+
+Result<std::vector<InstanceLockFile>>
+InstanceLockFileManager::ScanForUnusedLocks(unsigned start, unsigned count) {
+  std::vector<InstanceLockFile> locks;
+  for (unsigned num = start; locks.size() < count; num++) {
+    std::optional<InstanceLockFile> lock = CF_EXPECT(TryAcquireLock(num));
     if (lock && CF_EXPECT(lock->Status()) == InUseState::kNotInUse) {
-      return *lock;
+      locks.emplace_back(std::move(*lock));
+    } else {
+      locks.clear();
     }
   }
+  return locks;
 }
 
 Result<InstanceLockFile> InstanceLockFileManager::AcquireLock(
@@ -79,7 +171,7 @@ Result<InstanceLockFile> InstanceLockFileManager::AcquireLock(
   const auto lock_file_path = CF_EXPECT(LockFilePath(instance_num));
   LockFile lock_file =
       CF_EXPECT(lock_file_manager_.AcquireLock(lock_file_path));
-  return InstanceLockFile(std::move(lock_file), instance_num);
+  return InstanceLockFile(std::move(lock_file), instance_num, number_map_);
 }
 
 Result<std::optional<InstanceLockFile>> InstanceLockFileManager::TryAcquireLock(
@@ -90,7 +182,55 @@ Result<std::optional<InstanceLockFile>> InstanceLockFileManager::TryAcquireLock(
   if (!lock_file_opt) {
     return std::nullopt;
   }
-  return InstanceLockFile(std::move(*lock_file_opt), instance_num);
+  return InstanceLockFile(std::move(*lock_file_opt), instance_num,
+                          number_map_);
+}
+
+Result<InstanceNumberMap::Locked> InstanceLockFileManager::LockNumberMap() {
+  if (!number_map_) {
+    CF_EXPECT(EnsureDirectoryExists(instance_locks_path_));
+    number_map_ = CF_EXPECT(
+        InstanceNumberMap::Open(instance_locks_path_ + kNumberMapName));
+  }
+  InstanceNumberMap::Locked map = CF_EXPECT(number_map_->Lock());
+  int64_t stamp = CF_EXPECT(LockDirectoryStamp());
+  if (!map.Valid() || map.Stamp() != stamp) {
+    CF_EXPECT(RebuildNumberMap(map));
+    map.Stamp(stamp);
+  }
+  return map;
+}
+
+Result<void> InstanceLockFileManager::RebuildNumberMap(
+    InstanceNumberMap::Locked& map) {
+  VLOG(1) << "Rebuilding the instance number map from " << instance_locks_path_;
+  map.Reset();
+  for (const std::string& name :
+       CF_EXPECT(DirectoryContents(instance_locks_path_))) {
+    std::string_view num_str = name;
+    unsigned num = 0;
+    if (!absl::ConsumePrefix(&num_str, kLockFilePrefix) ||
+        !absl::ConsumeSuffix(&num_str, kLockFileSuffix) ||
+        !absl::SimpleAtoi(num_str, &num)) {
+      continue;
+    }
+    SharedFD fd = SharedFD::Open(instance_locks_path_ + name, O_RDONLY);
+    char state = static_cast<char>(InUseState::kNotInUse);
+    if (fd->IsOpen() && fd->Read(&state, 1).has_value() &&
+        state == static_cast<char>(InUseState::kInUse)) {
+      map.SetInUse(num, true);
+    }
+  }
+  return {};
+}
+
+// Creating or removing lock files updates the modification time of the
+// directory.
+Result<int64_t> InstanceLockFileManager::LockDirectoryStamp() {
+  struct stat st;
+  CF_EXPECTF(stat(instance_locks_path_.c_str(), &st) == 0,
+             "stat(\"{}\"): {}", instance_locks_path_, StrError(errno));
+  return int64_t{st.st_mtim.tv_sec} * 1000000000 + st.st_mtim.tv_nsec;
 }
 
 }  // namespace cuttlefish
@@ -15,9 +15,14 @@
  */
 #pragma once
 
+#include <stdint.h>
+
+#include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
+#include "cuttlefish/host/commands/cvd/instances/lock/instance_number_map.h"
 #include "cuttlefish/host/commands/cvd/instances/lock/lock_file.h"
 
 namespace cuttlefish {
@@ -32,9 +37,11 @@ class InstanceLockFile {
   Result<void> Status(InUseState);
 
  private:
-  InstanceLockFile(LockFile&& lock_file, unsigned instance_num);
+  InstanceLockFile(LockFile&& lock_file, unsigned instance_num,
+                   std::shared_ptr<InstanceNumberMap> number_map);
   LockFile lock_file_;
   const unsigned instance_num_;
+  std::shared_ptr<InstanceNumberMap> number_map_;
 };
 
 class InstanceLockFileManager {
@@ -43,6 +50,8 @@ class InstanceLockFileManager {
 
   Result<InstanceLockFile> AcquireLock(unsigned instance_num);
   Result<InstanceLockFile> AcquireUnusedLock();
+  // Acquires the locks of `count` consecutive instance numbers not in use.
+  Result<std::vector<InstanceLockFile>> AcquireUnusedLocks(unsigned count);
 
   // TODO: This routine should  be removed and replaced with allocd
   // The caller must check if the instance_num belongs to the user, before
@@ -52,9 +61,18 @@ class InstanceLockFileManager {
  private:
   Result<std::string> LockFilePath(unsigned instance_num);
   Result<std::optional<InstanceLockFile>> TryAcquireLock(unsigned instance_num);
+  Result<std::vector<InstanceLockFile>> ScanForUnusedLocks(unsigned start,
+                                                           unsigned count);
+
+  // The number map is rebuilt from the lock files when the lock directory
+  // was modified by anything else than this class, e.g. older cvd versions.
+  Result<InstanceNumberMap::Locked> LockNumberMap();
+  Result<void> RebuildNumberMap(InstanceNumberMap::Locked& map);
+  Result<int64_t> LockDirectoryStamp();
 
   std::string instance_locks_path_;
   LockFileManager lock_file_manager_;
+  std::shared_ptr<InstanceNumberMap> number_map_;
 };
 
 }  // namespace cuttlefish
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Allocates instance numbers from many threads at once, the way parallel
+// `cvd create` invocations do, on a host where `--instances_in_use` numbers
+// are already taken. Compares the instance number map with the linear scan
+// over the lock files it replaced.
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "android-base/file.h"
+#include "fmt/format.h"
+
+#include "cuttlefish/files/recursively_remove_directory.h"
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/host/commands/cvd/instances/lock/instance_lock.h"
+#include "cuttlefish/host/commands/cvd/instances/lock/lock_file.h"
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Returns the allocated instance number.
+using Allocator = std::function<Result<unsigned>(const std::string& dir)>;
+
+Result<unsigned> LinearScan(const std::string& dir) {
+  LockFileManager manager;
+  for (unsigned i = 1;; i++) {
+    std::string path = fmt::format("{}local-instance-{}.lock", dir, i);
+    std::optional<LockFile> lock = CF_EXPECT(manager.TryAcquireLock(path));
+    if (lock && CF_EXPECT(lock->Status()) == InUseState::kNotInUse) {
+      CF_EXPECT(lock->Status(InUseState::kInUse));
+      return i;
+    }
+  }
+}
+
+Result<unsigned> NumberMap(const std::string& dir) {
+  InstanceLockFileManager manager(dir);
+  InstanceLockFile lock = CF_EXPECT(manager.AcquireUnusedLock());
+  CF_EXPECT(lock.Status(InUseState::kInUse));
+  return lock.Instance();
+}
+
+Result<void> Run(const std::string& name, const Allocator& allocate,
+                 size_t instances_in_use, size_t parallel) {
+  std::string dir = TempDir() + "/instance_lock_benchmark.XXXXXX";
+  CF_EXPECTF(mkdtemp(dir.data()) != nullptr, "mkdtemp(\"{}\"): {}", dir,
+             StrError(errno));
+  dir += "/";
+  for (size_t i = 1; i <= instances_in_use; i++) {
+    std::string path = fmt::format("{}local-instance-{}.lock", dir, i);
+    CF_EXPECT(android::base::WriteStringToFile("I", path));
+  }
+  // Warms up the lock directory, and builds the number map outside of the
+  // measurement.
+  CF_EXPECT(NumberMap(dir));
+
+  std::vector<std::chrono::nanoseconds> latencies(parallel);
+  std::vector<std::optional<Result<unsigned>>> results(parallel);
+  std::latch start(parallel + 1);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < parallel; i++) {
+    threads.emplace_back([&, i]() {
+      start.arrive_and_wait();
+      Clock::time_point begin = Clock::now();
+      results[i] = allocate(dir);
+      latencies[i] = Clock::now() - begin;
+    });
+  }
+  Clock::time_point begin = Clock::now();
+  start.arrive_and_wait();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  std::chrono::nanoseconds total = Clock::now() - begin;
+
+  CF_EXPECT(RecursivelyRemoveDirectory(dir));
+  for (std::optional<Result<unsigned>>& result : results) {
+    CF_EXPECT(std::move(*result));
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto millis = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+  std::cout << name << ": total " << millis(total) << "ms, median "
+            << millis(latencies[parallel / 2]) << "ms, max "
+            << millis(latencies.back()) << "ms\n";
+  return {};
+}
+
+Result<void> InstanceLockBenchmarkMain(int argc, char** argv) {
+  size_t instances_in_use = 500;
+  size_t parallel = 16;
+  std::vector<Flag> flags;
+  flags.emplace_back(
+      GflagsCompatFlag("instances_in_use", instances_in_use)
+          .Help("How many instance numbers are taken before measuring."));
+  flags.emplace_back(GflagsCompatFlag("parallel", parallel)
+                         .Help("How many allocations run concurrently."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(parallel, 0u);
+
+  std::cout << parallel << " concurrent allocations with " << instances_in_use
+            << " instances in use\n";
+  CF_EXPECT(Run("linear scan", LinearScan, instances_in_use, parallel));
+  CF_EXPECT(Run("number map", NumberMap, instances_in_use, parallel));
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::InstanceLockBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
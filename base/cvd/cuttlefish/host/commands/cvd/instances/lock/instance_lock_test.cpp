@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/cvd/instances/lock/instance_lock.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/host/commands/cvd/instances/lock/instance_number_map.h"
+#include "cuttlefish/host/commands/cvd/instances/lock/lock_file.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+std::vector<unsigned> Instances(const std::vector<InstanceLockFile>& locks) {
+  std::vector<unsigned> instances;
+  for (const InstanceLockFile& lock : locks) {
+    instances.push_back(lock.Instance());
+  }
+  return instances;
+}
+
+class InstanceLockTest : public testing::Test {
+ protected:
+  std::string LocksPath() const { return std::string(temp_dir_.path) + "/"; }
+
+  TemporaryDir temp_dir_;
+};
+
+TEST_F(InstanceLockTest, AcquiresLowestUnusedNumber) {
+  InstanceLockFileManager manager(LocksPath());
+
+  Result<InstanceLockFile> first = manager.AcquireUnusedLock();
+  ASSERT_THAT(first, IsOk());
+  EXPECT_EQ(first->Instance(), 1u);
+  ASSERT_THAT(first->Status(InUseState::kInUse), IsOk());
+
+  {
+    // Not marked in use, but still locked.
+    Result<InstanceLockFile> second = manager.AcquireUnusedLock();
+    ASSERT_THAT(second, IsOk());
+    EXPECT_EQ(second->Instance(), 2u);
+    Result<InstanceLockFile> third = manager.AcquireUnusedLock();
+    ASSERT_THAT(third, IsOk());
+    EXPECT_EQ(third->Instance(), 3u);
+  }
+
+  Result<InstanceLockFile> again = manager.AcquireUnusedLock();
+  ASSERT_THAT(again, IsOk());
+  EXPECT_EQ(again->Instance(), 2u);
+}
+
+TEST_F(InstanceLockTest, ReservesConsecutiveNumbers) {
+  InstanceLockFileManager manager(LocksPath());
+  for (unsigned instance_num : {1u, 3u}) {
+    Result<InstanceLockFile> lock = manager.AcquireLock(instance_num);
+    ASSERT_THAT(lock, IsOk());
+    ASSERT_THAT(lock->Status(InUseState::kInUse), IsOk());
+  }
+
+  Result<std::vector<InstanceLockFile>> locks = manager.AcquireUnusedLocks(3);
+  ASSERT_THAT(locks, IsOk());
+  EXPECT_THAT(Instances(*locks), testing::ElementsAre(4u, 5u, 6u));
+
+  Result<InstanceLockFile> lock = manager.AcquireUnusedLock();
+  ASSERT_THAT(lock, IsOk());
+  EXPECT_EQ(lock->Instance(), 2u);
+}
+
+TEST_F(InstanceLockTest, SharesStateBetweenManagers) {
+  InstanceLockFileManager first_manager(LocksPath());
+  InstanceLockFileManager second_manager(LocksPath());
+
+  Result<InstanceLockFile> lock = first_manager.AcquireUnusedLock();
+  ASSERT_THAT(lock, IsOk());
+  ASSERT_THAT(lock->Status(InUseState::kInUse), IsOk());
+  Result<InstanceLockFile> other = second_manager.AcquireUnusedLock();
+  ASSERT_THAT(other, IsOk());
+  EXPECT_EQ(other->Instance(), 2u);
+}
+
+TEST_F(InstanceLockTest, ReusesRemovedNumbers) {
+  InstanceLockFileManager manager(LocksPath());
+  {
+    Result<std::vector<InstanceLockFile>> locks = manager.AcquireUnusedLocks(2);
+    ASSERT_THAT(locks, IsOk());
+    for (InstanceLockFile& lock : *locks) {
+      ASSERT_THAT(lock.Status(InUseState::kInUse), IsOk());
+    }
+  }
+  ASSERT_THAT(manager.RemoveLockFile(1), IsOk());
+
+  Result<InstanceLockFile> lock = manager.AcquireUnusedLock();
+  ASSERT_THAT(lock, IsOk());
+  EXPECT_EQ(lock->Instance(), 1u);
+}
+
+TEST_F(InstanceLockTest, SkipsNumbersMarkedOnlyInLockFiles) {
+  // As left behind by a cvd version that doesn't know about the map.
+  ASSERT_TRUE(android::base::WriteStringToFile(
+      "I", LocksPath() + "local-instance-1.lock"));
+  InstanceLockFileManager manager(LocksPath());
+
+  Result<InstanceLockFile> lock = manager.AcquireUnusedLock();
+  ASSERT_THAT(lock, IsOk());
+  EXPECT_EQ(lock->Instance(), 2u);
+}
+
+TEST_F(InstanceLockTest, NumberMapFindsRunsAcrossWords) {
+  Result<std::unique_ptr<InstanceNumberMap>> number_map =
+      InstanceNumberMap::Open(LocksPath() + "map");
+  ASSERT_THAT(number_map, IsOk());
+  Result<InstanceNumberMap::Locked> map = (*number_map)->Lock();
+  ASSERT_THAT(map, IsOk());
+  EXPECT_FALSE(map->Valid());
+  map->Reset();
+  ASSERT_TRUE(map->Valid());
+
+  for (unsigned instance_num = 1; instance_num <= 64; instance_num++) {
+    map->SetInUse(instance_num, true);
+  }
+  map->SetInUse(66, true);
+  EXPECT_EQ(map->FindFree(1, 1), 65u);
+  EXPECT_EQ(map->FindFree(1, 2), 67u);
+  EXPECT_EQ(map->FindFree(100, 1), 100u);
+  EXPECT_EQ(map->FindFree(InstanceNumberMap::kCapacity, 2), std::nullopt);
+
+  map->SetInUse(10, false);
+  EXPECT_EQ(map->FindFree(1, 1), 10u);
+}
+
+}  // namespace
+}  // namespace cuttlefish
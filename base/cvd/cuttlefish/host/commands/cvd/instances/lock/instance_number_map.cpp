@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/cvd/instances/lock/instance_number_map.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/log/log.h"
+
+#include "cuttlefish/common/libs/fs/scoped_mmap.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x41494643;  // "CFIA"
+constexpr uint32_t kVersion = 1;
+constexpr unsigned kBitsPerWord = 64;
+
+}  // namespace
+
+struct InstanceNumberMap::Layout {
+  uint32_t magic;
+  uint32_t version;
+  // No number below this one is free.
+  uint32_t first_free;
+  uint32_t reserved;
+  int64_t stamp;
+  uint64_t words[kCapacity / kBitsPerWord];
+};
+
+InstanceNumberMap::Locked::Locked(InstanceNumberMap& map) : map_(&map) {}
+
+InstanceNumberMap::Locked::Locked(Locked&& other)
+    : map_(std::exchange(other.map_, nullptr)) {}
+
+InstanceNumberMap::Locked::~Locked() {
+  if (!map_) {
+    return;
+  }
+  Result<void> unlock_result = map_->fd_->Flock(LOCK_UN);
+  if (!unlock_result.has_value()) {
+    LOG(ERROR) << "Failed to unlock instance number map: "
+               << unlock_result.error();
+  }
+}
+
+bool InstanceNumberMap::Locked::Valid() const {
+  const Layout& layout = map_->layout();
+  return layout.magic == kMagic && layout.version == kVersion &&
+         layout.first_free >= 1;
+}
+
+void InstanceNumberMap::Locked::Reset() {
+  Layout& layout = map_->layout();
+  memset(&layout, 0, sizeof(layout));
+  layout.magic = kMagic;
+  layout.version = kVersion;
+  layout.first_free = 1;
+}
+
+bool InstanceNumberMap::Locked::InUse(unsigned instance_num) const {
+  if (instance_num < 1 || instance_num > kCapacity) {
+    return false;
+  }
+  unsigned index = instance_num - 1;
+  uint64_t word = map_->layout().words[index / kBitsPerWord];
+  return (word >> (index % kBitsPerWord)) & 1;
+}
+
+void InstanceNumberMap::Locked::SetInUse(unsigned instance_num, bool in_use) {
+  if (instance_num < 1 || instance_num > kCapacity) {
+    return;
+  }
+  Layout& layout = map_->layout();
+  unsigned index = instance_num - 1;
+  uint64_t bit = uint64_t{1} << (index % kBitsPerWord);
+  if (in_use) {
+    layout.words[index / kBitsPerWord] |= bit;
+    while (layout.first_free <= kCapacity && InUse(layout.first_free)) {
+      layout.first_free++;
+    }
+  } else {
+    layout.words[index / kBitsPerWord] &= ~bit;
+    layout.first_free = std::min<uint32_t>(layout.first_free, instance_num);
+  }
+}
+
+std::optional<unsigned> InstanceNumberMap::Locked::FindFree(
+    unsigned start, unsigned count) const {
+  const Layout& layout = map_->layout();
+  unsigned run = 0;
+  unsigned instance_num = std::max({start, layout.first_free, 1u});
+  while (instance_num <= kCapacity) {
+    if (run == 0) {
+      // Skips straight to the next free number, a word at a time.
+      unsigned index = instance_num - 1;
+      uint64_t free_bits =
+          ~layout.words[index / kBitsPerWord] >> (index % kBitsPerWord);
+      if (free_bits == 0) {
+        instance_num += kBitsPerWord - index % kBitsPerWord;
+        continue;
+      }
+      instance_num += std::countr_zero(free_bits);
+      if (instance_num > kCapacity) {
+        break;
+      }
+      run = 1;
+    } else if (InUse(instance_num)) {
+      run = 0;
+      instance_num++;
+      continue;
+    } else {
+      run++;
+    }
+    if (run == count) {
+      return instance_num - count + 1;
+    }
+    instance_num++;
+  }
+  return std::nullopt;
+}
+
+int64_t InstanceNumberMap::Locked::Stamp() const {
+  return map_->layout().stamp;
+}
+
+void InstanceNumberMap::Locked::Stamp(int64_t stamp) {
+  map_->layout().stamp = stamp;
+}
+
+Result<std::unique_ptr<InstanceNumberMap>> InstanceNumberMap::Open(
+    const std::string& path) {
+  SharedFD fd = SharedFD::Open(path, O_CREAT | O_RDWR | O_CLOEXEC, 0666);
+  CF_EXPECTF(fd->IsOpen(), "open(\"{}\"): {}", path, fd->StrError());
+  // Shared with the other users of the host, like the lock files.
+  if (!fd->Chmod(0666)) {
+    VLOG(0) << "failed: chmod 666 " << path;
+  }
+  off_t size = fd->LSeek(0, SEEK_END);
+  CF_EXPECTF(size >= 0, "lseek(\"{}\"): {}", path, fd->StrError());
+  if (static_cast<size_t>(size) < sizeof(Layout)) {
+    // Zero filled, which reads as invalid until the first user resets it.
+    CF_EXPECT(fd->Truncate(sizeof(Layout)));
+  }
+  ScopedMMap mapping = fd->MMap(nullptr, sizeof(Layout),
+                                PROT_READ | PROT_WRITE, MAP_SHARED, 0);
+  CF_EXPECTF(!!mapping, "mmap(\"{}\"): {}", path, fd->StrError());
+  return std::unique_ptr<InstanceNumberMap>(
+      new InstanceNumberMap(std::move(fd), std::move(mapping)));
+}
+
+InstanceNumberMap::InstanceNumberMap(SharedFD fd, ScopedMMap mapping)
+    : fd_(std::move(fd)), mapping_(std::move(mapping)) {}
+
+Result<InstanceNumberMap::Locked> InstanceNumberMap::Lock() {
+  CF_EXPECT(fd_->Flock(LOCK_EX));
+  return Locked(*this);
+}
+
+InstanceNumberMap::Layout& InstanceNumberMap::layout() {
+  return *static_cast<Layout*>(mapping_.get());
+}
+
+const InstanceNumberMap::Layout& InstanceNumberMap::layout() const {
+  return *static_cast<const Layout*>(mapping_.get());
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "cuttlefish/common/libs/fs/scoped_mmap.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+// A bitmap of the instance numbers in use, in a memory-mapped file shared by
+// every cvd process on the host. It only caches the "in use" state of the
+// instance lock files so free numbers can be found without opening them; the
+// lock files stay authoritative.
+class InstanceNumberMap {
+ public:
+  // Instance numbers 1 to kCapacity are tracked.
+  static constexpr unsigned kCapacity = 4096;
+
+  // Exclusive access to the map, released on destruction.
+  class Locked {
+    friend class InstanceNumberMap;
+
+   public:
+    Locked(Locked&&);
+    ~Locked();
+
+    // False for a new or unrecognized file, which must be rebuilt.
+    bool Valid() const;
+    // Clears every number and marks the map valid.
+    void Reset();
+
+    bool InUse(unsigned instance_num) const;
+    void SetInUse(unsigned instance_num, bool in_use);
+
+    // The lowest run of `count` numbers, all at least `start`, that are not
+    // in use.
+    std::optional<unsigned> FindFree(unsigned start, unsigned count) const;
+
+    // Opaque value identifying the last state of the lock directory the map
+    // was synchronized with.
+    int64_t Stamp() const;
+    void Stamp(int64_t stamp);
+
+   private:
+    Locked(InstanceNumberMap& map);
+
+    InstanceNumberMap* map_;
+  };
+
+  static Result<std::unique_ptr<InstanceNumberMap>> Open(
+      const std::string& path);
+
+  Result<Locked> Lock();
+
+ private:
+  struct Layout;
+
+  InstanceNumberMap(SharedFD fd, ScopedMMap mapping);
+
+  Layout& layout();
+  const Layout& layout() const;
+
+  SharedFD fd_;
+  ScopedMMap mapping_;
+};
+
+}  // namespace cuttlefish
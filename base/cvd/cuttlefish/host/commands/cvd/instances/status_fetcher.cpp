@@ -28,12 +28,15 @@
 #include "fmt/core.h"
 #include "json/value.h"
 
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/utils/files.h"
 #include "cuttlefish/common/libs/utils/gflags_xml_parser.h"
 #include "cuttlefish/common/libs/utils/json.h"
 #include "cuttlefish/host/commands/cvd/cli/commands/host_tool_target.h"
 #include "cuttlefish/host/commands/cvd/cli/utils.h"
 #include "cuttlefish/host/commands/cvd/instances/cvd_persistent_data.pb.h"
+#include "cuttlefish/host/libs/command_util/runner/run_cvd.pb.h"
+#include "cuttlefish/host/libs/command_util/util.h"
 #include "cuttlefish/host/libs/config/config_constants.h"
 #include "cuttlefish/process/command.h"
 #include "cuttlefish/process/managed_stdio.h"
@@ -74,22 +77,33 @@ Result<std::string> GetBin(const std::string& host_artifacts_path) {
   return CF_EXPECT(HostToolTarget(host_artifacts_path).GetStatusBinName());
 }
 
-}  // namespace
+// Turns "PREFIX_SOME_VALUE" into "Some Value".
+std::string HumanFriendlyEnumName(std::string name, std::string_view prefix) {
+  // Drop the enum name prefix
+  if (absl::StartsWith(name, prefix)) {
+    name = name.substr(prefix.size());
+  }
 
-Result<Json::Value> FetchInstanceStatus(LocalInstance& instance,
-                                        std::chrono::seconds timeout) {
-  // Only running instances are capable of responding to status requests. An
-  // unreachable instance is also considered running, it just didnt't reply last
-  // time.
-  if (instance.State() != cvd::INSTANCE_STATE_RUNNING &&
-      instance.State() != cvd::INSTANCE_STATE_UNREACHABLE) {
-    Json::Value instance_json;
-    instance_json["instance_name"] = instance.Name();
-    instance_json["status"] = HumanFriendlyStateName(instance.State());
-    OverrideInstanceJson(instance, instance_json);
-    return instance_json;
+  for (size_t i = 0; i < name.size(); ++i) {
+    // Replace underscores with spaces
+    if (name[i] == '_') {
+      name[i] = ' ';
+      continue;
+    }
+    // All characters but the first of each word should be lowercase
+    bool first = (i == 0 || name[i - 1] == ' ');
+    if (!first) {
+      name[i] = std::tolower(static_cast<unsigned char>(name[i]));
+    }
   }
 
+  return name;
+}
+
+// Runs the status tool from the instance's host artifacts, for launchers that
+// predate status queries over the monitor socket.
+Result<Json::Value> FetchInstanceStatusFromTool(LocalInstance& instance,
+                                                std::chrono::seconds timeout) {
   const auto working_dir = CurrentDirectory();
 
   auto android_host_out = instance.HostArtifactsPath();
@@ -172,28 +186,73 @@ Result<Json::Value> FetchInstanceStatus(LocalInstance& instance,
   return instance_status_json;
 }
 
-std::string HumanFriendlyStateName(cvd::InstanceState state) {
-  std::string name = cvd::InstanceState_Name(state);
-  // Drop the enum name prefix
-  std::string_view prefix = "INSTANCE_STATE_";
-  if (absl::StartsWith(name, prefix)) {
-    name = name.substr(prefix.size());
+}  // namespace
+
+Result<Json::Value> FetchInstanceStatus(LocalInstance& instance,
+                                        std::chrono::seconds timeout) {
+  // Only running instances are capable of responding to status requests. An
+  // unreachable instance is also considered running, it just didnt't reply last
+  // time.
+  if (instance.State() != cvd::INSTANCE_STATE_RUNNING &&
+      instance.State() != cvd::INSTANCE_STATE_UNREACHABLE) {
+    Json::Value instance_json;
+    instance_json["instance_name"] = instance.Name();
+    instance_json["status"] = HumanFriendlyStateName(instance.State());
+    OverrideInstanceJson(instance, instance_json);
+    return instance_json;
   }
 
-  for (size_t i = 0; i < name.size(); ++i) {
-    // Replace underscores with spaces
-    if (name[i] == '_') {
-      name[i] = ' ';
-      continue;
-    }
-    // All characters but the first of each word should be lowercase
-    bool first = (i == 0 || name[i - 1] == ' ');
-    if (!first) {
-      name[i] = std::tolower(static_cast<unsigned char>(name[i]));
-    }
+  Result<SharedFD> monitor = instance.GetLauncherMonitor(timeout);
+  if (!monitor.has_value()) {
+    // The status tool wouldn't get a response either.
+    LOG(WARNING) << "Instance " << instance.Name()
+                 << " is unreachable: " << monitor.error().Message();
+    instance.SetState(cvd::INSTANCE_STATE_UNREACHABLE);
+    Json::Value instance_json;
+    instance_json["warning"] = "cvd status failed";
+    OverrideInstanceJson(instance, instance_json);
+    return instance_json;
+  }
+  Result<run_cvd::InstanceStatus> status =
+      QueryLauncherStatus(*monitor, /* watch */ false, timeout.count());
+  if (status.has_value()) {
+    return InstanceStatusToJson(instance, *status);
   }
+  VLOG(0) << "Status query failed, running the status tool instead: "
+          << status.error().Message();
+  return CF_EXPECT(FetchInstanceStatusFromTool(instance, timeout));
+}
 
-  return name;
+Json::Value InstanceStatusToJson(const LocalInstance& instance,
+                                 const run_cvd::InstanceStatus& status) {
+  Json::Value instance_json;
+  instance_json["adb_serial"] = status.adb_serial();
+  instance_json["displays"] = Json::Value(Json::arrayValue);
+  for (const std::string& display : status.displays()) {
+    instance_json["displays"].append(display);
+  }
+  instance_json["device_state"] = HumanFriendlyEnumName(
+      run_cvd::InstanceStatus::DeviceState_Name(status.device_state()),
+      "DEVICE_STATE_");
+  instance_json["processes"] = Json::Value(Json::arrayValue);
+  for (const run_cvd::ProcessStatus& process : status.processes()) {
+    Json::Value process_json;
+    process_json["name"] = process.name();
+    process_json["state"] = HumanFriendlyEnumName(
+        run_cvd::ProcessStatus::State_Name(process.state()), "STATE_");
+    process_json["pid"] = process.pid();
+    process_json["restarts"] = process.restarts();
+    process_json["cpu_time_ms"] = Json::UInt64(process.cpu_time_ms());
+    process_json["rss_bytes"] = Json::UInt64(process.rss_bytes());
+    instance_json["processes"].append(process_json);
+  }
+  OverrideInstanceJson(instance, instance_json);
+  return instance_json;
+}
+
+std::string HumanFriendlyStateName(cvd::InstanceState state) {
+  return HumanFriendlyEnumName(cvd::InstanceState_Name(state),
+                               "INSTANCE_STATE_");
 }
 
 }  // namespace cuttlefish
@@ -22,15 +22,22 @@
 
 #include "cuttlefish/host/commands/cvd/instances/cvd_persistent_data.pb.h"
 #include "cuttlefish/host/commands/cvd/instances/local_instance.h"
+#include "cuttlefish/host/libs/command_util/runner/run_cvd.pb.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
 // Fetches status from a single instance. Waits for each run_cvd process to
-// respond within the given timeout.
+// respond within the given timeout. Launchers that don't answer status queries
+// on their monitor socket are asked through the status tool instead.
 Result<Json::Value> FetchInstanceStatus(LocalInstance& instance,
                                         std::chrono::seconds timeout);
 
+// Builds the same JSON object as FetchInstanceStatus from a status report
+// sent by run_cvd.
+Json::Value InstanceStatusToJson(const LocalInstance& instance,
+                                 const run_cvd::InstanceStatus& status);
+
 // The most important thing this function does is turn "INSTANCE_STATE_RUNNING"
 // into "Running". Some external tools (like the host orchestrator) already
 // depend on this string.
@@ -0,0 +1,239 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replays a kernel log through `KernelLogServer` and through the scan it
+// replaced, which read 256 bytes at a time and searched every line once per
+// pattern. The log is `--capture`, a kernel.log saved from a device, or else
+// `--size_mib` of generated boot noise with a stage marker every
+// `--marker_interval` lines.
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/log/globals.h"
+#include "absl/log/log.h"
+
+#include "cuttlefish/common/libs/fs/shared_buf.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/fs/shared_select.h"
+#include "cuttlefish/common/libs/utils/known_paths.h"
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/host/commands/kernel_log_monitor/kernel_log_server.h"
+#include "cuttlefish/host/libs/config/config_constants.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish::monitor {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The patterns KernelLogServer looks for, in the order of its tables.
+constexpr std::string_view kInformationalPatterns[] = {
+    "U-Boot ",
+    "] Linux version ",
+    "GUEST_BUILD_FINGERPRINT: ",
+};
+constexpr std::string_view kStages[] = {
+    kBootStartedMessage,
+    kBootPendingMessage,
+    kBootCompletedMessage,
+    kBootFailedMessage,
+    kMobileNetworkConnectedMessage,
+    kWifiConnectedMessage,
+    kEthernetConnectedMessage,
+    kAdbdStartedMessage,
+    kFastbootdStartedMessage,
+    kFastbootStartedMessage,
+    kGblFastbootStartedMessage,
+    kScreenChangedMessage,
+    kBootloaderLoadedMessage,
+    kKernelLoadedMessage,
+    kDisplayPowerModeChangedMessage,
+    kHibernationExitMessage,
+    kHibernationExitMessage,
+};
+
+constexpr std::string_view kNoise[] = {
+    "] virtio_blk virtio2: [vda] 4096 512-byte logical blocks (2.10 MB)\n",
+    "] init: starting service 'vendor.hwcomposer-3'...\n",
+    "] audit: type=1400 audit(1700000000.000:42): avc:  denied  { read } "
+    "for  comm=\"main\" name=\"u:object_r:default_prop:s0\" dev=\"tmpfs\"\n",
+    "] binder: 1234:1234 transaction failed 29189/-22, size 0-0 line 3137\n",
+};
+constexpr std::string_view kMarker =
+    "] VIRTUAL_DEVICE_SCREEN_CHANGED rotation=1 orientation=90\n";
+
+std::string GenerateCapture(size_t size_mib, size_t marker_interval) {
+  std::string capture;
+  capture.reserve((size_mib << 20) + 256);
+  for (size_t line = 0; capture.size() < (size_mib << 20); line++) {
+    capture += "[ " + std::to_string(line / 1000) + "." +
+               std::to_string(100000 + line % 1000);
+    if (marker_interval > 0 && line % marker_interval == marker_interval - 1) {
+      capture += kMarker;
+    } else {
+      capture += kNoise[line % std::size(kNoise)];
+    }
+  }
+  return capture;
+}
+
+// KernelLogServer::HandleIncomingMessage before the pattern matcher.
+size_t LegacyScan(SharedFD fd) {
+  size_t events = 0;
+  std::string line;
+  char buf[256];
+  while (true) {
+    Result<uint64_t> read = fd->Read(buf, sizeof(buf));
+    if (!read.has_value() || *read == 0) {
+      return events;
+    }
+    for (size_t i = 0; i < *read; i++) {
+      if (buf[i] == '\n') {
+        for (std::string_view pattern : kInformationalPatterns) {
+          if (line.find(pattern) != std::string::npos) {
+            LOG(INFO) << pattern;
+          }
+        }
+        for (std::string_view stage : kStages) {
+          events += line.find(stage) != std::string::npos ? 1 : 0;
+        }
+        line.clear();
+      }
+      line.append(1, buf[i]);
+    }
+  }
+}
+
+size_t ServerScan(SharedFD fd, size_t size) {
+  KernelLogServer server(fd, "/dev/null");
+  size_t events = 0;
+  server.SubscribeToEvents([&events](const KernelLogEvent&) {
+    events++;
+    return SubscriptionAction::ContinueSubscription;
+  });
+  SharedFDSet fd_read;
+  fd_read.Set(fd);
+  off_t offset = 0;
+  while (offset < static_cast<off_t>(size)) {
+    server.AfterSelect(fd_read);
+    const off_t next = fd->LSeek(0, SEEK_CUR);
+    if (next == offset) {
+      break;  // The read failed
+    }
+    offset = next;
+  }
+  return events;
+}
+
+Result<void> Report(const std::string& name, const std::string& path,
+                    size_t size, size_t iterations,
+                    const std::function<size_t(SharedFD)>& scan) {
+  std::vector<Clock::duration> samples;
+  size_t events = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    SharedFD fd = SharedFD::Open(path, O_RDONLY);
+    CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", path, fd->StrError());
+    Clock::time_point begin = Clock::now();
+    events = scan(fd);
+    samples.emplace_back(Clock::now() - begin);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  const double median_seconds =
+      std::chrono::duration<double>(samples[samples.size() / 2]).count();
+  std::cout << name << ": " << events << " events, median "
+            << median_seconds * 1000 << "ms, "
+            << size / median_seconds / (1 << 20) << " MiB/s\n";
+  return {};
+}
+
+Result<void> KernelLogBenchmarkMain(int argc, char** argv) {
+  std::string capture_path;
+  size_t size_mib = 64;
+  size_t marker_interval = 1000;
+  size_t iterations = 5;
+  std::vector<Flag> flags;
+  flags.emplace_back(GflagsCompatFlag("capture", capture_path)
+                         .Help("Kernel log to replay instead of noise."));
+  flags.emplace_back(GflagsCompatFlag("size_mib", size_mib)
+                         .Help("Size of the generated log in mebibytes."));
+  flags.emplace_back(
+      GflagsCompatFlag("marker_interval", marker_interval)
+          .Help("Lines per stage marker in the generated log, 0 for none."));
+  flags.emplace_back(GflagsCompatFlag("iterations", iterations)
+                         .Help("How many times to replay the log per method."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(iterations, 0u);
+  // Both scans log the markers they find at INFO, which is not measured.
+  absl::SetMinLogLevel(absl::LogSeverityAtLeast::kWarning);
+
+  std::string path = capture_path;
+  if (path.empty()) {
+    CF_EXPECT_GT(size_mib, 0u);
+    path = TempDir() + "/kernel_log_benchmark.log";
+    const std::string capture = GenerateCapture(size_mib, marker_interval);
+    SharedFD fd = SharedFD::Open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    CF_EXPECTF(fd->IsOpen(), "Failed to create '{}': {}", path,
+               fd->StrError());
+    CF_EXPECT_EQ(WriteAll(fd, capture), static_cast<ssize_t>(capture.size()),
+                 fd->StrError());
+  }
+  SharedFD fd = SharedFD::Open(path, O_RDONLY);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", path, fd->StrError());
+  const off_t size = fd->LSeek(0, SEEK_END);
+  CF_EXPECT_GT(size, 0, fd->StrError());
+
+  std::cout << "Replaying " << size << " bytes of " << path << " "
+            << iterations << " times per method\n";
+  Result<void> result = [&]() -> Result<void> {
+    CF_EXPECT(Report("256 byte reads, find per pattern", path, size,
+                     iterations, LegacyScan));
+    CF_EXPECT(Report("KernelLogServer", path, size, iterations,
+                     [size](SharedFD fd) { return ServerScan(fd, size); }));
+    return {};
+  }();
+  if (capture_path.empty()) {
+    unlink(path.c_str());
+  }
+  CF_EXPECT(std::move(result));
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish::monitor
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::monitor::KernelLogBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
@@ -21,17 +21,18 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 #include "absl/log/log.h"
-#include "absl/strings/ascii.h"
-#include "absl/strings/str_split.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/fs/shared_select.h"
+#include "cuttlefish/host/commands/kernel_log_monitor/multi_pattern_matcher.h"
 #include "cuttlefish/host/libs/config/config_constants.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 #include "cuttlefish/result/result_type.h"
@@ -79,7 +80,28 @@ constexpr struct {
     {kHibernationExitMessage, Event::AdbdStarted, kBare},
 };
 
-void ProcessSubscriptions(Json::Value message,
+// Large enough that a flood of guest kernel logs is consumed in a few reads.
+constexpr size_t kReadBufferSize = 64 * 1024;
+
+// Patterns are numbered with kInformationalPatterns first, then kStageTable.
+constexpr size_t kInformationalPatternCount =
+    std::size(kInformationalPatterns);
+
+const MultiPatternMatcher& LogMatcher() {
+  static const MultiPatternMatcher* matcher = [] {
+    std::vector<std::string_view> patterns;
+    for (const auto& informational : kInformationalPatterns) {
+      patterns.push_back(informational.match);
+    }
+    for (const auto& stage : kStageTable) {
+      patterns.push_back(stage.stage);
+    }
+    return new MultiPatternMatcher(patterns);
+  }();
+  return *matcher;
+}
+
+void ProcessSubscriptions(const KernelLogEvent& message,
                           std::vector<EventCallback>* subscribers) {
   auto active_subscription_count = subscribers->size();
   size_t idx = 0;
@@ -103,7 +125,10 @@ void ProcessSubscriptions(Json::Value message,
 KernelLogServer::KernelLogServer(SharedFD pipe_fd, const std::string& log_name)
     : pipe_fd_(pipe_fd),
       log_fd_(SharedFD::Open(log_name.c_str(), O_CREAT | O_RDWR | O_APPEND,
-                             0666)) {}
+                             0666)),
+      read_buffer_(kReadBufferSize),
+      matcher_(LogMatcher()),
+      match_pos_(matcher_.PatternCount(), std::string_view::npos) {}
 
 void KernelLogServer::BeforeSelect(SharedFDSet* fd_read) const {
   fd_read->Set(pipe_fd_);
@@ -120,9 +145,8 @@ void KernelLogServer::SubscribeToEvents(EventCallback callback) {
 }
 
 bool KernelLogServer::HandleIncomingMessage() {
-  const size_t buf_len = 256;
-  char buf[buf_len];
-  Result<uint64_t> ret = pipe_fd_->Read(buf, buf_len);
+  Result<uint64_t> ret =
+      pipe_fd_->Read(read_buffer_.data(), read_buffer_.size());
   if (!ret.has_value()) {
     LOG(ERROR) << "Could not read kernel logs: " << pipe_fd_->StrError();
     return false;
@@ -131,65 +155,79 @@ bool KernelLogServer::HandleIncomingMessage() {
     return false;
   }
   // Write the log to a file
-  if (!log_fd_->Write(buf, *ret).has_value()) {
+  if (!log_fd_->Write(read_buffer_.data(), *ret).has_value()) {
     LOG(ERROR) << "Could not write kernel log to file: " << log_fd_->StrError();
     return false;
   }
 
   // Detect VIRTUAL_DEVICE_BOOT_*
-  for (ssize_t i = 0; i < *ret; i++) {
-    if ('\n' == buf[i]) {
-      for (auto& [match, prefix] : kInformationalPatterns) {
-        auto pos = line_.find(match);
-        if (std::string::npos != pos) {
-          LOG(INFO) << prefix << line_.substr(pos + match.size());
-        }
-      }
-      for (const auto& [stage, event, format] : kStageTable) {
-        auto pos = line_.find(stage);
-        if (std::string::npos != pos) {
-          // Log the stage
-          if (format == kPrefix) {
-            LOG(INFO) << line_.substr(pos);
-          } else {
-            LOG(INFO) << stage;
-          }
+  ScanChunk(std::string_view(read_buffer_.data(), *ret));
+  return true;
+}
 
-          Json::Value message;
-          message["event"] = event;
-          Json::Value metadata;
-
-          if (format == kKeyValuePair) {
-            // Expect space-separated key=value pairs in the log message.
-            const std::vector<std::string> fields =
-                absl::StrSplit(line_.substr(pos + stage.size()), ' ');
-            for (std::string_view field : fields) {
-              field = absl::StripAsciiWhitespace(field);
-              if (field.empty()) {
-                // Expected; absl::StrSplit() always returns at least
-                // one (possibly empty) string.
-                VLOG(0) << "Empty field for line: " << line_;
-                continue;
-              }
-              const std::vector<std::string> keyvalue =
-                  absl::StrSplit(field, '=');
-              if (keyvalue.size() != 2) {
-                LOG(WARNING) << "Field is not in key=value format: " << field;
-                continue;
-              }
-              metadata[keyvalue[0]] = keyvalue[1];
-            }
+void KernelLogServer::ScanChunk(std::string_view chunk) {
+  while (!chunk.empty()) {
+    const size_t newline = chunk.find('\n');
+    const std::string_view segment = chunk.substr(0, newline);
+    // Matches are recorded as offsets in the whole line, which starts in
+    // `line_` when an earlier read split it.
+    const size_t line_offset = line_.size();
+    scan_state_ = matcher_.Scan(
+        scan_state_, segment, [this, line_offset](size_t pattern, size_t end) {
+          size_t& pos = match_pos_[pattern];
+          if (pos == std::string_view::npos) {
+            pos = line_offset + end - matcher_.PatternSize(pattern);
+            line_matched_ = true;
           }
-          message["metadata"] = metadata;
-          ProcessSubscriptions(message, &subscribers_);
-        }
+        });
+    if (newline == std::string_view::npos) {
+      line_.append(segment);
+      return;
+    }
+    chunk.remove_prefix(newline + 1);
+
+    if (line_matched_) {
+      if (line_.empty()) {
+        EmitLineEvents(segment);
+      } else {
+        line_.append(segment);
+        EmitLineEvents(line_);
       }
-      line_.clear();
+      std::fill(match_pos_.begin(), match_pos_.end(), std::string_view::npos);
+      line_matched_ = false;
     }
-    line_.append(1, buf[i]);
+    line_.clear();
+    scan_state_ = MultiPatternMatcher::kStart;
   }
+}
 
-  return true;
+void KernelLogServer::EmitLineEvents(std::string_view line) {
+  for (size_t i = 0; i < kInformationalPatternCount; i++) {
+    const size_t pos = match_pos_[i];
+    if (pos != std::string_view::npos) {
+      const auto& [match, prefix] = kInformationalPatterns[i];
+      LOG(INFO) << prefix << line.substr(pos + match.size());
+    }
+  }
+  for (size_t i = 0; i < std::size(kStageTable); i++) {
+    const size_t pos = match_pos_[kInformationalPatternCount + i];
+    if (pos == std::string_view::npos) {
+      continue;
+    }
+    const auto& [stage, event, format] = kStageTable[i];
+    // Log the stage
+    if (format == kPrefix) {
+      LOG(INFO) << line.substr(pos);
+    } else {
+      LOG(INFO) << stage;
+    }
+
+    KernelLogEvent message{.event = event};
+    if (format == kKeyValuePair) {
+      message.metadata = line.substr(pos + stage.size());
+    }
+    ProcessSubscriptions(message, &subscribers_);
+  }
 }
 
 }  // namespace cuttlefish::monitor
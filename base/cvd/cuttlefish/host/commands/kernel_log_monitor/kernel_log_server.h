@@ -19,12 +19,12 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
-#include "json/json.h"
-
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/fs/shared_select.h"
+#include "cuttlefish/host/commands/kernel_log_monitor/multi_pattern_matcher.h"
 
 namespace cuttlefish::monitor {
 
@@ -52,7 +52,16 @@ enum class SubscriptionAction {
   CancelSubscription,
 };
 
-using EventCallback = std::function<SubscriptionAction(Json::Value)>;
+// An event detected in the kernel log. Subscribers that forward it to other
+// processes convert it with `KernelLogEventToJson` from utils.h.
+struct KernelLogEvent {
+  Event event;
+  // The text following the stage marker, holding space-separated key=value
+  // pairs for events that carry metadata. Only valid during the callback.
+  std::string_view metadata;
+};
+
+using EventCallback = std::function<SubscriptionAction(const KernelLogEvent&)>;
 
 // KernelLogServer manages an incoming kernel log connection from the VMM.
 // Only accept one connection.
@@ -76,9 +85,21 @@ class KernelLogServer {
   // Respond to message from remote client.
   // Returns false, if client disconnected.
   bool HandleIncomingMessage();
+  // Feeds a chunk of the log through the pattern matcher, emitting events for
+  // every line it completes.
+  void ScanChunk(std::string_view chunk);
+  void EmitLineEvents(std::string_view line);
 
   SharedFD pipe_fd_;
   SharedFD log_fd_;
+  std::vector<char> read_buffer_;
+  const MultiPatternMatcher& matcher_;
+  // Matcher state and first match offset of each pattern in the current
+  // line, carried across reads that split a line.
+  MultiPatternMatcher::State scan_state_ = MultiPatternMatcher::kStart;
+  std::vector<size_t> match_pos_;
+  bool line_matched_ = false;
+  // The start of a line not yet terminated by the last read.
   std::string line_;
   std::vector<EventCallback> subscribers_;
 
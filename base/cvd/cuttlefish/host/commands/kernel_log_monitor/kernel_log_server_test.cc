@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/kernel_log_monitor/kernel_log_server.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "json/value.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/fs/shared_select.h"
+#include "cuttlefish/host/commands/kernel_log_monitor/utils.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish::monitor {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Abridged from a phone boot, with the lines that produce events kept and
+// enough surrounding noise to exercise the scanner between them.
+constexpr std::string_view kBootLog =
+    "U-Boot 2023.10 (Jan 01 2024 - 00:00:00 +0000)\n"
+    "[    0.000000] Booting Linux on physical CPU 0x0000000000 [0x000f0510]\n"
+    "[    0.000000] Linux version 6.6.0-android15 (build-user@build-host)\n"
+    "[    0.000000] Machine model: linux,dummy-virt\n"
+    "[    1.234567] init: starting service 'ueventd'...\n"
+    "[    2.345678] init: starting service 'adbd'...\n"
+    "[    3.456789] GUEST_BUILD_FINGERPRINT: generic/aosp/vsoc:15/user\n"
+    "[    4.567890] VIRTUAL_DEVICE_DISPLAY_POWER_MODE_CHANGED display=0 "
+    "mode=2\n"
+    "[    5.678901] VIRTUAL_DEVICE_NETWORK_WIFI_CONNECTED\n"
+    "[    6.789012] VIRTUAL_DEVICE_SCREEN_CHANGED rotation=1 orientation=90\n"
+    "[    7.890123] VIRTUAL_DEVICE_BOOT_COMPLETED\n"
+    "[    8.901234] unterminated VIRTUAL_DEVICE_BOOT_FAILED";
+
+std::string Capture() {
+  std::string capture;
+  for (int i = 0; i < 200; i++) {
+    capture +=
+        "[    0.100000] virtio_blk virtio2: [vda] 4096 512-byte logical "
+        "blocks (2.10 MB/2.00 MiB)\n";
+  }
+  return capture + std::string(kBootLog);
+}
+
+// Replays `capture` into a KernelLogServer, `chunk_size` bytes per read, and
+// returns the events as they would be sent to subscribers.
+std::vector<Json::Value> Replay(std::string_view capture, size_t chunk_size) {
+  SharedFD read_end;
+  SharedFD write_end;
+  EXPECT_TRUE(SharedFD::Pipe(&read_end, &write_end));
+  KernelLogServer server(read_end, "/dev/null");
+
+  std::vector<Json::Value> events;
+  server.SubscribeToEvents([&events](const KernelLogEvent& event) {
+    events.push_back(KernelLogEventToJson(event));
+    return SubscriptionAction::ContinueSubscription;
+  });
+
+  SharedFDSet fd_read;
+  fd_read.Set(read_end);
+  while (!capture.empty()) {
+    const size_t size = std::min(chunk_size, capture.size());
+    EXPECT_THAT(write_end->Write(capture.data(), size), IsOkAndValue(size));
+    capture.remove_prefix(size);
+    server.AfterSelect(fd_read);
+  }
+  return events;
+}
+
+std::vector<int> EventIds(const std::vector<Json::Value>& events) {
+  std::vector<int> ids;
+  for (const Json::Value& event : events) {
+    ids.push_back(event["event"].asInt());
+  }
+  return ids;
+}
+
+TEST(KernelLogServerTest, ReplayBootLog) {
+  std::vector<Json::Value> events = Replay(Capture(), 4096);
+
+  EXPECT_THAT(EventIds(events),
+              ElementsAre(Event::BootloaderLoaded, Event::KernelLoaded,
+                          Event::AdbdStarted, Event::DisplayPowerModeChanged,
+                          Event::WifiNetworkConnected, Event::ScreenChanged,
+                          Event::BootCompleted));
+  ASSERT_EQ(events.size(), 7u);
+  EXPECT_EQ(events[3]["metadata"]["display"].asString(), "0");
+  EXPECT_EQ(events[3]["metadata"]["mode"].asString(), "2");
+  EXPECT_EQ(events[5]["metadata"]["rotation"].asString(), "1");
+  EXPECT_EQ(events[5]["metadata"]["orientation"].asString(), "90");
+  EXPECT_TRUE(events[6]["metadata"].isNull());
+}
+
+TEST(KernelLogServerTest, ReadBoundariesDontChangeEvents) {
+  const std::string capture = Capture();
+  const std::vector<Json::Value> expected = Replay(capture, capture.size());
+
+  for (size_t chunk_size : {1, 2, 3, 7, 64, 255, 1000}) {
+    EXPECT_EQ(Replay(capture, chunk_size), expected) << chunk_size;
+  }
+}
+
+TEST(KernelLogServerTest, OneEventPerStagePerLine) {
+  std::vector<Json::Value> events =
+      Replay("VIRTUAL_DEVICE_BOOT_STARTED VIRTUAL_DEVICE_BOOT_STARTED\n"
+             "PM: hibernation: hibernation exit\n",
+             1 << 16);
+
+  EXPECT_THAT(EventIds(events),
+              ElementsAre(Event::BootStarted, Event::HibernationExited,
+                          Event::AdbdStarted));
+}
+
+}  // namespace
+}  // namespace cuttlefish::monitor
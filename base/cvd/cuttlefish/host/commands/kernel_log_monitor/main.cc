@@ -27,7 +27,6 @@
 #include "absl/log/log.h"
 #include "absl/strings/str_split.h"
 #include "gflags/gflags.h"
-#include "json/value.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/fs/shared_select.h"
@@ -107,8 +106,8 @@ int KernelLogMonitorMain(int argc, char** argv) {
 
   for (auto subscriber_fd : subscriber_fds) {
     if (subscriber_fd->IsOpen()) {
-      klog.SubscribeToEvents([subscriber_fd](Json::Value message) {
-        if (!WriteEvent(subscriber_fd, message)) {
+      klog.SubscribeToEvents([subscriber_fd](const KernelLogEvent& event) {
+        if (!WriteEvent(subscriber_fd, KernelLogEventToJson(event))) {
           if (subscriber_fd->GetErrno() != EPIPE) {
             LOG(ERROR) << "Error while writing to pipe: "
                        << subscriber_fd->StrError();
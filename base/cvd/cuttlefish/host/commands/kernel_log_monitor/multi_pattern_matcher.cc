@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/kernel_log_monitor/multi_pattern_matcher.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <deque>
+#include <string_view>
+#include <vector>
+
+#include "absl/log/check.h"
+
+namespace cuttlefish::monitor {
+
+MultiPatternMatcher::MultiPatternMatcher(
+    const std::vector<std::string_view>& patterns) {
+  // Class 0 is every byte that doesn't occur in a pattern.
+  for (std::string_view pattern : patterns) {
+    CHECK(!pattern.empty()) << "Empty patterns match everywhere";
+    for (unsigned char c : pattern) {
+      if (byte_class_[c] == 0) {
+        byte_class_[c] = class_count_++;
+      }
+    }
+    pattern_sizes_.push_back(pattern.size());
+  }
+
+  // Build the trie. A transition of kStart from a state other than the root
+  // means "missing" until the failure links fill it in below.
+  transitions_.assign(class_count_, kStart);
+  std::vector<std::vector<uint32_t>> terminal(1);
+  for (uint32_t p = 0; p < patterns.size(); p++) {
+    State state = kStart;
+    for (unsigned char c : patterns[p]) {
+      State& next = transitions_[state * class_count_ + byte_class_[c]];
+      if (next == kStart) {
+        next = terminal.size();
+        terminal.emplace_back();
+        transitions_.resize(transitions_.size() + class_count_, kStart);
+      }
+      // `transitions_` may have been reallocated, so don't reuse `next`.
+      state = transitions_[state * class_count_ + byte_class_[c]];
+    }
+    terminal[state].push_back(p);
+  }
+  const size_t state_count = terminal.size();
+
+  // Breadth first, so that every suffix link points to a finished state.
+  std::vector<State> fail(state_count, kStart);
+  std::deque<State> queue;
+  for (uint32_t cls = 0; cls < class_count_; cls++) {
+    if (State child = transitions_[cls]; child != kStart) {
+      queue.push_back(child);
+    }
+  }
+  while (!queue.empty()) {
+    State state = queue.front();
+    queue.pop_front();
+    for (uint32_t p : terminal[fail[state]]) {
+      terminal[state].push_back(p);
+    }
+    for (uint32_t cls = 0; cls < class_count_; cls++) {
+      State& next = transitions_[state * class_count_ + cls];
+      State fallback = transitions_[fail[state] * class_count_ + cls];
+      if (next == kStart) {
+        next = fallback;
+      } else {
+        fail[next] = fallback;
+        queue.push_back(next);
+      }
+    }
+  }
+
+  // Matches ending at the same byte are reported in pattern order.
+  output_begin_.reserve(state_count + 1);
+  for (std::vector<uint32_t>& ending : terminal) {
+    std::sort(ending.begin(), ending.end());
+    output_begin_.push_back(outputs_.size());
+    outputs_.insert(outputs_.end(), ending.begin(), ending.end());
+  }
+  output_begin_.push_back(outputs_.size());
+}
+
+}  // namespace cuttlefish::monitor
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <string_view>
+#include <vector>
+
+namespace cuttlefish::monitor {
+
+// Finds every occurrence of a fixed set of patterns in a single pass over the
+// text, using an Aho-Corasick automaton compiled into a DFA.
+//
+// Bytes that don't appear in any pattern share a single input class, so the
+// transition table stays small enough to remain in cache while scanning.
+class MultiPatternMatcher {
+ public:
+  using State = uint32_t;
+  static constexpr State kStart = 0;
+
+  // Patterns must be non-empty. Duplicate patterns are reported separately.
+  explicit MultiPatternMatcher(const std::vector<std::string_view>& patterns);
+
+  size_t PatternCount() const { return pattern_sizes_.size(); }
+  size_t PatternSize(size_t pattern) const { return pattern_sizes_[pattern]; }
+
+  // Advances the automaton from `state` over `text`, calling
+  // `on_match(pattern, end)` for each occurrence, where `end` is the offset in
+  // `text` one past the last byte of the match. Passing the returned state to
+  // the next call finds matches that span both pieces of text.
+  template <typename OnMatch>
+  State Scan(State state, std::string_view text, OnMatch&& on_match) const {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+    for (size_t i = 0; i < text.size(); i++) {
+      state = transitions_[state * class_count_ + byte_class_[data[i]]];
+      for (uint32_t out = output_begin_[state]; out < output_begin_[state + 1];
+           out++) {
+        on_match(static_cast<size_t>(outputs_[out]), i + 1);
+      }
+    }
+    return state;
+  }
+
+ private:
+  std::array<uint8_t, 256> byte_class_{};
+  uint32_t class_count_ = 1;
+  // Fully resolved transitions, indexed by `state * class_count_ + class`.
+  std::vector<State> transitions_;
+  // Patterns ending at each state, including those reached through suffix
+  // links, as ranges of `outputs_` delimited by `output_begin_`.
+  std::vector<uint32_t> output_begin_;
+  std::vector<uint32_t> outputs_;
+  std::vector<size_t> pattern_sizes_;
+};
+
+}  // namespace cuttlefish::monitor
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/kernel_log_monitor/multi_pattern_matcher.h"
+
+#include <stddef.h>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace cuttlefish::monitor {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+using Matches = std::vector<std::pair<size_t, size_t>>;
+
+Matches ScanAll(const MultiPatternMatcher& matcher, std::string_view text) {
+  Matches matches;
+  matcher.Scan(MultiPatternMatcher::kStart, text,
+               [&matches](size_t pattern, size_t end) {
+                 matches.emplace_back(pattern, end);
+               });
+  return matches;
+}
+
+// The matches `std::string::find` would report, ordered the same way.
+Matches FindAll(const std::vector<std::string_view>& patterns,
+                std::string_view text) {
+  Matches matches;
+  for (size_t end = 1; end <= text.size(); end++) {
+    for (size_t p = 0; p < patterns.size(); p++) {
+      if (patterns[p].size() <= end &&
+          text.substr(end - patterns[p].size(), patterns[p].size()) ==
+              patterns[p]) {
+        matches.emplace_back(p, end);
+      }
+    }
+  }
+  return matches;
+}
+
+TEST(MultiPatternMatcherTest, NoMatches) {
+  MultiPatternMatcher matcher({"abc", "xyz"});
+
+  EXPECT_TRUE(ScanAll(matcher, "").empty());
+  EXPECT_TRUE(ScanAll(matcher, "abxyabyzc").empty());
+}
+
+TEST(MultiPatternMatcherTest, ReportsEndOffsets) {
+  MultiPatternMatcher matcher({"abc", "xyz"});
+
+  EXPECT_THAT(ScanAll(matcher, "--xyz--abc"),
+              ElementsAre(Pair(1, 5), Pair(0, 10)));
+}
+
+TEST(MultiPatternMatcherTest, OverlappingAndNestedPatterns) {
+  MultiPatternMatcher matcher({"he", "she", "his", "hers"});
+
+  EXPECT_THAT(ScanAll(matcher, "ushers"),
+              ElementsAre(Pair(0, 4), Pair(1, 4), Pair(3, 6)));
+}
+
+TEST(MultiPatternMatcherTest, DuplicatePatternsAreReportedSeparately) {
+  MultiPatternMatcher matcher({"exit", "exit"});
+
+  EXPECT_THAT(ScanAll(matcher, "exit"), ElementsAre(Pair(0, 4), Pair(1, 4)));
+}
+
+TEST(MultiPatternMatcherTest, StateCarriesAcrossCalls) {
+  MultiPatternMatcher matcher({"BOOT_COMPLETED"});
+  Matches matches;
+  auto on_match = [&matches](size_t pattern, size_t end) {
+    matches.emplace_back(pattern, end);
+  };
+
+  auto state = matcher.Scan(MultiPatternMatcher::kStart, "xx BOOT_", on_match);
+  EXPECT_TRUE(matches.empty());
+  matcher.Scan(state, "COMPLETED", on_match);
+
+  EXPECT_THAT(matches, ElementsAre(Pair(0, 9)));
+}
+
+TEST(MultiPatternMatcherTest, AgreesWithFind) {
+  const std::vector<std::string_view> patterns = {
+      "aab", "ab", "b", "abab", "baa", "aaaa", "bba",
+  };
+  MultiPatternMatcher matcher(patterns);
+
+  // Every string over {a, b, c} of up to 8 characters.
+  std::vector<std::string> texts = {""};
+  for (size_t i = 0; i < texts.size(); i++) {
+    const std::string text = texts[i];
+    EXPECT_EQ(ScanAll(matcher, text), FindAll(patterns, text)) << text;
+    if (text.size() < 8) {
+      for (char c : {'a', 'b', 'c'}) {
+        texts.push_back(text + c);
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace cuttlefish::monitor
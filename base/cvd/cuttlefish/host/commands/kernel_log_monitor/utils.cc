@@ -21,8 +21,12 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "absl/log/log.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_split.h"
 #include "json/value.h"
 #include "json/writer.h"
 
@@ -58,6 +62,29 @@ Result<std::optional<ReadEventResult>> ReadEvent(SharedFD fd) {
   return result;
 }
 
+Json::Value KernelLogEventToJson(const KernelLogEvent& event) {
+  Json::Value message;
+  message["event"] = event.event;
+  Json::Value metadata;
+  // Expect space-separated key=value pairs in the log message.
+  const std::vector<std::string_view> fields =
+      absl::StrSplit(event.metadata, ' ', absl::SkipEmpty());
+  for (std::string_view field : fields) {
+    field = absl::StripAsciiWhitespace(field);
+    if (field.empty()) {
+      continue;
+    }
+    const std::vector<std::string_view> keyvalue = absl::StrSplit(field, '=');
+    if (keyvalue.size() != 2) {
+      LOG(WARNING) << "Field is not in key=value format: " << field;
+      continue;
+    }
+    metadata[std::string(keyvalue[0])] = std::string(keyvalue[1]);
+  }
+  message["metadata"] = metadata;
+  return message;
+}
+
 bool WriteEvent(SharedFD fd, const Json::Value& event_message) {
   Json::StreamWriterBuilder factory;
   std::string message_string = Json::writeString(factory, event_message);
@@ -36,6 +36,9 @@ struct ReadEventResult {
  * while reading the event, while an empty optional indicates EOF. */
 Result<std::optional<ReadEventResult>> ReadEvent(SharedFD fd);
 
+// Converts an event to the message format expected by WriteEvent.
+Json::Value KernelLogEventToJson(const KernelLogEvent& event);
+
 // Writes a kernel log event to the fd, in a format expected by ReadEvent.
 bool WriteEvent(SharedFD fd, const Json::Value& event_message);
 
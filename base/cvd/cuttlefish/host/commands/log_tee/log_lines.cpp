@@ -0,0 +1,133 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/log_tee/log_lines.h"
+
+#include <stddef.h>
+
+#include <optional>
+#include <string_view>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+
+#include "cuttlefish/common/libs/utils/tee_logging.h"
+
+namespace cuttlefish {
+namespace {
+
+bool ConsumeChar(std::string_view& text, char c) {
+  if (text.empty() || text.front() != c) {
+    return false;
+  }
+  text.remove_prefix(1);
+  return true;
+}
+
+bool ConsumeDigits(std::string_view& text, size_t count) {
+  if (text.size() < count) {
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (!absl::ascii_isdigit(static_cast<unsigned char>(text[i]))) {
+      return false;
+    }
+  }
+  text.remove_prefix(count);
+  return true;
+}
+
+// Matches `Z`, `+hh`, `+hh:mm` or `+hhmm`, with either sign.
+bool ConsumeTimezone(std::string_view& text) {
+  if (ConsumeChar(text, 'Z')) {
+    return true;
+  }
+  if (!ConsumeChar(text, '+') && !ConsumeChar(text, '-')) {
+    return false;
+  }
+  if (!ConsumeDigits(text, 2)) {
+    return false;
+  }
+  // The minutes are optional, with or without a colon.
+  std::string_view with_colon = text;
+  if (ConsumeChar(with_colon, ':') && ConsumeDigits(with_colon, 2)) {
+    text = with_colon;
+  } else {
+    ConsumeDigits(text, 2);
+  }
+  return true;
+}
+
+// Parses "[YYYY-MM-DDThh:mm:ss.nnnnnnnnn<timezone> <LEVEL>", the prefix crosvm
+// puts on every line, equivalent to
+// ^\[\d{4}-\d{2}-\d{2}T\d{2}:\d{2}:\d{2}\.\d{9}(Z|[+-]\d{2}(:\d{2}|\d{2})?)\s
+// followed by the level.
+std::optional<LogSeverity> CrosvmLogLevel(std::string_view line) {
+  if (!ConsumeChar(line, '[') || !ConsumeDigits(line, 4) ||
+      !ConsumeChar(line, '-') || !ConsumeDigits(line, 2) ||
+      !ConsumeChar(line, '-') || !ConsumeDigits(line, 2) ||
+      !ConsumeChar(line, 'T') || !ConsumeDigits(line, 2) ||
+      !ConsumeChar(line, ':') || !ConsumeDigits(line, 2) ||
+      !ConsumeChar(line, ':') || !ConsumeDigits(line, 2) ||
+      !ConsumeChar(line, '.') || !ConsumeDigits(line, 9) ||
+      !ConsumeTimezone(line)) {
+    return std::nullopt;
+  }
+  if (line.empty() ||
+      !absl::ascii_isspace(static_cast<unsigned char>(line.front()))) {
+    return std::nullopt;
+  }
+  line.remove_prefix(1);
+
+  if (absl::StartsWith(line, "ERROR")) {
+    return LogSeverity::Error;
+  } else if (absl::StartsWith(line, "WARN")) {
+    return LogSeverity::Warning;
+  } else if (absl::StartsWith(line, "INFO")) {
+    return LogSeverity::Info;
+  } else if (absl::StartsWith(line, "DEBUG")) {
+    return LogSeverity::Debug;
+  } else if (absl::StartsWith(line, "TRACE")) {
+    return LogSeverity::Verbose;
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+LogSeverity ClassifyLogLine(std::string_view line) {
+  if (absl::StartsWith(line, "[INFO")) {
+    return LogSeverity::Debug;
+  } else if (absl::StartsWith(line, "[ERROR")) {
+    return LogSeverity::Error;
+  } else if (absl::StartsWith(line, "[WARNING")) {
+    return LogSeverity::Warning;
+  } else if (absl::StartsWith(line, "[VERBOSE")) {
+    return LogSeverity::Verbose;
+  }
+  std::optional<LogSeverity> level = CrosvmLogLevel(line);
+  if (!level) {
+    return LogSeverity::Debug;
+  }
+  // Crosvm reports every disk at INFO, which is too noisy for the console.
+  if (*level == LogSeverity::Info &&
+      (absl::StrContains(line, "disk] Disk image file is hosted") ||
+       absl::StrContains(line, "disk] disk size"))) {
+    return LogSeverity::Debug;
+  }
+  return *level;
+}
+
+}  // namespace cuttlefish
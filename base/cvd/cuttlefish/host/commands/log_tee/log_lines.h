@@ -0,0 +1,84 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+#include <string_view>
+
+#include "cuttlefish/common/libs/utils/tee_logging.h"
+
+namespace cuttlefish {
+
+// Splits a stream of reads into lines, regardless of where the read
+// boundaries fall.
+class LineFramer {
+ public:
+  // Lines longer than `max_line_size` are passed on in pieces of that size.
+  explicit LineFramer(size_t max_line_size = 1 << 16)
+      : max_line_size_(max_line_size) {}
+
+  // Calls `on_line` with every line completed by `chunk`, without the line
+  // terminator. Lines that lie entirely within `chunk` are passed as views
+  // into it; only a line split across chunks is copied.
+  template <typename OnLine>
+  void Append(std::string_view chunk, OnLine&& on_line) {
+    while (!chunk.empty()) {
+      const size_t newline = chunk.find('\n');
+      if (newline == std::string_view::npos) {
+        partial_.append(chunk);
+        if (partial_.size() >= max_line_size_) {
+          Flush(on_line);
+        }
+        return;
+      }
+      if (partial_.empty()) {
+        on_line(chunk.substr(0, newline));
+      } else {
+        partial_.append(chunk.substr(0, newline));
+        on_line(std::string_view(partial_));
+        partial_.clear();
+      }
+      chunk.remove_prefix(newline + 1);
+    }
+  }
+
+  // Passes on the incomplete line held back from earlier chunks, if any.
+  template <typename OnLine>
+  void Flush(OnLine&& on_line) {
+    if (!partial_.empty()) {
+      on_line(std::string_view(partial_));
+      partial_.clear();
+    }
+  }
+
+  bool HasPartialLine() const { return !partial_.empty(); }
+
+ private:
+  size_t max_line_size_;
+  std::string partial_;
+};
+
+// Determines the severity of a line logged by a VMM or another host process.
+//
+// Lines in the format of external/crosvm/base/src/syslog.rs, which start with
+// a local ISO 8601 timestamp and a log level, are classified by that level.
+// Lines from android-style loggers starting with "[<LEVEL>" are classified by
+// their level too. Anything else is logged at debug severity.
+LogSeverity ClassifyLogLine(std::string_view line);
+
+}  // namespace cuttlefish
@@ -0,0 +1,166 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/log_tee/log_lines.h"
+
+#include <stddef.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/utils/tee_logging.h"
+
+namespace cuttlefish {
+namespace {
+
+using ::testing::ElementsAre;
+
+std::vector<std::string> Frame(LineFramer& framer,
+                               const std::vector<std::string_view>& chunks) {
+  std::vector<std::string> lines;
+  auto on_line = [&lines](std::string_view line) { lines.emplace_back(line); };
+  for (std::string_view chunk : chunks) {
+    framer.Append(chunk, on_line);
+  }
+  framer.Flush(on_line);
+  return lines;
+}
+
+TEST(LineFramerTest, SplitsChunkIntoLines) {
+  LineFramer framer;
+
+  EXPECT_THAT(Frame(framer, {"one\ntwo\n\nthree\n"}),
+              ElementsAre("one", "two", "", "three"));
+}
+
+TEST(LineFramerTest, JoinsLinesSplitAcrossChunks) {
+  LineFramer framer;
+
+  EXPECT_THAT(Frame(framer, {"on", "e\ntw", "", "o", "\n"}),
+              ElementsAre("one", "two"));
+}
+
+TEST(LineFramerTest, HoldsBackPartialLineUntilFlush) {
+  LineFramer framer;
+  std::vector<std::string> lines;
+  auto on_line = [&lines](std::string_view line) { lines.emplace_back(line); };
+
+  framer.Append("done\npartial", on_line);
+  EXPECT_THAT(lines, ElementsAre("done"));
+  EXPECT_TRUE(framer.HasPartialLine());
+
+  framer.Flush(on_line);
+  EXPECT_THAT(lines, ElementsAre("done", "partial"));
+  EXPECT_FALSE(framer.HasPartialLine());
+}
+
+TEST(LineFramerTest, BreaksUpOverlongLines) {
+  LineFramer framer(/* max_line_size= */ 4);
+
+  EXPECT_THAT(Frame(framer, {"ab", "cdef", "g\nhi\n"}),
+              ElementsAre("abcdef", "g", "hi"));
+}
+
+constexpr char kTimestamp[] = "[2025-01-02T03:04:05.123456789";
+
+std::string CrosvmLine(std::string_view timezone, std::string_view rest) {
+  return std::string(kTimestamp) + std::string(timezone) + std::string(rest);
+}
+
+TEST(ClassifyLogLineTest, CrosvmLevels) {
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", " ERROR crosvm] failed")),
+            LogSeverity::Error);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", " WARN devices] slow")),
+            LogSeverity::Warning);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", " INFO crosvm] started")),
+            LogSeverity::Info);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", " DEBUG vm_control] request")),
+            LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", " TRACE virtio] queue")),
+            LogSeverity::Verbose);
+}
+
+TEST(ClassifyLogLineTest, CrosvmTimezones) {
+  for (std::string_view timezone : {"Z", "+01", "-0800", "+05:30"}) {
+    EXPECT_EQ(ClassifyLogLine(CrosvmLine(timezone, " ERROR x")),
+              LogSeverity::Error)
+        << timezone;
+    EXPECT_EQ(ClassifyLogLine(CrosvmLine(timezone, "\tERROR x")),
+              LogSeverity::Error)
+        << timezone;
+  }
+  for (std::string_view timezone : {"", "+1", "+05:3", "+05:300", "UTC"}) {
+    EXPECT_EQ(ClassifyLogLine(CrosvmLine(timezone, " ERROR x")),
+              LogSeverity::Debug)
+        << timezone;
+  }
+}
+
+TEST(ClassifyLogLineTest, MalformedCrosvmPrefixes) {
+  EXPECT_EQ(ClassifyLogLine("[2025-01-02T03:04:05.123Z ERROR x"),
+            LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine("[2025-01-02 03:04:05.123456789Z ERROR x"),
+            LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", "ERROR x")), LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", " FATAL x")), LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", "")), LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine(" " + CrosvmLine("Z", " ERROR x")),
+            LogSeverity::Debug);
+}
+
+TEST(ClassifyLogLineTest, DiskInfoIsDemoted) {
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine(
+                "Z", " INFO disk] Disk image file is hosted on ext4")),
+            LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", " INFO disk] disk size 4096")),
+            LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine(CrosvmLine("Z", " WARN disk] disk size 4096")),
+            LogSeverity::Warning);
+}
+
+TEST(ClassifyLogLineTest, AndroidStylePrefixes) {
+  EXPECT_EQ(ClassifyLogLine("[INFO:main.cpp(1)] hello"), LogSeverity::Debug);
+  EXPECT_EQ(ClassifyLogLine("[ERROR:main.cpp(1)] hello"), LogSeverity::Error);
+  EXPECT_EQ(ClassifyLogLine("[WARNING:main.cpp(1)] hi"), LogSeverity::Warning);
+  EXPECT_EQ(ClassifyLogLine("[VERBOSE:main.cpp(1)] hi"), LogSeverity::Verbose);
+  EXPECT_EQ(ClassifyLogLine("no prefix at all"), LogSeverity::Debug);
+}
+
+// Severities used to depend on where the reads split the log.
+TEST(ClassifyLogLineTest, SeverityIsPerLineRegardlessOfReads) {
+  const std::string log = CrosvmLine("Z", " INFO a\n") +
+                          CrosvmLine("Z", " ERROR b\n") +
+                          CrosvmLine("Z", " WARN c\n");
+  for (size_t chunk_size = 1; chunk_size <= log.size(); chunk_size++) {
+    LineFramer framer;
+    std::vector<LogSeverity> severities;
+    auto on_line = [&severities](std::string_view line) {
+      severities.push_back(ClassifyLogLine(line));
+    };
+    for (size_t i = 0; i < log.size(); i += chunk_size) {
+      framer.Append(std::string_view(log).substr(i, chunk_size), on_line);
+    }
+    EXPECT_THAT(severities, ElementsAre(LogSeverity::Info, LogSeverity::Error,
+                                        LogSeverity::Warning))
+        << chunk_size;
+  }
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -21,18 +21,18 @@
 #endif
 #include <unistd.h>
 
-#include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/ascii.h"
-#include "absl/strings/match.h"
 #include "gflags/gflags.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/utils/tee_logging.h"
+#include "cuttlefish/host/commands/log_tee/log_lines.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 #include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/result/result_type.h"
@@ -42,26 +42,66 @@ using cuttlefish::StrError;
 DEFINE_string(process_name, "", "The process to credit log messages to");
 DEFINE_int32(log_fd_in, -1, "The file descriptor to read logs from.");
 
-// Crosvm formats logs starting with a local ISO 8601 timestamp and then a
-// log level (based on external/crosvm/base/src/syslog.rs).
-const std::regex kCrosvmLogPattern(
-    "^\\["
-    "\\d{4}" /* year */
-    "-"
-    "\\d{2}" /* month */
-    "-"
-    "\\d{2}" /* day */
-    "T"
-    "\\d{2}" /* hour */
-    ":"
-    "\\d{2}" /* minute*/
-    ":"
-    "\\d{2}" /* second */
-    "\\."
-    "\\d{9}"                          /* millisecond */
-    "(Z|[+-]\\d{2}(:\\d{2}|\\d{2})?)" /* timezone */
-    "\\s"
-    "(ERROR|WARN|INFO|DEBUG|TRACE)");
+namespace {
+
+using cuttlefish::LogSeverity;
+
+// How long to wait for the rest of a line before logging what has arrived.
+constexpr int kPartialLineTimeoutMs = 100;
+
+// Collects consecutive lines of the same severity, so that a burst of output
+// reaches the log sinks as a few messages rather than one per line.
+class LogBatch {
+ public:
+  void Add(std::string_view line) {
+    line = absl::StripAsciiWhitespace(line);
+    if (line.empty()) {
+      return;
+    }
+    const LogSeverity severity = cuttlefish::ClassifyLogLine(line);
+    if (!lines_.empty()) {
+      if (severity != severity_) {
+        Flush();
+      } else {
+        lines_ += '\n';
+      }
+    }
+    severity_ = severity;
+    lines_.append(line);
+  }
+
+  void Flush() {
+    if (lines_.empty()) {
+      return;
+    }
+    // Newlines inside `lines_` are handled by the android logging code.
+    switch (severity_) {
+      case LogSeverity::Verbose:
+        VLOG(1) << lines_;
+        break;
+      case LogSeverity::Debug:
+        VLOG(0) << lines_;
+        break;
+      case LogSeverity::Info:
+        LOG(INFO) << lines_;
+        break;
+      case LogSeverity::Warning:
+        LOG(WARNING) << lines_;
+        break;
+      case LogSeverity::Error:
+      case LogSeverity::Fatal:
+        LOG(ERROR) << lines_;
+        break;
+    }
+    lines_.clear();
+  }
+
+ private:
+  LogSeverity severity_ = LogSeverity::Debug;
+  std::string lines_;
+};
+
+}  // namespace
 
 int main(int argc, char** argv) {
   google::ParseCommandLineFlags(&argc, &argv, /* remove_flags */ true);
@@ -121,6 +161,9 @@ int main(int argc, char** argv) {
 
   char buf[1 << 16];
   cuttlefish::Result<uint64_t> chars_read = 0;
+  cuttlefish::LineFramer framer;
+  LogBatch batch;
+  auto add_line = [&batch](std::string_view line) { batch.Add(line); };
   for (;;) {
     // We can assume all writers to `log_fd` have completed before a SIGINT is
     // sent, but we need to make sure we've actually read all the data before
@@ -130,8 +173,14 @@ int main(int argc, char** argv) {
     // This could be simpler if all the writers would close their FDs when they
     // are finished. Then, we could just read until EOF. However that would
     // require more work elsewhere in cuttlefish.
-    CHECK(cuttlefish::SharedFD::Poll(poll_fds, /*timeout=*/-1) >= 0)
-        << "poll failed: " << StrError(errno);
+    const int timeout = framer.HasPartialLine() ? kPartialLineTimeoutMs : -1;
+    const int poll_ret = cuttlefish::SharedFD::Poll(poll_fds, timeout);
+    CHECK(poll_ret >= 0) << "poll failed: " << StrError(errno);
+    if (poll_ret == 0) {
+      framer.Flush(add_line);
+      batch.Flush();
+      continue;
+    }
     if (poll_fds[0].revents) {
       chars_read = log_fd->Read(buf, sizeof(buf));
       if (!chars_read.has_value()) {
@@ -142,49 +191,8 @@ int main(int argc, char** argv) {
       if (*chars_read == 0) {
         break;
       }
-      std::string trimmed(
-          absl::StripAsciiWhitespace(std::string_view(buf, *chars_read)));
-      // Newlines inside `trimmed` are handled by the android logging code.
-      // These checks attempt to determine the log severity coming from crosvm.
-      // There is no guarantee of success all the time since log line boundaries
-      // could be out sync with the reads, but that's ok.
-      if (absl::StartsWith(trimmed, "[INFO")) {
-        VLOG(0) << trimmed;
-      } else if (absl::StartsWith(trimmed, "[ERROR")) {
-        LOG(ERROR) << trimmed;
-      } else if (absl::StartsWith(trimmed, "[WARNING")) {
-        LOG(WARNING) << trimmed;
-      } else if (absl::StartsWith(trimmed, "[VERBOSE")) {
-        VLOG(1) << trimmed;
-      } else {
-        std::smatch match_result;
-        if (std::regex_search(trimmed, match_result, kCrosvmLogPattern)) {
-          if (match_result.size() == 4) {
-            const auto& level = match_result[3];
-            if (level == "ERROR") {
-              LOG(ERROR) << trimmed;
-            } else if (level == "WARN") {
-              LOG(WARNING) << trimmed;
-            } else if (level == "INFO") {
-              if (trimmed.find("disk] Disk image file is hosted") !=
-                      std::string::npos ||
-                  trimmed.find("disk] disk size") != std::string::npos) {
-                VLOG(0) << trimmed;
-              } else {
-                LOG(INFO) << trimmed;
-              }
-            } else if (level == "DEBUG") {
-              VLOG(0) << trimmed;
-            } else if (level == "TRACE") {
-              VLOG(1) << trimmed;
-            } else {
-              VLOG(0) << trimmed;
-            }
-          }
-        } else {
-          VLOG(0) << trimmed;
-        }
-      }
+      framer.Append(std::string_view(buf, *chars_read), add_line);
+      batch.Flush();
 
       // Go back to polling immediately to see if there is more data, don't
       // handle any signals yet.
@@ -203,5 +211,8 @@ int main(int argc, char** argv) {
 #endif
   }
 
+  framer.Flush(add_line);
+  batch.Flush();
+
   VLOG(0) << "Finished reading from process " << FLAGS_process_name;
 }
@@ -0,0 +1,191 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Classifies `--size_mib` of crosvm INFO lines arriving in `--read_size`
+// reads, the way log_tee does, with `LineFramer` and `ClassifyLogLine` and
+// with the std::regex search over each read that they replaced. Nothing is
+// logged, only the classification and the grouping into messages is timed.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/strings/ascii.h"
+
+#include "cuttlefish/common/libs/utils/tee_logging.h"
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/host/commands/log_tee/log_lines.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The pattern log_tee matched against every read before ClassifyLogLine.
+const std::regex kCrosvmLogPattern(
+    "^\\["
+    "\\d{4}-\\d{2}-\\d{2}T\\d{2}:\\d{2}:\\d{2}\\.\\d{9}"
+    "(Z|[+-]\\d{2}(:\\d{2}|\\d{2})?)"
+    "\\s"
+    "(ERROR|WARN|INFO|DEBUG|TRACE)");
+
+std::string GenerateLog(size_t size_mib) {
+  constexpr std::string_view kLines[] = {
+      "[2025-01-02T03:04:05.123456789Z INFO  devices::virtio::vhost_user] "
+      "vhost-user frontend activated queue 0\n",
+      "[2025-01-02T03:04:05.123456790Z INFO  crosvm::crosvm::sys::linux] "
+      "guest memory: 4096 MiB\n",
+      "[2025-01-02T03:04:05.123456791Z INFO  disk] disk size 8589934592\n",
+  };
+  std::string log;
+  log.reserve((size_mib << 20) + 256);
+  for (size_t i = 0; log.size() < (size_mib << 20); i++) {
+    log += kLines[i % std::size(kLines)];
+  }
+  return log;
+}
+
+// What log_tee did with every read before LineFramer, without the logging.
+// Returns the number of log messages the reads turn into.
+size_t RegexPerRead(const std::vector<std::string_view>& reads) {
+  size_t messages = 0;
+  for (std::string_view read : reads) {
+    std::string trimmed(absl::StripAsciiWhitespace(read));
+    std::smatch match;
+    if (std::regex_search(trimmed, match, kCrosvmLogPattern) &&
+        match.size() == 4 && match[3] == "INFO") {
+      // Looked for to demote the disk messages to debug.
+      (void)(trimmed.find("disk] Disk image file is hosted") !=
+                 std::string::npos ||
+             trimmed.find("disk] disk size") != std::string::npos);
+    }
+    messages++;
+  }
+  return messages;
+}
+
+// What log_tee does with every read now, without the logging.
+// Returns the number of log messages the reads turn into.
+size_t FramedLines(const std::vector<std::string_view>& reads) {
+  size_t messages = 0;
+  LogSeverity severity = LogSeverity::Debug;
+  std::string lines;
+  auto flush = [&messages, &lines]() {
+    messages += lines.empty() ? 0 : 1;
+    lines.clear();
+  };
+  auto add_line = [&](std::string_view line) {
+    line = absl::StripAsciiWhitespace(line);
+    if (line.empty()) {
+      return;
+    }
+    const LogSeverity line_severity = ClassifyLogLine(line);
+    if (!lines.empty()) {
+      if (line_severity != severity) {
+        flush();
+      } else {
+        lines += '\n';
+      }
+    }
+    severity = line_severity;
+    lines.append(line);
+  };
+  LineFramer framer;
+  for (std::string_view read : reads) {
+    framer.Append(read, add_line);
+    flush();
+  }
+  framer.Flush(add_line);
+  flush();
+  return messages;
+}
+
+void Report(const std::string& name, const std::vector<std::string_view>& reads,
+            size_t size, size_t iterations,
+            const std::function<size_t(const std::vector<std::string_view>&)>&
+                classify) {
+  std::vector<Clock::duration> samples;
+  size_t messages = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    Clock::time_point begin = Clock::now();
+    messages = classify(reads);
+    samples.emplace_back(Clock::now() - begin);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  const double median_seconds =
+      std::chrono::duration<double>(samples[samples.size() / 2]).count();
+  std::cout << name << ": " << messages << " messages, median "
+            << median_seconds * 1000 << "ms, "
+            << size / median_seconds / (1 << 20) << " MiB/s\n";
+}
+
+Result<void> LogTeeBenchmarkMain(int argc, char** argv) {
+  size_t size_mib = 32;
+  size_t read_size = 1 << 16;
+  size_t iterations = 5;
+  std::vector<Flag> flags;
+  flags.emplace_back(GflagsCompatFlag("size_mib", size_mib)
+                         .Help("Size of the generated log in mebibytes."));
+  flags.emplace_back(GflagsCompatFlag("read_size", read_size)
+                         .Help("Bytes returned by each read of the log."));
+  flags.emplace_back(
+      GflagsCompatFlag("iterations", iterations)
+          .Help("How many times to classify the log per method."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(size_mib, 0u);
+  CF_EXPECT_GT(read_size, 0u);
+  CF_EXPECT_GT(iterations, 0u);
+
+  const std::string log = GenerateLog(size_mib);
+  std::vector<std::string_view> reads;
+  for (size_t i = 0; i < log.size(); i += read_size) {
+    reads.emplace_back(std::string_view(log).substr(i, read_size));
+  }
+
+  std::cout << "Classifying " << log.size() << " bytes of crosvm logs in "
+            << read_size << " byte reads " << iterations
+            << " times per method\n";
+  Report("std::regex per read", reads, log.size(), iterations, RegexPerRead);
+  Report("LineFramer and ClassifyLogLine", reads, log.size(), iterations,
+         FramedLines);
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::LogTeeBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
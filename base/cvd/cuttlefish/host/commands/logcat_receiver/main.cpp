@@ -19,17 +19,19 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <string>
+#include <thread>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "gflags/gflags.h"
 
-#include "cuttlefish/common/libs/fs/shared_buf.h"
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/host/libs/config/config_instance_derived.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 #include "cuttlefish/host/libs/config/logging.h"
+#include "cuttlefish/host/libs/logcat/logcat_segments.h"
 #include "cuttlefish/result/result_type.h"
 
 DEFINE_int32(log_pipe_fd, -1,
@@ -67,25 +69,27 @@ int main(int argc, char** argv) {
     return 2;
   }
 
-  auto path = cuttlefish::LogcatPath(instance);
-  auto logcat_file = cuttlefish::SharedFD::Open(
-      path.c_str(), O_CREAT | O_APPEND | O_WRONLY, 0666);
+  auto writer =
+      cuttlefish::LogcatWriter::Create(cuttlefish::LogcatPath(instance));
+  if (!writer.has_value()) {
+    LOG(ERROR) << "Error opening logcat file: " << writer.error();
+    return 3;
+  }
 
   // Server loop
   while (true) {
-    char buff[1024];
-    cuttlefish::Result<uint64_t> data_read = pipe->Read(buff, sizeof(buff));
-    if (!data_read.has_value()) {
-      LOG(ERROR) << "Could not read logcat: " << pipe->StrError();
+    cuttlefish::Result<bool> ingested = (*writer)->Ingest(pipe);
+    if (!ingested.has_value()) {
+      LOG(ERROR) << "Could not copy logcat: " << ingested.error();
       break;
     }
-    auto written = cuttlefish::WriteAll(logcat_file, buff, *data_read);
-    CHECK(written == data_read)
-        << "Error writing to log file: " << logcat_file->StrError()
-        << ". This is unrecoverable.";
+    if (!*ingested) {
+      // The guest side closes the pipe when it restarts. Wait for it to be
+      // reopened rather than spinning on end of file.
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
   }
 
-  logcat_file->Close();
   pipe->Close();
   return 0;
 }
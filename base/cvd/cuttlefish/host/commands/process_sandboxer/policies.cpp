@@ -40,6 +40,7 @@ namespace cuttlefish::process_sandboxer {
 
 using sapi::file::JoinPath;
 using sapi::file_util::fileops::CreateDirectoryRecursively;
+using sapi::file_util::fileops::Exists;
 
 absl::Status HostInfo::EnsureOutputDirectoriesExist() {
   if (!CreateDirectoryRecursively(assembly_dir, 0700)) {
@@ -67,6 +68,22 @@ absl::Status HostInfo::EnsureOutputDirectoriesExist() {
   return absl::OkStatus();
 }
 
+std::string HostInfo::CompiledConfigPath() const {
+  char* real_path = realpath(cuttlefish_config_path.c_str(), nullptr);
+  if (real_path == nullptr) {
+    return "/dev/null";
+  }
+  std::string compiled = std::string(real_path) + ".compiled";
+  free(real_path);
+  // An empty compiled file is ignored in favor of the JSON file, so this keeps
+  // the mount valid when compiling the configuration failed.
+  return Exists(compiled, /* fully_resolve= */ true) ? compiled : "/dev/null";
+}
+
+std::string HostInfo::CompiledConfigSandboxPath() const {
+  return cuttlefish_config_path + ".compiled";
+}
+
 std::string HostInfo::EnvironmentsUdsDir() const {
   return JoinPath(tmp_dir, "cf_env_1000");
 }
@@ -88,6 +105,7 @@ std::ostream& operator<<(std::ostream& out, const HostInfo& host) {
   out << "\tassembly_dir: \"" << host.assembly_dir << "\"\n";
   out << "\tcuttlefish_config_path: \"" << host.cuttlefish_config_path
       << "\"\n";
+  out << "\tcompiled_config_path: \"" << host.CompiledConfigPath() << "\"\n";
   out << "\tenvironments_dir: \"" << host.environments_dir << "\"\n";
   out << "\tenvironments_uds_dir: " << host.EnvironmentsUdsDir() << "\"\n";
   out << "\tguest_image_path: " << host.guest_image_path << "\t\n";
@@ -29,6 +29,11 @@ namespace cuttlefish::process_sandboxer {
 
 struct HostInfo {
   absl::Status EnsureOutputDirectoriesExist();
+  // The compiled form of `cuttlefish_config_path` lives next to the file the
+  // path resolves to, but is looked up next to `cuttlefish_config_path`
+  // inside the sandbox.
+  std::string CompiledConfigPath() const;
+  std::string CompiledConfigSandboxPath() const;
   std::string HostToolExe(std::string_view exe) const;
   std::string EnvironmentsUdsDir() const;
   std::string InstanceUdsDir() const;
@@ -29,6 +29,7 @@ sandbox2::PolicyBuilder AdbConnectorPolicy(const HostInfo& host) {
   return BaselinePolicy(host, host.HostToolExe("adb_connector"))
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .Allow(sandbox2::UnrestrictedNetworking())  // Used to message adb server
       .AddPolicyOnSyscall(__NR_socket, {ARG_32(0), JEQ32(AF_INET, ALLOW),
                                         JEQ32(AF_UNIX, ALLOW)})
@@ -33,6 +33,7 @@ sandbox2::PolicyBuilder EchoServerPolicy(const HostInfo& host) {
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile("/dev/urandom")  // For gRPC
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddPolicyOnSyscall(__NR_madvise,
                           {ARG_32(2), JEQ32(MADV_DONTNEED, ALLOW)})
       // Unclear where the INET and INET6 sockets come from
@@ -32,6 +32,7 @@ sandbox2::PolicyBuilder GnssGrpcProxyPolicy(const HostInfo& host) {
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile("/dev/urandom")  // For gRPC
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddPolicyOnSyscall(__NR_socket, {ARG_32(0), JEQ32(AF_UNIX, ALLOW),
                                         JEQ32(AF_INET, ERRNO(EACCES)),
                                         JEQ32(AF_INET6, ERRNO(EACCES))})
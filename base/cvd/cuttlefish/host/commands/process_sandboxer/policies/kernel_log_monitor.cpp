@@ -24,6 +24,7 @@ sandbox2::PolicyBuilder KernelLogMonitorPolicy(const HostInfo& host) {
   return BaselinePolicy(host, host.HostToolExe("kernel_log_monitor"))
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AllowHandleSignals()
       .AllowOpen()
       .AllowRead()
@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 
+#include <linux/filter.h>
+#include <sys/mman.h>
+#include <syscall.h>
+
 #include "sandboxed_api/sandbox2/policybuilder.h"
+#include "sandboxed_api/sandbox2/util/bpf_helper.h"
 
 #include "cuttlefish/host/commands/process_sandboxer/policies.h"
 
@@ -24,10 +29,21 @@ sandbox2::PolicyBuilder LogcatReceiverPolicy(const HostInfo& host) {
   return BaselinePolicy(host, host.HostToolExe("logcat_receiver"))
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
+      .AddPolicyOnSyscall(__NR_madvise,
+                          {ARG_32(2), JEQ32(MADV_DONTNEED, ALLOW)})
       .AllowHandleSignals()
+      .AllowLlseek()
       .AllowOpen()
       .AllowRead()
+      .AllowReaddir()  // Finding rotated segments
+      .AllowRename()
       .AllowSafeFcntl()
+      .AllowSleep()
+      .AllowSyscall(__NR_clone)  // Background compression
+      .AllowSyscall(__NR_ftruncate)
+      .AllowSyscall(__NR_splice)
+      .AllowUnlink()
       .AllowWrite();
 }
 
@@ -27,6 +27,7 @@ sandbox2::PolicyBuilder MetricsPolicy(const HostInfo& host) {
   return BaselinePolicy(host, host.HostToolExe("metrics"))
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .Allow(sandbox2::UnrestrictedNetworking())
       .AllowSafeFcntl()
       .AllowSyscall(__NR_clone)  // Multithreading
@@ -36,6 +36,7 @@ sandbox2::PolicyBuilder ModemSimulatorPolicy(const HostInfo& host) {
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddDirectory(host.runtime_dir, /* is_ro= */ false)  // modem_nvram.json
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddPolicyOnSyscall(
           __NR_setsockopt,
           [](bpf_labels& labels) -> std::vector<sock_filter> {
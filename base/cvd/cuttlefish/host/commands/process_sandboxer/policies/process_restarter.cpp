@@ -31,6 +31,7 @@ sandbox2::PolicyBuilder ProcessRestarterPolicy(const HostInfo& host) {
   return BaselinePolicy(host, host.HostToolExe("process_restarter"))
       .AddDirectory(host.runtime_dir, /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddFileAt(sandboxer_proxy, host.HostToolExe("adb_connector"))
       .AddFileAt(sandboxer_proxy, host.HostToolExe("casimir"))
       .AddFileAt(sandboxer_proxy, host.HostToolExe("crosvm"))
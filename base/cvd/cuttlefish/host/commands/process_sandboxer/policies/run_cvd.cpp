@@ -45,6 +45,7 @@ sandbox2::PolicyBuilder RunCvdPolicy(const HostInfo& host) {
       .AddDirectory(
           JoinPath(host.host_artifacts_path, "etc", "default_input_devices"))
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddFile("/dev/null", /* is_ro= */ false)
       .AddFileAt(sandboxer_proxy, host.HostToolExe("adb_connector"))
       .AddFileAt(sandboxer_proxy, host.HostToolExe("casimir_control_server"))
@@ -122,6 +123,8 @@ sandbox2::PolicyBuilder RunCvdPolicy(const HostInfo& host) {
                                         JEQ32(AF_VSOCK, ALLOW)})
       .AllowChmod()
       .AllowDup()
+      .AllowEpoll()      // Process monitor
+      .AllowEpollWait()  // Process monitor
       .AllowEventFd()
       .AllowFork()  // Multithreading, sandboxer_proxy, process monitor
       .AllowGetIDs()
@@ -138,6 +141,7 @@ sandbox2::PolicyBuilder RunCvdPolicy(const HostInfo& host) {
       .AllowSyscall(__NR_listen)
       .AllowSyscall(__NR_msgget)  // Metrics SysV RPC
       .AllowSyscall(__NR_msgsnd)  // Metrics SysV RPC
+      .AllowSyscall(__NR_pidfd_open)  // Process monitor
       .AllowSyscall(__NR_recvmsg)
       .AllowSyscall(__NR_sendmsg)
       .AllowSyscall(__NR_setpgid)
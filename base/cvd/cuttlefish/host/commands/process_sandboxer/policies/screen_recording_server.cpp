@@ -35,6 +35,7 @@ sandbox2::PolicyBuilder ScreenRecordingServerPolicy(const HostInfo& host) {
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile("/dev/urandom")  // For gRPC
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddPolicyOnSyscalls(
           {__NR_getsockopt, __NR_setsockopt},
           [](bpf_labels& labels) -> std::vector<sock_filter> {
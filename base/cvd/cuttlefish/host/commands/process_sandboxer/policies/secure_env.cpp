@@ -31,17 +31,23 @@ sandbox2::PolicyBuilder SecureEnvPolicy(const HostInfo& host) {
       .AddDirectory(host.runtime_dir, /* is_ro= */ false)
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddFile(exe)  // to exec itself
       .AllowDup()
       .AllowFork()    // Something is using clone, not sure what
       .AllowGetIDs()  // For getuid
+      .AllowRename()  // Log storage compaction and legacy file conversion
       .AllowSafeFcntl()
       .AllowSelect()
       .AllowSyscall(__NR_accept)
       .AllowSyscall(__NR_execve)  // to exec itself
+      // Log storage durability and recovery from torn records
+      .AllowSyscall(__NR_fsync)
+      .AllowSyscall(__NR_ftruncate)
       // Something is using arguments not allowed by AllowGetRandom()
       .AllowSyscall(__NR_getrandom)
       .AllowSyscall(__NR_madvise)
+      .AllowSyscall(__NR_setpriority)  // KeyMint key pool workers
       // statx not covered by AllowStat()
       .AllowSyscall(__NR_statx)
       .AllowSyscall(__NR_socketpair)
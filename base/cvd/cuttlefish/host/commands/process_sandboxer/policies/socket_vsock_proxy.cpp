@@ -30,6 +30,7 @@ sandbox2::PolicyBuilder SocketVsockProxyPolicy(const HostInfo& host) {
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddDirectory(host.VsockDeviceDir(), /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddPolicyOnSyscall(
           __NR_socket, {ARG_32(0), JEQ32(AF_UNIX, ALLOW), JEQ32(AF_INET, ALLOW),
                         JEQ32(AF_INET6, ALLOW), JEQ32(AF_VSOCK, ALLOW)})
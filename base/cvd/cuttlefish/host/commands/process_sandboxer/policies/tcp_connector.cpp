@@ -30,6 +30,7 @@ sandbox2::PolicyBuilder TcpConnectorPolicy(const HostInfo& host) {
       .AddDirectory(host.EnvironmentsUdsDir(), /* is_ro= */ false)
       .AddDirectory(host.log_dir, /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddPolicyOnSyscall(__NR_socket, {ARG_32(0), JEQ32(AF_INET, ALLOW),
                                         JEQ32(AF_UNIX, ALLOW)})
       .Allow(sandbox2::UnrestrictedNetworking())
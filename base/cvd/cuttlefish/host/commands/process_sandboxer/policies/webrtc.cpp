@@ -46,6 +46,7 @@ sandbox2::PolicyBuilder WebRtcPolicy(const HostInfo& host) {
       .AddDirectory(host.VsockDeviceDir(), /* is_ro= */ false)
       .AddDirectory(JoinPath(host.runtime_dir, "recording"), /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AddFile("/dev/urandom")
       .AddFile("/run/cuttlefish/operator")
       // Shared memory with crosvm for audio
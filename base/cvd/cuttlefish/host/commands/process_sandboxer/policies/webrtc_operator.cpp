@@ -42,6 +42,7 @@ sandbox2::PolicyBuilder WebRtcOperatorPolicy(const HostInfo& host) {
           JoinPath(host.host_artifacts_path, "usr", "share", "webrtc"))
       .AddFile("/dev/urandom")  // For libwebsockets
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       .AllowEventFd()
       .AllowHandleSignals()
       .AddPolicyOnSyscall(
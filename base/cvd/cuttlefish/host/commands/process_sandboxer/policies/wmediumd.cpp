@@ -41,6 +41,7 @@ sandbox2::PolicyBuilder WmediumdPolicy(const HostInfo& host) {
       .AddFile(JoinPath(host.environments_dir, "env-1", "wmediumd.cfg"),
                /* is_ro= */ false)
       .AddFile(host.cuttlefish_config_path)
+      .AddFileAt(host.CompiledConfigPath(), host.CompiledConfigSandboxPath())
       // Shared memory with crosvm for wifi
       .AddPolicyOnMmap([](bpf_labels& labels) -> std::vector<sock_filter> {
         return {
@@ -81,6 +81,7 @@ Result<MonitorCommand> SecureEnv(
   const auto& secure_hals = CF_EXPECT(config.secure_hals());
   bool secure_keymint = secure_hals.count(SecureHal::kHostKeymintSecure) > 0;
   command.AddParameter("-keymint_impl=", secure_keymint ? "tpm" : "software");
+  command.AddParameter("-keymint_key_pool=", config.keymint_key_pool());
   bool secure_gatekeeper =
       secure_hals.count(SecureHal::kHostGatekeeperSecure) > 0;
   auto gatekeeper_impl = secure_gatekeeper ? "tpm" : "software";
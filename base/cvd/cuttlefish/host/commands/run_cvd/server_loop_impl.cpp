@@ -18,6 +18,8 @@
 
 #include <errno.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <utime.h>
 
@@ -49,6 +51,9 @@
 #include "cuttlefish/host/libs/config/data_image.h"
 #include "cuttlefish/host/libs/config/vmm_mode.h"
 #include "cuttlefish/host/libs/feature/command_source.h"
+#include "cuttlefish/host/libs/image_aggregator/disk_image.h"
+#include "cuttlefish/host/libs/image_aggregator/image_from_file.h"
+#include "cuttlefish/host/libs/image_aggregator/qcow2.h"
 #include "cuttlefish/host/libs/process_monitor/process_monitor.h"
 #include "cuttlefish/posix/remove.h"
 #include "cuttlefish/posix/strerror.h"
@@ -58,21 +63,13 @@
 namespace cuttlefish {
 namespace run_cvd_impl {
 
-bool ServerLoopImpl::CreateQcowOverlay(const std::string& crosvm_path,
-                                       const std::string& backing_file,
-                                       const std::string& output_overlay_path) {
-  Command crosvm_qcow2_cmd(crosvm_path);
-  crosvm_qcow2_cmd.AddParameter("create_qcow2");
-  crosvm_qcow2_cmd.AddParameter("--backing-file");
-  crosvm_qcow2_cmd.AddParameter(backing_file);
-  crosvm_qcow2_cmd.AddParameter(output_overlay_path);
-  int success = crosvm_qcow2_cmd.Start().Wait();
-  if (success != 0) {
-    LOG(ERROR) << "Unable to run crosvm create_qcow2. Exited with status "
-               << success;
-    return false;
-  }
-  return true;
+Result<void> ServerLoopImpl::CreateQcowOverlay(
+    const std::string& backing_file, const std::string& output_overlay_path) {
+  std::unique_ptr<DiskImage> backing = CF_EXPECT(ImageFromFile(backing_file));
+  const uint64_t backing_size = CF_EXPECT(backing->VirtualSizeBytes());
+  CF_EXPECT(
+      Qcow2Image::Create(backing_file, backing_size, output_overlay_path));
+  return {};
 }
 
 ServerLoopImpl::ServerLoopImpl(
@@ -121,14 +118,24 @@ Result<void> ServerLoopImpl::Run() {
     SharedFDSet read_set;
     read_set.Set(server_);
     read_set.Set(process_monitor.status());
+    for (const SharedFD& watcher : status_watchers_) {
+      read_set.Set(watcher);
+    }
 
-    Select(&read_set, nullptr, nullptr, nullptr);
+    // Status watchers are sent changes found by polling.
+    struct timeval status_poll_interval = {.tv_sec = 1, .tv_usec = 0};
+    Select(&read_set, nullptr, nullptr,
+           status_watchers_.empty() ? nullptr : &status_poll_interval);
 
     if (read_set.IsSet(process_monitor.status())) {
       return CF_ERR("process monitor has died");
     }
 
-    CF_EXPECT(read_set.IsSet(server_));
+    DropClosedStatusWatchers(read_set);
+    PollStatus(process_monitor);
+    if (!read_set.IsSet(server_)) {
+      continue;
+    }
     SharedFD client = Fd::Accept(*server_).value_or(Fd());
     while (client->IsOpen()) {
       auto launcher_action_with_info_result = ReadLauncherActionFromFd(client);
@@ -147,6 +154,16 @@ Result<void> ServerLoopImpl::Run() {
         HandleActionWithNoData(launcher_action.action, client, process_monitor);
         continue;
       }
+      if (launcher_action.extended_action.has_status_query()) {
+        auto result = HandleStatusQuery(
+            launcher_action.extended_action.status_query(), client,
+            process_monitor);
+        if (!result.has_value()) {
+          LOG(ERROR) << "Failed to handle status query: " << result.error();
+        }
+        // The client is either done or kept as a status watcher.
+        break;
+      }
       auto result = HandleExtended(launcher_action, process_monitor);
       auto response = LauncherResponse::kSuccess;
       if (!result.has_value()) {
@@ -422,9 +439,9 @@ bool ServerLoopImpl::PowerwashFiles() {
     const std::string& composite_disk_path = overlay_file.composite_disk_path;
 
     unlink(overlay_path.c_str());
-    if (!CreateQcowOverlay(instance_.crosvm_binary(), composite_disk_path,
-                           overlay_path)) {
-      LOG(ERROR) << "CreateQcowOverlay failed";
+    Result<void> overlay = CreateQcowOverlay(composite_disk_path, overlay_path);
+    if (!overlay.has_value()) {
+      LOG(ERROR) << "CreateQcowOverlay failed: " << overlay.error();
       return false;
     }
 
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <atomic>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -25,10 +26,12 @@
 #include "fruit/fruit.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/fs/shared_select.h"
 #include "cuttlefish/common/libs/utils/json.h"
 #include "cuttlefish/host/commands/run_cvd/launch/webrtc_controller.h"
 #include "cuttlefish/host/commands/run_cvd/server_loop.h"
 #include "cuttlefish/host/libs/command_util/runner/defs.h"
+#include "cuttlefish/host/libs/command_util/runner/run_cvd.pb.h"
 #include "cuttlefish/host/libs/command_util/util.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 #include "cuttlefish/host/libs/config/vmm_mode.h"
@@ -79,6 +82,17 @@ class ServerLoopImpl : public ServerLoop,
   Result<void> HandleScreenshotDisplay(
       const run_cvd::ScreenshotDisplay& request);
 
+  Result<run_cvd::InstanceStatus> CollectStatus(
+      ProcessMonitor& process_monitor);
+  // Replies to the query, and keeps the client as a watcher if requested.
+  Result<void> HandleStatusQuery(const run_cvd::StatusQuery& query,
+                                 SharedFD client,
+                                 ProcessMonitor& process_monitor);
+  // Sends the status to the watchers if it changed since the last report.
+  void PollStatus(ProcessMonitor& process_monitor);
+  void PublishStatus(const run_cvd::InstanceStatus& status);
+  void DropClosedStatusWatchers(const SharedFDSet& read_set);
+
   void HandleActionWithNoData(const LauncherAction action,
                               const SharedFD& client,
                               ProcessMonitor& process_monitor);
@@ -86,17 +100,20 @@ class ServerLoopImpl : public ServerLoop,
   void DeleteFifos();
   bool PowerwashFiles();
   void RestartRunCvd(int notification_fd);
-  static bool CreateQcowOverlay(const std::string& crosvm_path,
-                                const std::string& backing_file,
-                                const std::string& output_overlay_path);
-  Result<void> SuspendGuest();
+  static Result<void> CreateQcowOverlay(
+      const std::string& backing_file, const std::string& output_overlay_path);
   Result<void> ResumeGuest();
+  // The crosvm control socket of openwrt, if it runs in its own crosvm.
+  Result<std::optional<std::string>> OpenwrtControlSocket();
+  Result<std::string> MainVmControlSocket();
 
   static std::unordered_map<std::string, std::string>
   InitializeVmToControlSockPath(const CuttlefishConfig::InstanceSpecific&);
   Result<std::string> VmControlSocket() const;
-  Result<void> TakeGuestSnapshot(VmmMode, const std::string&);
-  Result<void> TakeCrosvmGuestSnapshot(const Json::Value&);
+  Result<void> TakeGuestSnapshot(VmmMode, const run_cvd::SnapshotTake&);
+  // Returns how long each part took.
+  Result<Json::Value> TakeCrosvmGuestSnapshot(const Json::Value&,
+                                              bool compress_memory);
 
   const CuttlefishConfig& config_;
   const CuttlefishConfig::InstanceSpecific instance_;
@@ -113,6 +130,12 @@ class ServerLoopImpl : public ServerLoop,
   // mapping from the name of vm_manager to control_sock path
   std::unordered_map<std::string, std::string> vm_name_to_control_sock_;
   std::atomic<DeviceStatus> device_status_;
+  // How long each part of the last suspend took, for the snapshot report.
+  Json::Value suspend_timing_;
+  // Clients of StatusQuery requests with `watch` set.
+  std::vector<SharedFD> status_watchers_;
+  // The last report sent to the watchers, without resource usage.
+  std::string last_status_key_;
 };
 
 }  // namespace run_cvd_impl
@@ -17,10 +17,15 @@
 #include <fcntl.h>
 #include <sys/wait.h>  // IWYU pragma: keep (siginfo_t)
 
+#include <chrono>
+#include <functional>
+#include <future>
+#include <optional>
 #include <ostream>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "absl/log/log.h"
@@ -112,56 +117,65 @@ static Result<void> ResumeCrosvm(const std::string& vm_sock_path) {
   return {};
 }
 
-Result<void> ServerLoopImpl::SuspendGuest() {
-  // If openwrt is running in crosvm, suspend it.
+// Runs the functions concurrently and waits for all of them to finish.
+static Result<void> RunConcurrently(
+    std::vector<std::function<Result<void>()>> functions) {
+  std::vector<std::future<Result<void>>> futures;
+  for (auto& function : functions) {
+    futures.emplace_back(std::async(std::launch::async, std::move(function)));
+  }
+  std::vector<Result<void>> results;
+  for (auto& future : futures) {
+    results.emplace_back(future.get());
+  }
+  for (Result<void>& result : results) {
+    CF_EXPECT(std::move(result));
+  }
+  return {};
+}
+
+Result<std::optional<std::string>> ServerLoopImpl::OpenwrtControlSocket() {
   const auto ap_vm_name = config_.ap_vm_manager();
-  if (instance_.ap_boot_flow() != APBootFlow::None &&
-      ap_vm_name == cuttlefish::kApName) {
-    const auto openwrt_sock =
-        GetSocketPath(ap_vm_name, vm_name_to_control_sock_);
-    if (openwrt_sock.empty()) {
-      return CF_ERR("The vm_manager " + ap_vm_name + " is not supported yet");
-    }
-    CF_EXPECT(SuspendCrosvm(openwrt_sock),
-              "failed to suspend openwrt crosvm instance.");
+  if (instance_.ap_boot_flow() == APBootFlow::None ||
+      ap_vm_name != cuttlefish::kApName) {
+    return std::nullopt;
   }
+  const auto openwrt_sock = GetSocketPath(ap_vm_name, vm_name_to_control_sock_);
+  if (openwrt_sock.empty()) {
+    return CF_ERR("The vm_manager " + ap_vm_name + " is not supported yet");
+  }
+  return openwrt_sock;
+}
+
+Result<std::string> ServerLoopImpl::MainVmControlSocket() {
   const VmmMode main_vmm = config_.vm_manager();
-  if (VmManagerIsCrosvm(main_vmm)) {
-    const auto& vm_sock =
-        GetSocketPath(ToString(main_vmm), vm_name_to_control_sock_);
-    if (vm_sock.empty()) {
-      return CF_ERR("The vm_manager " << main_vmm << " is not supported yet");
-    }
-    return SuspendCrosvm(vm_sock);
-  } else {
+  if (!VmManagerIsCrosvm(main_vmm)) {
+    return CF_ERR("The vm_manager " << main_vmm << " is not supported yet");
+  }
+  const auto vm_sock =
+      GetSocketPath(ToString(main_vmm), vm_name_to_control_sock_);
+  if (vm_sock.empty()) {
     return CF_ERR("The vm_manager " << main_vmm << " is not supported yet");
   }
+  return vm_sock;
 }
 
 Result<void> ServerLoopImpl::ResumeGuest() {
+  // openwrt and the main VM don't depend on each other, so they are resumed
+  // at the same time.
+  std::vector<std::function<Result<void>()>> resumes;
   // If openwrt is running in crosvm, resume it.
-  const auto ap_vm_name = config_.ap_vm_manager();
-  if (instance_.ap_boot_flow() != APBootFlow::None &&
-      ap_vm_name == cuttlefish::kApName) {
-    const auto& openwrt_sock =
-        GetSocketPath(ap_vm_name, vm_name_to_control_sock_);
-    if (openwrt_sock.empty()) {
-      return CF_ERR("The vm_manager " + ap_vm_name + " is not supported yet");
-    }
-    CF_EXPECT(ResumeCrosvm(openwrt_sock),
-              "failed to resume openwrt crosvm instance.");
-  }
-  const auto main_vmm = config_.vm_manager();
-  if (VmManagerIsCrosvm(main_vmm)) {
-    const auto& vm_sock =
-        GetSocketPath(ToString(main_vmm), vm_name_to_control_sock_);
-    if (vm_sock.empty()) {
-      return CF_ERR("The vm_manager " << main_vmm << " is not supported yet");
-    }
-    return ResumeCrosvm(vm_sock);
-  } else {
-    return CF_ERR("The vm_manager " << main_vmm << " is not supported yet");
+  if (auto openwrt_sock = CF_EXPECT(OpenwrtControlSocket())) {
+    resumes.emplace_back([openwrt_sock]() -> Result<void> {
+      CF_EXPECT(ResumeCrosvm(*openwrt_sock),
+                "failed to resume openwrt crosvm instance.");
+      return {};
+    });
   }
+  const std::string vm_sock = CF_EXPECT(MainVmControlSocket());
+  resumes.emplace_back([vm_sock]() { return ResumeCrosvm(vm_sock); });
+  CF_EXPECT(RunConcurrently(std::move(resumes)));
+  return {};
 }
 
 static Result<void> RunAdbShellCommand(
@@ -190,14 +204,72 @@ static Result<void> RunAdbShellCommand(
 
 Result<void> ServerLoopImpl::HandleSuspend(ProcessMonitor& process_monitor) {
   // right order: guest -> host
+  const auto start = std::chrono::steady_clock::now();
   VLOG(0) << "Suspending the guest..";
-  CF_EXPECT(RunAdbShellCommand(
-      instance_, {"su", "root", "/vendor/bin/snapshot_hook_pre_suspend"}));
-  CF_EXPECT(SuspendGuest());
+  // openwrt has no suspend hook, so it is suspended while the Android guest
+  // runs its hook. If either side fails, the VMs that did suspend are resumed
+  // so that a failed suspend leaves the device running.
+  std::vector<std::function<Result<void>()>> suspends;
+  const auto openwrt_sock = CF_EXPECT(OpenwrtControlSocket());
+  Json::Int64 openwrt_suspend_ms = 0;
+  bool openwrt_suspended = false;
+  if (openwrt_sock) {
+    suspends.emplace_back([&openwrt_sock, &openwrt_suspend_ms,
+                           &openwrt_suspended]() -> Result<void> {
+      const auto openwrt_start = std::chrono::steady_clock::now();
+      CF_EXPECT(SuspendCrosvm(*openwrt_sock),
+                "failed to suspend openwrt crosvm instance.");
+      openwrt_suspended = true;
+      openwrt_suspend_ms = MillisecondsSince(openwrt_start);
+      return {};
+    });
+  }
+  const std::string vm_sock = CF_EXPECT(MainVmControlSocket());
+  Json::Int64 hook_ms = 0;
+  Json::Int64 guest_suspend_ms = 0;
+  bool guest_suspended = false;
+  suspends.emplace_back([this, &vm_sock, &hook_ms, &guest_suspend_ms,
+                         &guest_suspended]() -> Result<void> {
+    const auto hook_start = std::chrono::steady_clock::now();
+    CF_EXPECT(RunAdbShellCommand(
+        instance_, {"su", "root", "/vendor/bin/snapshot_hook_pre_suspend"}));
+    hook_ms = MillisecondsSince(hook_start);
+    const auto guest_start = std::chrono::steady_clock::now();
+    CF_EXPECT(SuspendCrosvm(vm_sock));
+    guest_suspended = true;
+    guest_suspend_ms = MillisecondsSince(guest_start);
+    return {};
+  });
+  Result<void> suspended = RunConcurrently(std::move(suspends));
+  if (!suspended.has_value()) {
+    if (openwrt_suspended) {
+      Result<void> resumed = ResumeCrosvm(*openwrt_sock);
+      if (!resumed.has_value()) {
+        LOG(ERROR) << "Failed to resume openwrt after a failed suspend: "
+                   << resumed.error();
+      }
+    }
+    if (guest_suspended) {
+      Result<void> resumed = ResumeCrosvm(vm_sock);
+      if (!resumed.has_value()) {
+        LOG(ERROR) << "Failed to resume the guest after a failed suspend: "
+                   << resumed.error();
+      }
+    }
+    CF_EXPECT(std::move(suspended), "Failed to suspend the guest.");
+  }
   VLOG(0) << "The guest is suspended.";
+  const auto host_start = std::chrono::steady_clock::now();
   CF_EXPECT(process_monitor.SuspendMonitoredProcesses(),
             "Failed to suspend host processes.");
   VLOG(0) << "The host processes are suspended.";
+
+  suspend_timing_ = Json::Value(Json::objectValue);
+  suspend_timing_["openwrt_suspend_ms"] = openwrt_suspend_ms;
+  suspend_timing_["pre_suspend_hook_ms"] = hook_ms;
+  suspend_timing_["guest_suspend_ms"] = guest_suspend_ms;
+  suspend_timing_["host_processes_suspend_ms"] = MillisecondsSince(host_start);
+  suspend_timing_["total_ms"] = MillisecondsSince(start);
   return {};
 }
 
@@ -214,41 +286,16 @@ Result<void> ServerLoopImpl::HandleResume(ProcessMonitor& process_monitor) {
   return {};
 }
 
-Result<void> ServerLoopImpl::TakeCrosvmGuestSnapshot(
-    const Json::Value& meta_json) {
-  const auto snapshots_parent_dir =
-      CF_EXPECT(InstanceGuestSnapshotPath(meta_json, instance_.id()));
-  const auto crosvm_bin = config_.crosvm_binary();
-  const std::string snapshot_guest_param =
-      snapshots_parent_dir + "/" + kGuestSnapshotBase;
-  // If openwrt is running in crosvm, snapshot it.
-  const auto ap_vm_name = config_.ap_vm_manager();
-  if (instance_.ap_boot_flow() != APBootFlow::None &&
-      ap_vm_name == cuttlefish::kApName) {
-    const auto& openwrt_sock =
-        GetSocketPath(ap_vm_name, vm_name_to_control_sock_);
-    if (openwrt_sock.empty()) {
-      return CF_ERR("The vm_manager " + ap_vm_name + " is not supported yet");
-    }
-    std::vector<std::string> openwrt_crosvm_command_args{
-        crosvm_bin, "snapshot", "take", snapshot_guest_param + "_openwrt",
-        openwrt_sock};
-    VLOG(0) << "Running the following command to take snapshot..." << std::endl
-            << "  ";
-    for (const auto& arg : openwrt_crosvm_command_args) {
-      VLOG(0) << arg << " ";
-    }
-    CF_EXPECT(Execute(openwrt_crosvm_command_args) == 0,
-              "Executing openwrt crosvm command returned -1");
-    VLOG(0) << "Guest snapshot for openwrt instance #" << instance_.id()
-            << " should have been stored in " << snapshots_parent_dir
-            << "_openwrt";
+static Result<void> TakeCrosvmSnapshot(const std::string& crosvm_bin,
+                                       const std::string& snapshot_param,
+                                       const std::string& control_socket,
+                                       bool compress_memory) {
+  std::vector<std::string> crosvm_command_args{crosvm_bin, "snapshot", "take"};
+  if (compress_memory) {
+    crosvm_command_args.emplace_back("--compress-memory");
   }
-  const auto control_socket_path =
-      CF_EXPECT(VmControlSocket(), "Failed to find crosvm control.sock path.");
-  std::vector<std::string> crosvm_command_args{crosvm_bin, "snapshot", "take",
-                                               snapshot_guest_param,
-                                               control_socket_path};
+  crosvm_command_args.emplace_back(snapshot_param);
+  crosvm_command_args.emplace_back(control_socket);
   VLOG(0) << "Running the following command to take snapshot..." << std::endl
           << "  ";
   for (const auto& arg : crosvm_command_args) {
@@ -256,16 +303,63 @@ Result<void> ServerLoopImpl::TakeCrosvmGuestSnapshot(
   }
   CF_EXPECT(Execute(crosvm_command_args) == 0,
             "Executing crosvm command failed");
-  VLOG(0) << "Guest snapshot for instance #" << instance_.id()
-          << " should have been stored in " << snapshots_parent_dir;
   return {};
 }
 
+Result<Json::Value> ServerLoopImpl::TakeCrosvmGuestSnapshot(
+    const Json::Value& meta_json, bool compress_memory) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto snapshots_parent_dir =
+      CF_EXPECT(InstanceGuestSnapshotPath(meta_json, instance_.id()));
+  const auto crosvm_bin = config_.crosvm_binary();
+  const std::string snapshot_guest_param =
+      snapshots_parent_dir + "/" + kGuestSnapshotBase;
+  // The snapshots of openwrt and the main VM are independent of each other,
+  // so they are written at the same time.
+  std::vector<std::function<Result<void>()>> snapshots;
+  Json::Int64 openwrt_snapshot_ms = 0;
+  // If openwrt is running in crosvm, snapshot it.
+  if (auto openwrt_sock = CF_EXPECT(OpenwrtControlSocket())) {
+    snapshots.emplace_back([&, openwrt_sock]() -> Result<void> {
+      const auto openwrt_start = std::chrono::steady_clock::now();
+      CF_EXPECT(TakeCrosvmSnapshot(crosvm_bin,
+                                   snapshot_guest_param + "_openwrt",
+                                   *openwrt_sock, compress_memory),
+                "Executing openwrt crosvm command returned -1");
+      openwrt_snapshot_ms = MillisecondsSince(openwrt_start);
+      VLOG(0) << "Guest snapshot for openwrt instance #" << instance_.id()
+              << " should have been stored in " << snapshots_parent_dir
+              << "_openwrt";
+      return {};
+    });
+  }
+  const auto control_socket_path =
+      CF_EXPECT(VmControlSocket(), "Failed to find crosvm control.sock path.");
+  Json::Int64 guest_snapshot_ms = 0;
+  snapshots.emplace_back([&]() -> Result<void> {
+    const auto guest_start = std::chrono::steady_clock::now();
+    CF_EXPECT(TakeCrosvmSnapshot(crosvm_bin, snapshot_guest_param,
+                                 control_socket_path, compress_memory));
+    guest_snapshot_ms = MillisecondsSince(guest_start);
+    VLOG(0) << "Guest snapshot for instance #" << instance_.id()
+            << " should have been stored in " << snapshots_parent_dir;
+    return {};
+  });
+  CF_EXPECT(RunConcurrently(std::move(snapshots)));
+
+  Json::Value timing;
+  timing["openwrt_snapshot_ms"] = openwrt_snapshot_ms;
+  timing["guest_snapshot_ms"] = guest_snapshot_ms;
+  timing["total_ms"] = MillisecondsSince(start);
+  return timing;
+}
+
 /*
  * Parse json file at json_path, and take guest snapshot
  */
-Result<void> ServerLoopImpl::TakeGuestSnapshot(VmmMode vm_manager,
-                                               const std::string& json_path) {
+Result<void> ServerLoopImpl::TakeGuestSnapshot(
+    VmmMode vm_manager, const run_cvd::SnapshotTake& snapshot_take) {
+  const std::string& json_path = snapshot_take.snapshot_path();
   // common code across vm_manager
   CF_EXPECTF(FileExists(json_path), "{} must exist but does not.", json_path);
   SharedFD json_fd = SharedFD::Open(json_path, O_RDONLY);
@@ -276,8 +370,19 @@ Result<void> ServerLoopImpl::TakeGuestSnapshot(VmmMode vm_manager,
       ParseJson(json_contents), "Failed to parse json: \n{}", json_contents);
   CF_EXPECTF(VmManagerIsCrosvm(vm_manager),
              "{}, which is not crosvm, is not yet supported.", vm_manager);
-  CF_EXPECT(TakeCrosvmGuestSnapshot(meta_json),
-            "TakeCrosvmGuestSnapshot() failed.");
+  Json::Value timing;
+  timing["suspend"] = suspend_timing_;
+  timing["snapshot"] = CF_EXPECT(
+      TakeCrosvmGuestSnapshot(meta_json, snapshot_take.compress_memory()),
+      "TakeCrosvmGuestSnapshot() failed.");
+
+  // snapshot_util_cvd moves the report into the snapshot meta information.
+  const std::string timing_path =
+      CF_EXPECT(InstanceGuestSnapshotPath(meta_json, instance_.id())) + "/" +
+      kSnapshotTimingFileName;
+  CF_EXPECTF(android::base::WriteStringToFile(timing.toStyledString(),
+                                              timing_path),
+             "Failed to write \"{}\"", timing_path);
   return {};
 }
 
@@ -285,9 +390,8 @@ Result<void> ServerLoopImpl::HandleSnapshotTake(
     const run_cvd::SnapshotTake& snapshot_take) {
   CF_EXPECT(!snapshot_take.snapshot_path().empty(),
             "snapshot_path must be non-empty");
-  CF_EXPECT(
-      TakeGuestSnapshot(config_.vm_manager(), snapshot_take.snapshot_path()),
-      "Failed to take guest snapshot");
+  CF_EXPECT(TakeGuestSnapshot(config_.vm_manager(), snapshot_take),
+            "Failed to take guest snapshot");
   return {};
 }
 
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "fmt/format.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/fs/shared_select.h"
+#include "cuttlefish/host/commands/run_cvd/server_loop_impl.h"
+#include "cuttlefish/host/libs/command_util/runner/defs.h"
+#include "cuttlefish/host/libs/command_util/runner/run_cvd.pb.h"
+#include "cuttlefish/host/libs/command_util/util.h"
+#include "cuttlefish/host/libs/process_monitor/process_monitor.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace run_cvd_impl {
+namespace {
+
+run_cvd::InstanceStatus::DeviceState ToProto(
+    ServerLoopImpl::DeviceStatus status) {
+  switch (status) {
+    case ServerLoopImpl::DeviceStatus::kActive:
+      return run_cvd::InstanceStatus::DEVICE_STATE_ACTIVE;
+    case ServerLoopImpl::DeviceStatus::kSuspended:
+      return run_cvd::InstanceStatus::DEVICE_STATE_SUSPENDED;
+    case ServerLoopImpl::DeviceStatus::kUnknown:
+      return run_cvd::InstanceStatus::DEVICE_STATE_UNKNOWN;
+  }
+  return run_cvd::InstanceStatus::DEVICE_STATE_UNKNOWN;
+}
+
+run_cvd::ProcessStatus::State ToProto(MonitoredProcessStats::State state) {
+  switch (state) {
+    case MonitoredProcessStats::State::kRunning:
+      return run_cvd::ProcessStatus::STATE_RUNNING;
+    case MonitoredProcessStats::State::kRestartPending:
+      return run_cvd::ProcessStatus::STATE_RESTART_PENDING;
+    case MonitoredProcessStats::State::kExited:
+      return run_cvd::ProcessStatus::STATE_EXITED;
+  }
+  return run_cvd::ProcessStatus::STATE_EXITED;
+}
+
+// Resource usage changes on every poll, so it is left out when deciding
+// whether watchers need a new report.
+std::string ChangeKey(run_cvd::InstanceStatus status) {
+  for (run_cvd::ProcessStatus& process : *status.mutable_processes()) {
+    process.clear_cpu_time_ms();
+    process.clear_rss_bytes();
+  }
+  return status.SerializeAsString();
+}
+
+}  // namespace
+
+Result<run_cvd::InstanceStatus> ServerLoopImpl::CollectStatus(
+    ProcessMonitor& process_monitor) {
+  run_cvd::InstanceStatus status;
+  status.set_instance_name(instance_.instance_name());
+  status.set_device_state(ToProto(device_status_.load()));
+  status.set_adb_serial(
+      fmt::format("127.0.0.1:{}", instance_.adb_host_port()));
+  for (const auto& display : instance_.display_configs()) {
+    status.add_displays(fmt::format("{} x {} ( {} )", display.width,
+                                    display.height, display.dpi));
+  }
+  std::vector<MonitoredProcessStats> processes =
+      CF_EXPECT(process_monitor.QueryMonitoredProcessStats());
+  for (const MonitoredProcessStats& stats : processes) {
+    run_cvd::ProcessStatus* process = status.add_processes();
+    process->set_name(stats.name);
+    process->set_state(ToProto(stats.state));
+    process->set_pid(stats.pid);
+    process->set_restarts(stats.restarts);
+    process->set_cpu_time_ms(stats.cpu_time.count());
+    process->set_rss_bytes(stats.rss_bytes);
+  }
+  return status;
+}
+
+Result<void> ServerLoopImpl::HandleStatusQuery(
+    const run_cvd::StatusQuery& query, SharedFD client,
+    ProcessMonitor& process_monitor) {
+  VLOG(0) << "Run_cvd received status query.";
+  run_cvd::InstanceStatus status = CF_EXPECT(CollectStatus(process_monitor));
+  auto response = LauncherResponse::kSuccess;
+  CF_EXPECTF(client->Send(&response, sizeof(response), MSG_NOSIGNAL) ==
+                 sizeof(response),
+             "Failed to write response: {}", client->StrError());
+  CF_EXPECT(WriteLauncherStatus(client, status));
+  if (query.watch()) {
+    // Updates are written from the control loop, which must not wait on a
+    // watcher that stopped reading. A write that would block fails and drops
+    // the watcher instead.
+    const int flags = client->Fcntl(F_GETFL, 0);
+    CF_EXPECTF(flags >= 0, "Failed to get watcher flags: {}",
+               client->StrError());
+    CF_EXPECTF(client->Fcntl(F_SETFL, flags | O_NONBLOCK) == 0,
+               "Failed to make watcher non-blocking: {}", client->StrError());
+    // Brings the other watchers up to date with what the new one was sent.
+    PublishStatus(status);
+    status_watchers_.emplace_back(std::move(client));
+  }
+  return {};
+}
+
+void ServerLoopImpl::PollStatus(ProcessMonitor& process_monitor) {
+  if (status_watchers_.empty()) {
+    return;
+  }
+  Result<run_cvd::InstanceStatus> status = CollectStatus(process_monitor);
+  if (!status.has_value()) {
+    LOG(ERROR) << "Failed to collect status for watchers: " << status.error();
+    return;
+  }
+  PublishStatus(*status);
+}
+
+void ServerLoopImpl::PublishStatus(const run_cvd::InstanceStatus& status) {
+  std::string key = ChangeKey(status);
+  if (key == last_status_key_) {
+    return;
+  }
+  last_status_key_ = std::move(key);
+  std::erase_if(status_watchers_, [&status](const SharedFD& watcher) {
+    Result<void> written = WriteLauncherStatus(watcher, status);
+    if (!written.has_value()) {
+      VLOG(0) << "Dropping status watcher: " << written.error();
+    }
+    return !written.has_value();
+  });
+}
+
+void ServerLoopImpl::DropClosedStatusWatchers(const SharedFDSet& read_set) {
+  // Watchers send nothing after their query, so a readable watcher has hung
+  // up.
+  std::erase_if(status_watchers_, [&read_set](const SharedFD& watcher) {
+    return read_set.IsSet(watcher);
+  });
+}
+
+}  // namespace run_cvd_impl
+}  // namespace cuttlefish
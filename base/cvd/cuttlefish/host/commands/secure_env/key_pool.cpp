@@ -0,0 +1,255 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/secure_env/key_pool.h"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+
+#include <openssl/bn.h>
+#include <openssl/ec_key.h>
+#include <openssl/err.h>
+#include <openssl/nid.h>
+#include <openssl/rsa.h>
+
+#include "absl/log/log.h"
+
+namespace cuttlefish {
+namespace {
+
+// The stats are logged after this many requests.
+constexpr uint64_t kStatsLogInterval = 100;
+// Added to the niceness of the workers, so that they run when the request
+// threads don't.
+constexpr int kWorkerNiceness = 10;
+
+using Microseconds = std::chrono::microseconds;
+
+std::string OpenSslError() {
+  char buf[256];
+  ERR_error_string_n(ERR_get_error(), buf, sizeof(buf));
+  return buf;
+}
+
+Result<PooledKey> GenerateRsaKey(int bits) {
+  std::unique_ptr<BIGNUM, decltype(&BN_free)> exponent(BN_new(), BN_free);
+  std::unique_ptr<RSA, decltype(&RSA_free)> rsa(RSA_new(), RSA_free);
+  PooledKey key(EVP_PKEY_new(), EVP_PKEY_free);
+  CF_EXPECT(exponent && rsa && key, "Allocation failed");
+  CF_EXPECT_EQ(BN_set_word(exponent.get(), RSA_F4), 1, OpenSslError());
+  CF_EXPECT_EQ(RSA_generate_key_ex(rsa.get(), bits, exponent.get(), nullptr),
+               1, OpenSslError());
+  CF_EXPECT_EQ(EVP_PKEY_assign_RSA(key.get(), rsa.release()), 1,
+               OpenSslError());
+  return key;
+}
+
+Result<PooledKey> GenerateEcKey(int curve_nid) {
+  std::unique_ptr<EC_KEY, decltype(&EC_KEY_free)> ec(
+      EC_KEY_new_by_curve_name(curve_nid), EC_KEY_free);
+  PooledKey key(EVP_PKEY_new(), EVP_PKEY_free);
+  CF_EXPECT(ec && key, "Allocation failed");
+  CF_EXPECT_EQ(EC_KEY_generate_key(ec.get()), 1, OpenSslError());
+  CF_EXPECT_EQ(EVP_PKEY_assign_EC_KEY(key.get(), ec.release()), 1,
+               OpenSslError());
+  return key;
+}
+
+double MeanMilliseconds(Microseconds total, uint64_t count) {
+  return count == 0 ? 0 : total.count() / 1000.0 / count;
+}
+
+}  // namespace
+
+std::string_view PooledKeyTypeName(PooledKeyType type) {
+  switch (type) {
+    case PooledKeyType::kRsa2048:
+      return "RSA-2048";
+    case PooledKeyType::kRsa3072:
+      return "RSA-3072";
+    case PooledKeyType::kEcP256:
+      return "EC P-256";
+  }
+  return "unknown";
+}
+
+Result<PooledKey> GeneratePooledKey(PooledKeyType type) {
+  switch (type) {
+    case PooledKeyType::kRsa2048:
+      return CF_EXPECT(GenerateRsaKey(2048));
+    case PooledKeyType::kRsa3072:
+      return CF_EXPECT(GenerateRsaKey(3072));
+    case PooledKeyType::kEcP256:
+      return CF_EXPECT(GenerateEcKey(NID_X9_62_prime256v1));
+  }
+  return CF_ERRF("Unknown key type {}", static_cast<int>(type));
+}
+
+KeyPool::KeyPool(KeyPoolOptions options) : options_(std::move(options)) {
+  for (PooledKeyType type : options_.types) {
+    pools_[type];
+  }
+}
+
+Result<std::unique_ptr<KeyPool>> KeyPool::Create(KeyPoolOptions options) {
+  CF_EXPECT_GT(options.low_watermark, 0u);
+  CF_EXPECT_LE(options.low_watermark, options.high_watermark);
+  CF_EXPECT_GT(options.threads, 0u);
+  std::unique_ptr<KeyPool> pool(new KeyPool(std::move(options)));
+  for (size_t i = 0; i < pool->options_.threads; i++) {
+    pool->workers_.emplace_back([pool = pool.get()]() { pool->WorkerLoop(); });
+  }
+  return pool;
+}
+
+KeyPool::~KeyPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+PooledKey KeyPool::Take(PooledKeyType type) {
+  std::lock_guard lock(mutex_);
+  auto it = pools_.find(type);
+  if (it == pools_.end()) {
+    return PooledKey(nullptr, EVP_PKEY_free);
+  }
+  Pool& pool = it->second;
+  PooledKey key(nullptr, EVP_PKEY_free);
+  if (pool.keys.empty()) {
+    pool.stats.misses++;
+  } else {
+    key = std::move(pool.keys.front());
+    pool.keys.pop_front();
+    pool.stats.hits++;
+  }
+  if (!pool.refilling && pool.keys.size() < options_.low_watermark) {
+    pool.refilling = true;
+    cv_.notify_one();
+  }
+  return key;
+}
+
+void KeyPool::RecordLatency(PooledKeyType type, bool hit,
+                            std::chrono::steady_clock::duration latency) {
+  std::map<PooledKeyType, KeyPoolStats> to_log;
+  {
+    std::lock_guard lock(mutex_);
+    auto it = pools_.find(type);
+    if (it == pools_.end()) {
+      return;
+    }
+    KeyPoolStats& stats = it->second.stats;
+    (hit ? stats.hit_latency : stats.miss_latency) +=
+        std::chrono::duration_cast<Microseconds>(latency);
+    if (++requests_ % kStatsLogInterval != 0) {
+      return;
+    }
+    for (const auto& [pool_type, pool] : pools_) {
+      to_log[pool_type] = pool.stats;
+      to_log[pool_type].available = pool.keys.size();
+    }
+  }
+  for (const auto& [pool_type, stats] : to_log) {
+    LogStats(pool_type, stats);
+  }
+}
+
+KeyPoolStats KeyPool::Stats(PooledKeyType type) const {
+  std::lock_guard lock(mutex_);
+  auto it = pools_.find(type);
+  if (it == pools_.end()) {
+    return {};
+  }
+  KeyPoolStats stats = it->second.stats;
+  stats.available = it->second.keys.size();
+  return stats;
+}
+
+KeyPool::Pool* KeyPool::NextToGenerate(PooledKeyType* type) {
+  Pool* next = nullptr;
+  for (auto& [pool_type, pool] : pools_) {
+    const size_t pending = pool.keys.size() + pool.in_flight;
+    if (!pool.refilling || pending >= options_.high_watermark) {
+      continue;
+    }
+    if (next == nullptr || pending < next->keys.size() + next->in_flight) {
+      next = &pool;
+      *type = pool_type;
+    }
+  }
+  return next;
+}
+
+void KeyPool::WorkerLoop() {
+  if (setpriority(PRIO_PROCESS, gettid(), kWorkerNiceness) != 0) {
+    PLOG(WARNING) << "Failed to lower the key pool worker priority";
+  }
+  std::unique_lock lock(mutex_);
+  while (true) {
+    PooledKeyType type;
+    Pool* pool = nullptr;
+    cv_.wait(lock, [this, &type, &pool]() {
+      return stopping_ || (pool = NextToGenerate(&type)) != nullptr;
+    });
+    if (stopping_) {
+      return;
+    }
+    pool->in_flight++;
+    lock.unlock();
+    const auto begin = std::chrono::steady_clock::now();
+    Result<PooledKey> key = GeneratePooledKey(type);
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    lock.lock();
+
+    pool->in_flight--;
+    if (!key.has_value()) {
+      LOG(ERROR) << "Failed to generate a " << PooledKeyTypeName(type)
+                 << " key: " << key.error();
+      // Retried once a request takes the pool below the low watermark again.
+      pool->refilling = false;
+      continue;
+    }
+    pool->keys.push_back(std::move(*key));
+    pool->stats.generated++;
+    pool->stats.generation_time +=
+        std::chrono::duration_cast<Microseconds>(elapsed);
+    if (pool->keys.size() >= options_.high_watermark) {
+      pool->refilling = false;
+    }
+  }
+}
+
+void KeyPool::LogStats(PooledKeyType type, const KeyPoolStats& stats) const {
+  const uint64_t requests = stats.hits + stats.misses;
+  LOG(INFO) << PooledKeyTypeName(type) << " key pool: " << stats.hits << "/"
+            << requests << " hits, " << stats.available << " available, "
+            << MeanMilliseconds(stats.hit_latency, stats.hits)
+            << "ms per hit, "
+            << MeanMilliseconds(stats.miss_latency, stats.misses)
+            << "ms per miss, "
+            << MeanMilliseconds(stats.generation_time, stats.generated)
+            << "ms per background key";
+}
+
+}  // namespace cuttlefish
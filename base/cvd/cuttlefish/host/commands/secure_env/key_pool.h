@@ -0,0 +1,124 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <openssl/evp.h>
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+enum class PooledKeyType {
+  kRsa2048,
+  kRsa3072,
+  kEcP256,
+};
+
+std::string_view PooledKeyTypeName(PooledKeyType type);
+
+struct KeyPoolOptions {
+  // A pool is refilled once it holds fewer than `low_watermark` keys, until it
+  // holds `high_watermark` keys.
+  size_t low_watermark = 2;
+  size_t high_watermark = 4;
+  size_t threads = 1;
+  std::vector<PooledKeyType> types = {
+      PooledKeyType::kRsa2048,
+      PooledKeyType::kRsa3072,
+      PooledKeyType::kEcP256,
+  };
+};
+
+struct KeyPoolStats {
+  size_t available = 0;
+  // Keys generated in the background, and the time spent on them.
+  uint64_t generated = 0;
+  std::chrono::microseconds generation_time{0};
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // Total time spent serving the requests that were hits and misses.
+  std::chrono::microseconds hit_latency{0};
+  std::chrono::microseconds miss_latency{0};
+};
+
+using PooledKey = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+
+/**
+ * Generates RSA and EC private keys on background threads, running at a lower
+ * priority than the request threads, so that key generation requests can take
+ * a ready key instead of waiting for one to be generated.
+ *
+ * Only the key material comes from the pool: the callers still seal the key
+ * and produce its certificates per request.
+ *
+ * This class is thread-safe.
+ */
+class KeyPool {
+ public:
+  static Result<std::unique_ptr<KeyPool>> Create(KeyPoolOptions options);
+  ~KeyPool();
+
+  // Returns a ready key of `type`, or null if there is none and the caller
+  // has to generate the key itself.
+  PooledKey Take(PooledKeyType type);
+  // Records how long serving a request for a key of `type` took.
+  void RecordLatency(PooledKeyType type, bool hit,
+                     std::chrono::steady_clock::duration latency);
+
+  KeyPoolStats Stats(PooledKeyType type) const;
+
+ private:
+  struct Pool {
+    std::deque<PooledKey> keys;
+    size_t in_flight = 0;
+    bool refilling = true;
+    KeyPoolStats stats;
+  };
+
+  explicit KeyPool(KeyPoolOptions options);
+
+  // The type to generate a key of next, if any. Requires `mutex_`.
+  Pool* NextToGenerate(PooledKeyType* type);
+  void WorkerLoop();
+  void LogStats(PooledKeyType type, const KeyPoolStats& stats) const;
+
+  const KeyPoolOptions options_;
+
+  mutable std::mutex mutex_;
+  std::map<PooledKeyType, Pool> pools_;
+  uint64_t requests_ = 0;
+  bool stopping_ = false;
+  std::condition_variable cv_;
+  std::vector<std::thread> workers_;
+};
+
+// Generates a key of `type` on the calling thread.
+Result<PooledKey> GeneratePooledKey(PooledKeyType type);
+
+}  // namespace cuttlefish
@@ -0,0 +1,127 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/secure_env/key_pool.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <openssl/evp.h>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+std::unique_ptr<KeyPool> CreateOrDie(KeyPoolOptions options) {
+  Result<std::unique_ptr<KeyPool>> pool = KeyPool::Create(std::move(options));
+  EXPECT_THAT(pool, IsOk());
+  return pool.has_value() ? std::move(*pool) : nullptr;
+}
+
+// Waits for the pool of `type` to hold `count` keys.
+bool WaitForKeys(const KeyPool& pool, PooledKeyType type, size_t count) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (pool.Stats(type).available >= count) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return false;
+}
+
+TEST(KeyPoolTest, GeneratesEveryType) {
+  for (PooledKeyType type : {PooledKeyType::kRsa2048, PooledKeyType::kRsa3072,
+                             PooledKeyType::kEcP256}) {
+    Result<PooledKey> key = GeneratePooledKey(type);
+    ASSERT_THAT(key, IsOk()) << PooledKeyTypeName(type);
+    EXPECT_EQ(EVP_PKEY_id(key->get()), type == PooledKeyType::kEcP256
+                                           ? EVP_PKEY_EC
+                                           : EVP_PKEY_RSA);
+    EXPECT_EQ(EVP_PKEY_bits(key->get()), type == PooledKeyType::kRsa2048 ? 2048
+                                         : type == PooledKeyType::kRsa3072
+                                             ? 3072
+                                             : 256);
+  }
+}
+
+TEST(KeyPoolTest, FillsToHighWatermark) {
+  std::unique_ptr<KeyPool> pool = CreateOrDie({
+      .low_watermark = 2,
+      .high_watermark = 3,
+      .types = {PooledKeyType::kEcP256},
+  });
+  ASSERT_NE(pool, nullptr);
+  ASSERT_TRUE(WaitForKeys(*pool, PooledKeyType::kEcP256, 3));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(pool->Stats(PooledKeyType::kEcP256).available, 3u);
+  EXPECT_EQ(pool->Stats(PooledKeyType::kEcP256).generated, 3u);
+}
+
+TEST(KeyPoolTest, RefillsBelowLowWatermark) {
+  std::unique_ptr<KeyPool> pool = CreateOrDie({
+      .low_watermark = 2,
+      .high_watermark = 4,
+      .types = {PooledKeyType::kEcP256},
+  });
+  ASSERT_NE(pool, nullptr);
+  ASSERT_TRUE(WaitForKeys(*pool, PooledKeyType::kEcP256, 4));
+
+  // Still at the low watermark, so nothing is generated.
+  EXPECT_NE(pool->Take(PooledKeyType::kEcP256), nullptr);
+  EXPECT_NE(pool->Take(PooledKeyType::kEcP256), nullptr);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(pool->Stats(PooledKeyType::kEcP256).generated, 4u);
+
+  EXPECT_NE(pool->Take(PooledKeyType::kEcP256), nullptr);
+  ASSERT_TRUE(WaitForKeys(*pool, PooledKeyType::kEcP256, 4));
+  EXPECT_EQ(pool->Stats(PooledKeyType::kEcP256).generated, 7u);
+}
+
+TEST(KeyPoolTest, CountsHitsAndMisses) {
+  std::unique_ptr<KeyPool> pool = CreateOrDie({
+      .low_watermark = 1,
+      .high_watermark = 1,
+      .types = {PooledKeyType::kEcP256},
+  });
+  ASSERT_NE(pool, nullptr);
+  ASSERT_TRUE(WaitForKeys(*pool, PooledKeyType::kEcP256, 1));
+
+  EXPECT_NE(pool->Take(PooledKeyType::kEcP256), nullptr);
+  pool->RecordLatency(PooledKeyType::kEcP256, true,
+                      std::chrono::milliseconds(1));
+  // Not pooled.
+  EXPECT_EQ(pool->Take(PooledKeyType::kRsa2048), nullptr);
+
+  KeyPoolStats stats = pool->Stats(PooledKeyType::kEcP256);
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.hit_latency, std::chrono::milliseconds(1));
+  EXPECT_EQ(pool->Stats(PooledKeyType::kRsa2048).misses, 0u);
+}
+
+TEST(KeyPoolTest, RejectsBadWatermarks) {
+  EXPECT_THAT(KeyPool::Create({.low_watermark = 0}), IsError());
+  EXPECT_THAT(KeyPool::Create({.low_watermark = 3, .high_watermark = 2}),
+              IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -0,0 +1,224 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/secure_env/pooled_key_factory.h"
+
+#include <stdint.h>
+
+#include <chrono>
+#include <optional>
+#include <utility>
+
+#include <keymaster/km_openssl/ec_key.h>
+#include <keymaster/km_openssl/openssl_utils.h>
+#include <keymaster/km_openssl/rsa_key.h>
+#include <openssl/rsa.h>
+
+namespace cuttlefish {
+namespace {
+
+using keymaster::AuthorizationSet;
+using keymaster::CertificateChain;
+using keymaster::Key;
+using keymaster::KeymasterBlob;
+using keymaster::KeymasterContext;
+using keymaster::KeymasterKeyBlob;
+using keymaster::SoftwareKeyBlobMaker;
+using keymaster::UniquePtr;
+
+std::optional<PooledKeyType> RsaPoolType(const AuthorizationSet& description) {
+  uint64_t public_exponent;
+  uint32_t key_size;
+  if (!description.GetTagValue(keymaster::TAG_RSA_PUBLIC_EXPONENT,
+                               &public_exponent) ||
+      public_exponent != RSA_F4 ||
+      !description.GetTagValue(keymaster::TAG_KEY_SIZE, &key_size)) {
+    return std::nullopt;
+  }
+  switch (key_size) {
+    case 2048:
+      return PooledKeyType::kRsa2048;
+    case 3072:
+      return PooledKeyType::kRsa3072;
+    default:
+      return std::nullopt;
+  }
+}
+
+std::optional<PooledKeyType> EcPoolType(const AuthorizationSet& description) {
+  keymaster_ec_curve_t curve;
+  uint32_t key_size;
+  if (!description.GetTagValue(keymaster::TAG_EC_CURVE, &curve) ||
+      curve != KM_EC_CURVE_P_256) {
+    return std::nullopt;
+  }
+  if (description.GetTagValue(keymaster::TAG_KEY_SIZE, &key_size) &&
+      key_size != 256) {
+    return std::nullopt;
+  }
+  return PooledKeyType::kEcP256;
+}
+
+// Keys that can't sign get a self-signed certificate with a fake signature.
+bool CanSignCertificate(const AuthorizationSet& description) {
+  return description.Contains(keymaster::TAG_PURPOSE, KM_PURPOSE_SIGN) ||
+         description.Contains(keymaster::TAG_PURPOSE, KM_PURPOSE_ATTEST_KEY);
+}
+
+/*
+ * What RsaKeyFactory::GenerateKey and EcKeyFactory::GenerateKey do once they
+ * have generated the private key: seal it into `key_blob`, and from KeyMint 1
+ * on, attest it or self-sign a certificate for it.
+ *
+ * `make_key` wraps the private key in the Key type of the factory.
+ */
+template <typename MakeKey>
+keymaster_error_t SealAndCertify(
+    const SoftwareKeyBlobMaker& blob_maker, const KeymasterContext& context,
+    const AuthorizationSet& key_description,
+    const AuthorizationSet& authorizations, EVP_PKEY* pkey, MakeKey make_key,
+    UniquePtr<Key> attest_key, const KeymasterBlob& issuer_subject,
+    KeymasterKeyBlob* key_blob, AuthorizationSet* hw_enforced,
+    AuthorizationSet* sw_enforced, CertificateChain* cert_chain) {
+  KeymasterKeyBlob key_material;
+  keymaster_error_t error = keymaster::EvpKeyToKeyMaterial(pkey, &key_material);
+  if (error != KM_ERROR_OK) {
+    return error;
+  }
+  error = blob_maker.CreateKeyBlob(authorizations, KM_ORIGIN_GENERATED,
+                                   key_material, key_blob, hw_enforced,
+                                   sw_enforced);
+  if (error != KM_ERROR_OK) {
+    return error;
+  }
+
+  // Keymaster attests keys with a separate attestKey call.
+  if (context.GetKmVersion() < keymaster::KmVersion::KEYMINT_1) {
+    return KM_ERROR_OK;
+  }
+  if (!cert_chain) {
+    return KM_ERROR_UNEXPECTED_NULL_POINTER;
+  }
+  UniquePtr<Key> key = make_key(*hw_enforced, *sw_enforced);
+  if (key_description.Contains(keymaster::TAG_ATTESTATION_CHALLENGE)) {
+    *cert_chain = context.GenerateAttestation(
+        *key, key_description, std::move(attest_key), issuer_subject, &error);
+  } else if (attest_key.get() != nullptr) {
+    return KM_ERROR_ATTESTATION_CHALLENGE_MISSING;
+  } else {
+    *cert_chain = context.GenerateSelfSignedCertificate(
+        *key, key_description, !CanSignCertificate(key_description), &error);
+  }
+  return error;
+}
+
+}  // namespace
+
+PooledRsaKeyFactory::PooledRsaKeyFactory(
+    const SoftwareKeyBlobMaker& blob_maker, const KeymasterContext& context,
+    KeyPool& pool)
+    : keymaster::RsaKeyFactory(blob_maker, context),
+      pool_blob_maker_(blob_maker),
+      pool_context_(context),
+      pool_(pool) {}
+
+keymaster_error_t PooledRsaKeyFactory::GenerateKey(
+    const AuthorizationSet& key_description, UniquePtr<Key> attest_key,
+    const KeymasterBlob& issuer_subject, KeymasterKeyBlob* key_blob,
+    AuthorizationSet* hw_enforced, AuthorizationSet* sw_enforced,
+    CertificateChain* cert_chain) const {
+  const auto begin = std::chrono::steady_clock::now();
+  std::optional<PooledKeyType> type = RsaPoolType(key_description);
+  PooledKey pkey =
+      type ? pool_.Take(*type) : PooledKey(nullptr, EVP_PKEY_free);
+  if (!pkey) {
+    keymaster_error_t error = keymaster::RsaKeyFactory::GenerateKey(
+        key_description, std::move(attest_key), issuer_subject, key_blob,
+        hw_enforced, sw_enforced, cert_chain);
+    if (type) {
+      pool_.RecordLatency(*type, false,
+                          std::chrono::steady_clock::now() - begin);
+    }
+    return error;
+  }
+  if (!key_blob || !hw_enforced || !sw_enforced) {
+    return KM_ERROR_OUTPUT_PARAMETER_NULL;
+  }
+
+  keymaster::RSA_Ptr rsa(EVP_PKEY_get1_RSA(pkey.get()));
+  auto make_key = [this, &rsa](const AuthorizationSet& hw_enforced,
+                               const AuthorizationSet& sw_enforced) {
+    return UniquePtr<Key>(
+        new keymaster::RsaKey(hw_enforced, sw_enforced, this, std::move(rsa)));
+  };
+  keymaster_error_t error = SealAndCertify(
+      pool_blob_maker_, pool_context_, key_description, key_description,
+      pkey.get(), make_key, std::move(attest_key), issuer_subject, key_blob,
+      hw_enforced, sw_enforced, cert_chain);
+  pool_.RecordLatency(*type, true, std::chrono::steady_clock::now() - begin);
+  return error;
+}
+
+PooledEcKeyFactory::PooledEcKeyFactory(const SoftwareKeyBlobMaker& blob_maker,
+                                       const KeymasterContext& context,
+                                       KeyPool& pool)
+    : keymaster::EcKeyFactory(blob_maker, context),
+      pool_blob_maker_(blob_maker),
+      pool_context_(context),
+      pool_(pool) {}
+
+keymaster_error_t PooledEcKeyFactory::GenerateKey(
+    const AuthorizationSet& key_description, UniquePtr<Key> attest_key,
+    const KeymasterBlob& issuer_subject, KeymasterKeyBlob* key_blob,
+    AuthorizationSet* hw_enforced, AuthorizationSet* sw_enforced,
+    CertificateChain* cert_chain) const {
+  const auto begin = std::chrono::steady_clock::now();
+  std::optional<PooledKeyType> type = EcPoolType(key_description);
+  PooledKey pkey =
+      type ? pool_.Take(*type) : PooledKey(nullptr, EVP_PKEY_free);
+  if (!pkey) {
+    keymaster_error_t error = keymaster::EcKeyFactory::GenerateKey(
+        key_description, std::move(attest_key), issuer_subject, key_blob,
+        hw_enforced, sw_enforced, cert_chain);
+    if (type) {
+      pool_.RecordLatency(*type, false,
+                          std::chrono::steady_clock::now() - begin);
+    }
+    return error;
+  }
+  if (!key_blob || !hw_enforced || !sw_enforced) {
+    return KM_ERROR_OUTPUT_PARAMETER_NULL;
+  }
+
+  // EcKeyFactory records the size of keys generated by curve.
+  AuthorizationSet authorizations(key_description);
+  if (!authorizations.Contains(keymaster::TAG_KEY_SIZE)) {
+    authorizations.push_back(keymaster::TAG_KEY_SIZE, 256);
+  }
+  keymaster::EC_KEY_Ptr ec_key(EVP_PKEY_get1_EC_KEY(pkey.get()));
+  auto make_key = [this, &ec_key](const AuthorizationSet& hw_enforced,
+                                  const AuthorizationSet& sw_enforced) {
+    return UniquePtr<Key>(new keymaster::EcKey(hw_enforced, sw_enforced, this,
+                                               std::move(ec_key)));
+  };
+  keymaster_error_t error = SealAndCertify(
+      pool_blob_maker_, pool_context_, key_description, authorizations,
+      pkey.get(), make_key, std::move(attest_key), issuer_subject, key_blob,
+      hw_enforced, sw_enforced, cert_chain);
+  pool_.RecordLatency(*type, true, std::chrono::steady_clock::now() - begin);
+  return error;
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,74 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <keymaster/km_openssl/ec_key_factory.h>
+#include <keymaster/km_openssl/rsa_key_factory.h>
+
+#include "cuttlefish/host/commands/secure_env/key_pool.h"
+
+namespace cuttlefish {
+
+/**
+ * RsaKeyFactory that takes the private key of RSA-2048 and RSA-3072 keys with
+ * the F4 public exponent from a KeyPool. The key is sealed and certified per
+ * request exactly as RsaKeyFactory does, and every other request goes to
+ * RsaKeyFactory.
+ */
+class PooledRsaKeyFactory : public keymaster::RsaKeyFactory {
+ public:
+  PooledRsaKeyFactory(const keymaster::SoftwareKeyBlobMaker& blob_maker,
+                      const keymaster::KeymasterContext& context,
+                      KeyPool& pool);
+
+  keymaster_error_t GenerateKey(
+      const keymaster::AuthorizationSet& key_description,
+      keymaster::UniquePtr<keymaster::Key> attest_key,
+      const keymaster::KeymasterBlob& issuer_subject,
+      keymaster::KeymasterKeyBlob* key_blob,
+      keymaster::AuthorizationSet* hw_enforced,
+      keymaster::AuthorizationSet* sw_enforced,
+      keymaster::CertificateChain* cert_chain) const override;
+
+ private:
+  const keymaster::SoftwareKeyBlobMaker& pool_blob_maker_;
+  const keymaster::KeymasterContext& pool_context_;
+  KeyPool& pool_;
+};
+
+/** The EcKeyFactory counterpart of PooledRsaKeyFactory, for P-256 keys. */
+class PooledEcKeyFactory : public keymaster::EcKeyFactory {
+ public:
+  PooledEcKeyFactory(const keymaster::SoftwareKeyBlobMaker& blob_maker,
+                     const keymaster::KeymasterContext& context,
+                     KeyPool& pool);
+
+  keymaster_error_t GenerateKey(
+      const keymaster::AuthorizationSet& key_description,
+      keymaster::UniquePtr<keymaster::Key> attest_key,
+      const keymaster::KeymasterBlob& issuer_subject,
+      keymaster::KeymasterKeyBlob* key_blob,
+      keymaster::AuthorizationSet* hw_enforced,
+      keymaster::AuthorizationSet* sw_enforced,
+      keymaster::CertificateChain* cert_chain) const override;
+
+ private:
+  const keymaster::SoftwareKeyBlobMaker& pool_blob_maker_;
+  const keymaster::KeymasterContext& pool_context_;
+  KeyPool& pool_;
+};
+
+}  // namespace cuttlefish
@@ -39,13 +39,14 @@
 #include "cuttlefish/host/commands/secure_env/device_tpm.h"
 #include "cuttlefish/host/commands/secure_env/gatekeeper_responder.h"
 #include "cuttlefish/host/commands/secure_env/in_process_tpm.h"
+#include "cuttlefish/host/commands/secure_env/key_pool.h"
 #include "cuttlefish/host/commands/secure_env/keymaster_responder.h"
 #include "cuttlefish/host/commands/secure_env/oemlock/oemlock.h"
 #include "cuttlefish/host/commands/secure_env/oemlock/oemlock_responder.h"
 #include "cuttlefish/host/commands/secure_env/proxy_keymaster_context.h"
 #include "cuttlefish/host/commands/secure_env/rust/kmr_ta.h"
 #include "cuttlefish/host/commands/secure_env/soft_gatekeeper.h"
-#include "cuttlefish/host/commands/secure_env/storage/insecure_json_storage.h"
+#include "cuttlefish/host/commands/secure_env/storage/insecure_log_storage.h"
 #include "cuttlefish/host/commands/secure_env/storage/storage.h"
 #include "cuttlefish/host/commands/secure_env/storage/tpm_storage.h"
 #include "cuttlefish/host/commands/secure_env/suspend_resume_handler.h"
@@ -85,6 +86,16 @@ DEFINE_string(tpm_impl, "in_memory",
 DEFINE_string(keymint_impl, "tpm",
               "The KeyMint implementation. \"tpm\" or \"software\"");
 
+DEFINE_bool(keymint_key_pool, false,
+            "Generate the private keys of RSA-2048, RSA-3072 and P-256 keys "
+            "in the background, ahead of the C++ KeyMint requests for them.");
+DEFINE_int32(keymint_key_pool_low_watermark, 2,
+             "Refill a key pool once it holds fewer keys than this.");
+DEFINE_int32(keymint_key_pool_high_watermark, 4,
+             "Stop refilling a key pool once it holds this many keys.");
+DEFINE_int32(keymint_key_pool_threads, 1,
+             "How many threads generate keys for the key pools.");
+
 DEFINE_string(gatekeeper_impl, "tpm",
               "The gatekeeper implementation. \"tpm\" or \"software\"");
 
@@ -98,6 +109,14 @@ namespace {
 constexpr size_t kOperationTableSize = 16;
 constexpr std::chrono::seconds kRestartLockTimeout(2);
 
+secure_env::InsecureLogStorage* OpenInsecureStorage(const std::string& path) {
+  auto storage = secure_env::InsecureLogStorage::Open(path);
+  if (!storage.has_value()) {
+    LOG(FATAL) << "Failed to open " << path << ": " << storage.error();
+  }
+  return storage->release();  // fruit will take ownership
+}
+
 // Dup a command line file descriptor into a SharedFD.
 SharedFD DupFdFlag(gflags::int32 fd) {
   CHECK(fd != -1);
@@ -186,7 +205,7 @@ ChooseOemlockComponent() {
       .registerProvider(
           [](TpmResourceManager& resource_manager) -> secure_env::Storage* {
             if (FLAGS_oemlock_impl == "software") {
-              return new secure_env::InsecureJsonStorage("oemlock_insecure");
+              return OpenInsecureStorage("oemlock_insecure");
             } else if (FLAGS_oemlock_impl == "tpm") {
               return new secure_env::TpmStorage(resource_manager,
                                                 "oemlock_secure");
@@ -240,12 +259,11 @@ SecureEnvComponent() {
         return new secure_env::TpmStorage(resource_manager,
                                           "gatekeeper_secure");
       })
-      .registerProvider([]() {
-        return new secure_env::InsecureJsonStorage("gatekeeper_insecure");
-      })
+      .registerProvider(
+          []() { return OpenInsecureStorage("gatekeeper_insecure"); })
       .registerProvider([](TpmResourceManager& resource_manager,
                            secure_env::TpmStorage& secure_storage,
-                           secure_env::InsecureJsonStorage& insecure_storage) {
+                           secure_env::InsecureLogStorage& insecure_storage) {
         return new TpmGatekeeper(resource_manager, secure_storage,
                                  insecure_storage);
       })
@@ -269,6 +287,8 @@ Result<void> SecureEnvMain(int argc, char** argv) {
   oemlock::OemLock* oemlock = injector.get<oemlock::OemLock*>();
   keymaster::KeymasterEnforcement* keymaster_enforcement =
       injector.get<keymaster::KeymasterEnforcement*>();
+  // Outlives the context, which takes keys from it.
+  std::unique_ptr<KeyPool> key_pool;
   std::unique_ptr<keymaster::KeymasterContext> keymaster_context;
   std::unique_ptr<keymaster::AndroidKeymaster> keymaster;
   std::timed_mutex oemlock_lock;
@@ -340,8 +360,20 @@ Result<void> SecureEnvMain(int argc, char** argv) {
     keymaster_context.reset(new keymaster::PureSoftKeymasterContext(
         keymaster::KmVersion::KEYMINT_3, KM_SECURITY_LEVEL_SOFTWARE));
   } else /* KM_SECURITY_LEVEL_TRUSTED_ENVIRONMENT */ {
-    keymaster_context.reset(
-        new TpmKeymasterContext(*resource_manager, *keymaster_enforcement));
+    if (FLAGS_keymint_key_pool) {
+      CF_EXPECT_GE(FLAGS_keymint_key_pool_low_watermark, 0);
+      CF_EXPECT_GE(FLAGS_keymint_key_pool_high_watermark, 0);
+      CF_EXPECT_GE(FLAGS_keymint_key_pool_threads, 0);
+      key_pool = CF_EXPECT(KeyPool::Create({
+          .low_watermark =
+              static_cast<size_t>(FLAGS_keymint_key_pool_low_watermark),
+          .high_watermark =
+              static_cast<size_t>(FLAGS_keymint_key_pool_high_watermark),
+          .threads = static_cast<size_t>(FLAGS_keymint_key_pool_threads),
+      }));
+    }
+    keymaster_context.reset(new TpmKeymasterContext(
+        *resource_manager, *keymaster_enforcement, key_pool.get()));
   }
 
   // keymaster::AndroidKeymaster puts the context pointer into a UniquePtr,
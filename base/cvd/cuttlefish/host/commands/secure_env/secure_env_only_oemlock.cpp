@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <thread>
@@ -28,7 +29,7 @@
 #include "cuttlefish/host/commands/kernel_log_monitor/utils.h"
 #include "cuttlefish/host/commands/secure_env/oemlock/oemlock.h"
 #include "cuttlefish/host/commands/secure_env/oemlock/oemlock_responder.h"
-#include "cuttlefish/host/commands/secure_env/storage/insecure_json_storage.h"
+#include "cuttlefish/host/commands/secure_env/storage/insecure_log_storage.h"
 #include "cuttlefish/host/commands/secure_env/suspend_resume_handler.h"
 #include "cuttlefish/host/commands/secure_env/worker_thread_loop_body.h"
 #include "cuttlefish/host/libs/config/known_paths.h"
@@ -134,8 +135,9 @@ Result<void> SecureEnvMain(int argc, char** argv) {
   DefaultSubprocessLogging(argv);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-  secure_env::InsecureJsonStorage storage("oemlock_insecure");
-  oemlock::OemLock oemlock(storage);
+  std::unique_ptr<secure_env::InsecureLogStorage> storage =
+      CF_EXPECT(secure_env::InsecureLogStorage::Open("oemlock_insecure"));
+  oemlock::OemLock oemlock(*storage);
 
   std::timed_mutex oemlock_lock;
 
@@ -0,0 +1,332 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/secure_env/storage/insecure_log_storage.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "android-base/file.h"
+#include "json/value.h"
+
+#include "cuttlefish/common/libs/utils/base64.h"
+#include "cuttlefish/common/libs/utils/json.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/string.h"
+#include "cuttlefish/io/write_exact.h"
+#include "cuttlefish/posix/rename.h"
+
+namespace cuttlefish {
+namespace secure_env {
+namespace {
+
+// The log starts with kMagic, followed by records of a RecordHeader, the key
+// and the value. A later record for a key replaces the earlier ones.
+constexpr char kMagic[8] = {'C', 'F', 'K', 'V', 'L', 'O', 'G', '1'};
+
+struct RecordHeader {
+  uint32_t key_size;
+  uint32_t value_size;
+  // CRC-32 of the sizes, the key and the value.
+  uint32_t checksum;
+};
+
+uint32_t Checksum(const RecordHeader& header, std::string_view key,
+                  std::string_view value) {
+  uLong crc = crc32(0, reinterpret_cast<const Bytef*>(&header.key_size),
+                    sizeof(header.key_size));
+  crc = crc32(crc, reinterpret_cast<const Bytef*>(&header.value_size),
+              sizeof(header.value_size));
+  crc = crc32(crc, reinterpret_cast<const Bytef*>(key.data()), key.size());
+  crc = crc32(crc, reinterpret_cast<const Bytef*>(value.data()), value.size());
+  return crc;
+}
+
+uint64_t RecordSize(std::string_view key, uint64_t value_size) {
+  return sizeof(RecordHeader) + key.size() + value_size;
+}
+
+// Appends a record to `log` and returns the offset of the value in `log`.
+uint64_t AppendRecord(std::string& log, std::string_view key,
+                      std::string_view value) {
+  RecordHeader header{
+      .key_size = static_cast<uint32_t>(key.size()),
+      .value_size = static_cast<uint32_t>(value.size()),
+  };
+  header.checksum = Checksum(header, key, value);
+  log.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  log.append(key);
+  const uint64_t value_offset = log.size();
+  log.append(value);
+  return value_offset;
+}
+
+Result<void> SyncDirectory(const std::string& path) {
+  const std::string dir = android::base::Dirname(path);
+  SharedFD dir_fd = SharedFD::Open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  CF_EXPECTF(dir_fd->IsOpen(), "Failed to open '{}': {}", dir,
+             dir_fd->StrError());
+  CF_EXPECTF(dir_fd->Fsync() == 0, "Failed to sync '{}': {}", dir,
+             dir_fd->StrError());
+  return {};
+}
+
+}  // namespace
+
+InsecureLogStorage::InsecureLogStorage(std::string path,
+                                       InsecureLogStorageOptions options)
+    : path_(std::move(path)), options_(options) {}
+
+Result<std::unique_ptr<InsecureLogStorage>> InsecureLogStorage::Open(
+    std::string path, InsecureLogStorageOptions options) {
+  std::unique_ptr<InsecureLogStorage> storage(
+      new InsecureLogStorage(std::move(path), options));
+  CF_EXPECTF(storage->Load(), "Failed to load '{}'", storage->path_);
+  if (options.sync_delay.count() > 0) {
+    storage->sync_thread_ =
+        std::thread([storage = storage.get()]() { storage->SyncLoop(); });
+  }
+  return storage;
+}
+
+InsecureLogStorage::~InsecureLogStorage() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  sync_cv_.notify_one();
+  if (sync_thread_.joinable()) {
+    sync_thread_.join();
+  }
+  Result<void> synced = Sync();
+  if (!synced.has_value()) {
+    LOG(ERROR) << "Failed to sync '" << path_ << "': " << synced.error();
+  }
+}
+
+Result<void> InsecureLogStorage::Load() {
+  fd_ = SharedFD::Open(path_, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  CF_EXPECTF(fd_->IsOpen(), "Failed to open '{}': {}", path_,
+             fd_->StrError());
+  const std::string contents = CF_EXPECT(ReadToString(*fd_));
+  if (contents.empty()) {
+    CF_EXPECT(PWriteExact(*fd_, kMagic, sizeof(kMagic), 0));
+    end_ = sizeof(kMagic);
+    return {};
+  }
+  if (std::string_view(contents).starts_with(
+          std::string_view(kMagic, sizeof(kMagic)))) {
+    CF_EXPECT(LoadLog(contents));
+  } else {
+    CF_EXPECT(ImportJson(contents));
+  }
+  return {};
+}
+
+Result<void> InsecureLogStorage::LoadLog(const std::string& contents) {
+  uint64_t offset = sizeof(kMagic);
+  while (contents.size() - offset >= sizeof(RecordHeader)) {
+    RecordHeader header;
+    memcpy(&header, contents.data() + offset, sizeof(header));
+    const uint64_t record_size =
+        sizeof(header) + uint64_t{header.key_size} + header.value_size;
+    if (contents.size() - offset < record_size) {
+      break;
+    }
+    const std::string_view key(contents.data() + offset + sizeof(header),
+                               header.key_size);
+    const std::string_view value(key.data() + key.size(), header.value_size);
+    if (Checksum(header, key, value) != header.checksum) {
+      break;
+    }
+    auto [it, inserted] = index_.try_emplace(std::string(key));
+    if (!inserted) {
+      live_bytes_ -= RecordSize(key, it->second.size);
+    }
+    it->second = Location{
+        .offset = offset + sizeof(header) + key.size(),
+        .size = header.value_size,
+    };
+    live_bytes_ += record_size;
+    offset += record_size;
+  }
+  if (offset < contents.size()) {
+    // Left by a crash in the middle of an append.
+    LOG(WARNING) << "Dropping " << contents.size() - offset
+                 << " bytes of incomplete records at the end of '" << path_
+                 << "'";
+    CF_EXPECT(fd_->Truncate(offset));
+  }
+  end_ = offset;
+  return {};
+}
+
+Result<void> InsecureLogStorage::ImportJson(const std::string& contents) {
+  LOG(INFO) << "Converting '" << path_ << "' from JSON to a log";
+  const Json::Value root = CF_EXPECT(ParseJson(contents));
+  std::unordered_map<std::string, std::string> values;
+  for (const std::string& key : root.getMemberNames()) {
+    std::vector<uint8_t> value =
+        CF_EXPECTF(DecodeBase64(root[key].asString()),
+                   "Failed to decode base64 to read key '{}'", key);
+    values[key] = std::string(value.begin(), value.end());
+  }
+  CF_EXPECT(Rewrite(values));
+  return {};
+}
+
+Result<void> InsecureLogStorage::Rewrite(
+    const std::unordered_map<std::string, std::string>& values) {
+  std::string log(kMagic, sizeof(kMagic));
+  std::unordered_map<std::string, Location> index;
+  for (const auto& [key, value] : values) {
+    index[key] = Location{
+        .offset = AppendRecord(log, key, value),
+        .size = static_cast<uint32_t>(value.size()),
+    };
+  }
+
+  const std::string tmp_path = path_ + ".tmp";
+  SharedFD tmp =
+      SharedFD::Open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  CF_EXPECTF(tmp->IsOpen(), "Failed to open '{}': {}", tmp_path,
+             tmp->StrError());
+  CF_EXPECT(PWriteExact(*tmp, log.data(), log.size(), 0));
+  CF_EXPECTF(tmp->Fsync() == 0, "Failed to sync '{}': {}", tmp_path,
+             tmp->StrError());
+  CF_EXPECT(Rename(tmp_path, path_));
+  CF_EXPECT(SyncDirectory(path_));
+
+  fd_ = tmp;
+  end_ = log.size();
+  live_bytes_ = log.size() - sizeof(kMagic);
+  index_ = std::move(index);
+  dirty_ = false;
+  return {};
+}
+
+Result<void> InsecureLogStorage::Compact() {
+  std::unordered_map<std::string, std::string> values;
+  for (const auto& [key, location] : index_) {
+    std::string value(location.size, '\0');
+    CF_EXPECT(PReadExact(*fd_, value.data(), value.size(), location.offset));
+    values[key] = std::move(value);
+  }
+  VLOG(0) << "Compacting '" << path_ << "' from " << end_ << " to "
+          << sizeof(kMagic) + live_bytes_ << " bytes";
+  CF_EXPECT(Rewrite(values));
+  return {};
+}
+
+void InsecureLogStorage::SyncLoop() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    sync_cv_.wait(lock, [this]() { return dirty_ || stopping_; });
+    // Give the writes that follow a chance to share the sync.
+    sync_cv_.wait_for(lock, options_.sync_delay,
+                      [this]() { return stopping_; });
+    if (stopping_) {
+      return;  // The destructor syncs what is left.
+    }
+    if (!dirty_) {
+      continue;  // Compacted in the meantime.
+    }
+    SharedFD fd = fd_;
+    dirty_ = false;
+    lock.unlock();
+    if (fd->Fsync() != 0) {
+      LOG(ERROR) << "Failed to sync '" << path_ << "': " << fd->StrError();
+    }
+    lock.lock();
+  }
+}
+
+bool InsecureLogStorage::Exists() const {
+  std::lock_guard lock(mutex_);
+  return !index_.empty();
+}
+
+Result<bool> InsecureLogStorage::HasKey(const std::string& key) const {
+  std::lock_guard lock(mutex_);
+  return index_.contains(key);
+}
+
+Result<ManagedStorageData> InsecureLogStorage::Read(
+    const std::string& key) const {
+  SharedFD fd;
+  Location location;
+  {
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(key);
+    CF_EXPECTF(it != index_.end(), "Key: '{}' not found in {}", key, path_);
+    // A compaction replaces fd_ but leaves the file behind it intact.
+    fd = fd_;
+    location = it->second;
+  }
+  auto storage_data = CF_EXPECT(CreateStorageData(location.size));
+  CF_EXPECT(PReadExact(*fd, reinterpret_cast<char*>(storage_data->payload),
+                       location.size, location.offset));
+  return storage_data;
+}
+
+Result<void> InsecureLogStorage::Write(const std::string& key,
+                                       const StorageData& data) {
+  const std::string_view value(reinterpret_cast<const char*>(data.payload),
+                               data.size);
+  std::lock_guard lock(mutex_);
+  std::string record;
+  const uint64_t value_offset = end_ + AppendRecord(record, key, value);
+  CF_EXPECT(PWriteExact(*fd_, record.data(), record.size(), end_));
+
+  auto [it, inserted] = index_.try_emplace(key);
+  if (!inserted) {
+    live_bytes_ -= RecordSize(key, it->second.size);
+  }
+  it->second = Location{.offset = value_offset, .size = data.size};
+  live_bytes_ += record.size();
+  end_ += record.size();
+
+  if (end_ >= options_.min_compaction_bytes &&
+      end_ > options_.compaction_ratio * (sizeof(kMagic) + live_bytes_)) {
+    CF_EXPECT(Compact());
+  } else if (options_.sync_delay.count() == 0) {
+    CF_EXPECTF(fd_->Fsync() == 0, "Failed to sync '{}': {}", path_,
+               fd_->StrError());
+  } else {
+    dirty_ = true;
+    sync_cv_.notify_one();
+  }
+  return {};
+}
+
+Result<void> InsecureLogStorage::Sync() {
+  std::lock_guard lock(mutex_);
+  if (!dirty_) {
+    return {};
+  }
+  CF_EXPECTF(fd_->Fsync() == 0, "Failed to sync '{}': {}", path_,
+             fd_->StrError());
+  dirty_ = false;
+  return {};
+}
+
+}  // namespace secure_env
+}  // namespace cuttlefish
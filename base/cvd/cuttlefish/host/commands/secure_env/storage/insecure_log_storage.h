@@ -0,0 +1,106 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/host/commands/secure_env/storage/storage.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace secure_env {
+
+struct InsecureLogStorageOptions {
+  // Writes reach the disk at most this long after they are made, so that
+  // bursts of writes share one fsync. Zero syncs every write before returning.
+  std::chrono::milliseconds sync_delay = std::chrono::milliseconds(50);
+  // The log is rewritten with only the latest value of every key once it is
+  // this many times larger than those values, and at least
+  // `min_compaction_bytes` long.
+  uint64_t compaction_ratio = 2;
+  uint64_t min_compaction_bytes = 64 << 10;
+};
+
+/**
+ * Unencrypted storage kept in an append-only log, with an in-memory index from
+ * each key to its latest value in the log. Lookups don't touch the disk, reads
+ * are a single pread and writes a single append.
+ *
+ * Every record carries a checksum, and a torn record at the end of the log,
+ * left by a crash during an append, is dropped when the log is opened.
+ *
+ * A file written by InsecureJsonStorage is converted to a log when opened.
+ *
+ * This class is thread-safe.
+ */
+class InsecureLogStorage : public secure_env::Storage {
+ public:
+  static Result<std::unique_ptr<InsecureLogStorage>> Open(
+      std::string path, InsecureLogStorageOptions options = {});
+  ~InsecureLogStorage() override;
+
+  Result<bool> HasKey(const std::string& key) const override;
+  Result<ManagedStorageData> Read(const std::string& key) const override;
+  Result<void> Write(const std::string& key, const StorageData& data) override;
+  bool Exists() const override;
+
+  // Writes the pending changes to the disk now.
+  Result<void> Sync();
+
+ private:
+  struct Location {
+    uint64_t offset;
+    uint32_t size;
+  };
+
+  InsecureLogStorage(std::string path, InsecureLogStorageOptions options);
+
+  Result<void> Load();
+  Result<void> LoadLog(const std::string& contents);
+  Result<void> ImportJson(const std::string& contents);
+  // Replaces the log with one holding only `values`, atomically.
+  Result<void> Rewrite(
+      const std::unordered_map<std::string, std::string>& values);
+  Result<void> Compact();
+  void SyncLoop();
+
+  const std::string path_;
+  const InsecureLogStorageOptions options_;
+
+  mutable std::mutex mutex_;
+  SharedFD fd_;
+  uint64_t end_ = 0;
+  // The bytes in the log taken by the latest record of each key.
+  uint64_t live_bytes_ = 0;
+  std::unordered_map<std::string, Location> index_;
+
+  bool dirty_ = false;
+  bool stopping_ = false;
+  std::condition_variable sync_cv_;
+  std::thread sync_thread_;
+};
+
+}  // namespace secure_env
+}  // namespace cuttlefish
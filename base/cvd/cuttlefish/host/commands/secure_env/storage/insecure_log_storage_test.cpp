@@ -0,0 +1,174 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/secure_env/storage/insecure_log_storage.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/utils/base64.h"
+#include "cuttlefish/host/commands/secure_env/storage/storage.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace secure_env {
+namespace {
+
+std::unique_ptr<InsecureLogStorage> OpenOrDie(
+    const std::string& path, InsecureLogStorageOptions options = {}) {
+  Result<std::unique_ptr<InsecureLogStorage>> storage =
+      InsecureLogStorage::Open(path, options);
+  EXPECT_THAT(storage, IsOk());
+  return storage.has_value() ? std::move(*storage) : nullptr;
+}
+
+void WriteOrDie(Storage& storage, const std::string& key,
+                const std::string& value) {
+  Result<ManagedStorageData> data =
+      CreateStorageData(value.data(), value.size());
+  ASSERT_THAT(data, IsOk());
+  EXPECT_THAT(storage.Write(key, **data), IsOk());
+}
+
+std::string ReadOrDie(const Storage& storage, const std::string& key) {
+  Result<ManagedStorageData> data = storage.Read(key);
+  EXPECT_THAT(data, IsOk());
+  if (!data.has_value()) {
+    return "";
+  }
+  return std::string(reinterpret_cast<const char*>((*data)->payload),
+                     (*data)->size);
+}
+
+off_t FileSize(const std::string& path) {
+  struct stat st {};
+  EXPECT_EQ(stat(path.c_str(), &st), 0) << path;
+  return st.st_size;
+}
+
+class InsecureLogStorageTest : public testing::Test {
+ protected:
+  std::string Path() const {
+    return std::string(temp_dir_.path) + "/gatekeeper_insecure";
+  }
+
+  TemporaryDir temp_dir_;
+};
+
+TEST_F(InsecureLogStorageTest, ReadsWhatWasWritten) {
+  std::unique_ptr<InsecureLogStorage> storage = OpenOrDie(Path());
+  ASSERT_NE(storage, nullptr);
+  EXPECT_FALSE(storage->Exists());
+  EXPECT_THAT(storage->HasKey("a"), IsOkAndValue(false));
+  EXPECT_THAT(storage->Read("a"), IsError());
+
+  WriteOrDie(*storage, "a", "first");
+  WriteOrDie(*storage, "b", std::string("\0\1\2", 3));
+  WriteOrDie(*storage, "a", "second");
+
+  EXPECT_TRUE(storage->Exists());
+  EXPECT_THAT(storage->HasKey("a"), IsOkAndValue(true));
+  EXPECT_EQ(ReadOrDie(*storage, "a"), "second");
+  EXPECT_EQ(ReadOrDie(*storage, "b"), std::string("\0\1\2", 3));
+}
+
+TEST_F(InsecureLogStorageTest, KeepsValuesAcrossOpens) {
+  {
+    std::unique_ptr<InsecureLogStorage> storage = OpenOrDie(Path());
+    ASSERT_NE(storage, nullptr);
+    WriteOrDie(*storage, "a", "first");
+    WriteOrDie(*storage, "a", "second");
+    WriteOrDie(*storage, "b", "");
+  }
+  std::unique_ptr<InsecureLogStorage> storage = OpenOrDie(Path());
+  ASSERT_NE(storage, nullptr);
+  EXPECT_TRUE(storage->Exists());
+  EXPECT_EQ(ReadOrDie(*storage, "a"), "second");
+  EXPECT_EQ(ReadOrDie(*storage, "b"), "");
+}
+
+TEST_F(InsecureLogStorageTest, DropsTornRecord) {
+  {
+    std::unique_ptr<InsecureLogStorage> storage =
+        OpenOrDie(Path(), {.sync_delay = std::chrono::milliseconds(0)});
+    ASSERT_NE(storage, nullptr);
+    WriteOrDie(*storage, "a", "first");
+    WriteOrDie(*storage, "b", "second");
+  }
+  // Cut the last record short, as a crash in the middle of the append would.
+  ASSERT_EQ(truncate(Path().c_str(), FileSize(Path()) - 2), 0);
+
+  std::unique_ptr<InsecureLogStorage> storage = OpenOrDie(Path());
+  ASSERT_NE(storage, nullptr);
+  EXPECT_EQ(ReadOrDie(*storage, "a"), "first");
+  EXPECT_THAT(storage->HasKey("b"), IsOkAndValue(false));
+
+  WriteOrDie(*storage, "b", "again");
+  storage.reset();
+  storage = OpenOrDie(Path());
+  ASSERT_NE(storage, nullptr);
+  EXPECT_EQ(ReadOrDie(*storage, "b"), "again");
+}
+
+TEST_F(InsecureLogStorageTest, Compacts) {
+  std::unique_ptr<InsecureLogStorage> storage =
+      OpenOrDie(Path(), {.min_compaction_bytes = 4096});
+  ASSERT_NE(storage, nullptr);
+  for (int i = 0; i < 1000; i++) {
+    WriteOrDie(*storage, "key" + std::to_string(i % 10), std::to_string(i));
+  }
+  EXPECT_LT(FileSize(Path()), 4096);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(ReadOrDie(*storage, "key" + std::to_string(i)),
+              std::to_string(990 + i));
+  }
+  storage.reset();
+  storage = OpenOrDie(Path());
+  ASSERT_NE(storage, nullptr);
+  EXPECT_EQ(ReadOrDie(*storage, "key9"), "999");
+}
+
+TEST_F(InsecureLogStorageTest, ConvertsJsonStorage) {
+  Result<std::string> encoded = EncodeBase64(std::string_view("\1"));
+  ASSERT_THAT(encoded, IsOk());
+  ASSERT_TRUE(android::base::WriteStringToFile(
+      "{\"oemlock_state\":\"" + *encoded + "\"}", Path()));
+
+  std::unique_ptr<InsecureLogStorage> storage = OpenOrDie(Path());
+  ASSERT_NE(storage, nullptr);
+  EXPECT_TRUE(storage->Exists());
+  EXPECT_EQ(ReadOrDie(*storage, "oemlock_state"), "\1");
+  WriteOrDie(*storage, "other", "value");
+
+  storage.reset();
+  storage = OpenOrDie(Path());
+  ASSERT_NE(storage, nullptr);
+  EXPECT_EQ(ReadOrDie(*storage, "oemlock_state"), "\1");
+  EXPECT_EQ(ReadOrDie(*storage, "other"), "value");
+}
+
+}  // namespace
+}  // namespace secure_env
+}  // namespace cuttlefish
@@ -0,0 +1,143 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Fills a storage with `--keys` keys and then overwrites and reads back random
+// ones, the way gatekeeper and keystore traffic does, with both the JSON file
+// and the log based insecure storage.
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "android-base/file.h"
+
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/host/commands/secure_env/storage/insecure_json_storage.h"
+#include "cuttlefish/host/commands/secure_env/storage/insecure_log_storage.h"
+#include "cuttlefish/host/commands/secure_env/storage/storage.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace secure_env {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Workload {
+  size_t keys;
+  size_t operations;
+  size_t value_size;
+};
+
+std::string Key(size_t i) { return "failure_record_" + std::to_string(i); }
+
+double MicrosecondsPer(Clock::duration total, size_t count) {
+  return std::chrono::duration<double, std::micro>(total).count() / count;
+}
+
+Result<void> Run(const std::string& name, Storage& storage,
+                 const Workload& workload) {
+  std::vector<uint8_t> value(workload.value_size, 0xa5);
+  auto data = CF_EXPECT(CreateStorageData(value.data(), value.size()));
+
+  Clock::time_point begin = Clock::now();
+  for (size_t i = 0; i < workload.keys; i++) {
+    CF_EXPECT(storage.Write(Key(i), *data));
+  }
+  Clock::duration fill = Clock::now() - begin;
+
+  std::mt19937 random(42);
+  std::uniform_int_distribution<size_t> key(0, workload.keys - 1);
+  Clock::duration writes{};
+  Clock::duration reads{};
+  for (size_t i = 0; i < workload.operations; i++) {
+    begin = Clock::now();
+    CF_EXPECT(storage.Write(Key(key(random)), *data));
+    writes += Clock::now() - begin;
+
+    begin = Clock::now();
+    const std::string read_key = Key(key(random));
+    const bool has_key = CF_EXPECT(storage.HasKey(read_key));
+    CF_EXPECT_EQ(has_key, true);
+    auto read = CF_EXPECT(storage.Read(read_key));
+    reads += Clock::now() - begin;
+    CF_EXPECT_EQ(read->size, value.size());
+  }
+
+  std::cout << name << ": fill " << MicrosecondsPer(fill, workload.keys)
+            << "us/key, write " << MicrosecondsPer(writes, workload.operations)
+            << "us, HasKey+Read " << MicrosecondsPer(reads, workload.operations)
+            << "us\n";
+  return {};
+}
+
+Result<void> StorageBenchmarkMain(int argc, char** argv) {
+  Workload workload{
+      .keys = 2000,
+      .operations = 1000,
+      .value_size = 64,
+  };
+  std::vector<Flag> flags;
+  flags.emplace_back(GflagsCompatFlag("keys", workload.keys)
+                         .Help("How many keys the storage holds."));
+  flags.emplace_back(
+      GflagsCompatFlag("operations", workload.operations)
+          .Help("How many random overwrites and reads to time."));
+  flags.emplace_back(GflagsCompatFlag("value_size", workload.value_size)
+                         .Help("Size of every value in bytes."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(workload.keys, 0u);
+  CF_EXPECT_GT(workload.operations, 0u);
+
+  TemporaryDir temp_dir;
+  {
+    InsecureJsonStorage storage(std::string(temp_dir.path) + "/json");
+    CF_EXPECT(Run("json", storage, workload));
+  }
+  {
+    std::unique_ptr<InsecureLogStorage> storage = CF_EXPECT(
+        InsecureLogStorage::Open(std::string(temp_dir.path) + "/log"));
+    CF_EXPECT(Run("log", *storage, workload));
+  }
+  {
+    std::unique_ptr<InsecureLogStorage> storage =
+        CF_EXPECT(InsecureLogStorage::Open(
+            std::string(temp_dir.path) + "/log_sync",
+            {.sync_delay = std::chrono::milliseconds(0)}));
+    CF_EXPECT(Run("log, fsync per write", *storage, workload));
+  }
+  return {};
+}
+
+}  // namespace
+}  // namespace secure_env
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::secure_env::StorageBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
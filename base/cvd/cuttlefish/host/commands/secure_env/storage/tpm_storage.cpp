@@ -33,6 +33,7 @@ static constexpr char kHandle[] = "handle";
 TpmStorage::TpmStorage(TpmResourceManager& resource_manager, const std::string& index_file)
     : resource_manager_(resource_manager), index_file_(index_file) {
   index_ = ReadProtectedJsonFromFile(resource_manager_, index_file);
+  exists_ = index_.isMember(kEntries);
   if (!index_.isMember(kEntries)
       || index_[kEntries].type() != Json::arrayValue) {
     if (index_.empty()) {
@@ -43,12 +44,19 @@ TpmStorage::TpmStorage(TpmResourceManager& resource_manager, const std::string&
     index_[kEntries] = Json::Value(Json::arrayValue);
   } else {
     VLOG(0) << "Restoring index from file";
+    for (const auto& entry : index_[kEntries]) {
+      if (!entry.isMember(kKey) || !entry.isMember(kHandle)) {
+        LOG(WARNING) << "Index entry missing key or handle, likely corrupted.";
+        continue;
+      }
+      // The first entry for a key wins, as it did with the linear scan.
+      handles_.try_emplace(entry[kKey].asString(), entry[kHandle].asUInt());
+    }
   }
 }
 
-bool TpmStorage::Exists() const {
-  return ReadProtectedJsonFromFile(resource_manager_, index_file_).isMember(kEntries);
-}
+// Only this instance writes index_file_, so it doesn't need to be read again.
+bool TpmStorage::Exists() const { return exists_; }
 
 Result<bool> TpmStorage::HasKey(const std::string& key) const {
   return CF_EXPECT(GetHandle(key)).has_value();
@@ -162,15 +170,11 @@ TPM2_HANDLE TpmStorage::GenerateRandomHandle() {
 }
 
 Result<std::optional<TPM2_HANDLE>> TpmStorage::GetHandle(const std::string& key) const {
-  for (const auto& entry : index_[kEntries]) {
-    CF_EXPECT(entry.isMember(kKey), "Index was corrupted");
-    if (entry[kKey] != key) {
-      continue;
-    }
-    CF_EXPECT(entry.isMember(kHandle), "Index was corrupted");
-    return entry[kHandle].asUInt();
+  auto it = handles_.find(key);
+  if (it == handles_.end()) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  return it->second;
 }
 
 Result<void> TpmStorage::Allocate(const std::string& key, uint16_t size) {
@@ -217,9 +221,11 @@ Result<void> TpmStorage::Allocate(const std::string& key, uint16_t size) {
   entry[kKey] = key;
   entry[kHandle] = handle;
   index_[kEntries].append(entry);
+  handles_[key] = handle;
 
   CF_EXPECT(WriteProtectedJsonToFile(resource_manager_, index_file_, index_),
             "Failed to save changes to " << index_file_);
+  exists_ = true;
 
   return {};
 }
@@ -20,6 +20,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <tss2/tss2_esys.h>
@@ -62,6 +63,10 @@ class TpmStorage : public secure_env::Storage {
   TpmResourceManager& resource_manager_;
   std::string index_file_;
   Json::Value index_;
+  // The entries of index_ by key, so lookups don't scan it.
+  std::unordered_map<std::string, TPM2_HANDLE> handles_;
+  // Whether index_file_ holds an index, as of the last read or write.
+  bool exists_ = false;
 
   std::string path_;
 };
@@ -37,6 +37,8 @@
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 
+#include "cuttlefish/host/commands/secure_env/key_pool.h"
+#include "cuttlefish/host/commands/secure_env/pooled_key_factory.h"
 #include "cuttlefish/host/commands/secure_env/primary_key_builder.h"
 #include "cuttlefish/host/commands/secure_env/tpm_attestation_record.h"
 #include "cuttlefish/host/commands/secure_env/tpm_hmac.h"
@@ -84,7 +86,7 @@ keymaster_error_t TranslateAuthorizationSetError(AuthorizationSet::Error err) {
 
 TpmKeymasterContext::TpmKeymasterContext(
     TpmResourceManager& resource_manager,
-    keymaster::KeymasterEnforcement& enforcement)
+    keymaster::KeymasterEnforcement& enforcement, KeyPool* key_pool)
     : resource_manager_(resource_manager),
       enforcement_(enforcement),
       key_blob_maker_(new TpmKeyBlobMaker(resource_manager_)),
@@ -92,10 +94,20 @@ TpmKeymasterContext::TpmKeymasterContext(
       attestation_context_(new TpmAttestationRecordContext),
       remote_provisioning_context_(
           new TpmRemoteProvisioningContext(resource_manager_)) {
-  key_factories_.emplace(KM_ALGORITHM_RSA,
-                         new keymaster::RsaKeyFactory(*key_blob_maker_, *this));
-  key_factories_.emplace(KM_ALGORITHM_EC,
-                         new keymaster::EcKeyFactory(*key_blob_maker_, *this));
+  if (key_pool) {
+    key_factories_.emplace(
+        KM_ALGORITHM_RSA,
+        new PooledRsaKeyFactory(*key_blob_maker_, *this, *key_pool));
+    key_factories_.emplace(
+        KM_ALGORITHM_EC,
+        new PooledEcKeyFactory(*key_blob_maker_, *this, *key_pool));
+  } else {
+    key_factories_.emplace(
+        KM_ALGORITHM_RSA,
+        new keymaster::RsaKeyFactory(*key_blob_maker_, *this));
+    key_factories_.emplace(
+        KM_ALGORITHM_EC, new keymaster::EcKeyFactory(*key_blob_maker_, *this));
+  }
   key_factories_.emplace(
       KM_ALGORITHM_AES,
       new keymaster::AesKeyFactory(*key_blob_maker_, *random_source_));
@@ -31,6 +31,7 @@
 
 namespace cuttlefish {
 
+class KeyPool;
 class TpmAttestationRecordContext;
 class TpmResourceManager;
 class TpmKeyBlobMaker;
@@ -40,6 +41,9 @@ class TpmRemoteProvisioningContext;
 /**
  * Implementation of KeymasterContext that wraps its keys with a TPM.
  *
+ * With a KeyPool, RSA and EC keys of the parameter sets it pools are generated
+ * from its keys. Without one, every key is generated on request.
+ *
  * See the parent class for details:
  * https://cs.android.com/android/platform/superproject/+/master:system/keymaster/include/keymaster/keymaster_context.h;drc=821acb74d7febb886a9b7cefee4ee3df4cc8c556
  */
@@ -63,7 +67,8 @@ class TpmKeymasterContext : public keymaster::KeymasterContext {
   std::optional<std::vector<uint8_t>> vbmeta_digest_;
 
  public:
-  TpmKeymasterContext(TpmResourceManager&, keymaster::KeymasterEnforcement&);
+  TpmKeymasterContext(TpmResourceManager&, keymaster::KeymasterEnforcement&,
+                      KeyPool* key_pool = nullptr);
   ~TpmKeymasterContext() = default;
 
   keymaster::KmVersion GetKmVersion() const override {
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <optional>
 #include <string>
@@ -23,6 +25,7 @@
 #include "absl/log/log.h"
 #include "fmt/core.h"
 #include "google/protobuf/text_format.h"
+#include "json/value.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/utils/files.h"
@@ -32,6 +35,8 @@
 #include "cuttlefish/host/commands/snapshot_util_cvd/parse.h"
 #include "cuttlefish/host/commands/snapshot_util_cvd/snapshot_taker.h"
 #include "cuttlefish/host/libs/command_util/runner/run_cvd.pb.h"
+#include "cuttlefish/host/libs/command_util/snapshot_manifest.h"
+#include "cuttlefish/host/libs/command_util/snapshot_utils.h"
 #include "cuttlefish/host/libs/command_util/util.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 #include "cuttlefish/result/result.h"
@@ -39,18 +44,37 @@
 namespace cuttlefish {
 namespace {
 
-// Send a `LauncherAction` RPC to every instance specified in `parsed`.
-Result<void> BroadcastLauncherAction(
+// Send a `LauncherAction` RPC to every instance specified in `parsed`, all at
+// once. Returns how many milliseconds each instance took, by instance number.
+Result<Json::Value> BroadcastLauncherAction(
     const CuttlefishConfig& config, const Parsed& parsed,
-    run_cvd::ExtendedLauncherAction extended_action) {
+    const run_cvd::ExtendedLauncherAction& extended_action) {
+  std::vector<std::future<Result<Json::Int64>>> responses;
   for (const auto instance_num : parsed.instance_nums) {
     LOG(INFO) << "Instance #" << instance_num
               << ": Sending request: " << extended_action.ShortDebugString();
-    auto socket = CF_EXPECT(
-        GetLauncherMonitor(config, instance_num, parsed.wait_for_launcher));
-    CF_EXPECT(RunLauncherAction(socket, extended_action, std::nullopt));
+    responses.emplace_back(std::async(
+        std::launch::async,
+        [&config, &parsed, &extended_action,
+         instance_num]() -> Result<Json::Int64> {
+          const auto start = std::chrono::steady_clock::now();
+          auto socket = CF_EXPECT(GetLauncherMonitor(
+              config, instance_num, parsed.wait_for_launcher));
+          CF_EXPECT(RunLauncherAction(socket, extended_action, std::nullopt));
+          return MillisecondsSince(start);
+        }));
   }
-  return {};
+  Json::Value timing(Json::objectValue);
+  std::vector<Result<Json::Int64>> results;
+  for (auto& response : responses) {
+    results.emplace_back(response.get());
+  }
+  for (size_t i = 0; i < results.size(); i++) {
+    const int instance_num = parsed.instance_nums[i];
+    timing[std::to_string(instance_num)] = CF_EXPECTF(
+        std::move(results[i]), "Instance #{} failed", instance_num);
+  }
+  return timing;
 }
 
 Result<void> SnapshotCvdMain(std::vector<std::string> args) {
@@ -86,12 +110,23 @@ Result<void> SnapshotCvdMain(std::vector<std::string> args) {
       CF_EXPECTF(!FileExists(parsed.snapshot_path, /* follow symlink */ false),
                  "Delete the destination directory \"{}\" first",
                  parsed.snapshot_path);
+      // Share unchanged files with the snapshot the device was restored from,
+      // unless told otherwise.
+      if (parsed.base_snapshot_path.empty() &&
+          HasSnapshotManifest(config->snapshot_path())) {
+        parsed.base_snapshot_path = config->snapshot_path();
+      } else if (!parsed.base_snapshot_path.empty()) {
+        parsed.base_snapshot_path = AbsolutePath(parsed.base_snapshot_path);
+      }
 
+      const auto start = std::chrono::steady_clock::now();
+      Json::Value timing;
       // Automatically suspend and resume if requested.
       if (parsed.auto_suspend) {
         run_cvd::ExtendedLauncherAction extended_action;
         extended_action.mutable_suspend();
-        CF_EXPECT(BroadcastLauncherAction(*config, parsed, extended_action));
+        timing["suspend_ms"] = CF_EXPECT(
+            BroadcastLauncherAction(*config, parsed, extended_action));
       }
       absl::Cleanup maybe_resume_on_exit = [&parsed, &config]() {
         if (!parsed.auto_suspend) {
@@ -99,7 +134,7 @@ Result<void> SnapshotCvdMain(std::vector<std::string> args) {
         }
         run_cvd::ExtendedLauncherAction extended_action;
         extended_action.mutable_resume();
-        Result<void> result =
+        Result<Json::Value> result =
             BroadcastLauncherAction(*config, parsed, extended_action);
         if (!result.has_value()) {
           LOG(FATAL) << "RunLauncherAction failed: " << result.error();
@@ -121,14 +156,30 @@ Result<void> SnapshotCvdMain(std::vector<std::string> args) {
 
       // Snapshot group-level host runtime files and generate snapshot metadata
       // file.
+      auto phase_start = std::chrono::steady_clock::now();
       const std::string meta_json_path =
-          CF_EXPECT(HandleHostGroupSnapshot(parsed.snapshot_path),
+          CF_EXPECT(HandleHostGroupSnapshot(parsed.snapshot_path,
+                                            parsed.base_snapshot_path),
                     "Failed to back up the group-level host runtime files.");
+      timing["host_files_ms"] = MillisecondsSince(phase_start);
       // Snapshot each instance.
       run_cvd::ExtendedLauncherAction extended_action;
       extended_action.mutable_snapshot_take()->set_snapshot_path(
           meta_json_path);
-      CF_EXPECT(BroadcastLauncherAction(*config, parsed, extended_action));
+      extended_action.mutable_snapshot_take()->set_compress_memory(
+          parsed.compress_memory);
+      timing["guest_snapshot_ms"] =
+          CF_EXPECT(BroadcastLauncherAction(*config, parsed, extended_action));
+      timing["instances"] =
+          CF_EXPECT(TakeInstanceTimings(parsed.snapshot_path));
+      phase_start = std::chrono::steady_clock::now();
+      CF_EXPECT(HandleGuestSnapshots(parsed.snapshot_path,
+                                     parsed.base_snapshot_path),
+                "Failed to add the guest snapshots to the manifest.");
+      timing["guest_files_ms"] = MillisecondsSince(phase_start);
+      timing["total_ms"] = MillisecondsSince(start);
+      CF_EXPECT(WriteSnapshotTiming(parsed.snapshot_path, std::move(timing)),
+                "Failed to write the timing report.");
       std::move(delete_snapshot_on_fail).Cancel();
       return {};
     }
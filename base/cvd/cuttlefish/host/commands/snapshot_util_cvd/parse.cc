@@ -46,6 +46,10 @@ constexpr char wait_for_launcher_help[] =
 constexpr char snapshot_path_help[] =
     "Path to the directory the taken snapshot files are saved";
 
+constexpr char base_snapshot_path_help[] =
+    "Path to a previous snapshot to share unchanged files with. Defaults to "
+    "the snapshot the device was restored from, if any.";
+
 Flag SnapshotCmdFlag(std::string& value_buf) {
   return GflagsCompatFlag("subcmd", value_buf).Help(snapshot_cmd_help);
 }
@@ -118,12 +122,20 @@ Result<Parsed> Parse(std::vector<std::string>& args) {
   flags.push_back(SnapshotCmdFlag(snapshot_op));
   flags.push_back(WaitForLauncherFlag(parsed.wait_for_launcher));
   flags.push_back(SnapshotPathFlag(snapshot_path));
+  flags.push_back(GflagsCompatFlag("base_snapshot_path",
+                                   parsed.base_snapshot_path)
+                      .Help(base_snapshot_path_help));
   flags.push_back(CleanupSnapshotPathFlag(parsed.cleanup_snapshot_path));
   flags.push_back(
       GflagsCompatFlag("force", parsed.force)
           .Help("If the snapshot path already exists, delete it first"));
   flags.push_back(GflagsCompatFlag("auto_suspend", parsed.auto_suspend)
                       .Help("Suspend/resume before/after taking the snapshot"));
+  flags.push_back(
+      GflagsCompatFlag("compress_memory", parsed.compress_memory)
+          .Help("Compress the guest memory while crosvm writes it. Smaller "
+                "snapshots, but they can't share the memory with the base "
+                "snapshot."));
   flags.push_back(HelpFlag(flags));
   flags.push_back(HelpXmlFlag(flags, std::cout, help_xml));
   Result<void> parse_res =
@@ -40,6 +40,8 @@ struct Parsed {
   std::vector<int> instance_nums;
   int wait_for_launcher;
   std::string snapshot_path;
+  // Previous snapshot to share unchanged files with.
+  std::string base_snapshot_path;
   bool cleanup_snapshot_path;
   // Delete snapshot_path if already present.
   bool force = false;
@@ -48,6 +50,8 @@ struct Parsed {
   // Ideally we'd detect the suspended state of CF and do this automatically by
   // default.
   bool auto_suspend = false;
+  // Compress the guest memory while it is written to the snapshot.
+  bool compress_memory = false;
   std::optional<LogSeverity> verbosity_level;
 };
 Result<Parsed> Parse(int argc, char** argv);
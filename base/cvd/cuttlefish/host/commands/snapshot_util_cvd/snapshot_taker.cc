@@ -22,22 +22,39 @@
 #include "absl/log/log.h"
 #include "absl/strings/match.h"
 #include "android-base/file.h"
+#include "fmt/format.h"
 
 #include "cuttlefish/common/libs/utils/environment.h"
 #include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/common/libs/utils/json.h"
+#include "cuttlefish/files/file_exists.h"
+#include "cuttlefish/posix/remove.h"
 #include "cuttlefish/common/libs/utils/users.h"
+#include "cuttlefish/host/libs/command_util/snapshot_manifest.h"
 #include "cuttlefish/host/libs/command_util/snapshot_utils.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
+namespace {
+
+void LogStats(const std::string& what, const SnapshotCopyStats& stats) {
+  LOG(INFO) << fmt::format(
+      "Snapshot of {} {}: {} bytes reflinked, {} bytes shared with the base "
+      "snapshot, {} bytes copied",
+      stats.files, what, stats.bytes_cloned, stats.bytes_shared,
+      stats.bytes_copied);
+}
+
+}  // namespace
 
 /**
  * cp -r <cuttlefish home dir> <snapshot_path>
  * write meta info for cvd: i.e. HOME, group name, instance names
  * returns the path of generated snapshot json file
  */
-Result<std::string> HandleHostGroupSnapshot(const std::string& path) {
+Result<std::string> HandleHostGroupSnapshot(
+    const std::string& path, const std::string& base_snapshot_path) {
   const auto cuttlefish_home = StringFromEnv("HOME", "");
   CF_EXPECT(!cuttlefish_home.empty(),
             "\"HOME\" environment variable must be set.");
@@ -53,12 +70,12 @@ Result<std::string> HandleHostGroupSnapshot(const std::string& path) {
              "is not subdirectory of cuttlefish home \"{}\".",
              cuttlefish_root, cuttlefish_home);
 
-  // cp -r HOME snapshot_path
-  auto always_true = [](const std::string&) -> bool { return true; };
-  CF_EXPECTF(CopyDirectoryRecursively(cuttlefish_root, snapshot_path,
-                                      /* verify_dest_dir_empty */ true,
-                                      /* predicate */ std::move(always_true)),
-             "\"cp -r {} {} failed.\"", cuttlefish_root, snapshot_path);
+  // cp -r HOME snapshot_path, in parallel and sharing data where possible
+  SnapshotCopyStats stats = CF_EXPECTF(
+      CopyToSnapshot(cuttlefish_root, snapshot_path,
+                     {.base_snapshot_path = base_snapshot_path}),
+      "\"cp -r {} {} failed.\"", cuttlefish_root, snapshot_path);
+  LogStats("host files", stats);
 
   const auto meta_json =
       CF_EXPECTF(CreateMetaInfo(*cuttlefish_config, snapshot_path),
@@ -90,4 +107,50 @@ Result<std::string> HandleHostGroupSnapshot(const std::string& path) {
   return meta_json_path;
 }
 
+Result<void> HandleGuestSnapshots(const std::string& snapshot_path,
+                                  const std::string& base_snapshot_path) {
+  const Json::Value meta_json = CF_EXPECT(LoadMetaJson(snapshot_path));
+  const Json::Value& guest_snapshots = meta_json[kGuestSnapshotField];
+  for (const std::string& id : guest_snapshots.getMemberNames()) {
+    SnapshotCopyStats stats = CF_EXPECTF(
+        AddToSnapshot(snapshot_path, guest_snapshots[id].asString(),
+                      {.base_snapshot_path = base_snapshot_path}),
+        "Failed to add the guest snapshot of instance {}", id);
+    LogStats(fmt::format("guest files of instance {}", id), stats);
+  }
+  return {};
+}
+
+Result<Json::Value> TakeInstanceTimings(const std::string& snapshot_path) {
+  const Json::Value meta_json = CF_EXPECT(LoadMetaJson(snapshot_path));
+  const Json::Value& guest_snapshots = meta_json[kGuestSnapshotField];
+  Json::Value timings(Json::objectValue);
+  for (const std::string& id : guest_snapshots.getMemberNames()) {
+    const std::string timing_path = snapshot_path + "/" +
+                                    guest_snapshots[id].asString() + "/" +
+                                    kSnapshotTimingFileName;
+    // Older launchers don't write one.
+    if (!FileExists(timing_path)) {
+      continue;
+    }
+    timings[id] = CF_EXPECT(LoadFromFile(timing_path));
+    CF_EXPECT(RemoveFile(timing_path));
+  }
+  return timings;
+}
+
+Result<void> WriteSnapshotTiming(const std::string& snapshot_path,
+                                 Json::Value timing) {
+  Json::Value meta_json = CF_EXPECT(LoadMetaJson(snapshot_path));
+  meta_json[kSnapshotTimingField] = std::move(timing);
+  VLOG(0) << "Snapshot timing: " << meta_json[kSnapshotTimingField];
+
+  const std::string meta_json_path = SnapshotMetaJsonPath(snapshot_path);
+  CF_EXPECTF(android::base::WriteStringToFile(meta_json.toStyledString(),
+                                              meta_json_path,
+                                              /* follow_symlinks */ true),
+             "Failed to write \"{}\"", meta_json_path);
+  return {};
+}
+
 }  // namespace cuttlefish
@@ -18,6 +18,8 @@
 
 #include <string>
 
+#include "json/value.h"
+
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
@@ -31,6 +33,26 @@ namespace cuttlefish {
  * TODO(kwstephenkim): separate host instance specific snapshot from
  * the host group snapshot
  */
-Result<std::string> HandleHostGroupSnapshot(const std::string& snapshot_path);
+Result<std::string> HandleHostGroupSnapshot(
+    const std::string& snapshot_path, const std::string& base_snapshot_path);
+
+/**
+ * Adds the guest snapshots written by the VMM to the snapshot manifest,
+ * sharing their unchanged chunks with the base snapshot.
+ */
+Result<void> HandleGuestSnapshots(const std::string& snapshot_path,
+                                  const std::string& base_snapshot_path);
+
+/**
+ * Collects the per-phase timings run_cvd wrote into each instance guest
+ * snapshot directory, by instance id, and removes the files.
+ */
+Result<Json::Value> TakeInstanceTimings(const std::string& snapshot_path);
+
+/**
+ * Adds the timing report to the snapshot meta information.
+ */
+Result<void> WriteSnapshotTiming(const std::string& snapshot_path,
+                                 Json::Value timing);
 
 }  // namespace cuttlefish
@@ -1,15 +1,32 @@
 #include "cuttlefish/host/frontend/webrtc/audio_mixer.h"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
+#include <cmath>
+#include <optional>
 #include <vector>
 #include "audio_settings.h"
 
 #include "absl/log/check.h"
+#include "absl/log/log.h"
+
+#include "cuttlefish/host/frontend/webrtc/audio_resampler.h"
 
 namespace cuttlefish {
 namespace {
 
+constexpr uint8_t kMaxChannelsCount =
+    GetChannelsCount(AudioChannelsLayout::Surround51);
+
+// How far ahead of the mixer a stream may queue audio. Frames beyond that are
+// dropped rather than adding to the playback latency.
+constexpr size_t kMaxQueuedMs = 500;
+
+// Channel gains are Q14 fixed point, so volumes up to 2.0 are representable.
+constexpr int kGainBits = 14;
+
 class CvdAudioFrameBuffer : public webrtc_streaming::AudioFrameBuffer {
  public:
   CvdAudioFrameBuffer(const uint8_t* buffer, int bits_per_sample,
@@ -44,103 +61,142 @@ inline size_t GetFramesCount(size_t buffer_size_bytes, uint8_t channels_count,
   return buffer_size_bits / (channels_count * bits_per_sample);
 }
 
-inline size_t GetFrameCountAfterResampling(uint32_t target_rate,
-                                           uint32_t source_rate,
-                                           size_t source_frames_count) {
-  if (target_rate == source_rate) {
-    return source_frames_count;
-  }
-  return source_frames_count * target_rate / source_rate;
+inline int16_t Saturate(int32_t value) {
+  return static_cast<int16_t>(
+      std::clamp<int32_t>(value, std::numeric_limits<int16_t>::min(),
+                          std::numeric_limits<int16_t>::max()));
 }
 
-template <class DST, class SRC>
-size_t ConvertAudioStream(void* dst, uint8_t dst_channels, uint32_t dst_rate,
-                          const void* src, uint8_t src_channels,
-                          uint32_t src_rate, size_t src_frames_count,
-                          const std::vector<std::vector<float>>& channel_map) {
-  constexpr uint8_t kMaxChannelsCount =
-      GetChannelsCount(AudioChannelsLayout::Surround51);
-
-  CHECK(src_channels <= kMaxChannelsCount);
-  CHECK(channel_map.size() >= dst_channels);
-  CHECK(std::all_of(channel_map.cbegin(), channel_map.cbegin() + dst_channels,
-                    [src_channels](const std::vector<float>& v) {
-                      return v.size() >= src_channels;
-                    }));
+// Scales a sample to the mixer's 16 bit full scale
+inline int32_t ToMixerScale(int8_t sample) { return sample * 256; }
+inline int32_t ToMixerScale(int16_t sample) { return sample; }
+inline int32_t ToMixerScale(int32_t sample) { return sample >> 16; }
 
-  std::array<SRC, kMaxChannelsCount> src_frame_resampled = {};
+// Row major dst_channels x src_channels matrix of Q14 gains
+using ChannelGains = std::array<int32_t, kMaxChannelsCount * kMaxChannelsCount>;
 
-  const auto factor = static_cast<double>(dst_rate) / src_rate;
-  const auto dst_frames_count =
-      GetFrameCountAfterResampling(dst_rate, src_rate, src_frames_count);
-
-  auto dst_typed = reinterpret_cast<DST*>(dst);
+template <class SRC>
+void MapChannels(const void* src, uint8_t src_channels, size_t frames_count,
+                 const ChannelGains& gains, uint8_t dst_channels,
+                 int16_t* dst) {
   auto src_typed = reinterpret_cast<const SRC*>(src);
-
-  for (size_t frame_id = 0; frame_id < dst_frames_count; ++frame_id) {
-    const double src_frame_idx_float = frame_id / factor;
-    const size_t src_frame_idx_1 = static_cast<size_t>(src_frame_idx_float);
-    const size_t src_frame_idx_2 =
-        std::min(src_frame_idx_1 + 1, src_frames_count - 1);
-    const float fraction = src_frame_idx_float - src_frame_idx_1;
-
-    // Resample a single frame
-    for (size_t c = 0; c < src_channels; ++c) {
-      const auto sample1 = src_typed[src_frame_idx_1 * src_channels + c];
-      const auto sample2 = src_typed[src_frame_idx_2 * src_channels + c];
-      src_frame_resampled[c] =
-          static_cast<SRC>(sample1 + (sample2 - sample1) * fraction);
-    }
-
-    // Mix and apply channel mapping
-    const auto dst_frame_begin = frame_id * dst_channels;
-    for (auto i = 0; i < dst_channels; ++i) {
-      for (auto j = 0; j < src_channels; ++j) {
-        const int64_t value =
-            static_cast<int64_t>(dst_typed[dst_frame_begin + i]) +
-            src_frame_resampled[j] * channel_map[i][j];
-        dst_typed[dst_frame_begin + i] = static_cast<DST>(
-            std::clamp<int64_t>(value, std::numeric_limits<DST>::min(),
-                                std::numeric_limits<DST>::max()));
+  for (size_t frame_id = 0; frame_id < frames_count; ++frame_id) {
+    const SRC* src_frame = src_typed + frame_id * src_channels;
+    int16_t* dst_frame = dst + frame_id * dst_channels;
+    for (uint8_t i = 0; i < dst_channels; ++i) {
+      const int32_t* row = &gains[i * src_channels];
+      int64_t acc = 0;
+      for (uint8_t j = 0; j < src_channels; ++j) {
+        acc += static_cast<int64_t>(ToMixerScale(src_frame[j])) * row[j];
       }
+      acc += 1 << (kGainBits - 1);
+      dst_frame[i] = Saturate(static_cast<int32_t>(std::clamp<int64_t>(
+          acc >> kGainBits, std::numeric_limits<int32_t>::min(),
+          std::numeric_limits<int32_t>::max())));
     }
   }
-  return dst_frames_count;
 }
 
-using ConvertAudioStreamFn = size_t(void*, uint8_t, uint32_t, const void*,
-                                    uint8_t, uint32_t, size_t,
-                                    const std::vector<std::vector<float>>&);
+using MapChannelsFn = void(const void*, uint8_t, size_t, const ChannelGains&,
+                           uint8_t, int16_t*);
 /*
- * The kConvertAudioStreamFunctionMap variable is a 2D array of function
- * pointers for converting between different audio sample formats. The rows are
- * indexed by the destination format's size in bytes per sample, while the
- * columns are indexed by the source format's size. This provides an efficient
- * way to look up the correct conversion function based on the source and
- * destination audio formats.
+ * Channel mapping functions indexed by the source format's size in bytes per
+ * sample. The mixer always works on 16-bit samples.
  * 0-byte and 3-bytes samples are not supported.
  */
-constexpr std::array<std::array<ConvertAudioStreamFn*, 5>, 5>
-    kConvertAudioStreamFunctionMap = {
-        {{nullptr, nullptr, nullptr, nullptr, nullptr},
-         {nullptr, ConvertAudioStream<int8_t, int8_t>,
-          ConvertAudioStream<int8_t, int16_t>, nullptr,
-          ConvertAudioStream<int8_t, int32_t>},
-         {nullptr, ConvertAudioStream<int16_t, int8_t>,
-          ConvertAudioStream<int16_t, int16_t>, nullptr,
-          ConvertAudioStream<int16_t, int32_t>},
-         {nullptr, nullptr, nullptr, nullptr, nullptr},
-         {nullptr, ConvertAudioStream<int32_t, int8_t>,
-          ConvertAudioStream<int32_t, int16_t>, nullptr,
-          ConvertAudioStream<int32_t, int32_t>}}};
+constexpr std::array<MapChannelsFn*, 5> kMapChannelsFunctionMap = {
+    nullptr, MapChannels<int8_t>, MapChannels<int16_t>, nullptr,
+    MapChannels<int32_t>};
+
+/*
+ * Single producer, single consumer queue of interleaved frames. The producer
+ * only writes at the tail and the consumer only reads at the head, so neither
+ * side waits for the other.
+ */
+class FrameQueue {
+ public:
+  FrameQueue(size_t capacity_frames, uint8_t channels)
+      : samples_(std::bit_ceil(capacity_frames * channels)),
+        mask_(samples_.size() - 1),
+        channels_(channels) {}
+
+  // Queues up to `frames_count` frames, returns how many fit.
+  size_t Push(const int16_t* frames, size_t frames_count) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t free_frames = (samples_.size() - (tail - head)) / channels_;
+    const size_t count = std::min(frames_count, free_frames) * channels_;
+    for (size_t i = 0; i < count; ++i) {
+      samples_[(tail + i) & mask_] = frames[i];
+    }
+    tail_.store(tail + count, std::memory_order_release);
+    return count / channels_;
+  }
+
+  // Adds up to `frames_count` queued frames to `dst` and dequeues them.
+  // Returns how many were available.
+  size_t PopAndAdd(int32_t* dst, size_t frames_count) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t count = std::min(frames_count * channels_, tail - head);
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] += samples_[(head + i) & mask_];
+    }
+    head_.store(head + count, std::memory_order_release);
+    return count / channels_;
+  }
+
+  bool Empty() const {
+    return head_.load(std::memory_order_relaxed) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  std::vector<int16_t> samples_;
+  const size_t mask_;
+  const uint8_t channels_;
+  // Written by the consumer only
+  alignas(64) std::atomic<size_t> head_{0};
+  // Written by the producer only
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
 }  // namespace
 
+struct AudioMixer::Stream {
+  Stream(size_t capacity_frames, uint8_t channels)
+      : queue(capacity_frames, channels) {}
+
+  // Serializes OnPlayback calls for this stream
+  std::mutex producer_mutex;
+  ////////////////////////////////////////////////////
+  //////////// Guarded by producer_mutex /////////////
+  ////////////////////////////////////////////////////
+
+  uint8_t channels_count = 0;
+  float volume = -1;
+  // As of now we only use direct channel mapping, with the volume applied
+  ChannelGains gains = {};
+  std::optional<AudioResampler> resampler;
+  // Scratch buffers, kept to avoid allocating on every playback buffer
+  std::vector<int16_t> mapped;
+  std::vector<int16_t> resampled;
+
+  ////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////
+
+  // Frames converted to the mixer's format, consumed by MixerLoop
+  FrameQueue queue;
+  std::atomic<size_t> dropped_frames{0};
+};
+
 AudioMixer::AudioMixer(std::shared_ptr<webrtc_streaming::AudioSink> audio_sink,
                        const AudioMixerSettings& settings)
     : channels_count_(GetChannelsCount(settings.channels_layout)),
       sample_rate_(settings.sample_rate),
       audio_sink_(std::move(audio_sink)),
-      mixed_buffer_(chunk_frames_count_ * frame_size_bytes_) {}
+      mix_buffer_(chunk_frames_count_ * channels_count_),
+      output_buffer_(chunk_frames_count_ * channels_count_) {}
 
 AudioMixer::~AudioMixer() { Stop(); }
 
@@ -158,62 +214,87 @@ void AudioMixer::Stop() {
 
 void AudioMixer::OnStreamStopped(uint32_t stream_id) {
   std::lock_guard<std::mutex> lock(mutex_);
-  next_frame_.erase(stream_id);
+  const auto it = streams_.find(stream_id);
+  if (it == streams_.end()) {
+    return;
+  }
+  // Play what was already queued, a restarted stream gets a new queue
+  if (!it->second->queue.Empty()) {
+    draining_streams_.emplace_back(std::move(it->second));
+  }
+  streams_.erase(it);
 }
 
 void AudioMixer::OnPlayback(uint32_t stream_id, uint32_t stream_sample_rate,
                             uint8_t stream_channels_count,
                             uint8_t stream_bits_per_channel, float volume,
                             const uint8_t* buffer, size_t size) {
+  CHECK(stream_channels_count <= kMaxChannelsCount);
+  const auto map_fn =
+      kMapChannelsFunctionMap[std::min<size_t>(stream_bits_per_channel / 8,
+                                               kMapChannelsFunctionMap.size() -
+                                                   1)];
+  CHECK(map_fn) << "Format is not supported";
   const auto stream_frames_count =
       GetFramesCount(size, stream_channels_count, stream_bits_per_channel);
-  const auto frames_count = GetFrameCountAfterResampling(
-      sample_rate_, stream_sample_rate, stream_frames_count);
-
-  std::unique_lock<std::mutex> lock(mutex_);
 
-  // As of now we only use direct channel mapping
-  for(size_t i = 0; i < channles_map.size(); ++i) {
-    channles_map[i][i] = volume;
+  std::shared_ptr<Stream> stream;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool need_notify = streams_.empty();  // no active streams
+    auto& entry = streams_[stream_id];
+    if (!entry) {
+      // If stream was not active it will start from the next 10ms bucket
+      entry = std::make_shared<Stream>(sample_rate_ * kMaxQueuedMs / 1000,
+                                       channels_count_);
+    }
+    stream = entry;
+    if (need_notify) {
+      mixer_cv_.notify_one();
+    }
   }
 
-  const bool need_notify = next_frame_.empty();  // no active streams
-
-  const auto it = next_frame_.find(stream_id);
-  // If stream was not active it will start from the next 10ms bucket
-  const auto next_frame_id = it == next_frame_.end() ? 0 : it->second;
+  std::lock_guard<std::mutex> lock(stream->producer_mutex);
 
-  // Resize the buffer to fit extra frames_count samples
-  const auto buffer_size = mixed_buffer_.size();
-  if (buffer_size < (next_frame_id + frames_count) * frame_size_bytes_) {
-    mixed_buffer_.resize((next_frame_id + frames_count) * frame_size_bytes_);
+  if (stream->volume != volume ||
+      stream->channels_count != stream_channels_count) {
+    const int32_t gain = std::lround(std::clamp(volume, 0.0f, 1.99f) *
+                                     (1 << kGainBits));
+    stream->gains.fill(0);
+    for (uint8_t i = 0; i < std::min(channels_count_, stream_channels_count);
+         ++i) {
+      stream->gains[i * stream_channels_count + i] = gain;
+    }
+    stream->volume = volume;
   }
-
-  if (next_frame_id + frames_count > last_active_frame_) {
-    std::fill(mixed_buffer_.data() + last_active_frame_ * frame_size_bytes_,
-              mixed_buffer_.data() +
-                  (next_frame_id + frames_count) * frame_size_bytes_,
-              0);
+  if (!stream->resampler ||
+      stream->resampler->InputRate() != stream_sample_rate ||
+      stream->channels_count != stream_channels_count) {
+    stream->resampler.emplace(stream_sample_rate, sample_rate_,
+                              channels_count_);
+    stream->channels_count = stream_channels_count;
   }
 
-  const auto stream_sample_size_bytes = stream_bits_per_channel / 8;
-  const auto convert_fn =
-      kConvertAudioStreamFunctionMap[sample_size_bytes_]
-                                    [stream_sample_size_bytes];
-  CHECK(convert_fn) << "Format is not supported";
-  const auto filled_frames_count =
-      convert_fn(mixed_buffer_.data() + next_frame_id * frame_size_bytes_,
-                 channels_count_, sample_rate_, buffer, stream_channels_count,
-                 stream_sample_rate, stream_frames_count, channles_map);
-  CHECK(filled_frames_count <= frames_count);
-
-  next_frame_[stream_id] = next_frame_id + filled_frames_count;
-  last_active_frame_ =
-      std::max(last_active_frame_, next_frame_id + filled_frames_count);
-
-  if (need_notify) {
-    lock.unlock();
-    mixer_cv_.notify_one();
+  // Remix first, which shrinks the data when downmixing and lets the
+  // resampler work on the mixer's channel layout.
+  stream->mapped.resize(stream_frames_count * channels_count_);
+  map_fn(buffer, stream_channels_count, stream_frames_count, stream->gains,
+         channels_count_, stream->mapped.data());
+
+  stream->resampled.clear();
+  stream->resampler->Resample(stream->mapped.data(), stream_frames_count,
+                              stream->resampled);
+
+  const size_t frames_count = stream->resampled.size() / channels_count_;
+  const size_t queued =
+      stream->queue.Push(stream->resampled.data(), frames_count);
+  if (queued < frames_count) {
+    const size_t dropped = stream->dropped_frames.fetch_add(
+        frames_count - queued, std::memory_order_relaxed);
+    if (dropped == 0) {
+      LOG(WARNING) << "Audio stream " << stream_id
+                   << " is too far ahead of the mixer, dropping frames";
+    }
   }
 }
 
@@ -230,26 +311,36 @@ void AudioMixer::MixerLoop() {
       continue;
     }
 
-    if (next_frame_.empty() && last_active_frame_ == 0) {
+    if (streams_.empty() && draining_streams_.empty()) {
       // No active streams and nothing to play, block until there is
       mixer_cv_.wait(
-          lock, [&]() { return !next_frame_.empty() || stop_mixer_.load(); });
+          lock, [&]() { return !streams_.empty() || stop_mixer_.load(); });
       if (stop_mixer_.load()) {
         return;
       }
       next_frame_time = std::chrono::system_clock::now();
     }
 
-    if (last_active_frame_ < chunk_frames_count_) {
-      // Fill the rest of 10ms bucket with 0s
-      std::fill(mixed_buffer_.data() + last_active_frame_ * frame_size_bytes_,
-                mixed_buffer_.data() + chunk_frames_count_ * frame_size_bytes_,
-                0);
+    // Streams that are behind leave the rest of the 10ms bucket silent
+    std::fill(mix_buffer_.begin(), mix_buffer_.end(), 0);
+    for (const auto& [id, stream] : streams_) {
+      stream->queue.PopAndAdd(mix_buffer_.data(), chunk_frames_count_);
+    }
+    for (const auto& stream : draining_streams_) {
+      stream->queue.PopAndAdd(mix_buffer_.data(), chunk_frames_count_);
     }
+    std::erase_if(draining_streams_,
+                  [](const auto& stream) { return stream->queue.Empty(); });
+    lock.unlock();
+
+    // The sum is only clamped once, after all streams were added
+    std::transform(mix_buffer_.begin(), mix_buffer_.end(),
+                   output_buffer_.begin(), Saturate);
 
     const CvdAudioFrameBuffer audio_frame_buffer(
-        mixed_buffer_.data(), sample_size_bytes_ * 8, sample_rate_,
-        channels_count_, chunk_frames_count_);
+        reinterpret_cast<const uint8_t*>(output_buffer_.data()),
+        sample_size_bytes_ * 8, sample_rate_, channels_count_,
+        chunk_frames_count_);
 
     const int64_t timestamp_ms =
         std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -257,24 +348,6 @@ void AudioMixer::MixerLoop() {
             .count();
     audio_sink_->OnFrame(audio_frame_buffer, timestamp_ms);
     next_frame_time += kInterval;
-
-    // Frame
-    for (auto& [id, frame] : next_frame_) {
-      if (frame > chunk_frames_count_) {
-        frame -= chunk_frames_count_;
-      } else {
-        frame = 0;
-      }
-    }
-    last_active_frame_ = last_active_frame_ > chunk_frames_count_
-                             ? last_active_frame_ - chunk_frames_count_
-                             : 0;
-    if (last_active_frame_ > 0) {
-      std::memmove(
-          mixed_buffer_.data(),
-          mixed_buffer_.data() + chunk_frames_count_ * frame_size_bytes_,
-          last_active_frame_ * frame_size_bytes_);
-    }
   }
 }
 
@@ -31,6 +31,10 @@ class AudioMixer {
   void OnStreamStopped(uint32_t stream_id);
 
  private:
+  // Per stream conversion state and the queue of converted frames, defined in
+  // the source file.
+  struct Stream;
+
   // The main mixing loop that runs on its own thread.
   void MixerLoop();
 
@@ -43,34 +47,27 @@ class AudioMixer {
 
   std::shared_ptr<webrtc_streaming::AudioSink> audio_sink_;
 
+  // Streams are converted to the mixer's format by the threads calling
+  // OnPlayback, which only take mutex_ to look up the stream. The converted
+  // frames are handed to MixerLoop through each stream's lock-free queue.
   std::mutex mutex_;
   ////////////////////////////////////////////////////
   ///////////////// Guarded by mutex_ ////////////////
   ////////////////////////////////////////////////////
 
-  // Buffer stores mixed auido data for every active stream. Consumed by
-  // MixerLoop
-  std::vector<uint8_t> mixed_buffer_;
-
-  // Index of the last frame with available (i.e. not yet played) audio data
-  size_t last_active_frame_ = 0;
+  // Active streams by id
+  std::unordered_map<uint32_t, std::shared_ptr<Stream>> streams_;
 
-  // Frame index per stream to put next available data to
-  std::unordered_map<uint32_t, size_t> next_frame_;
-
-  // Used to remap channels and apply volume levels
-  std::vector<std::vector<float>> channles_map = {{
-      {1, 0, 0, 0, 0, 0},
-      {0, 1, 0, 0, 0, 0},
-      {0, 0, 1, 0, 0, 0},
-      {0, 0, 0, 1, 0, 0},
-      {0, 0, 0, 0, 1, 0},
-      {0, 0, 0, 0, 0, 1},
-  }};
+  // Stopped streams that still have queued frames to play
+  std::vector<std::shared_ptr<Stream>> draining_streams_;
 
   ////////////////////////////////////////////////////
   ////////////////////////////////////////////////////
 
+  // Only accessed by MixerLoop
+  std::vector<int32_t> mix_buffer_;
+  std::vector<int16_t> output_buffer_;
+
   std::thread mixer_thread_;
   std::atomic<bool> stop_mixer_{false};
   std::condition_variable mixer_cv_;
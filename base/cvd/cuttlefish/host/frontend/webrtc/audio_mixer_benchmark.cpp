@@ -0,0 +1,215 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Converts `--seconds` of stereo audio from each guest sample rate to the
+// mixer's 48 kHz in 10 ms periods, with `AudioResampler` and with the linear
+// interpolation `AudioMixer` used before it. Then plays `--streams` streams
+// through an `AudioMixer` in real time and reports how long the `OnPlayback`
+// calls, which block the audio handler threads, take.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/log/log.h"
+
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/host/frontend/webrtc/audio_mixer.h"
+#include "cuttlefish/host/frontend/webrtc/audio_resampler.h"
+#include "cuttlefish/host/frontend/webrtc/audio_settings.h"
+#include "cuttlefish/host/frontend/webrtc/libdevice/audio_sink.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t kMixerRate = 48000;
+constexpr uint8_t kChannels = 2;
+constexpr uint32_t kGuestRates[] = {8000, 11025, 16000, 22050, 44100, 48000};
+
+std::vector<int16_t> Sine(uint32_t rate, size_t frames) {
+  std::vector<int16_t> samples(frames * kChannels);
+  for (size_t i = 0; i < frames; i++) {
+    const auto value =
+        static_cast<int16_t>(16000 * std::sin(2 * M_PI * 1000.0 * i / rate));
+    std::fill_n(&samples[i * kChannels], kChannels, value);
+  }
+  return samples;
+}
+
+// The per buffer linear interpolation AudioMixer used before AudioResampler.
+void LinearResample(const int16_t* in, size_t frames, uint32_t in_rate,
+                    float volume, std::vector<int16_t>& out) {
+  const double factor = static_cast<double>(kMixerRate) / in_rate;
+  const size_t out_frames = frames * kMixerRate / in_rate;
+  const size_t begin = out.size();
+  out.resize(begin + out_frames * kChannels);
+  for (size_t frame = 0; frame < out_frames; frame++) {
+    const double position = frame / factor;
+    const size_t first = static_cast<size_t>(position);
+    const size_t second = std::min(first + 1, frames - 1);
+    const float fraction = position - first;
+    for (size_t c = 0; c < kChannels; c++) {
+      const int16_t sample1 = in[first * kChannels + c];
+      const int16_t sample2 = in[second * kChannels + c];
+      const auto resampled =
+          static_cast<int16_t>(sample1 + (sample2 - sample1) * fraction);
+      out[begin + frame * kChannels + c] = static_cast<int16_t>(std::clamp<
+          int64_t>(static_cast<int64_t>(resampled * volume), INT16_MIN,
+                   INT16_MAX));
+    }
+  }
+}
+
+double MicrosecondsPer(Clock::duration total, size_t count) {
+  return std::chrono::duration<double, std::micro>(total).count() / count;
+}
+
+void BenchmarkResamplers(size_t seconds) {
+  std::cout << "Converting " << seconds << " s of stereo audio to "
+            << kMixerRate << " Hz in 10 ms periods, per second of audio:\n";
+  std::vector<int16_t> out;
+  out.reserve(kMixerRate / 100 * kChannels * 2);
+  for (uint32_t rate : kGuestRates) {
+    const size_t period = rate / 100;
+    const std::vector<int16_t> in = Sine(rate, period * 100 * seconds);
+    const size_t periods = in.size() / kChannels / period;
+
+    Clock::time_point begin = Clock::now();
+    for (size_t i = 0; i < periods; i++) {
+      out.clear();
+      LinearResample(&in[i * period * kChannels], period, rate, 0.5f, out);
+    }
+    const Clock::duration linear = Clock::now() - begin;
+
+    AudioResampler resampler(rate, kMixerRate, kChannels);
+    begin = Clock::now();
+    for (size_t i = 0; i < periods; i++) {
+      out.clear();
+      resampler.Resample(&in[i * period * kChannels], period, out);
+    }
+    const Clock::duration polyphase = Clock::now() - begin;
+
+    std::cout << rate << " Hz: linear " << MicrosecondsPer(linear, seconds)
+              << "us, AudioResampler " << MicrosecondsPer(polyphase, seconds)
+              << "us\n";
+  }
+}
+
+class CountingSink : public webrtc_streaming::AudioSink {
+ public:
+  void OnFrame(const webrtc_streaming::AudioFrameBuffer& frame,
+               int64_t) override {
+    frames_ += frame.frames();
+  }
+
+  size_t Frames() const { return frames_; }
+
+ private:
+  std::atomic<size_t> frames_ = 0;
+};
+
+void BenchmarkMixer(size_t seconds, size_t streams) {
+  auto sink = std::make_shared<CountingSink>();
+  AudioMixer mixer(sink, AudioMixerSettings{
+                             .channels_layout = AudioChannelsLayout::Stereo,
+                             .sample_rate = kMixerRate,
+                         });
+  mixer.Start();
+
+  std::mutex samples_mutex;
+  std::vector<Clock::duration> samples;
+  std::vector<std::thread> threads;
+  for (size_t stream = 0; stream < streams; stream++) {
+    threads.emplace_back([&, stream]() {
+      const uint32_t rate = kGuestRates[stream % std::size(kGuestRates)];
+      const size_t period = rate / 100;
+      const std::vector<int16_t> in = Sine(rate, period);
+      std::vector<Clock::duration> stream_samples;
+      Clock::time_point next = Clock::now();
+      for (size_t i = 0; i < seconds * 100; i++) {
+        std::this_thread::sleep_until(next);
+        next += std::chrono::milliseconds(10);
+        Clock::time_point begin = Clock::now();
+        mixer.OnPlayback(stream, rate, kChannels, 16, 0.5f,
+                         reinterpret_cast<const uint8_t*>(in.data()),
+                         in.size() * sizeof(int16_t));
+        stream_samples.emplace_back(Clock::now() - begin);
+      }
+      mixer.OnStreamStopped(stream);
+      std::lock_guard lock(samples_mutex);
+      samples.insert(samples.end(), stream_samples.begin(),
+                     stream_samples.end());
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  mixer.Stop();
+  std::sort(samples.begin(), samples.end());
+
+  std::cout << "Playing " << streams << " streams for " << seconds
+            << " s: OnPlayback median "
+            << MicrosecondsPer(samples[samples.size() / 2], 1) << "us, p99 "
+            << MicrosecondsPer(samples[samples.size() * 99 / 100], 1)
+            << "us, max " << MicrosecondsPer(samples.back(), 1) << "us, "
+            << sink->Frames() * 1000 / kMixerRate << " ms played\n";
+}
+
+Result<void> AudioMixerBenchmarkMain(int argc, char** argv) {
+  size_t seconds = 10;
+  size_t streams = 4;
+  std::vector<Flag> flags;
+  flags.emplace_back(GflagsCompatFlag("seconds", seconds)
+                         .Help("Seconds of audio to convert and to play."));
+  flags.emplace_back(GflagsCompatFlag("streams", streams)
+                         .Help("Concurrent playback streams in the mixer."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(seconds, 0u);
+  CF_EXPECT_GT(streams, 0u);
+
+  BenchmarkResamplers(seconds);
+  BenchmarkMixer(seconds, streams);
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::AudioMixerBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/audio_resampler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace cuttlefish {
+namespace {
+
+// Taps per phase when interpolating. Decimation widens the filter in
+// proportion to the ratio so the transition band stays put at the output rate.
+constexpr size_t kBaseTaps = 32;
+constexpr size_t kMaxTaps = 256;
+// Rates without a small common divisor use the nearest of this many phases,
+// which bounds the coefficient table to kMaxPhases * kMaxTaps samples. Output
+// timing stays exact, the phase error is under 1/kMaxPhases of a sample.
+constexpr uint32_t kMaxPhases = 1024;
+// Cutoff relative to the lower of the two Nyquist frequencies
+constexpr double kRolloff = 0.92;
+constexpr double kKaiserBeta = 8.0;
+constexpr int kCoefficientBits = 14;
+
+// Zeroth order modified Bessel function of the first kind
+double BesselI0(double x) {
+  double sum = 1;
+  double term = 1;
+  for (int k = 1; k < 32; ++k) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+int16_t Saturate(int32_t value) {
+  return static_cast<int16_t>(std::clamp<int32_t>(value, INT16_MIN, INT16_MAX));
+}
+
+}  // namespace
+
+AudioResampler::AudioResampler(uint32_t input_rate, uint32_t output_rate,
+                               uint8_t channels)
+    : input_rate_(input_rate),
+      output_rate_(output_rate),
+      channels_(channels),
+      history_(channels) {
+  const uint32_t divisor = std::gcd(input_rate, output_rate);
+  up_ = output_rate / divisor;
+  down_ = input_rate / divisor;
+  if (up_ == down_) {
+    return;
+  }
+  phases_ = std::min(up_, kMaxPhases);
+
+  const size_t decimation = (down_ + up_ - 1) / up_;
+  taps_ = std::min(kMaxTaps, kBaseTaps * decimation);
+  const size_t length = taps_ * phases_;
+  // Cutoff in cycles per sample at the interpolated rate
+  const double cutoff =
+      0.5 * kRolloff * std::min(1.0, static_cast<double>(up_) / down_) /
+      phases_;
+  const double center = (length - 1) / 2.0;
+  const double window_norm = BesselI0(kKaiserBeta);
+
+  std::vector<double> prototype(length);
+  for (size_t n = 0; n < length; ++n) {
+    const double t = n - center;
+    const double x = 2 * cutoff * t;
+    const double sinc = x == 0 ? 1 : std::sin(M_PI * x) / (M_PI * x);
+    const double r = t / center;
+    const double window =
+        BesselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1 - r * r))) /
+        window_norm;
+    prototype[n] = sinc * window;
+  }
+
+  // Output sample m of the interpolated signal is the sum over j of
+  // prototype[p + j * phases_] * x[q - j] with p = m % phases_ and
+  // q = m / phases_. Each
+  // phase is stored reversed to run forward over the input, and normalized to
+  // unity gain so no phase modulates the DC level.
+  coefficients_.resize(length);
+  for (uint32_t phase = 0; phase < phases_; ++phase) {
+    double sum = 0;
+    for (size_t j = 0; j < taps_; ++j) {
+      sum += prototype[phase + j * phases_];
+    }
+    int16_t* dst = &coefficients_[phase * taps_];
+    for (size_t j = 0; j < taps_; ++j) {
+      const double value = prototype[phase + j * phases_] / sum;
+      dst[taps_ - 1 - j] = static_cast<int16_t>(
+          std::lround(value * (1 << kCoefficientBits)));
+    }
+  }
+
+  for (auto& samples : history_) {
+    samples.assign(taps_ - 1, 0);
+  }
+  position_ = static_cast<uint64_t>(taps_ - 1) * up_;
+}
+
+void AudioResampler::Resample(const int16_t* in, size_t frames,
+                              std::vector<int16_t>& out) {
+  if (taps_ == 0) {
+    out.insert(out.end(), in, in + frames * channels_);
+    return;
+  }
+
+  for (uint8_t c = 0; c < channels_; ++c) {
+    auto& samples = history_[c];
+    const size_t offset = samples.size();
+    samples.resize(offset + frames);
+    for (size_t i = 0; i < frames; ++i) {
+      samples[offset + i] = in[i * channels_ + c];
+    }
+  }
+
+  const size_t available = history_[0].size();
+  const uint64_t end = static_cast<uint64_t>(available) * up_;
+  const size_t produced =
+      position_ < end ? (end - position_ + down_ - 1) / down_ : 0;
+  const size_t out_begin = out.size();
+  out.resize(out_begin + produced * channels_);
+  int16_t* dst = &out[out_begin];
+
+  for (uint8_t c = 0; c < channels_; ++c) {
+    const int16_t* samples = history_[c].data();
+    uint64_t position = position_;
+    for (size_t i = 0; i < produced; ++i, position += down_) {
+      const size_t newest = position / up_;
+      const int16_t* window = samples + newest + 1 - taps_;
+      const uint64_t phase = (position % up_) * phases_ / up_;
+      const int16_t* coefficients = &coefficients_[phase * taps_];
+      int32_t acc = 0;
+      for (size_t k = 0; k < taps_; ++k) {
+        acc += static_cast<int32_t>(window[k]) * coefficients[k];
+      }
+      acc += 1 << (kCoefficientBits - 1);
+      dst[i * channels_ + c] = Saturate(acc >> kCoefficientBits);
+    }
+  }
+  position_ += static_cast<uint64_t>(produced) * down_;
+
+  // Keep the taps_ - 1 samples preceding the next output window
+  const size_t consumed =
+      std::min<size_t>(position_ / up_ + 1 - taps_, available);
+  for (auto& samples : history_) {
+    samples.erase(samples.begin(), samples.begin() + consumed);
+  }
+  position_ -= static_cast<uint64_t>(consumed) * up_;
+}
+
+}  // namespace cuttlefish
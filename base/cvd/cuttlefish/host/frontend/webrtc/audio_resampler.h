@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace cuttlefish {
+
+// Band-limited sample rate converter for interleaved 16-bit audio.
+//
+// The conversion ratio is reduced to up/down factors and applied with a
+// windowed-sinc polyphase filter in fixed point, picking the filter phase that
+// matches each output sample's position between input samples.
+// Filter history is kept between calls so a stream can be converted in
+// arbitrary chunks without discontinuities at the chunk boundaries.
+class AudioResampler {
+ public:
+  AudioResampler(uint32_t input_rate, uint32_t output_rate, uint8_t channels);
+
+  uint32_t InputRate() const { return input_rate_; }
+  uint32_t OutputRate() const { return output_rate_; }
+  uint8_t Channels() const { return channels_; }
+
+  // Converts `frames` interleaved input frames and appends the produced frames
+  // to `out`. The output lags the input by half the filter length.
+  void Resample(const int16_t* in, size_t frames, std::vector<int16_t>& out);
+
+ private:
+  const uint32_t input_rate_;
+  const uint32_t output_rate_;
+  const uint8_t channels_;
+  // Interpolation and decimation factors, output_rate / input_rate = up / down
+  uint32_t up_ = 1;
+  uint32_t down_ = 1;
+  // Filter phases, up_ unless that would make the table too large
+  uint32_t phases_ = 1;
+  // Filter taps per phase, a multiple of 8 so the dot products vectorize
+  size_t taps_ = 0;
+  // phases_ phases of taps_ Q14 coefficients each, stored in the order in which
+  // they multiply the (oldest to newest) input samples.
+  std::vector<int16_t> coefficients_;
+  // Per channel input samples, starting with taps_ - 1 samples of history
+  std::vector<std::vector<int16_t>> history_;
+  // Position of the next output sample, in 1/up_ input samples since the
+  // start of history_
+  uint64_t position_ = 0;
+};
+
+}  // namespace cuttlefish
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/audio_resampler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace cuttlefish {
+namespace {
+
+constexpr double kAmplitude = 16000;
+
+std::vector<int16_t> Sine(double frequency, uint32_t rate, size_t frames,
+                          uint8_t channels) {
+  std::vector<int16_t> samples(frames * channels);
+  for (size_t i = 0; i < frames; ++i) {
+    const double value =
+        kAmplitude * std::sin(2 * M_PI * frequency * i / rate);
+    for (uint8_t c = 0; c < channels; ++c) {
+      samples[i * channels + c] = static_cast<int16_t>(std::lround(value));
+    }
+  }
+  return samples;
+}
+
+// Resamples `in` in chunks of `chunk` frames, as the mixer would
+std::vector<int16_t> Resample(AudioResampler& resampler,
+                              const std::vector<int16_t>& in, size_t chunk) {
+  const uint8_t channels = resampler.Channels();
+  const size_t frames = in.size() / channels;
+  std::vector<int16_t> out;
+  for (size_t i = 0; i < frames; i += chunk) {
+    resampler.Resample(&in[i * channels], std::min(chunk, frames - i), out);
+  }
+  return out;
+}
+
+struct ToneFit {
+  double amplitude;
+  // Power of what remains after removing the tone, relative to the tone
+  double residual_db;
+};
+
+// Least squares fit of a tone of known frequency to one channel of `samples`,
+// skipping the filter's start-up transient.
+ToneFit FitTone(const std::vector<int16_t>& samples, uint8_t channels,
+                uint8_t channel, double frequency, uint32_t rate) {
+  const size_t frames = samples.size() / channels;
+  const size_t skip = rate / 100;
+  double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0;
+  for (size_t i = skip; i < frames; ++i) {
+    const double s = std::sin(2 * M_PI * frequency * i / rate);
+    const double c = std::cos(2 * M_PI * frequency * i / rate);
+    const double y = samples[i * channels + channel];
+    ss += s * s, cc += c * c, sc += s * c, ys += y * s, yc += y * c;
+  }
+  const double det = ss * cc - sc * sc;
+  const double a = (ys * cc - yc * sc) / det;
+  const double b = (yc * ss - ys * sc) / det;
+  double tone = 0, residual = 0;
+  for (size_t i = skip; i < frames; ++i) {
+    const double fit = a * std::sin(2 * M_PI * frequency * i / rate) +
+                       b * std::cos(2 * M_PI * frequency * i / rate);
+    const double y = samples[i * channels + channel];
+    tone += fit * fit;
+    residual += (y - fit) * (y - fit);
+  }
+  return ToneFit{
+      .amplitude = std::hypot(a, b),
+      .residual_db = 10 * std::log10(residual / tone),
+  };
+}
+
+double RmsAfterStartup(const std::vector<int16_t>& samples, uint32_t rate) {
+  double sum = 0;
+  size_t count = 0;
+  for (size_t i = rate / 100; i < samples.size(); ++i, ++count) {
+    sum += static_cast<double>(samples[i]) * samples[i];
+  }
+  return std::sqrt(sum / count);
+}
+
+TEST(AudioResamplerTest, SameRateIsPassthrough) {
+  AudioResampler resampler(48000, 48000, 2);
+  const auto in = Sine(1000, 48000, 480, 2);
+  EXPECT_EQ(Resample(resampler, in, 480), in);
+}
+
+TEST(AudioResamplerTest, ProducesFramesAtOutputRate) {
+  AudioResampler resampler(44100, 48000, 2);
+  const auto in = Sine(1000, 44100, 44100, 2);
+  // Chunks which don't line up with the 147 input frame period
+  const auto out = Resample(resampler, in, 441);
+  // Short by the filter delay at most
+  EXPECT_LE(out.size() / 2, 48000u);
+  EXPECT_GE(out.size() / 2, 48000u - 32);
+}
+
+TEST(AudioResamplerTest, ToneDistortion) {
+  for (const uint32_t rate : {8000u, 22050u, 44100u, 96000u}) {
+    AudioResampler resampler(rate, 48000, 2);
+    const auto out = Resample(resampler, Sine(997, rate, rate, 2), rate / 100);
+    for (uint8_t c = 0; c < 2; ++c) {
+      const auto fit = FitTone(out, 2, c, 997, 48000);
+      EXPECT_NEAR(fit.amplitude, kAmplitude, kAmplitude * 0.01) << rate;
+      // THD+N, well below what linear interpolation achieves
+      EXPECT_LT(fit.residual_db, -60) << rate;
+    }
+  }
+}
+
+TEST(AudioResamplerTest, PassbandIsFlat) {
+  AudioResampler resampler(44100, 48000, 1);
+  const auto out = Resample(resampler, Sine(18000, 44100, 44100, 1), 441);
+  const auto fit = FitTone(out, 1, 0, 18000, 48000);
+  // Within 0.5 dB
+  EXPECT_NEAR(fit.amplitude, kAmplitude, kAmplitude * 0.06);
+  EXPECT_LT(fit.residual_db, -50);
+}
+
+TEST(AudioResamplerTest, RejectsAliases) {
+  // 30 kHz is above the 24 kHz output Nyquist frequency and would fold back to
+  // 18 kHz
+  AudioResampler resampler(96000, 48000, 1);
+  const auto out = Resample(resampler, Sine(30000, 96000, 96000, 1), 960);
+  EXPECT_LT(20 * std::log10(RmsAfterStartup(out, 48000) / kAmplitude), -60);
+}
+
+TEST(AudioResamplerTest, UnusualRates) {
+  AudioResampler resampler(44101, 48000, 1);
+  const auto out = Resample(resampler, Sine(1000, 44101, 44101, 1), 441);
+  const auto fit = FitTone(out, 1, 0, 1000, 48000);
+  EXPECT_LT(fit.residual_db, -50);
+}
+
+}  // namespace
+}  // namespace cuttlefish
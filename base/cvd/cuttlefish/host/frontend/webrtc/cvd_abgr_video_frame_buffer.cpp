@@ -18,6 +18,10 @@
 
 #include <string.h>
 
+#include <memory>
+#include <utility>
+#include <vector>
+
 namespace cuttlefish {
 
 CvdAbgrVideoFrameBuffer::CvdAbgrVideoFrameBuffer(int width, int height,
@@ -27,10 +31,21 @@ CvdAbgrVideoFrameBuffer::CvdAbgrVideoFrameBuffer(int width, int height,
       height_(height),
       format_(format),
       stride_(stride),
-      data_(data, data + height * stride) {}
+      data_(std::make_shared<std::vector<uint8_t>>(data,
+                                                   data + height * stride)) {}
+
+CvdAbgrVideoFrameBuffer::CvdAbgrVideoFrameBuffer(
+    int width, int height, uint32_t format, int stride,
+    std::shared_ptr<std::vector<uint8_t>> data)
+    : width_(width),
+      height_(height),
+      format_(format),
+      stride_(stride),
+      data_(std::move(data)) {}
 
 std::unique_ptr<VideoFrameBuffer> CvdAbgrVideoFrameBuffer::Clone() const {
-  return std::make_unique<CvdAbgrVideoFrameBuffer>(*this);
+  return std::make_unique<CvdAbgrVideoFrameBuffer>(width_, height_, format_,
+                                                   stride_, data_->data());
 }
 
 }  // namespace cuttlefish
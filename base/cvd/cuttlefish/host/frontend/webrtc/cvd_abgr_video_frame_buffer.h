@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <vector>
 
 #include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
@@ -28,14 +29,18 @@ class CvdAbgrVideoFrameBuffer : public PackedVideoFrameBuffer {
  public:
   CvdAbgrVideoFrameBuffer(int width, int height, uint32_t format, int stride,
                           const uint8_t* data);
+  // Shares `data`, which must hold `height` rows of `stride` bytes and not
+  // be modified while this buffer exists.
+  CvdAbgrVideoFrameBuffer(int width, int height, uint32_t format, int stride,
+                          std::shared_ptr<std::vector<uint8_t>> data);
   ~CvdAbgrVideoFrameBuffer() override = default;
 
   int width() const override { return width_; }
   int height() const override { return height_; }
 
-  uint8_t* Data() const override { return const_cast<uint8_t*>(data_.data()); }
+  uint8_t* Data() const override { return data_->data(); }
   int Stride() const override { return stride_; }
-  std::size_t DataSize() const override { return data_.size(); }
+  std::size_t DataSize() const override { return data_->size(); }
   uint32_t PixelFormat() const override { return format_; }
 
   std::unique_ptr<VideoFrameBuffer> Clone() const override;
@@ -45,7 +50,7 @@ class CvdAbgrVideoFrameBuffer : public PackedVideoFrameBuffer {
   int height_;
   uint32_t format_;
   int stride_;
-  std::vector<uint8_t> data_;
+  std::shared_ptr<std::vector<uint8_t>> data_;
 };
 
 }  // namespace cuttlefish
@@ -30,9 +30,35 @@
 #include "cuttlefish/host/frontend/webrtc/cvd_abgr_video_frame_buffer.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/streamer.h"
 #include "cuttlefish/host/libs/screen_connector/composition_manager.h"
+#include "cuttlefish/host/libs/screen_connector/frame_buffer_pool.h"
 #include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
 
 namespace cuttlefish {
+namespace {
+
+// Frames are repeated often at first so that the encoder can refine the
+// picture, and then only as a keepalive. Repeats of composed frames pick up
+// overlay changes from other devices, so those never slow down.
+constexpr std::chrono::milliseconds kRepeatingInterval(20);
+constexpr std::chrono::milliseconds kIdleRepeatingInterval(500);
+constexpr int kFastRepeats = 25;
+
+std::chrono::milliseconds RepeatingInterval(int repeats, bool composed) {
+  return composed || repeats < kFastRepeats ? kRepeatingInterval
+                                            : kIdleRepeatingInterval;
+}
+
+// Undamaged frames share the pixels of the previous frame of the display. The
+// pool doesn't recycle pixels while they are referenced, so the same pixels
+// mean the same contents.
+bool SharesPixels(const std::shared_ptr<VideoFrameBuffer>& a,
+                  const std::shared_ptr<VideoFrameBuffer>& b) {
+  auto packed_a = std::dynamic_pointer_cast<PackedVideoFrameBuffer>(a);
+  auto packed_b = std::dynamic_pointer_cast<PackedVideoFrameBuffer>(b);
+  return packed_a && packed_b && packed_a->Data() == packed_b->Data();
+}
+
+}  // namespace
 
 DisplayHandler::DisplayHandler(
     webrtc_streaming::Streamer& streamer, ScreenshotHandler& screenshot_handler,
@@ -98,25 +124,34 @@ DisplayHandler::GenerateProcessedFrameCallback
 DisplayHandler::GetScreenConnectorCallback() {
   // only to tell the producer how to create a ProcessedFrame to cache into the
   // queue
-  auto& composition_manager = composition_manager_;
   DisplayHandler::GenerateProcessedFrameCallback callback =
-      [&composition_manager](
-          uint32_t display_number, uint32_t frame_width, uint32_t frame_height,
-          uint32_t frame_fourcc_format, uint32_t frame_stride_bytes,
-          uint8_t* frame_pixels, WebRtcScProcessedFrame& processed_frame) {
+      [this](uint32_t display_number, uint32_t frame_width,
+             uint32_t frame_height, uint32_t frame_fourcc_format,
+             uint32_t frame_stride_bytes, uint8_t* frame_pixels,
+             const FrameDamage& damage,
+             WebRtcScProcessedFrame& processed_frame) {
         processed_frame.display_number_ = display_number;
-        if (composition_manager.has_value()) {
-          composition_manager.value()->OnFrame(
+        FrameDamage frame_damage = damage;
+        if (composition_manager_.has_value()) {
+          composition_manager_.value()->OnFrame(
               display_number, frame_width, frame_height, frame_fourcc_format,
               frame_stride_bytes, frame_pixels);
+          // Overlays change independently of the guest frame.
+          frame_damage = FrameDamage{0, 0, frame_width, frame_height};
         }
         if (frame_fourcc_format == DRM_FORMAT_ARGB8888 ||
             frame_fourcc_format == DRM_FORMAT_XRGB8888 ||
             frame_fourcc_format == DRM_FORMAT_ABGR8888 ||
             frame_fourcc_format == DRM_FORMAT_XBGR8888) {
+          FrameBufferPool::Buffer pixels;
+          {
+            std::lock_guard<std::mutex> lock(frame_pools_mutex_);
+            pixels = frame_pools_[display_number].Copy(
+                frame_pixels, frame_stride_bytes, frame_height, frame_damage);
+          }
           processed_frame.buf_ = std::make_unique<CvdAbgrVideoFrameBuffer>(
               frame_width, frame_height, frame_fourcc_format,
-              frame_stride_bytes, frame_pixels);
+              frame_stride_bytes, std::move(pixels));
           processed_frame.is_success_ = true;
         } else {
           processed_frame.is_success_ = false;
@@ -134,11 +169,16 @@ DisplayHandler::GetScreenConnectorCallback() {
     const uint32_t display_number = processed_frame.display_number_;
     {
       std::lock_guard<std::mutex> lock(last_buffers_mutex_);
-      display_last_buffers_[display_number] =
-          std::make_shared<BufferInfo>(BufferInfo{
-              .last_sent_time_stamp = std::chrono::system_clock::now(),
-              .buffer = buffer,
-          });
+      std::shared_ptr<BufferInfo>& last = display_last_buffers_[display_number];
+      if (processed_frame.is_success_ && last &&
+          SharesPixels(last->buffer, buffer)) {
+        // Nothing changed, the repeater takes care of resending the frame.
+        continue;
+      }
+      last = std::make_shared<BufferInfo>(BufferInfo{
+          .last_sent_time_stamp = std::chrono::system_clock::now(),
+          .buffer = buffer,
+      });
     }
     if (processed_frame.is_success_) {
       SendLastFrame(display_number);
@@ -205,7 +245,6 @@ void DisplayHandler::RepeatFramesPeriodically() {
   // SendBuffers can be called from multiple threads simultaneously, locking
   // here avoids injecting frames with the timestamps in the wrong order and
   // protects writing the BufferInfo timestamps.
-  const std::chrono::milliseconds kRepeatingInterval(20);
   auto next_send = std::chrono::system_clock::now() + kRepeatingInterval;
   while (true) {
     {
@@ -242,7 +281,10 @@ void DisplayHandler::RepeatFramesPeriodically() {
 
       for (auto& [display_number, buffer_info] : display_last_buffers_) {
         if (time_stamp >
-            buffer_info->last_sent_time_stamp + kRepeatingInterval) {
+            buffer_info->last_sent_time_stamp +
+                RepeatingInterval(buffer_info->repeats,
+                                  composition_manager_.has_value())) {
+          buffer_info->repeats++;
           if (composition_manager_.has_value()) {
             auto planar = std::dynamic_pointer_cast<PlanarVideoFrameBuffer>(
                 buffer_info->buffer);
@@ -261,7 +303,9 @@ void DisplayHandler::RepeatFramesPeriodically() {
       next_send = std::chrono::system_clock::now() + kRepeatingInterval;
       for (const auto& [_, buffer_info] : display_last_buffers_) {
         next_send = std::min(
-            next_send, buffer_info->last_sent_time_stamp + kRepeatingInterval);
+            next_send, buffer_info->last_sent_time_stamp +
+                           RepeatingInterval(buffer_info->repeats,
+                                             composition_manager_.has_value()));
       }
     }
   }
@@ -25,6 +25,7 @@
 #include "cuttlefish/host/frontend/webrtc/cvd_video_frame_buffer.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/video_sink.h"
 #include "cuttlefish/host/frontend/webrtc/screenshot_handler.h"
+#include "cuttlefish/host/libs/screen_connector/frame_buffer_pool.h"
 #include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
 #include "cuttlefish/host/libs/screen_connector/screen_connector.h"
 #include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
@@ -81,6 +82,9 @@ class DisplayHandler {
   struct BufferInfo {
     std::chrono::system_clock::time_point last_sent_time_stamp;
     std::shared_ptr<VideoFrameBuffer> buffer;
+    // Times the repeater has resent the buffer, protected by
+    // last_buffers_mutex_.
+    int repeats = 0;
   };
   enum class RepeaterState {
     RUNNING,
@@ -91,6 +95,9 @@ class DisplayHandler {
   void RepeatFramesPeriodically();
 
   std::optional<std::unique_ptr<CompositionManager>> composition_manager_;
+  // Frames come from the Wayland and the confirmation UI threads.
+  std::map<uint32_t, FrameBufferPool> frame_pools_;
+  std::mutex frame_pools_mutex_;
   std::map<uint32_t, std::shared_ptr<webrtc_streaming::VideoSink>>
       display_sinks_;
   webrtc_streaming::Streamer& streamer_;
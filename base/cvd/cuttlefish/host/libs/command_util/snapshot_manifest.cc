@@ -0,0 +1,682 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/command_util/snapshot_manifest.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/strings/escaping.h"
+#include "android-base/file.h"
+#include "json/value.h"
+#include "openssl/sha.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/common/libs/utils/json.h"
+#include "cuttlefish/files/copy.h"
+#include "cuttlefish/files/directory_contents.h"
+#include "cuttlefish/files/file_exists.h"
+#include "cuttlefish/posix/readlink.h"
+#include "cuttlefish/posix/remove.h"
+#include "cuttlefish/posix/rename.h"
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/posix/symlink.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr int kManifestVersion = 1;
+// Small enough that writes to a disk overlay leave most of its chunks
+// unchanged, large enough to keep the manifest of a multi GiB disk short.
+constexpr uint64_t kChunkSize = 4 << 20;
+// Stands for a chunk of zeroes, which is left as a hole.
+constexpr char kZeroChunk[] = "0";
+
+constexpr char kVersionField[] = "version";
+constexpr char kEntriesField[] = "entries";
+constexpr char kTypeField[] = "type";
+constexpr char kModeField[] = "mode";
+constexpr char kSizeField[] = "size";
+constexpr char kMtimeField[] = "mtime_ns";
+constexpr char kChunksField[] = "chunks";
+constexpr char kTargetField[] = "target";
+
+constexpr char kDirectoryType[] = "directory";
+constexpr char kFileType[] = "file";
+constexpr char kSymlinkType[] = "symlink";
+
+struct Entry {
+  std::string type;
+  mode_t mode = 0;
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+  // Not known for files that were reflinked from the source.
+  std::optional<std::vector<std::string>> chunks;
+  std::string target;
+};
+
+// Keyed by the path relative to the snapshot directory. Parent directories
+// sort before their contents.
+using Manifest = std::map<std::string, Entry>;
+
+struct Base {
+  std::string path;
+  Manifest manifest;
+};
+
+std::string ManifestPath(const std::string& snapshot_path) {
+  return snapshot_path + "/" + kSnapshotManifestFileName;
+}
+
+std::string Join(const std::string& dir, const std::string& relative) {
+  return relative.empty() ? dir : dir + "/" + relative;
+}
+
+std::string Parent(const std::string& relative) {
+  size_t slash = relative.rfind('/');
+  return slash == std::string::npos ? "" : relative.substr(0, slash);
+}
+
+int64_t MtimeNs(const struct stat& st) {
+  return int64_t{st.st_mtim.tv_sec} * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+Json::Value ToJson(const Manifest& manifest) {
+  Json::Value json;
+  json[kVersionField] = kManifestVersion;
+  Json::Value& entries = json[kEntriesField];
+  entries = Json::Value(Json::objectValue);
+  for (const auto& [path, entry] : manifest) {
+    Json::Value& entry_json = entries[path];
+    entry_json[kTypeField] = entry.type;
+    entry_json[kModeField] = entry.mode;
+    entry_json[kMtimeField] = Json::Int64(entry.mtime_ns);
+    if (entry.type == kFileType) {
+      entry_json[kSizeField] = Json::UInt64(entry.size);
+    }
+    if (entry.chunks) {
+      Json::Value& chunks = entry_json[kChunksField];
+      chunks = Json::Value(Json::arrayValue);
+      for (const std::string& chunk : *entry.chunks) {
+        chunks.append(chunk);
+      }
+    }
+    if (entry.type == kSymlinkType) {
+      entry_json[kTargetField] = entry.target;
+    }
+  }
+  return json;
+}
+
+Result<Manifest> FromJson(const Json::Value& json) {
+  CF_EXPECT(json[kVersionField].isInt(), "Missing manifest version");
+  CF_EXPECT_EQ(json[kVersionField].asInt(), kManifestVersion);
+  const Json::Value& entries = json[kEntriesField];
+  CF_EXPECT(entries.isObject(), "Missing manifest entries");
+  Manifest manifest;
+  for (const std::string& path : entries.getMemberNames()) {
+    const Json::Value& entry_json = entries[path];
+    CF_EXPECTF(!path.empty() && path[0] != '/' &&
+                   path.find("..") == std::string::npos,
+               "Invalid manifest path \"{}\"", path);
+    Entry entry;
+    entry.type = entry_json[kTypeField].asString();
+    CF_EXPECTF(entry.type == kDirectoryType || entry.type == kFileType ||
+                   entry.type == kSymlinkType,
+               "Unknown type \"{}\" of \"{}\"", entry.type, path);
+    entry.mode = entry_json[kModeField].asUInt() & 07777;
+    entry.size = entry_json[kSizeField].asUInt64();
+    entry.mtime_ns = entry_json[kMtimeField].asInt64();
+    if (entry_json.isMember(kChunksField)) {
+      std::vector<std::string>& chunks = entry.chunks.emplace();
+      for (const Json::Value& chunk : entry_json[kChunksField]) {
+        chunks.push_back(chunk.asString());
+      }
+      CF_EXPECTF(chunks.size() == (entry.size + kChunkSize - 1) / kChunkSize,
+                 "Wrong number of chunks for \"{}\"", path);
+    }
+    entry.target = entry_json[kTargetField].asString();
+    manifest.emplace(path, std::move(entry));
+  }
+  return manifest;
+}
+
+Result<Manifest> LoadManifest(const std::string& snapshot_path) {
+  Json::Value json = CF_EXPECT(LoadFromFile(ManifestPath(snapshot_path)));
+  return CF_EXPECT(FromJson(json));
+}
+
+Result<void> SaveManifest(const std::string& snapshot_path,
+                          const Manifest& manifest) {
+  // The manifest marks the snapshot as complete, so it's never left half
+  // written.
+  const std::string path = ManifestPath(snapshot_path);
+  const std::string temp_path = path + ".tmp";
+  CF_EXPECTF(android::base::WriteStringToFile(ToJson(manifest).toStyledString(),
+                                              temp_path),
+             "Failed to write \"{}\"", temp_path);
+  CF_EXPECT(Rename(temp_path, path));
+  return {};
+}
+
+std::optional<Base> LoadBase(const std::string& base_snapshot_path) {
+  if (base_snapshot_path.empty()) {
+    return std::nullopt;
+  }
+  Result<Manifest> manifest = LoadManifest(base_snapshot_path);
+  if (!manifest.has_value()) {
+    LOG(WARNING) << "Not sharing data with \"" << base_snapshot_path
+                 << "\": " << manifest.error().Message();
+    return std::nullopt;
+  }
+  return Base{.path = base_snapshot_path, .manifest = std::move(*manifest)};
+}
+
+// Only files with known chunks can be compared.
+const Entry* BaseFile(const std::optional<Base>& base,
+                      const std::string& relative) {
+  if (!base) {
+    return nullptr;
+  }
+  auto it = base->manifest.find(relative);
+  if (it == base->manifest.end() || it->second.type != kFileType ||
+      !it->second.chunks) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+// Adds `relative` and everything under it in `root` to `manifest`, except
+// for sockets and named pipes.
+Result<void> Walk(const std::string& root, const std::string& relative,
+                  const std::function<bool(const std::string&)>& predicate,
+                  Manifest& manifest) {
+  const std::string dir = Join(root, relative);
+  for (const std::string& name : CF_EXPECT(DirectoryContents(dir))) {
+    const std::string path = dir + "/" + name;
+    if (!predicate(path)) {
+      continue;
+    }
+    const std::string entry_path =
+        relative.empty() ? name : relative + "/" + name;
+    struct stat st;
+    CF_EXPECTF(lstat(path.c_str(), &st) == 0, "lstat(\"{}\"): {}", path,
+               StrError(errno));
+    Entry entry{
+        .mode = st.st_mode & 07777,
+        .mtime_ns = MtimeNs(st),
+    };
+    if (S_ISLNK(st.st_mode)) {
+      entry.type = kSymlinkType;
+      entry.target = CF_EXPECT(ReadLink(path));
+    } else if (S_ISDIR(st.st_mode)) {
+      entry.type = kDirectoryType;
+      manifest.emplace(entry_path, std::move(entry));
+      CF_EXPECT(Walk(root, entry_path, predicate, manifest));
+      continue;
+    } else if (S_ISREG(st.st_mode)) {
+      entry.type = kFileType;
+      entry.size = st.st_size;
+    } else {
+      VLOG(0) << "Ignoring a named pipe or socket " << path;
+      continue;
+    }
+    manifest.emplace(entry_path, std::move(entry));
+  }
+  return {};
+}
+
+// Runs `function` for every index below `count` on up to one thread per core.
+Result<void> ParallelFor(size_t count,
+                         const std::function<Result<void>(size_t)>& function) {
+  const size_t threads = std::min<size_t>(
+      count, std::max(1u, std::thread::hardware_concurrency()));
+  std::atomic<size_t> next = 0;
+  std::atomic<bool> failed = false;
+  std::vector<std::future<Result<void>>> workers;
+  for (size_t i = 0; i < threads; i++) {
+    workers.emplace_back(std::async(std::launch::async, [&]() -> Result<void> {
+      for (size_t index = next++; index < count && !failed; index = next++) {
+        Result<void> result = function(index);
+        if (!result.has_value()) {
+          failed = true;
+          return result;
+        }
+      }
+      return {};
+    }));
+  }
+  Result<void> result;
+  for (std::future<Result<void>>& worker : workers) {
+    Result<void> worker_result = worker.get();
+    if (result.has_value() && !worker_result.has_value()) {
+      result = std::move(worker_result);
+    }
+  }
+  return result;
+}
+
+Result<void> PReadAll(Fd& fd, char* data, uint64_t size, uint64_t offset) {
+  while (size > 0) {
+    uint64_t read = CF_EXPECT(fd.PRead(data, size, offset));
+    CF_EXPECT_GT(read, 0u, "Unexpected end of file");
+    data += read;
+    size -= read;
+    offset += read;
+  }
+  return {};
+}
+
+Result<void> PWriteAll(Fd& fd, const char* data, uint64_t size,
+                       uint64_t offset) {
+  while (size > 0) {
+    uint64_t written = CF_EXPECT(fd.PWrite(data, size, offset));
+    CF_EXPECT_GT(written, 0u, "Failed to write");
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return {};
+}
+
+// Leaves the chunk in `buffer` unless it is all zeroes.
+Result<std::string> ReadChunk(Fd& fd, uint64_t offset, uint64_t size,
+                              std::string& buffer) {
+  // Holes in sparse disk images don't need to be read.
+  off_t data = fd.LSeek(offset, SEEK_DATA);
+  if ((data < 0 && fd.GetErrno() == ENXIO) ||
+      (data >= 0 && static_cast<uint64_t>(data) >= offset + size)) {
+    return kZeroChunk;
+  }
+  CF_EXPECT(PReadAll(fd, buffer.data(), size, offset));
+  if (buffer[0] == 0 &&
+      memcmp(buffer.data(), buffer.data() + 1, size - 1) == 0) {
+    return kZeroChunk;
+  }
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const uint8_t*>(buffer.data()), size, digest);
+  return absl::BytesToHexString(std::string_view(
+      reinterpret_cast<const char*>(digest), sizeof(digest)));
+}
+
+Result<void> SetAttributes(Fd& fd, const std::string& path,
+                           const Entry& entry) {
+  CF_EXPECTF(fd.Chmod(entry.mode), "chmod(\"{}\"): {}", path, fd.StrError());
+  const struct timespec times[2] = {
+      {.tv_sec = 0, .tv_nsec = UTIME_OMIT},
+      {.tv_sec = entry.mtime_ns / 1000000000,
+       .tv_nsec = entry.mtime_ns % 1000000000},
+  };
+  CF_EXPECTF(fd.Futimens(times) == 0, "futimens(\"{}\"): {}", path,
+             fd.StrError());
+  return {};
+}
+
+// Replaces `path` with a hard link to the identical file in the base
+// snapshot. Hard links share attributes, so the modes need to match.
+bool LinkToBase(const std::string& base_path, const Entry& base_entry,
+                const std::string& path, const Entry& entry) {
+  if (base_entry.mode != entry.mode || base_entry.size != entry.size) {
+    return false;
+  }
+  const std::string temp_path = path + ".link";
+  if (link(base_path.c_str(), temp_path.c_str()) != 0) {
+    return false;
+  }
+  if (rename(temp_path.c_str(), path.c_str()) != 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Copies a file to the snapshot, sharing as much data as possible with the
+// source or the base snapshot.
+Result<SnapshotCopyStats> SnapshotFile(const std::string& src_path,
+                                       const std::string& dest_path,
+                                       const std::string& base_path,
+                                       const Entry* base_entry, Entry& entry) {
+  SnapshotCopyStats stats{.files = 1};
+  // Like rsync, trusts that a file with the same size and modification time
+  // hasn't changed.
+  if (base_entry && base_entry->mode == entry.mode &&
+      base_entry->size == entry.size &&
+      base_entry->mtime_ns == entry.mtime_ns &&
+      link(base_path.c_str(), dest_path.c_str()) == 0) {
+    entry.chunks = base_entry->chunks;
+    stats.bytes_shared = entry.size;
+    return stats;
+  }
+
+  SharedFD src = SharedFD::Open(src_path, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(src->IsOpen(), "open(\"{}\"): {}", src_path, src->StrError());
+  SharedFD dest = SharedFD::Open(
+      dest_path, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, entry.mode);
+  CF_EXPECTF(dest->IsOpen(), "open(\"{}\"): {}", dest_path, dest->StrError());
+  if (entry.size > 0 && dest->CloneRange(*src, 0, 0, 0) == 0) {
+    stats.bytes_cloned = entry.size;
+    CF_EXPECT(SetAttributes(*dest, dest_path, entry));
+    return stats;
+  }
+
+  SharedFD base;
+  if (base_entry) {
+    base = SharedFD::Open(base_path, O_RDONLY | O_CLOEXEC);
+  }
+  CF_EXPECT(dest->Truncate(entry.size));
+  std::string buffer(kChunkSize, '\0');
+  std::vector<std::string>& chunks = entry.chunks.emplace();
+  bool all_shared = base_entry != nullptr && base_entry->size == entry.size;
+  for (uint64_t offset = 0; offset < entry.size; offset += kChunkSize) {
+    const uint64_t size = std::min(kChunkSize, entry.size - offset);
+    std::string chunk = CF_EXPECTF(ReadChunk(*src, offset, size, buffer),
+                                   "Failed to read \"{}\"", src_path);
+    const size_t index = chunks.size();
+    const bool same = base_entry && index < base_entry->chunks->size() &&
+                      (*base_entry->chunks)[index] == chunk;
+    all_shared = all_shared && same;
+    if (chunk == kZeroChunk) {
+      // Already a hole after the truncation.
+    } else if (same && base->IsOpen() &&
+               dest->CloneRange(*base, offset, size, offset) == 0) {
+      stats.bytes_shared += size;
+    } else {
+      CF_EXPECTF(PWriteAll(*dest, buffer.data(), size, offset),
+                 "Failed to write \"{}\": {}", dest_path, dest->StrError());
+      stats.bytes_copied += size;
+    }
+    chunks.push_back(std::move(chunk));
+  }
+  CF_EXPECT(SetAttributes(*dest, dest_path, entry));
+  // File systems without reflinks can still share identical files.
+  if (all_shared && LinkToBase(base_path, *base_entry, dest_path, entry)) {
+    stats.bytes_shared = entry.size;
+    stats.bytes_copied = 0;
+  }
+  return stats;
+}
+
+// Computes the chunks of a file that was written into the snapshot, and
+// deduplicates those in common with the base snapshot.
+Result<SnapshotCopyStats> IndexFile(const std::string& path,
+                                    const std::string& base_path,
+                                    const Entry* base_entry, Entry& entry) {
+  SnapshotCopyStats stats{.files = 1};
+  // Deduplication needs the file to be writable.
+  SharedFD file = SharedFD::Open(path, O_RDWR | O_CLOEXEC);
+  CF_EXPECTF(file->IsOpen(), "open(\"{}\"): {}", path, file->StrError());
+  SharedFD base;
+  if (base_entry) {
+    base = SharedFD::Open(base_path, O_RDONLY | O_CLOEXEC);
+  }
+  std::string buffer(kChunkSize, '\0');
+  std::vector<std::string>& chunks = entry.chunks.emplace();
+  bool all_shared = base_entry != nullptr && base_entry->size == entry.size;
+  for (uint64_t offset = 0; offset < entry.size; offset += kChunkSize) {
+    const uint64_t size = std::min(kChunkSize, entry.size - offset);
+    std::string chunk = CF_EXPECTF(ReadChunk(*file, offset, size, buffer),
+                                   "Failed to read \"{}\"", path);
+    const size_t index = chunks.size();
+    const bool same = base_entry && index < base_entry->chunks->size() &&
+                      (*base_entry->chunks)[index] == chunk;
+    all_shared = all_shared && same;
+    int64_t deduplicated = 0;
+    if (same && chunk != kZeroChunk && base->IsOpen()) {
+      deduplicated = std::max<int64_t>(
+          file->DedupeRange(*base, offset, size, offset), 0);
+    }
+    stats.bytes_shared += deduplicated;
+    if (chunk != kZeroChunk) {
+      stats.bytes_copied += size - deduplicated;
+    }
+    chunks.push_back(std::move(chunk));
+  }
+  file->Close();
+  if (all_shared && LinkToBase(base_path, *base_entry, path, entry)) {
+    stats.bytes_shared = entry.size;
+    stats.bytes_copied = 0;
+  }
+  return stats;
+}
+
+Result<SnapshotCopyStats> RestoreFile(const std::string& src_path,
+                                      const std::string& dest_path,
+                                      const Entry& entry) {
+  SnapshotCopyStats stats{.files = 1};
+  struct stat st;
+  if (lstat(dest_path.c_str(), &st) == 0) {
+    if (S_ISREG(st.st_mode) &&
+        static_cast<uint64_t>(st.st_size) == entry.size &&
+        MtimeNs(st) == entry.mtime_ns) {
+      if ((st.st_mode & 07777) != entry.mode) {
+        CF_EXPECTF(chmod(dest_path.c_str(), entry.mode) == 0,
+                   "chmod(\"{}\"): {}", dest_path, StrError(errno));
+      }
+      stats.files_unchanged = 1;
+      return stats;
+    }
+    if (!S_ISREG(st.st_mode)) {
+      CF_EXPECT(RemoveFile(dest_path));
+    }
+  }
+
+  SharedFD src = SharedFD::Open(src_path, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(src->IsOpen(), "open(\"{}\"): {}", src_path, src->StrError());
+  SharedFD dest = SharedFD::Open(
+      dest_path, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, entry.mode);
+  CF_EXPECTF(dest->IsOpen(), "open(\"{}\"): {}", dest_path, dest->StrError());
+  if (entry.size == 0 || dest->CloneRange(*src, 0, 0, 0) == 0) {
+    stats.bytes_cloned = entry.size;
+  } else {
+    CF_EXPECTF(Copy(src_path, dest_path), "Copy from {} to {} failed",
+               src_path, dest_path);
+    stats.bytes_copied = entry.size;
+  }
+  CF_EXPECT(SetAttributes(*dest, dest_path, entry));
+  return stats;
+}
+
+void Add(SnapshotCopyStats& total, const SnapshotCopyStats& stats) {
+  total.files += stats.files;
+  total.bytes_cloned += stats.bytes_cloned;
+  total.bytes_shared += stats.bytes_shared;
+  total.bytes_copied += stats.bytes_copied;
+  total.files_unchanged += stats.files_unchanged;
+}
+
+std::vector<std::pair<const std::string, Entry>*> Files(Manifest& manifest) {
+  std::vector<std::pair<const std::string, Entry>*> files;
+  for (auto& path_and_entry : manifest) {
+    if (path_and_entry.second.type == kFileType) {
+      files.push_back(&path_and_entry);
+    }
+  }
+  // Starts the largest files first, so they don't end up last on one thread.
+  std::stable_sort(files.begin(), files.end(), [](auto* a, auto* b) {
+    return a->second.size > b->second.size;
+  });
+  return files;
+}
+
+}  // namespace
+
+bool HasSnapshotManifest(const std::string& snapshot_path) {
+  return FileExists(ManifestPath(snapshot_path));
+}
+
+Result<SnapshotCopyStats> CopyToSnapshot(const std::string& src_dir_path,
+                                         const std::string& snapshot_path,
+                                         const SnapshotCopyOptions& options) {
+  CF_EXPECTF(!FileExists(snapshot_path, /* follow_symlinks */ false),
+             "Delete the destination directory \"{}\" first", snapshot_path);
+  Manifest manifest;
+  CF_EXPECT(Walk(src_dir_path, "", options.predicate, manifest));
+  const std::optional<Base> base = LoadBase(options.base_snapshot_path);
+
+  CF_EXPECT(EnsureDirectoryExists(snapshot_path));
+  for (const auto& [path, entry] : manifest) {
+    const std::string dest_path = Join(snapshot_path, path);
+    if (entry.type == kDirectoryType) {
+      CF_EXPECT(EnsureDirectoryExists(dest_path));
+    } else if (entry.type == kSymlinkType) {
+      CF_EXPECT(Symlink(entry.target, dest_path));
+    }
+  }
+
+  auto files = Files(manifest);
+  std::vector<SnapshotCopyStats> file_stats(files.size());
+  auto snapshot_file = [&](size_t index) -> Result<void> {
+    auto& [path, entry] = *files[index];
+    file_stats[index] = CF_EXPECTF(
+        SnapshotFile(Join(src_dir_path, path), Join(snapshot_path, path),
+                     base ? Join(base->path, path) : "", BaseFile(base, path),
+                     entry),
+        "Failed to snapshot \"{}\"", path);
+    return {};
+  };
+  CF_EXPECT(ParallelFor(files.size(), snapshot_file));
+  CF_EXPECT(SaveManifest(snapshot_path, manifest));
+
+  SnapshotCopyStats stats;
+  for (const SnapshotCopyStats& file : file_stats) {
+    Add(stats, file);
+  }
+  return stats;
+}
+
+Result<SnapshotCopyStats> AddToSnapshot(const std::string& snapshot_path,
+                                        const std::string& relative_dir,
+                                        const SnapshotCopyOptions& options) {
+  Manifest manifest = CF_EXPECT(LoadManifest(snapshot_path));
+  const std::optional<Base> base = LoadBase(options.base_snapshot_path);
+
+  Manifest added;
+  for (std::string dir = relative_dir; !dir.empty(); dir = Parent(dir)) {
+    if (manifest.count(dir)) {
+      break;
+    }
+    struct stat st;
+    const std::string path = Join(snapshot_path, dir);
+    CF_EXPECTF(lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode),
+               "\"{}\" is not a directory", path);
+    added.emplace(dir, Entry{
+                           .type = kDirectoryType,
+                           .mode = st.st_mode & 07777,
+                           .mtime_ns = MtimeNs(st),
+                       });
+  }
+  CF_EXPECT(Walk(snapshot_path, relative_dir, options.predicate, added));
+  std::erase_if(added, [&manifest](const auto& path_and_entry) {
+    return manifest.count(path_and_entry.first) > 0;
+  });
+
+  auto files = Files(added);
+  std::vector<SnapshotCopyStats> file_stats(files.size());
+  auto index_file = [&](size_t index) -> Result<void> {
+    auto& [path, entry] = *files[index];
+    file_stats[index] = CF_EXPECTF(
+        IndexFile(Join(snapshot_path, path), base ? Join(base->path, path) : "",
+                  BaseFile(base, path), entry),
+        "Failed to add \"{}\" to the snapshot", path);
+    return {};
+  };
+  CF_EXPECT(ParallelFor(files.size(), index_file));
+  manifest.merge(added);
+  CF_EXPECT(SaveManifest(snapshot_path, manifest));
+
+  SnapshotCopyStats stats;
+  for (const SnapshotCopyStats& file : file_stats) {
+    Add(stats, file);
+  }
+  return stats;
+}
+
+Result<SnapshotCopyStats> RestoreFromSnapshot(
+    const std::string& snapshot_path, const std::string& dest_dir_path,
+    const SnapshotCopyOptions& options) {
+  Manifest manifest = CF_EXPECT(LoadManifest(snapshot_path));
+
+  // Parents come before their contents, so excluding a directory excludes
+  // everything under it.
+  std::set<std::string> excluded;
+  std::erase_if(manifest, [&](const auto& path_and_entry) {
+    const auto& [path, entry] = path_and_entry;
+    if (excluded.count(Parent(path)) ||
+        !options.predicate(Join(snapshot_path, path))) {
+      excluded.insert(path);
+      return true;
+    }
+    return false;
+  });
+
+  CF_EXPECT(EnsureDirectoryExists(dest_dir_path));
+  for (const auto& [path, entry] : manifest) {
+    const std::string dest_path = Join(dest_dir_path, path);
+    if (entry.type == kDirectoryType) {
+      CF_EXPECT(EnsureDirectoryExists(dest_path));
+    } else if (entry.type == kSymlinkType) {
+      Result<std::string> target = ReadLink(dest_path);
+      if (target.has_value() && *target == entry.target) {
+        continue;
+      }
+      if (FileExists(dest_path, /* follow_symlinks */ false)) {
+        CF_EXPECT(RemoveFile(dest_path));
+      }
+      CF_EXPECT(Symlink(entry.target, dest_path));
+    }
+  }
+
+  auto files = Files(manifest);
+  std::vector<SnapshotCopyStats> file_stats(files.size());
+  auto restore_file = [&](size_t index) -> Result<void> {
+    auto& [path, entry] = *files[index];
+    file_stats[index] = CF_EXPECTF(
+        RestoreFile(Join(snapshot_path, path), Join(dest_dir_path, path),
+                    entry),
+        "Failed to restore \"{}\"", path);
+    return {};
+  };
+  CF_EXPECT(ParallelFor(files.size(), restore_file));
+
+  SnapshotCopyStats stats;
+  for (const SnapshotCopyStats& file : file_stats) {
+    Add(stats, file);
+  }
+  return stats;
+}
+
+}  // namespace cuttlefish
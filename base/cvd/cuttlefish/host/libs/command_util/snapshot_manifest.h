@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+/*
+ * A snapshot directory is a plain copy of the host runtime files, so crosvm
+ * and older tools can read it directly. Its manifest lists every file with
+ * its attributes and the hashes of its chunks, which lets
+ *
+ * - a later snapshot share unchanged data with this one, by reflinking
+ *   chunks or hard linking whole files, instead of copying it, and
+ * - a restore skip the files the device hasn't changed since.
+ */
+inline constexpr char kSnapshotManifestFileName[] = "snapshot_manifest.json";
+
+struct SnapshotCopyStats {
+  size_t files = 0;
+  // Shared with the source through a reflink, without copying.
+  uint64_t bytes_cloned = 0;
+  // Shared with the base snapshot, by reflink, dedupe or hard link.
+  uint64_t bytes_shared = 0;
+  uint64_t bytes_copied = 0;
+  // Restore only: files that were already up to date.
+  size_t files_unchanged = 0;
+};
+
+struct SnapshotCopyOptions {
+  // A previous snapshot with a manifest to share unchanged data with. Ignored
+  // if empty.
+  std::string base_snapshot_path;
+  // Called with the source path of every file and directory. Directories the
+  // predicate rejects are skipped entirely.
+  std::function<bool(const std::string&)> predicate =
+      [](const std::string&) { return true; };
+};
+
+bool HasSnapshotManifest(const std::string& snapshot_path);
+
+/*
+ * Copies `src_dir_path` into the new directory `snapshot_path` using as many
+ * threads as there are cores, and writes the manifest.
+ */
+Result<SnapshotCopyStats> CopyToSnapshot(const std::string& src_dir_path,
+                                         const std::string& snapshot_path,
+                                         const SnapshotCopyOptions& options);
+
+/*
+ * Adds files that were written straight into the snapshot directory after
+ * CopyToSnapshot, such as the guest memory images written by crosvm, to the
+ * manifest. Chunks they have in common with the same files in the base
+ * snapshot are deduplicated where the file system supports it.
+ */
+Result<SnapshotCopyStats> AddToSnapshot(const std::string& snapshot_path,
+                                        const std::string& relative_dir,
+                                        const SnapshotCopyOptions& options);
+
+/*
+ * Copies the files in the manifest of `snapshot_path` to `dest_dir_path`,
+ * skipping the ones whose size and modification time already match.
+ */
+Result<SnapshotCopyStats> RestoreFromSnapshot(
+    const std::string& snapshot_path, const std::string& dest_dir_path,
+    const SnapshotCopyOptions& options);
+
+}  // namespace cuttlefish
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/command_util/snapshot_manifest.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::string contents;
+  EXPECT_TRUE(android::base::ReadFileToString(path, &contents)) << path;
+  return contents;
+}
+
+struct stat Stat(const std::string& path) {
+  struct stat st {};
+  EXPECT_EQ(lstat(path.c_str(), &st), 0) << path;
+  return st;
+}
+
+class SnapshotManifestTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(mkdir(Runtime().c_str(), 0755), 0);
+    ASSERT_EQ(mkdir((Runtime() + "/instances").c_str(), 0755), 0);
+    Write("instances/overlay.img", std::string(9 << 20, 'a') + "tail");
+    Write("instances/NVChip", "nv");
+    ASSERT_EQ(chmod((Runtime() + "/instances/NVChip").c_str(), 0600), 0);
+    ASSERT_EQ(symlink("instances/NVChip", (Runtime() + "/link").c_str()), 0);
+    // Mostly a hole.
+    Write("sparse.img", "");
+    ASSERT_EQ(truncate((Runtime() + "/sparse.img").c_str(), 16 << 20), 0);
+  }
+
+  std::string Path(const std::string& name) const {
+    return std::string(temp_dir_.path) + "/" + name;
+  }
+  std::string Runtime() const { return Path("runtime"); }
+
+  void Write(const std::string& relative, const std::string& contents) {
+    ASSERT_TRUE(
+        android::base::WriteStringToFile(contents, Runtime() + "/" + relative));
+  }
+
+  TemporaryDir temp_dir_;
+};
+
+TEST_F(SnapshotManifestTest, RestoresSnapshot) {
+  Result<SnapshotCopyStats> taken =
+      CopyToSnapshot(Runtime(), Path("snapshot"), {});
+  ASSERT_THAT(taken, IsOk());
+  EXPECT_EQ(taken->files, 3u);
+  EXPECT_TRUE(HasSnapshotManifest(Path("snapshot")));
+
+  Result<SnapshotCopyStats> restored =
+      RestoreFromSnapshot(Path("snapshot"), Path("restored"), {});
+  ASSERT_THAT(restored, IsOk());
+  EXPECT_EQ(restored->files_unchanged, 0u);
+  for (const char* file :
+       {"instances/overlay.img", "instances/NVChip", "sparse.img"}) {
+    EXPECT_EQ(ReadFile(Path("restored/") + file),
+              ReadFile(Runtime() + "/" + file));
+  }
+  EXPECT_EQ(Stat(Path("restored/instances/NVChip")).st_mode & 07777, 0600);
+  std::string target;
+  ASSERT_TRUE(android::base::Readlink(Path("restored/link"), &target));
+  EXPECT_EQ(target, "instances/NVChip");
+  EXPECT_EQ(Stat(Path("restored/instances/overlay.img")).st_mtim.tv_nsec,
+            Stat(Runtime() + "/instances/overlay.img").st_mtim.tv_nsec);
+  // Holes stay holes.
+  EXPECT_LT(Stat(Path("snapshot/sparse.img")).st_blocks * 512, 16 << 20);
+}
+
+TEST_F(SnapshotManifestTest, RestoresOnlyChangedFiles) {
+  ASSERT_THAT(CopyToSnapshot(Runtime(), Path("snapshot"), {}), IsOk());
+  ASSERT_THAT(RestoreFromSnapshot(Path("snapshot"), Runtime(), {}), IsOk());
+
+  Write("instances/NVChip", "changed");
+  Result<SnapshotCopyStats> restored =
+      RestoreFromSnapshot(Path("snapshot"), Runtime(), {});
+  ASSERT_THAT(restored, IsOk());
+  EXPECT_EQ(restored->files, 3u);
+  EXPECT_EQ(restored->files_unchanged, 2u);
+  EXPECT_EQ(ReadFile(Runtime() + "/instances/NVChip"), "nv");
+}
+
+TEST_F(SnapshotManifestTest, SharesUnchangedFilesWithBase) {
+  ASSERT_THAT(CopyToSnapshot(Runtime(), Path("base"), {}), IsOk());
+  Write("instances/NVChip", "changed");
+
+  Result<SnapshotCopyStats> taken = CopyToSnapshot(
+      Runtime(), Path("snapshot"), {.base_snapshot_path = Path("base")});
+  ASSERT_THAT(taken, IsOk());
+  EXPECT_EQ(Stat(Path("snapshot/instances/overlay.img")).st_ino,
+            Stat(Path("base/instances/overlay.img")).st_ino);
+  EXPECT_NE(Stat(Path("snapshot/instances/NVChip")).st_ino,
+            Stat(Path("base/instances/NVChip")).st_ino);
+  EXPECT_EQ(ReadFile(Path("snapshot/instances/NVChip")), "changed");
+  EXPECT_GE(taken->bytes_shared, (9u << 20) + 4);
+}
+
+TEST_F(SnapshotManifestTest, CopiesChangedChunks) {
+  ASSERT_THAT(CopyToSnapshot(Runtime(), Path("base"), {}), IsOk());
+  Write("instances/overlay.img", std::string(9 << 20, 'a') + "TAIL");
+
+  ASSERT_THAT(CopyToSnapshot(Runtime(), Path("snapshot"),
+                             {.base_snapshot_path = Path("base")}),
+              IsOk());
+  EXPECT_EQ(ReadFile(Path("snapshot/instances/overlay.img")),
+            ReadFile(Runtime() + "/instances/overlay.img"));
+  EXPECT_EQ(ReadFile(Path("base/instances/overlay.img")),
+            std::string(9 << 20, 'a') + "tail");
+}
+
+TEST_F(SnapshotManifestTest, AddsFilesWrittenIntoSnapshot) {
+  ASSERT_THAT(CopyToSnapshot(Runtime(), Path("snapshot"), {}), IsOk());
+  ASSERT_EQ(mkdir(Path("snapshot/guest").c_str(), 0755), 0);
+  ASSERT_TRUE(android::base::WriteStringToFile(
+      "memory", Path("snapshot/guest/memory.img")));
+
+  Result<SnapshotCopyStats> added =
+      AddToSnapshot(Path("snapshot"), "guest", {});
+  ASSERT_THAT(added, IsOk());
+  EXPECT_EQ(added->files, 1u);
+
+  ASSERT_THAT(RestoreFromSnapshot(Path("snapshot"), Path("restored"), {}),
+              IsOk());
+  EXPECT_EQ(ReadFile(Path("restored/guest/memory.img")), "memory");
+}
+
+TEST_F(SnapshotManifestTest, SkipsExcludedDirectories) {
+  ASSERT_THAT(CopyToSnapshot(Runtime(), Path("snapshot"), {}), IsOk());
+  const std::string excluded = Path("snapshot/instances");
+  SnapshotCopyOptions options{
+      .predicate = [&excluded](const std::string& path) {
+        return path != excluded;
+      },
+  };
+
+  ASSERT_THAT(RestoreFromSnapshot(Path("snapshot"), Path("restored"), options),
+              IsOk());
+  EXPECT_EQ(access(Path("restored/instances").c_str(), F_OK), -1);
+  EXPECT_EQ(access(Path("restored/sparse.img").c_str(), F_OK), 0);
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -21,6 +21,7 @@
 #include <sys/stat.h>
 #include <time.h>
 
+#include <chrono>
 #include <functional>
 #include <string>
 #include <string_view>
@@ -280,4 +281,10 @@ Result<std::vector<std::string>> GuestSnapshotDirectories(
   return guest_snapshot_paths;
 }
 
+Json::Int64 MillisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
 }  // namespace cuttlefish
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <string>
 
@@ -48,10 +49,17 @@ Result<Json::Value> LoadMetaJson(const std::string& snapshot_path);
 Result<std::vector<std::string>> GuestSnapshotDirectories(
     const std::string& snapshot_path);
 
+// For the timing reports in the snapshot meta information.
+Json::Int64 MillisecondsSince(std::chrono::steady_clock::time_point start);
+
 inline constexpr const char kMetaInfoJsonFileName[] = "snapshot_meta_info.json";
 inline constexpr const char kGuestSnapshotField[] = "guest_snapshot";
 inline constexpr const char kSnapshotPathField[] = "snapshot_path";
 inline constexpr const char kCfHomeField[] = "HOME";
 inline constexpr const char kGuestSnapshotBase[] = "guest_vm";
+inline constexpr const char kSnapshotTimingField[] = "timing";
+// Written by run_cvd into the instance guest snapshot directory, and moved
+// into the meta information by snapshot_util_cvd.
+inline constexpr const char kSnapshotTimingFileName[] = "snapshot_timing.json";
 
 }  // namespace cuttlefish
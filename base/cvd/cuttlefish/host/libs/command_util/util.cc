@@ -18,6 +18,8 @@
 
 #include <errno.h>
 #include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
 #include <sys/time.h>  // IWYU pragma: keep: timeval
 #include <sys/types.h>
 
@@ -72,6 +74,37 @@ static Result<bool> ReadExactBinaryResult(const SharedFD& fd, T* t) {
   return true;
 }
 
+Result<void> WriteExtendedAction(
+    const SharedFD& monitor_socket,
+    const run_cvd::ExtendedLauncherAction& extended_action) {
+  const std::string serialized_data = extended_action.SerializeAsString();
+  CF_EXPECT(!serialized_data.empty(), "failed to serialize proto");
+
+  const LauncherAction action = LauncherAction::kExtended;
+  CF_EXPECT(WriteAllBinaryResult(monitor_socket, &action),
+            "Error writing LauncherAction");
+  const uint32_t length = serialized_data.size();
+  CF_EXPECT(WriteAllBinaryResult(monitor_socket, &length),
+            "Error writing proto length");
+  ssize_t n =
+      WriteAll(monitor_socket, serialized_data.data(), serialized_data.size());
+  CF_EXPECTF(n > 0, "Write error: {}", monitor_socket->StrError());
+  CF_EXPECT(n == serialized_data.size(), "Unexpected EOF on write");
+  return {};
+}
+
+Result<void> ReadLauncherResponse(const SharedFD& monitor_socket,
+                                  std::optional<int> timeout_seconds) {
+  if (timeout_seconds.has_value()) {
+    CF_EXPECT(WaitForRead(monitor_socket, timeout_seconds.value()));
+  }
+  LauncherResponse response;
+  CF_EXPECT(ReadExactBinaryResult(monitor_socket, &response),
+            "Error reading LauncherResponse");
+  CF_EXPECT_EQ(response, LauncherResponse::kSuccess);
+  return {};
+}
+
 }  // namespace
 
 Result<RunnerExitCodes> ReadExitCode(SharedFD monitor_socket) {
@@ -165,14 +198,7 @@ Result<void> RunLauncherAction(SharedFD monitor_socket, LauncherAction action,
              static_cast<const char>(action));
   CF_EXPECT(WriteAllBinaryResult(monitor_socket, &action),
             "Error writing LauncherAction");
-
-  if (timeout_seconds.has_value()) {
-    CF_EXPECT(WaitForRead(monitor_socket, timeout_seconds.value()));
-  }
-  LauncherResponse response;
-  CF_EXPECT(ReadExactBinaryResult(monitor_socket, &response),
-            "Error reading LauncherResponse");
-  CF_EXPECT_EQ(response, LauncherResponse::kSuccess);
+  CF_EXPECT(ReadLauncherResponse(monitor_socket, timeout_seconds));
   return {};
 }
 
@@ -180,29 +206,60 @@ Result<void> RunLauncherAction(
     SharedFD monitor_socket,
     const run_cvd::ExtendedLauncherAction& extended_action,
     std::optional<int> timeout_seconds) {
-  const std::string serialized_data = extended_action.SerializeAsString();
-  CF_EXPECT(!serialized_data.empty(), "failed to serialize proto");
+  CF_EXPECT(WriteExtendedAction(monitor_socket, extended_action));
+  CF_EXPECT(ReadLauncherResponse(monitor_socket, timeout_seconds));
+  return {};
+}
 
-  const LauncherAction action = LauncherAction::kExtended;
-  CF_EXPECT(WriteAllBinaryResult(monitor_socket, &action),
-            "Error writing LauncherAction");
-  const uint32_t length = serialized_data.size();
-  CF_EXPECT(WriteAllBinaryResult(monitor_socket, &length),
-            "Error writing proto length");
-  if (!serialized_data.empty()) {
-    ssize_t n = WriteAll(monitor_socket, serialized_data.data(),
-                         serialized_data.size());
-    CF_EXPECTF(n > 0, "Write error: {}", monitor_socket->StrError());
-    CF_EXPECT(n == serialized_data.size(), "Unexpected EOF on write");
+Result<run_cvd::InstanceStatus> QueryLauncherStatus(
+    SharedFD monitor_socket, bool watch, std::optional<int> timeout_seconds) {
+  run_cvd::ExtendedLauncherAction extended_action;
+  extended_action.mutable_status_query()->set_watch(watch);
+  CF_EXPECT(WriteExtendedAction(monitor_socket, extended_action));
+  CF_EXPECT(ReadLauncherResponse(monitor_socket, timeout_seconds),
+            "The launcher may not support status queries");
+  std::optional<run_cvd::InstanceStatus> status =
+      CF_EXPECT(ReadLauncherStatus(monitor_socket));
+  CF_EXPECT(status.has_value(), "Launcher closed the connection");
+  return std::move(*status);
+}
+
+Result<std::optional<run_cvd::InstanceStatus>> ReadLauncherStatus(
+    SharedFD monitor_socket) {
+  uint32_t length = 0;
+  if (!CF_EXPECT(ReadExactBinaryResult(monitor_socket, &length),
+                 "Error reading status length")) {
+    return std::nullopt;
   }
+  std::string serialized_data(length, 0);
+  if (length > 0) {
+    ssize_t n = ReadExact(monitor_socket, serialized_data.data(),
+                          serialized_data.size());
+    CF_EXPECTF(n > 0, "Read error: {}", monitor_socket->StrError());
+    CF_EXPECT(n == serialized_data.size(), "Unexpected EOF on read");
+  }
+  run_cvd::InstanceStatus status;
+  CF_EXPECT(status.ParseFromString(serialized_data),
+            "Failed to parse InstanceStatus proto");
+  return status;
+}
 
-  if (timeout_seconds.has_value()) {
-    CF_EXPECT(WaitForRead(monitor_socket, timeout_seconds.value()));
+Result<void> WriteLauncherStatus(SharedFD client,
+                                 const run_cvd::InstanceStatus& status) {
+  const std::string serialized_data = status.SerializeAsString();
+  const uint32_t length = serialized_data.size();
+  std::string message(sizeof(length), '\0');
+  memcpy(message.data(), &length, sizeof(length));
+  message += serialized_data;
+  // Watchers can hang up at any time, which must not kill the launcher with
+  // SIGPIPE.
+  size_t sent = 0;
+  while (sent < message.size()) {
+    ssize_t n = client->Send(message.data() + sent, message.size() - sent,
+                             MSG_NOSIGNAL);
+    CF_EXPECTF(n > 0, "Send error: {}", client->StrError());
+    sent += n;
   }
-  LauncherResponse response;
-  CF_EXPECT(ReadExactBinaryResult(monitor_socket, &response),
-            "Error reading LauncherResponse");
-  CF_EXPECT_EQ(response, LauncherResponse::kSuccess);
   return {};
 }
 
@@ -56,4 +56,18 @@ Result<void> RunLauncherAction(
     const run_cvd::ExtendedLauncherAction& extended_action,
     std::optional<int> timeout_seconds);
 
+// Sends a StatusQuery to the launcher and returns its reply. With `watch`,
+// the launcher keeps the connection open and the following replies are read
+// with ReadLauncherStatus.
+Result<run_cvd::InstanceStatus> QueryLauncherStatus(
+    SharedFD monitor_socket, bool watch, std::optional<int> timeout_seconds);
+
+// Returns std::nullopt once the launcher closes the connection.
+Result<std::optional<run_cvd::InstanceStatus>> ReadLauncherStatus(
+    SharedFD monitor_socket);
+
+// The launcher side of QueryLauncherStatus and ReadLauncherStatus.
+Result<void> WriteLauncherStatus(SharedFD client,
+                                 const run_cvd::InstanceStatus& status);
+
 }  // namespace cuttlefish
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/config/compiled_config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <bit>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "json/value.h"
+
+#include "cuttlefish/common/libs/fs/scoped_mmap.h"
+#include "cuttlefish/common/libs/fs/shared_buf.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/posix/realpath.h"
+#include "cuttlefish/posix/rename.h"
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr char kMagic[8] = {'C', 'F', 'C', 'O', 'N', 'F', 'I', 'G'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kNoNode = UINT32_MAX;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t node_count;
+  uint64_t strings_offset;
+  uint64_t strings_size;
+  // Identifies the JSON file that was compiled.
+  uint64_t json_device;
+  uint64_t json_inode;
+  uint64_t json_size;
+  int64_t json_mtime_ns;
+};
+
+// Nodes start right after the header, the root being the first one.
+struct Node {
+  uint8_t type;  // Json::ValueType
+  uint8_t reserved[3];
+  // Only set for object members.
+  uint32_t key_offset;
+  uint32_t key_size;
+  // Length of strings, number of children of arrays and objects.
+  uint32_t size;
+  // Bits of booleans and numbers, offset of strings, index of the first child
+  // of arrays and objects.
+  uint64_t value;
+};
+
+static_assert(sizeof(Header) % alignof(Node) == 0);
+
+bool SameFile(const Header& header, const struct stat& st) {
+  return header.json_device == st.st_dev && header.json_inode == st.st_ino &&
+         header.json_size == static_cast<uint64_t>(st.st_size) &&
+         header.json_mtime_ns ==
+             int64_t{st.st_mtim.tv_sec} * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+class Compiler {
+ public:
+  std::string Compile(const Json::Value& root, const struct stat& source) {
+    // Breadth first, so the children of each container are contiguous.
+    std::deque<std::pair<const Json::Value*, uint32_t>> pending;
+    nodes_.emplace_back();
+    pending.emplace_back(&root, 0);
+    while (!pending.empty()) {
+      auto [value, index] = pending.front();
+      pending.pop_front();
+      Fill(*value, index, pending);
+    }
+
+    Header header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.node_count = nodes_.size();
+    header.strings_offset = sizeof(Header) + nodes_.size() * sizeof(Node);
+    header.strings_size = strings_.size();
+    header.json_device = source.st_dev;
+    header.json_inode = source.st_ino;
+    header.json_size = source.st_size;
+    header.json_mtime_ns =
+        int64_t{source.st_mtim.tv_sec} * 1000000000 + source.st_mtim.tv_nsec;
+
+    std::string compiled(reinterpret_cast<const char*>(&header),
+                         sizeof(header));
+    compiled.append(reinterpret_cast<const char*>(nodes_.data()),
+                    nodes_.size() * sizeof(Node));
+    compiled += strings_;
+    return compiled;
+  }
+
+ private:
+  void Fill(const Json::Value& value, uint32_t index,
+            std::deque<std::pair<const Json::Value*, uint32_t>>& pending) {
+    Node node = nodes_[index];
+    node.type = value.type();
+    switch (value.type()) {
+      case Json::nullValue:
+        break;
+      case Json::intValue:
+        node.value = std::bit_cast<uint64_t>(value.asInt64());
+        break;
+      case Json::uintValue:
+        node.value = value.asUInt64();
+        break;
+      case Json::realValue:
+        node.value = std::bit_cast<uint64_t>(value.asDouble());
+        break;
+      case Json::booleanValue:
+        node.value = value.asBool();
+        break;
+      case Json::stringValue: {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        value.getString(&begin, &end);
+        node.size = end - begin;
+        node.value = AddString(std::string_view(begin, end - begin));
+        break;
+      }
+      case Json::arrayValue:
+        node.size = value.size();
+        node.value = nodes_.size();
+        for (const Json::Value& element : value) {
+          pending.emplace_back(&element, nodes_.size());
+          nodes_.emplace_back();
+        }
+        break;
+      case Json::objectValue:
+        node.size = value.size();
+        node.value = nodes_.size();
+        // Sorted, for binary search.
+        for (const std::string& key : value.getMemberNames()) {
+          Node& member = nodes_.emplace_back();
+          member.key_offset = AddString(key, /* intern */ true);
+          member.key_size = key.size();
+          pending.emplace_back(&value[key], nodes_.size() - 1);
+        }
+        break;
+    }
+    nodes_[index] = node;
+  }
+
+  uint32_t AddString(std::string_view str, bool intern = false) {
+    // The same keys repeat in every instance.
+    if (intern) {
+      auto it = interned_.find(std::string(str));
+      if (it != interned_.end()) {
+        return it->second;
+      }
+    }
+    uint32_t offset = strings_.size();
+    strings_.append(str);
+    if (intern) {
+      interned_.emplace(str, offset);
+    }
+    return offset;
+  }
+
+  std::vector<Node> nodes_;
+  std::string strings_;
+  std::unordered_map<std::string, uint32_t> interned_;
+};
+
+// Bounds checked access to a mapped compiled config.
+class View {
+ public:
+  static Result<View> Create(const ScopedMMap& mapping) {
+    CF_EXPECT(mapping.WithinBounds(0, sizeof(Header)), "Truncated header");
+    const Header* header = static_cast<const Header*>(mapping.get());
+    CF_EXPECT(memcmp(header->magic, kMagic, sizeof(kMagic)) == 0,
+              "Not a compiled config");
+    CF_EXPECT_EQ(header->version, kVersion);
+    CF_EXPECT_GT(header->node_count, 0u);
+    CF_EXPECT(mapping.WithinBounds(sizeof(Header),
+                                   header->node_count * sizeof(Node)),
+              "Truncated nodes");
+    CF_EXPECT_GE(header->strings_offset,
+                 sizeof(Header) + header->node_count * sizeof(Node));
+    CF_EXPECT(header->strings_size == 0 ||
+                  mapping.WithinBounds(header->strings_offset,
+                                       header->strings_size),
+              "Truncated strings");
+    const char* base = static_cast<const char*>(mapping.get());
+    return View(header,
+                reinterpret_cast<const Node*>(base + sizeof(Header)),
+                std::string_view(base + header->strings_offset,
+                                 header->strings_size));
+  }
+
+  Result<uint32_t> Find(uint32_t object, std::string_view key) const {
+    const Node& node = nodes_[object];
+    CF_EXPECT(node.type == Json::objectValue, "Not an object");
+    uint32_t first = CF_EXPECT(FirstChild(object));
+    uint32_t last = first + node.size;
+    while (first < last) {
+      uint32_t middle = first + (last - first) / 2;
+      std::string_view middle_key = CF_EXPECT(Key(nodes_[middle]));
+      if (middle_key == key) {
+        return middle;
+      }
+      if (middle_key < key) {
+        first = middle + 1;
+      } else {
+        last = middle;
+      }
+    }
+    return CF_ERRF("No member \"{}\"", key);
+  }
+
+  // Members of the object at index `deferred` are decoded as null.
+  Result<Json::Value> Decode(uint32_t index, uint32_t deferred) const {
+    const Node& node = nodes_[index];
+    switch (node.type) {
+      case Json::nullValue:
+        return Json::Value();
+      case Json::intValue:
+        return Json::Value(Json::Int64(std::bit_cast<int64_t>(node.value)));
+      case Json::uintValue:
+        return Json::Value(Json::UInt64(node.value));
+      case Json::realValue:
+        return Json::Value(std::bit_cast<double>(node.value));
+      case Json::booleanValue:
+        return Json::Value(node.value != 0);
+      case Json::stringValue: {
+        std::string_view str = CF_EXPECT(String(node.value, node.size));
+        return Json::Value(str.data(), str.data() + str.size());
+      }
+      case Json::arrayValue: {
+        uint32_t first = CF_EXPECT(FirstChild(index));
+        Json::Value array(Json::arrayValue);
+        for (uint32_t i = 0; i < node.size; i++) {
+          array.append(CF_EXPECT(Decode(first + i, deferred)));
+        }
+        return array;
+      }
+      case Json::objectValue: {
+        uint32_t first = CF_EXPECT(FirstChild(index));
+        Json::Value object(Json::objectValue);
+        for (uint32_t i = first; i < first + node.size; i++) {
+          std::string key(CF_EXPECT(Key(nodes_[i])));
+          object[key] = index == deferred ? Json::Value()
+                                          : CF_EXPECT(Decode(i, deferred));
+        }
+        return object;
+      }
+    }
+    return CF_ERRF("Unknown value type {}", node.type);
+  }
+
+ private:
+  View(const Header* header, const Node* nodes, std::string_view strings)
+      : header_(header), nodes_(nodes), strings_(strings) {}
+
+  // Children always come after their parent, which rules out cycles.
+  Result<uint32_t> FirstChild(uint32_t index) const {
+    const Node& node = nodes_[index];
+    CF_EXPECT_GT(node.value, index);
+    CF_EXPECT_LE(node.value + node.size, header_->node_count);
+    return static_cast<uint32_t>(node.value);
+  }
+
+  Result<std::string_view> Key(const Node& node) const {
+    return CF_EXPECT(String(node.key_offset, node.key_size));
+  }
+
+  Result<std::string_view> String(uint64_t offset, uint32_t size) const {
+    CF_EXPECT_LE(offset, strings_.size());
+    CF_EXPECT_LE(size, strings_.size() - offset);
+    return strings_.substr(offset, size);
+  }
+
+  const Header* header_;
+  const Node* nodes_;
+  std::string_view strings_;
+};
+
+}  // namespace
+
+std::string CompiledConfigPath(const std::string& json_path) {
+  return json_path + ".compiled";
+}
+
+Result<void> CompiledConfig::Write(const Json::Value& root,
+                                   const std::string& json_link) {
+  // Kept next to the file rather than next to the links to it.
+  std::string json_path = CF_EXPECT(RealPath(json_link));
+  struct stat source;
+  CF_EXPECTF(stat(json_path.c_str(), &source) == 0, "stat(\"{}\"): {}",
+             json_path, StrError(errno));
+  std::string compiled = Compiler().Compile(root, source);
+
+  // Readers either see the previous file or the complete new one.
+  std::string path = CompiledConfigPath(json_path);
+  std::string temp_path = path + ".tmp";
+  SharedFD fd =
+      SharedFD::Open(temp_path, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+  CF_EXPECTF(fd->IsOpen(), "open(\"{}\"): {}", temp_path, fd->StrError());
+  CF_EXPECTF(WriteAll(fd, compiled) == static_cast<ssize_t>(compiled.size()),
+             "Failed to write \"{}\": {}", temp_path, fd->StrError());
+  fd->Close();
+  CF_EXPECT(Rename(temp_path, path));
+  return {};
+}
+
+Result<std::unique_ptr<CompiledConfig>> CompiledConfig::Open(
+    const std::string& json_link) {
+  std::string json_path = CF_EXPECT(RealPath(json_link));
+  std::string path = CompiledConfigPath(json_path);
+  SharedFD fd = SharedFD::Open(path, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(fd->IsOpen(), "open(\"{}\"): {}", path, fd->StrError());
+  off_t size = fd->LSeek(0, SEEK_END);
+  CF_EXPECTF(size > 0, "Empty or unreadable \"{}\": {}", path,
+             fd->StrError());
+  ScopedMMap mapping = fd->MMap(nullptr, size, PROT_READ, MAP_PRIVATE, 0);
+  CF_EXPECTF(!!mapping, "mmap(\"{}\"): {}", path, fd->StrError());
+
+  View view = CF_EXPECTF(View::Create(mapping), "Invalid \"{}\"", path);
+  struct stat source;
+  CF_EXPECTF(stat(json_path.c_str(), &source) == 0, "stat(\"{}\"): {}",
+             json_path, StrError(errno));
+  const Header* header = static_cast<const Header*>(mapping.get());
+  CF_EXPECTF(SameFile(*header, source), "\"{}\" is older than \"{}\"", path,
+             json_path);
+  return std::unique_ptr<CompiledConfig>(
+      new CompiledConfig(std::move(mapping)));
+}
+
+CompiledConfig::CompiledConfig(ScopedMMap mapping)
+    : mapping_(std::move(mapping)) {}
+
+Result<Json::Value> CompiledConfig::Root(std::string_view deferred) const {
+  View view = CF_EXPECT(View::Create(mapping_));
+  uint32_t deferred_index = kNoNode;
+  Result<uint32_t> found = view.Find(0, deferred);
+  if (found.has_value()) {
+    deferred_index = *found;
+  }
+  return CF_EXPECT(view.Decode(0, deferred_index));
+}
+
+Result<Json::Value> CompiledConfig::Member(std::string_view object,
+                                           std::string_view member) const {
+  View view = CF_EXPECT(View::Create(mapping_));
+  uint32_t object_index = CF_EXPECT(view.Find(0, object));
+  uint32_t member_index = CF_EXPECT(view.Find(object_index, member));
+  return CF_EXPECT(view.Decode(member_index, kNoNode));
+}
+
+}  // namespace cuttlefish
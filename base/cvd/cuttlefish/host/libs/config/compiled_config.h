@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "json/value.h"
+
+#include "cuttlefish/common/libs/fs/scoped_mmap.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+// Where the compiled form of the JSON configuration file at `json_path` is
+// stored. Symbolic links are resolved before calling this.
+std::string CompiledConfigPath(const std::string& json_path);
+
+// A JSON configuration file compiled to a binary form that is memory mapped
+// instead of parsed. Every value is a fixed size record, containers point to
+// their contiguous children and object members are sorted by key, so single
+// members can be found and decoded without touching the rest of the file.
+//
+// The compiled file records the identity of the JSON file it was compiled
+// from, and is ignored once the JSON file is replaced or modified.
+class CompiledConfig {
+ public:
+  // Compiles `root`, which must be what was just saved to `json_path`.
+  static Result<void> Write(const Json::Value& root,
+                            const std::string& json_path);
+  // Fails if there is no compiled file for `json_path`, or if it's stale.
+  static Result<std::unique_ptr<CompiledConfig>> Open(
+      const std::string& json_path);
+
+  // The whole tree, except that the members of the top level object named
+  // `deferred` are left as null values, to be decoded with `Member`.
+  Result<Json::Value> Root(std::string_view deferred) const;
+  // Decodes root[object][member].
+  Result<Json::Value> Member(std::string_view object,
+                             std::string_view member) const;
+
+ private:
+  CompiledConfig(ScopedMMap mapping);
+
+  ScopedMMap mapping_;
+};
+
+}  // namespace cuttlefish
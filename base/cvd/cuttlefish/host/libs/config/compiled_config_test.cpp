@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/config/compiled_config.h"
+
+#include <unistd.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "json/value.h"
+#include "json/writer.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+Json::Value Instance(int num) {
+  Json::Value instance;
+  instance["num"] = num;
+  instance["uid"] = Json::UInt64(1) << 40;
+  instance["offset"] = -1;
+  instance["ratio"] = 0.5;
+  instance["enabled"] = num % 2 == 0;
+  instance["missing"] = Json::Value();
+  instance["name"] = "cvd-" + std::to_string(num);
+  instance["nul"] = std::string("a\0b", 3);
+  instance["args"].append("--foo");
+  instance["args"].append(Json::Value(Json::objectValue));
+  instance["args"].append(Json::Value(Json::arrayValue));
+  return instance;
+}
+
+class CompiledConfigTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    config_["root_dir"] = "/tmp/cuttlefish";
+    config_["fragments"]["adb"]["mode"] = "vsock";
+    for (int num = 1; num <= 3; num++) {
+      config_["instances"][std::to_string(num)] = Instance(num);
+    }
+    ASSERT_TRUE(android::base::WriteStringToFile(Serialize(), JsonPath()));
+  }
+
+  std::string JsonPath() const {
+    return std::string(temp_dir_.path) + "/cuttlefish_config.json";
+  }
+
+  std::string Serialize() const {
+    std::stringstream json;
+    json << config_;
+    return json.str();
+  }
+
+  TemporaryDir temp_dir_;
+  Json::Value config_;
+};
+
+TEST_F(CompiledConfigTest, DecodesEverything) {
+  ASSERT_THAT(CompiledConfig::Write(config_, JsonPath()), IsOk());
+  Result<std::unique_ptr<CompiledConfig>> compiled =
+      CompiledConfig::Open(JsonPath());
+  ASSERT_THAT(compiled, IsOk());
+
+  EXPECT_THAT((*compiled)->Root(""), IsOkAndValue(config_));
+}
+
+TEST_F(CompiledConfigTest, DefersMembers) {
+  ASSERT_THAT(CompiledConfig::Write(config_, JsonPath()), IsOk());
+  Result<std::unique_ptr<CompiledConfig>> compiled =
+      CompiledConfig::Open(JsonPath());
+  ASSERT_THAT(compiled, IsOk());
+
+  Result<Json::Value> root = (*compiled)->Root("instances");
+  ASSERT_THAT(root, IsOk());
+  EXPECT_EQ((*root)["fragments"], config_["fragments"]);
+  EXPECT_THAT((*root)["instances"].getMemberNames(),
+              testing::ElementsAre("1", "2", "3"));
+  EXPECT_TRUE((*root)["instances"]["2"].isNull());
+
+  EXPECT_THAT((*compiled)->Member("instances", "2"),
+              IsOkAndValue(config_["instances"]["2"]));
+  EXPECT_THAT((*compiled)->Member("instances", "4"), IsError());
+}
+
+TEST_F(CompiledConfigTest, IgnoredOnceJsonChanges) {
+  ASSERT_THAT(CompiledConfig::Write(config_, JsonPath()), IsOk());
+
+  config_["root_dir"] = "/tmp/cuttlefish2";
+  ASSERT_TRUE(android::base::WriteStringToFile(Serialize(), JsonPath()));
+  EXPECT_THAT(CompiledConfig::Open(JsonPath()), IsError());
+}
+
+TEST_F(CompiledConfigTest, FollowsSymlinks) {
+  std::string link = std::string(temp_dir_.path) + "/link.json";
+  ASSERT_EQ(symlink(JsonPath().c_str(), link.c_str()), 0);
+  ASSERT_THAT(CompiledConfig::Write(config_, link), IsOk());
+
+  EXPECT_THAT(CompiledConfig::Open(JsonPath()), IsOk());
+  EXPECT_THAT(CompiledConfig::Open(link), IsOk());
+}
+
+TEST_F(CompiledConfigTest, RejectsCorruptFiles) {
+  ASSERT_TRUE(android::base::WriteStringToFile(
+      "not a compiled config", CompiledConfigPath(JsonPath())));
+  EXPECT_THAT(CompiledConfig::Open(JsonPath()), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Loads the configuration the way each host process does at startup and reads
+// one instance from it, with and without the compiled config next to the JSON
+// file. Uses `--config_file` if given, or else a synthetic configuration.
+//
+// Then starts `--helpers` processes per instance at once, each loading the
+// configuration, to approximate every host process of a device group reading
+// it at the same time during launch.
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "android-base/file.h"
+#include "json/value.h"
+#include "json/writer.h"
+
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/host/libs/config/compiled_config.h"
+#include "cuttlefish/host/libs/config/cuttlefish_config.h"
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Roughly the shape of what assemble_cvd writes.
+Json::Value SyntheticConfig(size_t instances, size_t keys_per_instance) {
+  Json::Value config;
+  config["root_dir"] = "/tmp/cuttlefish";
+  for (size_t i = 1; i <= instances; i++) {
+    Json::Value& instance = config["instances"][std::to_string(i)];
+    instance["instance_name"] = "cvd-" + std::to_string(i);
+    for (size_t key = 0; key < keys_per_instance; key++) {
+      std::string name = "setting_" + std::to_string(key);
+      switch (key % 3) {
+        case 0:
+          instance[name] = "/tmp/cuttlefish/instances/cvd-" +
+                           std::to_string(i) + "/" + name;
+          break;
+        case 1:
+          instance[name] = Json::Int(6520 + i + key);
+          break;
+        case 2:
+          instance[name] = key % 2 == 0;
+          break;
+      }
+    }
+  }
+  return config;
+}
+
+Result<void> Run(const std::string& name, const std::string& config_path,
+                 size_t instances, size_t loads) {
+  std::chrono::nanoseconds total{};
+  for (size_t i = 0; i < loads; i++) {
+    Clock::time_point begin = Clock::now();
+    CuttlefishConfig config;
+    CF_EXPECT(config.LoadFromFile(config_path.c_str()));
+    // Each host process only looks at its own instance.
+    std::string instance_name =
+        std::as_const(config).ForInstance(1 + i % instances).instance_name();
+    total += Clock::now() - begin;
+    CF_EXPECT(!instance_name.empty(), "Instance has no name");
+  }
+  std::cout << name << ": "
+            << std::chrono::duration<double, std::milli>(total).count() / loads
+            << "ms per load\n";
+  return {};
+}
+
+// Each child stands in for one host process starting up.
+Result<void> RunProcesses(const std::string& name,
+                          const std::string& config_path, size_t instances,
+                          size_t helpers) {
+  Clock::time_point begin = Clock::now();
+  std::vector<pid_t> children;
+  for (size_t i = 0; i < instances * helpers; i++) {
+    pid_t pid = fork();
+    CF_EXPECTF(pid >= 0, "fork failed: {}", StrError(errno));
+    if (pid == 0) {
+      CuttlefishConfig config;
+      bool loaded = config.LoadFromFile(config_path.c_str()) &&
+                    !std::as_const(config)
+                         .ForInstance(1 + i % instances)
+                         .instance_name()
+                         .empty();
+      _exit(loaded ? 0 : 1);
+    }
+    children.push_back(pid);
+  }
+  size_t failed = 0;
+  for (pid_t child : children) {
+    int status = 0;
+    CF_EXPECTF(waitpid(child, &status, 0) == child, "waitpid failed: {}",
+               StrError(errno));
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failed++;
+    }
+  }
+  std::chrono::nanoseconds total = Clock::now() - begin;
+  CF_EXPECT_EQ(failed, 0u, "Some processes failed to load the config");
+  std::cout << name << ": "
+            << std::chrono::duration<double, std::milli>(total).count()
+            << "ms for " << children.size() << " processes\n";
+  return {};
+}
+
+Result<void> ConfigLoadBenchmarkMain(int argc, char** argv) {
+  std::string config_file;
+  size_t instances = 16;
+  size_t keys_per_instance = 400;
+  size_t loads = 100;
+  size_t helpers = 20;
+  std::vector<Flag> flags;
+  flags.emplace_back(
+      GflagsCompatFlag("config_file", config_file)
+          .Help("Existing configuration to load instead of a synthetic one."));
+  flags.emplace_back(
+      GflagsCompatFlag("instances", instances)
+          .Help("How many instances the synthetic configuration has."));
+  flags.emplace_back(
+      GflagsCompatFlag("keys_per_instance", keys_per_instance)
+          .Help("How many settings each synthetic instance has."));
+  flags.emplace_back(GflagsCompatFlag("loads", loads)
+                         .Help("How many times the configuration is loaded."));
+  flags.emplace_back(
+      GflagsCompatFlag("helpers", helpers)
+          .Help("How many processes per instance load the configuration at "
+                "once. 0 skips the multi-process measurement."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(loads, 0u);
+
+  TemporaryDir temp_dir;
+  std::string config_path =
+      std::string(temp_dir.path) + "/cuttlefish_config.json";
+  CuttlefishConfig config;
+  if (config_file.empty()) {
+    std::string synthetic_path = std::string(temp_dir.path) + "/synthetic.json";
+    std::stringstream json;
+    json << SyntheticConfig(instances, keys_per_instance);
+    CF_EXPECT(android::base::WriteStringToFile(json.str(), synthetic_path));
+    CF_EXPECT(config.LoadFromFile(synthetic_path.c_str()));
+  } else {
+    CF_EXPECT(config.LoadFromFile(config_file.c_str()));
+    instances = config.Instances().size();
+  }
+  CF_EXPECT_GT(instances, 0u);
+  // Writes the compiled config along with the JSON file.
+  CF_EXPECT(config.SaveToFile(config_path));
+  std::string compiled_path = CompiledConfigPath(config_path);
+  std::string moved_path = compiled_path + ".moved";
+
+  std::cout << instances << " instances, "
+            << std::filesystem::file_size(config_path) << " bytes of JSON\n";
+  CF_EXPECT_EQ(rename(compiled_path.c_str(), moved_path.c_str()), 0);
+  CF_EXPECT(Run("json", config_path, instances, loads));
+  if (helpers > 0) {
+    CF_EXPECT(RunProcesses("json processes", config_path, instances, helpers));
+  }
+  CF_EXPECT_EQ(rename(moved_path.c_str(), compiled_path.c_str()), 0);
+  CF_EXPECT(Run("compiled", config_path, instances, loads));
+  if (helpers > 0) {
+    CF_EXPECT(
+        RunProcesses("compiled processes", config_path, instances, helpers));
+  }
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::ConfigLoadBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
@@ -22,6 +22,7 @@
 #include <fstream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <string_view>
@@ -38,6 +39,7 @@
 #include "cuttlefish/common/libs/utils/environment.h"
 #include "cuttlefish/common/libs/utils/files.h"
 #include "cuttlefish/files/file_exists.h"
+#include "cuttlefish/host/libs/config/compiled_config.h"
 #include "cuttlefish/host/libs/config/config_constants.h"
 #include "cuttlefish/host/libs/config/config_fragment.h"
 #include "cuttlefish/host/libs/config/config_utils.h"
@@ -188,6 +190,14 @@ std::map<std::string, uint32_t> CuttlefishConfig::host_tools_version() const {
   return versions;
 }
 
+static constexpr char kKeymintKeyPool[] = "keymint_key_pool";
+void CuttlefishConfig::set_keymint_key_pool(bool keymint_key_pool) {
+  (*dictionary_)[kKeymintKeyPool] = keymint_key_pool;
+}
+bool CuttlefishConfig::keymint_key_pool() const {
+  return (*dictionary_)[kKeymintKeyPool].asBool();
+}
+
 static constexpr char kEnableHostUwb[] = "enable_host_uwb";
 void CuttlefishConfig::set_enable_host_uwb(bool enable_host_uwb) {
   (*dictionary_)[kEnableHostUwb] = enable_host_uwb;
@@ -473,6 +483,14 @@ CuttlefishConfig::GetFromFile(const std::string& path) {
   return FileExists(real_file_path);
 }
 
+// Every host process loads the configuration, but most only use their own
+// instance. Instances are decoded from the compiled config on first use.
+struct CuttlefishConfig::LazyInstances {
+  std::unique_ptr<CompiledConfig> compiled;
+  std::mutex mutex;
+  std::set<std::string> pending;
+};
+
 CuttlefishConfig::CuttlefishConfig() : dictionary_(new Json::Value()) {}
 // Can't use '= default' on the header because the compiler complains of
 // Json::Value being an incomplete type
@@ -487,6 +505,27 @@ bool CuttlefishConfig::LoadFromFile(const char* file) {
     LOG(ERROR) << "Could not get real path for file " << file;
     return false;
   }
+  lazy_instances_.reset();
+  Result<std::unique_ptr<CompiledConfig>> compiled =
+      CompiledConfig::Open(real_file_path);
+  if (compiled.has_value()) {
+    Result<Json::Value> root = (*compiled)->Root(kInstances);
+    if (root.has_value()) {
+      *dictionary_ = std::move(*root);
+      lazy_instances_ = std::make_unique<LazyInstances>();
+      lazy_instances_->compiled = std::move(*compiled);
+      for (const std::string& id :
+           (*dictionary_)[kInstances].getMemberNames()) {
+        lazy_instances_->pending.insert(id);
+      }
+      return true;
+    }
+    LOG(WARNING) << "Ignoring compiled config for " << file << ": "
+                 << root.error().Message();
+  } else {
+    VLOG(1) << "Not using compiled config: " << compiled.error().Message();
+  }
+
   Json::CharReaderBuilder builder;
   std::ifstream ifs(real_file_path);
   std::string errorMessage;
@@ -497,13 +536,59 @@ bool CuttlefishConfig::LoadFromFile(const char* file) {
   return true;
 }
 bool CuttlefishConfig::SaveToFile(const std::string& file) const {
+  DecodeAllInstances();
   std::ofstream ofs(file);
   if (!ofs.is_open()) {
     LOG(ERROR) << "Unable to write to file " << file;
     return false;
   }
   ofs << *dictionary_;
-  return !ofs.fail();
+  ofs.close();
+  if (ofs.fail()) {
+    return false;
+  }
+  // The JSON file stays the source of truth, so failing to compile it is not
+  // fatal.
+  Result<void> compiled = CompiledConfig::Write(*dictionary_, file);
+  if (!compiled.has_value()) {
+    LOG(WARNING) << "Failed to compile config file " << file << ": "
+                 << compiled.error().Message();
+  }
+  return true;
+}
+
+Json::Value* CuttlefishConfig::InstanceDictionary(const std::string& id) const {
+  Json::Value* instance = &(*dictionary_)[kInstances][id];
+  if (!lazy_instances_) {
+    return instance;
+  }
+  std::lock_guard lock(lazy_instances_->mutex);
+  if (lazy_instances_->pending.erase(id) == 0) {
+    return instance;
+  }
+  Result<Json::Value> decoded =
+      lazy_instances_->compiled->Member(kInstances, id);
+  if (decoded.has_value()) {
+    *instance = std::move(*decoded);
+  } else {
+    LOG(ERROR) << "Failed to decode instance " << id
+               << " from the compiled config: " << decoded.error().Message();
+  }
+  return instance;
+}
+
+void CuttlefishConfig::DecodeAllInstances() const {
+  if (!lazy_instances_) {
+    return;
+  }
+  std::set<std::string> pending;
+  {
+    std::lock_guard lock(lazy_instances_->mutex);
+    pending = lazy_instances_->pending;
+  }
+  for (const std::string& id : pending) {
+    InstanceDictionary(id);
+  }
 }
 
 std::string CuttlefishConfig::instances_dir() const {
@@ -62,7 +62,8 @@ class CuttlefishConfig {
   CuttlefishConfig& operator=(CuttlefishConfig&&);
 
   // Saves the configuration object in a file, it can then be read in other
-  // processes by passing the --config_file option.
+  // processes by passing the --config_file option. A compiled copy is saved
+  // next to it, which LoadFromFile prefers while it's up to date.
   bool SaveToFile(const std::string& file) const;
   bool LoadFromFile(const char* file);
 
@@ -137,6 +138,9 @@ class CuttlefishConfig {
   void set_secure_hals(const std::set<SecureHal>&);
   Result<std::set<SecureHal>> secure_hals() const;
 
+  void set_keymint_key_pool(bool keymint_key_pool);
+  bool keymint_key_pool() const;
+
   void set_crosvm_binary(const std::string& crosvm_binary);
   std::string crosvm_binary() const;
 
@@ -915,7 +919,16 @@ class CuttlefishConfig {
   };
 
  private:
+  struct LazyInstances;
+
+  // Returns the dictionary of one instance, decoding it from the compiled
+  // config first if it hasn't been used yet.
+  Json::Value* InstanceDictionary(const std::string& id) const;
+  void DecodeAllInstances() const;
+
   std::unique_ptr<Json::Value> dictionary_;
+  // Only set when loaded from a compiled config.
+  std::unique_ptr<LazyInstances> lazy_instances_;
 
   static CuttlefishConfig* BuildConfigImpl(const std::string& path);
 
@@ -56,8 +56,6 @@
 namespace cuttlefish {
 namespace {
 
-const char* kInstances = "instances";
-
 std::string IdToName(const std::string& id) { return kCvdNamePrefix + id; }
 
 }  // namespace
@@ -72,11 +70,11 @@ CuttlefishConfig::MutableInstanceSpecific::MutableInstanceSpecific(
 }
 
 Json::Value* CuttlefishConfig::MutableInstanceSpecific::Dictionary() {
-  return &(*config_->dictionary_)[kInstances][id_];
+  return config_->InstanceDictionary(id_);
 }
 
 const Json::Value* CuttlefishConfig::InstanceSpecific::Dictionary() const {
-  return &(*config_->dictionary_)[kInstances][id_];
+  return config_->InstanceDictionary(id_);
 }
 
 std::string CuttlefishConfig::InstanceSpecific::instance_dir() const {
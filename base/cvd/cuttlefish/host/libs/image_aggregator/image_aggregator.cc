@@ -23,11 +23,13 @@
 #include <fcntl.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/types.h>
 
 #include <fstream>
 #include <ios>
 #include <memory>
 #include <random>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -38,8 +40,8 @@
 #include "cuttlefish/common/libs/fs/fd.h"
 #include "cuttlefish/common/libs/fs/shared_buf.h"
 #include "cuttlefish/common/libs/fs/shared_fd.h"
-#include "cuttlefish/common/libs/utils/files.h"
 #include "cuttlefish/common/libs/utils/size_utils.h"
+#include "cuttlefish/common/libs/utils/task_graph.h"
 #include "cuttlefish/host/libs/image_aggregator/cdisk_spec.pb.h"
 #include "cuttlefish/host/libs/image_aggregator/composite_disk.h"
 #include "cuttlefish/host/libs/image_aggregator/disk_image.h"
@@ -48,11 +50,17 @@
 #include "cuttlefish/host/libs/image_aggregator/image_from_file.h"
 #include "cuttlefish/host/libs/image_aggregator/mbr.h"
 #include "cuttlefish/host/libs/image_aggregator/sparse_image.h"
+#include "cuttlefish/io/copy.h"
+#include "cuttlefish/io/shared_fd.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 namespace {
 
+// Partitions are copied in parallel, so a copy that can't be offloaded to the
+// kernel uses a small buffer rather than the `Copy` default.
+constexpr size_t kCopyBufferSize = 1 << 20;
+
 struct PartitionInfo {
   ImagePartition source;
   uint64_t size;
@@ -133,6 +141,9 @@ class CompositeDiskBuilder {
     return {};
   }
 
+  /** The offset of the end of the last partition. */
+  uint64_t PartitionsEnd() const { return next_disk_offset_; }
+
   uint64_t DiskSize() const {
     return AlignToPowerOf2(next_disk_offset_ + sizeof(GptEnd), DISK_SIZE_SHIFT);
   }
@@ -290,9 +301,39 @@ Result<void> WriteEnd(SharedFD out, const GptEnd& end) {
  * support them.
  */
 Result<void> DeAndroidSparse(const std::vector<ImagePartition>& partitions) {
+  std::set<std::string> image_files;
   for (const auto& partition : partitions) {
-    CF_EXPECT(ForceRawImage(partition.image_file_path));
+    image_files.insert(partition.image_file_path);
+  }
+  TaskGraph conversions;
+  for (const std::string& image_file : image_files) {
+    conversions.Add("ForceRawImage " + image_file,
+                    [&image_file]() { return ForceRawImage(image_file); });
   }
+  CF_EXPECT(conversions.Run());
+  return {};
+}
+
+/*
+ * Copies the contents of a partition into place in the disk at `output_path`.
+ * Each copy has its own file descriptions, so that several can run at once.
+ * Padding up to the aligned size is left as a hole.
+ */
+Result<void> CopyPartition(const PartitionInfo& partition,
+                           const std::string& output_path) {
+  const std::string& input_path = partition.source.image_file_path;
+  SharedFD input = SharedFD::Open(input_path, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(input->IsOpen(), "Failed to open '{}': {}", input_path,
+             input->StrError());
+  SharedFD output = SharedFD::Open(output_path, O_WRONLY | O_CLOEXEC);
+  CF_EXPECTF(output->IsOpen(), "Failed to open '{}': {}", output_path,
+             output->StrError());
+
+  SharedFdIo input_io(input);
+  SharedFdIo output_io(output);
+  CF_EXPECT(output_io.SeekSet(partition.offset));
+  CF_EXPECTF(Copy(input_io, output_io, kCopyBufferSize),
+             "Could not copy from '{}' to '{}'", input_path, output_path);
   return {};
 }
 
@@ -330,24 +371,18 @@ Result<void> AggregateImage(const std::vector<ImagePartition>& partitions,
              "Could not write GPT beginning to '{}': {}", output_path,
              output->StrError());
 
+  TaskGraph copies;
   for (const auto& partition_info : builder.Partitions()) {
-    const auto& disk = partition_info.source;
-    SharedFD disk_fd = SharedFD::Open(disk.image_file_path, O_RDONLY);
-    CF_EXPECTF(disk_fd->IsOpen(), "{}", disk_fd->StrError());
-
-    auto file_size = FileSize(disk.image_file_path);
-    CF_EXPECTF(output->CopyFrom(*disk_fd, file_size),
-               "Could not copy from '{}' to '{}': {}", disk.image_file_path,
-               output_path, output->StrError());
-    // Handle disk images that are not aligned to PARTITION_SIZE_SHIFT
-    uint64_t padding = AlignToPartitionSize(file_size) - file_size;
-    std::string padding_str;
-    padding_str.resize(padding, '\0');
-
-    CF_EXPECTF(WriteAll(output, padding_str) == padding_str.size(),
-               "Could not write partition padding to '{}': {}", output_path,
-               output->StrError());
+    copies.Add("Copy " + partition_info.source.label,
+               [&partition_info, &output_path]() {
+                 return CopyPartition(partition_info, output_path);
+               });
   }
+  CF_EXPECT(copies.Run());
+
+  const off_t partitions_end = builder.PartitionsEnd();
+  CF_EXPECTF(output->LSeek(partitions_end, SEEK_SET) == partitions_end,
+             "Could not seek in '{}': {}", output_path, output->StrError());
   CF_EXPECTF(WriteEnd(output, builder.End(beginning)),
              "Could not write GPT end to '{}': {}", output_path,
              output->StrError());
@@ -18,16 +18,22 @@
 
 #include <fcntl.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
-#include "cuttlefish/common/libs/fs/shared_buf.h"
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/utils/cf_endian.h"
-#include "cuttlefish/process/command.h"
-#include "cuttlefish/process/managed_stdio.h"
+#include "cuttlefish/io/fake_seek.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/length.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/write_exact.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
@@ -48,43 +54,232 @@ struct __attribute__((packed)) QcowHeader {
   Be32 refcount_table_clusters;
   Be32 nb_snapshots;
   Be64 snapshots_offset;
+  // Version 3 only
+  Be64 incompatible_features;
+  Be64 compatible_features;
+  Be64 autoclear_features;
+  Be32 refcount_order;
+  Be32 header_length;
 };
 
-static_assert(sizeof(QcowHeader) == 72);
+static_assert(sizeof(QcowHeader) == 104);
+
+// Version 2 headers end at `incompatible_features`.
+constexpr uint32_t kV2HeaderSize = 72;
+
+// The parameters `crosvm create_qcow2` uses.
+constexpr uint32_t kCreateVersion = 3;
+constexpr uint32_t kCreateClusterBits = 16;
+constexpr uint32_t kCreateRefcountOrder = 4;
+
+// L1 and L2 table entries.
+constexpr uint64_t kTableOffsetMask = 0x00fffffffffffe00;
+constexpr uint64_t kCompressedFlag = 1ULL << 62;
+// L2 table entries in version 3.
+constexpr uint64_t kZeroFlag = 1;
+
+uint64_t DivRoundUp(uint64_t numerator, uint64_t denominator) {
+  return (numerator + denominator - 1) / denominator;
+}
+
+class Qcow2GuestView : public ReaderFakeSeeker {
+ public:
+  Qcow2GuestView(SharedFD overlay, const QcowHeader& header,
+                 std::vector<uint64_t> l1_table,
+                 std::unique_ptr<ReaderSeeker> backing, uint64_t backing_size)
+      : ReaderFakeSeeker(header.size.as_uint64_t()),
+        overlay_(std::move(overlay)),
+        cluster_bits_(header.cluster_bits.as_uint32_t()),
+        size_(header.size.as_uint64_t()),
+        l1_table_(std::move(l1_table)),
+        backing_(std::move(backing)),
+        backing_size_(backing_size) {}
+
+  Result<uint64_t> PRead(void* buf, uint64_t count,
+                         uint64_t offset) const override {
+    if (offset >= size_) {
+      return 0;
+    }
+    // Stay inside one cluster, which has a single location.
+    const uint64_t cluster_size = 1ULL << cluster_bits_;
+    const uint64_t in_cluster = offset & (cluster_size - 1);
+    count = std::min({count, cluster_size - in_cluster, size_ - offset});
+
+    const uint64_t l2_bits = cluster_bits_ - 3;
+    const uint64_t l1_index = offset >> (cluster_bits_ + l2_bits);
+    const uint64_t l2_index =
+        (offset >> cluster_bits_) & ((1ULL << l2_bits) - 1);
+    CF_EXPECT_LT(l1_index, l1_table_.size(), "L1 table too small");
+
+    const uint64_t l2_table = l1_table_[l1_index] & kTableOffsetMask;
+    uint64_t l2_entry = 0;
+    if (l2_table != 0) {
+      l2_entry = CF_EXPECT(PReadExactBinary<Be64>(
+                               overlay_, l2_table + l2_index * sizeof(Be64)))
+                     .as_uint64_t();
+    }
+    CF_EXPECT_EQ(l2_entry & kCompressedFlag, 0,
+                 "Compressed clusters are not supported");
+
+    if (l2_entry & kZeroFlag) {
+      memset(buf, 0, count);
+      return count;
+    }
+    if (const uint64_t data = l2_entry & kTableOffsetMask; data != 0) {
+      return CF_EXPECT(overlay_.PRead(buf, count, data + in_cluster));
+    }
+    if (backing_ && offset < backing_size_) {
+      count = std::min(count, backing_size_ - offset);
+      return CF_EXPECT(backing_->PRead(buf, count, offset));
+    }
+    memset(buf, 0, count);
+    return count;
+  }
+
+ private:
+  SharedFdIo overlay_;
+  uint64_t cluster_bits_;
+  uint64_t size_;
+  std::vector<uint64_t> l1_table_;
+  std::unique_ptr<ReaderSeeker> backing_;
+  uint64_t backing_size_;
+};
 
 }  // namespace
 
 struct Qcow2Image::Impl {
+  SharedFD fd_;
   QcowHeader header_;
+  std::string backing_file_;
+
+  Result<std::vector<uint64_t>> L1Table() const {
+    SharedFdIo io(fd_);
+    std::vector<Be64> table(header_.l1_size.as_uint32_t());
+    CF_EXPECT(PReadExact(io, reinterpret_cast<char*>(table.data()),
+                         table.size() * sizeof(Be64),
+                         header_.l1_table_offset.as_uint64_t()));
+    std::vector<uint64_t> ret;
+    ret.reserve(table.size());
+    for (const Be64& entry : table) {
+      ret.emplace_back(entry.as_uint64_t());
+    }
+    return ret;
+  }
 };
 
-Result<Qcow2Image> Qcow2Image::Create(const std::string& crosvm_path,
-                                      const std::string& backing_file,
+Result<Qcow2Image> Qcow2Image::Create(const std::string& backing_file,
+                                      const uint64_t virtual_size_bytes,
                                       std::string output_overlay_path) {
-  Command create_cmd = Command(crosvm_path)
-                           .AddParameter("create_qcow2")
-                           .AddParameter("--backing-file")
-                           .AddParameter(backing_file)
-                           .AddParameter(output_overlay_path);
+  const uint64_t cluster_size = 1ULL << kCreateClusterBits;
+  CF_EXPECTF(backing_file.size() <= cluster_size - sizeof(QcowHeader),
+             "Backing file path is too long: '{}'", backing_file);
+
+  // Same sizing as crosvm. The refcount table has room for the largest the
+  // file can grow to, so it never has to be moved.
+  const uint64_t l2_entries = cluster_size / sizeof(Be64);
+  const uint64_t data_clusters = DivRoundUp(virtual_size_bytes, cluster_size);
+  const uint64_t l2_clusters = DivRoundUp(data_clusters, l2_entries);
+  const uint64_t l1_clusters =
+      DivRoundUp(l2_clusters * sizeof(Be64), cluster_size);
+  const uint64_t refcount_bytes = (1 << kCreateRefcountOrder) / 8;
+  const uint64_t max_clusters = data_clusters + l2_clusters + l1_clusters + 1;
+  const uint64_t refcount_blocks_for_data =
+      DivRoundUp(max_clusters * refcount_bytes, cluster_size);
+  const uint64_t refcount_blocks =
+      refcount_blocks_for_data +
+      DivRoundUp(refcount_blocks_for_data * refcount_bytes, cluster_size);
+  const uint64_t refcount_table_clusters =
+      DivRoundUp(refcount_blocks * sizeof(Be64), cluster_size);
+
+  // Header cluster, then the L1 table, the refcount table and the first
+  // refcount block.
+  const uint64_t l1_table_offset = cluster_size;
+  const uint64_t refcount_table_offset = (1 + l1_clusters) * cluster_size;
+  const uint64_t refcount_block_offset =
+      refcount_table_offset + refcount_table_clusters * cluster_size;
+  const uint64_t metadata_clusters = refcount_block_offset / cluster_size + 1;
+  CF_EXPECT_LE(metadata_clusters, cluster_size / refcount_bytes,
+               "Disk too large: " << virtual_size_bytes);
+
+  QcowHeader header{};
+  memcpy(&header.magic, MagicString().data(), sizeof(header.magic));
+  header.version = Be32(kCreateVersion);
+  header.backing_file_offset = Be64(backing_file.empty() ? 0 : sizeof(header));
+  header.backing_file_size = Be32(backing_file.size());
+  header.cluster_bits = Be32(kCreateClusterBits);
+  header.size = Be64(virtual_size_bytes);
+  header.crypt_method = Be32(0);
+  header.l1_size = Be32(l2_clusters);
+  header.l1_table_offset = Be64(l1_table_offset);
+  header.refcount_table_offset = Be64(refcount_table_offset);
+  header.refcount_table_clusters = Be32(refcount_table_clusters);
+  header.nb_snapshots = Be32(0);
+  header.snapshots_offset = Be64(0);
+  header.incompatible_features = Be64(0);
+  header.compatible_features = Be64(0);
+  header.autoclear_features = Be64(0);
+  header.refcount_order = Be32(kCreateRefcountOrder);
+  header.header_length = Be32(sizeof(header));
 
-  CF_EXPECT(RunAndCaptureStdout(std::move(create_cmd)));
+  SharedFD fd =
+      SharedFD::Open(output_overlay_path,
+                     O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+  CF_EXPECTF(fd->IsOpen(), "Failed to create '{}': {}", output_overlay_path,
+             fd->StrError());
+  SharedFdIo io(fd);
+
+  // Tables are all zeroes except for the metadata clusters' refcounts, so
+  // the rest of the file is left sparse.
+  CF_EXPECT(io.Truncate(refcount_block_offset + cluster_size));
+  CF_EXPECT(WriteExactBinary(io, header));
+  CF_EXPECT(WriteExact(io, backing_file.data(), backing_file.size()));
+
+  CF_EXPECT(io.SeekSet(refcount_table_offset));
+  CF_EXPECT(WriteExactBinary(io, Be64(refcount_block_offset)));
+
+  const std::vector<Be16> refcounts(metadata_clusters, Be16(1));
+  CF_EXPECT(io.SeekSet(refcount_block_offset));
+  CF_EXPECT(WriteExact(io, reinterpret_cast<const char*>(refcounts.data()),
+                       refcounts.size() * sizeof(Be16)));
 
   return CF_EXPECT(OpenExisting(std::move(output_overlay_path)));
 }
 
 Result<Qcow2Image> Qcow2Image::OpenExisting(std::string path) {
-  SharedFD fd = SharedFD::Open(path, O_CLOEXEC, O_RDONLY);
-  CF_EXPECT(fd->IsOpen(), fd->StrError());
+  SharedFD fd = SharedFD::Open(path, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", path, fd->StrError());
+  SharedFdIo io(fd);
 
   std::unique_ptr<Impl> impl(new Impl());
   CF_EXPECT(impl.get());
+  impl->fd_ = fd;
 
-  CF_EXPECT_EQ(ReadExactBinary(fd, &impl->header_), sizeof(QcowHeader));
+  QcowHeader& header = impl->header_;
+  CF_EXPECT(PReadExact(io, reinterpret_cast<char*>(&header), kV2HeaderSize, 0));
 
-  std::string magic(reinterpret_cast<char*>(&impl->header_),
-                    MagicString().size());
+  std::string magic(reinterpret_cast<char*>(&header), MagicString().size());
   CF_EXPECT_EQ(magic, MagicString());
 
+  const uint32_t version = header.version.as_uint32_t();
+  CF_EXPECT(version == 2 || version == 3, "Unknown qcow2 version " << version);
+  if (version == 3) {
+    CF_EXPECT(PReadExact(io, reinterpret_cast<char*>(&header) + kV2HeaderSize,
+                         sizeof(header) - kV2HeaderSize, kV2HeaderSize));
+  } else {
+    header.refcount_order = Be32(4);
+    header.header_length = Be32(kV2HeaderSize);
+  }
+  const uint32_t cluster_bits = header.cluster_bits.as_uint32_t();
+  CF_EXPECT(cluster_bits >= 9 && cluster_bits <= 21,
+            "Invalid cluster_bits " << cluster_bits);
+
+  if (header.backing_file_offset.as_uint64_t() != 0) {
+    impl->backing_file_.resize(header.backing_file_size.as_uint32_t());
+    CF_EXPECT(PReadExact(io, impl->backing_file_.data(),
+                         impl->backing_file_.size(),
+                         header.backing_file_offset.as_uint64_t()));
+  }
+
   return Qcow2Image(std::move(impl));
 }
 
@@ -103,6 +298,47 @@ Result<uint64_t> Qcow2Image::VirtualSizeBytes() const {
   return impl_->header_.size.as_uint64_t();
 }
 
+const std::string& Qcow2Image::BackingFile() const {
+  return impl_->backing_file_;
+}
+
+Result<uint64_t> Qcow2Image::AllocatedClusters() const {
+  CF_EXPECT(impl_.get());
+
+  SharedFdIo io(impl_->fd_);
+  const uint64_t cluster_size = 1ULL
+                                << impl_->header_.cluster_bits.as_uint32_t();
+  std::vector<Be64> l2_table(cluster_size / sizeof(Be64));
+  uint64_t allocated = 0;
+  for (const uint64_t l1_entry : CF_EXPECT(impl_->L1Table())) {
+    const uint64_t l2_offset = l1_entry & kTableOffsetMask;
+    if (l2_offset == 0) {
+      continue;
+    }
+    CF_EXPECT(PReadExact(io, reinterpret_cast<char*>(l2_table.data()),
+                         cluster_size, l2_offset));
+    for (const Be64& l2_entry : l2_table) {
+      const uint64_t entry = l2_entry.as_uint64_t();
+      if ((entry & kTableOffsetMask) != 0 || (entry & kZeroFlag) != 0) {
+        allocated++;
+      }
+    }
+  }
+  return allocated;
+}
+
+Result<std::unique_ptr<ReaderSeeker>> Qcow2Image::GuestView(
+    std::unique_ptr<ReaderSeeker> backing) const {
+  CF_EXPECT(impl_.get());
+  CF_EXPECT_EQ(impl_->header_.crypt_method.as_uint32_t(), 0,
+               "Encrypted images are not supported");
+
+  const uint64_t backing_size = backing ? CF_EXPECT(Length(*backing)) : 0;
+  return std::make_unique<Qcow2GuestView>(impl_->fd_, impl_->header_,
+                                          CF_EXPECT(impl_->L1Table()),
+                                          std::move(backing), backing_size);
+}
+
 Qcow2Image::Qcow2Image(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
 
 }  // namespace cuttlefish
@@ -21,6 +21,7 @@
 #include <string>
 
 #include "cuttlefish/host/libs/image_aggregator/disk_image.h"
+#include "cuttlefish/io/io.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
@@ -37,12 +38,16 @@ class Qcow2Image : public DiskImage {
   /**
    * Generate a qcow overlay backed by a given implementation file.
    *
-   * The crosvm binary at `crosvm_path` is used to generate an overlay file at
-   * `output_overlay_path` that functions as an overlay on the file at
-   * `backing_file`.
+   * Writes an overlay file at `output_overlay_path` that presents
+   * `virtual_size_bytes` of disk, all of which reads through to the file at
+   * `backing_file` until the guest writes to it. This is normally the virtual
+   * size of the backing file. Uses the same version, cluster size and refcount
+   * width as `crosvm create_qcow2`, but is not byte for byte identical to its
+   * output: the backing file name directly follows the header, with no header
+   * extensions.
    */
-  static Result<Qcow2Image> Create(const std::string& crosvm_path,
-                                   const std::string& backing_file,
+  static Result<Qcow2Image> Create(const std::string& backing_file,
+                                   uint64_t virtual_size_bytes,
                                    std::string output_overlay_path);
   static Result<Qcow2Image> OpenExisting(std::string path);
 
@@ -60,6 +65,26 @@ class Qcow2Image : public DiskImage {
 
   Result<uint64_t> VirtualSizeBytes() const override;
 
+  /** The path of the backing file, or empty if there isn't one. */
+  const std::string& BackingFile() const;
+
+  /**
+   * The number of guest clusters stored in the overlay, which hide the
+   * corresponding data in the backing file.
+   */
+  Result<uint64_t> AllocatedClusters() const;
+
+  /**
+   * The disk contents as seen by the guest.
+   *
+   * Clusters the overlay doesn't store are read from `backing`, which should
+   * present the guest-visible contents of `BackingFile()`. Without `backing`,
+   * or past its end, they read as zeroes. Compressed clusters are not
+   * supported.
+   */
+  Result<std::unique_ptr<ReaderSeeker>> GuestView(
+      std::unique_ptr<ReaderSeeker> backing) const;
+
  private:
   struct Impl;
 
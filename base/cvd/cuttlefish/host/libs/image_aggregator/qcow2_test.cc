@@ -0,0 +1,200 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/image_aggregator/qcow2.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/utils/cf_endian.h"
+#include "cuttlefish/io/in_memory.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/string.h"
+#include "cuttlefish/io/write_exact.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint64_t kClusterSize = 1 << 16;
+constexpr uint64_t kUsedFlag = 1ULL << 63;
+
+std::string TempPath() {
+  const char* tmpdir = getenv("TEST_TMPDIR");
+  std::string path = std::string(tmpdir ? tmpdir : "/tmp") + "/qcow2_XXXXXX";
+  const int fd = mkstemp(path.data());
+  EXPECT_GE(fd, 0);
+  close(fd);
+  return path;
+}
+
+uint64_t ReadBe32(const ReaderSeeker& reader, uint64_t offset) {
+  Result<Be32> value = PReadExactBinary<Be32>(reader, offset);
+  EXPECT_THAT(value, IsOk());
+  return value.has_value() ? value->as_uint32_t() : 0;
+}
+
+uint64_t ReadBe64(const ReaderSeeker& reader, uint64_t offset) {
+  Result<Be64> value = PReadExactBinary<Be64>(reader, offset);
+  EXPECT_THAT(value, IsOk());
+  return value.has_value() ? value->as_uint64_t() : 0;
+}
+
+// Stands in for a guest write through crosvm, by editing the tables directly.
+void WriteBe64(const std::string& path, uint64_t offset, uint64_t value) {
+  SharedFdIo io(SharedFD::Open(path, O_RDWR));
+  ASSERT_THAT(io.SeekSet(offset), IsOk());
+  ASSERT_THAT(WriteExactBinary(io, Be64(value)), IsOk());
+}
+
+// The header, L1 table, refcount table and refcount block of a new overlay,
+// for any virtual size under 32 TiB.
+constexpr uint64_t kNewOverlaySize = 4 * kClusterSize;
+
+TEST(Qcow2ImageTest, CreateMatchesCrosvmLayout) {
+  const std::string path = TempPath();
+  const std::string backing = "/path/to/composite.img";
+  const uint64_t size = 10ULL << 30;
+
+  ASSERT_THAT(Qcow2Image::Create(backing, size, path), IsOk());
+
+  // The header `crosvm create_qcow2 --backing-file` writes for a 10 GiB
+  // backing file.
+  SharedFdIo io(SharedFD::Open(path, O_RDONLY));
+  EXPECT_EQ(ReadBe32(io, 0), 0x514649fb);         // magic
+  EXPECT_EQ(ReadBe32(io, 4), 3);                  // version
+  EXPECT_EQ(ReadBe64(io, 8), 104);                // backing_file_offset
+  EXPECT_EQ(ReadBe32(io, 16), backing.size());    // backing_file_size
+  EXPECT_EQ(ReadBe32(io, 20), 16);                // cluster_bits
+  EXPECT_EQ(ReadBe64(io, 24), size);              // size
+  EXPECT_EQ(ReadBe32(io, 32), 0);                 // crypt_method
+  EXPECT_EQ(ReadBe32(io, 36), 20);                // l1_size
+  EXPECT_EQ(ReadBe64(io, 40), kClusterSize);      // l1_table_offset
+  EXPECT_EQ(ReadBe64(io, 48), 2 * kClusterSize);  // refcount_table_offset
+  EXPECT_EQ(ReadBe32(io, 56), 1);                 // refcount_table_clusters
+  EXPECT_EQ(ReadBe32(io, 60), 0);                 // nb_snapshots
+  EXPECT_EQ(ReadBe64(io, 64), 0);                 // snapshots_offset
+  EXPECT_EQ(ReadBe64(io, 72), 0);                 // incompatible_features
+  EXPECT_EQ(ReadBe64(io, 80), 0);                 // compatible_features
+  EXPECT_EQ(ReadBe64(io, 88), 0);                 // autoclear_features
+  EXPECT_EQ(ReadBe32(io, 96), 4);                 // refcount_order
+  EXPECT_EQ(ReadBe32(io, 100), 104);              // header_length
+
+  std::string name(backing.size(), '\0');
+  ASSERT_THAT(PReadExact(io, name.data(), name.size(), 104), IsOk());
+  EXPECT_EQ(name, backing);
+
+  EXPECT_EQ(ReadBe64(io, 2 * kClusterSize), 3 * kClusterSize);
+  Result<Be16> refcount = PReadExactBinary<Be16>(io, 3 * kClusterSize);
+  ASSERT_THAT(refcount, IsOk());
+  EXPECT_EQ(refcount->as_uint16_t(), 1);
+  EXPECT_THAT(io.SeekEnd(0), IsOkAndValue(kNewOverlaySize));
+}
+
+TEST(Qcow2ImageTest, OpenExisting) {
+  const std::string path = TempPath();
+  const uint64_t size = 3 * kClusterSize + 100;
+  ASSERT_THAT(Qcow2Image::Create("backing.img", size, path), IsOk());
+
+  Result<Qcow2Image> image = Qcow2Image::OpenExisting(path);
+  ASSERT_THAT(image, IsOk());
+  EXPECT_THAT(image->VirtualSizeBytes(), IsOkAndValue(size));
+  EXPECT_EQ(image->BackingFile(), "backing.img");
+  EXPECT_THAT(image->AllocatedClusters(), IsOkAndValue(0));
+}
+
+TEST(Qcow2ImageTest, GuestViewReadsThroughToBacking) {
+  const std::string path = TempPath();
+  const uint64_t size = 3 * kClusterSize + 100;
+  Result<Qcow2Image> image = Qcow2Image::Create("backing.img", size, path);
+  ASSERT_THAT(image, IsOk());
+
+  const std::string backing(2 * kClusterSize + 10, 'b');
+  Result<std::unique_ptr<ReaderSeeker>> view =
+      image->GuestView(InMemoryIo(backing));
+  ASSERT_THAT(view, IsOk());
+
+  std::string expected = backing;
+  expected.resize(size, '\0');
+  EXPECT_THAT(ReadToString(**view), IsOkAndValue(expected));
+}
+
+TEST(Qcow2ImageTest, GuestViewReadsAllocatedClusters) {
+  const std::string path = TempPath();
+  const uint64_t size = 4 * kClusterSize;
+  ASSERT_THAT(Qcow2Image::Create("backing.img", size, path), IsOk());
+
+  // Cluster 1 is stored in the overlay and cluster 2 reads as zeroes.
+  const uint64_t l2_table = kNewOverlaySize;
+  const uint64_t data = l2_table + kClusterSize;
+  WriteBe64(path, kClusterSize, l2_table | kUsedFlag);
+  WriteBe64(path, l2_table + 8, data | kUsedFlag);
+  WriteBe64(path, l2_table + 16, 1);
+  {
+    SharedFdIo io(SharedFD::Open(path, O_RDWR));
+    ASSERT_THAT(io.SeekSet(data), IsOk());
+    const std::string overlay_data(kClusterSize, 'o');
+    ASSERT_THAT(WriteExact(io, overlay_data.data(), overlay_data.size()),
+                IsOk());
+  }
+
+  Result<Qcow2Image> image = Qcow2Image::OpenExisting(path);
+  ASSERT_THAT(image, IsOk());
+  EXPECT_THAT(image->AllocatedClusters(), IsOkAndValue(2));
+
+  const std::string backing(size, 'b');
+  Result<std::unique_ptr<ReaderSeeker>> view =
+      image->GuestView(InMemoryIo(backing));
+  ASSERT_THAT(view, IsOk());
+
+  const std::string expected = std::string(kClusterSize, 'b') +
+                               std::string(kClusterSize, 'o') +
+                               std::string(kClusterSize, '\0') +
+                               std::string(kClusterSize, 'b');
+  EXPECT_THAT(ReadToString(**view), IsOkAndValue(expected));
+}
+
+TEST(Qcow2ImageTest, GuestViewRejectsCompressedClusters) {
+  const std::string path = TempPath();
+  ASSERT_THAT(Qcow2Image::Create("", kClusterSize, path), IsOk());
+
+  const uint64_t l2_table = kNewOverlaySize;
+  WriteBe64(path, kClusterSize, l2_table | kUsedFlag);
+  WriteBe64(path, l2_table, (1ULL << 62) | (l2_table + kClusterSize));
+
+  Result<Qcow2Image> image = Qcow2Image::OpenExisting(path);
+  ASSERT_THAT(image, IsOk());
+  EXPECT_EQ(image->BackingFile(), "");
+  Result<std::unique_ptr<ReaderSeeker>> view = image->GuestView(nullptr);
+  ASSERT_THAT(view, IsOk());
+
+  char buf[16];
+  EXPECT_THAT((*view)->PRead(buf, sizeof(buf), 0), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
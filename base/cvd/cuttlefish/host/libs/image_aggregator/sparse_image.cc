@@ -17,6 +17,7 @@
 #include "cuttlefish/host/libs/image_aggregator/sparse_image.h"
 
 #include <fcntl.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <sys/file.h>
 
@@ -31,10 +32,12 @@
 #include "sparse/sparse.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
-#include "cuttlefish/host/libs/config/known_paths.h"
+#include "cuttlefish/io/android_sparse.h"
+#include "cuttlefish/io/copy.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/shared_fd.h"
 #include "cuttlefish/posix/realpath.h"
 #include "cuttlefish/posix/rename.h"
-#include "cuttlefish/process/execute.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
@@ -42,6 +45,10 @@ namespace {
 
 constexpr std::string_view kAndroidSparseImageMagic = "\x3A\xFF\x26\xED";
 
+// Several images are expanded at once, one per thread, so each conversion
+// gets a small buffer rather than the `SparseCopy` default.
+constexpr size_t kExpandBufferSize = 1 << 20;
+
 Result<SharedFD> AcquireLockForImage(const std::string& image_path) {
   std::string image_realpath = CF_EXPECT(RealPath(image_path));
   std::string tmp_lock_image_path = image_realpath + ".lock";
@@ -80,14 +87,28 @@ Result<void> ForceRawImage(const std::string& image_path) {
     return {};
   }
 
-  std::string tmp_raw_image_path = image_path + ".raw";
-  // Use simg2img to convert sparse image to raw images.
-  int simg2img_status =
-      Execute({Simg2ImgBinary(), image_path, tmp_raw_image_path});
+  CF_EXPECT(ExpandSparseImage(image_path));
 
-  CF_EXPECT_EQ(simg2img_status, 0,
-               "Unable to convert Android sparse image '"
-                   << image_path << "' to raw image: " << simg2img_status);
+  return {};
+}
+
+Result<void> ExpandSparseImage(const std::string& image_path) {
+  SharedFD sparse_fd = SharedFD::Open(image_path, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(sparse_fd->IsOpen(), "Failed to open '{}': '{}'", image_path,
+             sparse_fd->StrError());
+  std::unique_ptr<ReaderSeeker> expanded =
+      CF_EXPECT(AndroidSparseReader(std::make_unique<SharedFdIo>(sparse_fd)),
+                "Unable to parse Android sparse image '" << image_path << "'");
+
+  std::string tmp_raw_image_path = image_path + ".raw";
+  SharedFD raw_fd = SharedFD::Open(
+      tmp_raw_image_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0664);
+  CF_EXPECTF(raw_fd->IsOpen(), "Failed to open '{}': '{}'", tmp_raw_image_path,
+             raw_fd->StrError());
+  SharedFdIo raw(raw_fd);
+  CF_EXPECTF(SparseCopy(*expanded, raw, kExpandBufferSize),
+             "Unable to convert Android sparse image '{}' to raw image",
+             image_path);
 
   // Replace the original sparse image with the raw image.
   // `rename` can fail if these are on different mounts, but they are files
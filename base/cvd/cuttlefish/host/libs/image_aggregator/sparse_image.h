@@ -28,6 +28,12 @@ namespace cuttlefish {
 
 Result<void> ForceRawImage(const std::string& image_path);
 Result<bool> IsSparseImage(const std::string& image_path);
+/** Replaces the Android sparse image at `image_path` with its raw contents.
+ *
+ * The image is decoded in-process. "Don't care" chunks and zero-filled blocks
+ * are left as holes in the output. Unlike `ForceRawImage`, this does not
+ * check the file type or take a lock on the image. */
+Result<void> ExpandSparseImage(const std::string& image_path);
 
 /** Image file format comprised of a list of chunks of "raw data" and "fill
  * data" that is a repeated byte string.  */
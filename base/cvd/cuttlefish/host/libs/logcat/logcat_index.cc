@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/logcat/logcat_index.h"
+
+#include <endian.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+#include "cuttlefish/common/libs/fs/shared_buf.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/files/file_exists.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/string.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+namespace {
+
+// Parses exactly `count` digits, and checks the value is at most `max`.
+std::optional<uint64_t> ConsumeNumber(std::string_view& text, size_t count,
+                                      uint64_t max) {
+  if (text.size() < count) {
+    return std::nullopt;
+  }
+  uint64_t value = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (text[i] < '0' || text[i] > '9') {
+      return std::nullopt;
+    }
+    value = value * 10 + (text[i] - '0');
+  }
+  if (value > max) {
+    return std::nullopt;
+  }
+  text.remove_prefix(count);
+  return value;
+}
+
+bool ConsumeChar(std::string_view& text, char c) {
+  if (text.empty() || text.front() != c) {
+    return false;
+  }
+  text.remove_prefix(1);
+  return true;
+}
+
+struct IndexRecord {
+  uint64_t timestamp_le;
+  uint64_t offset_le;
+};
+static_assert(sizeof(IndexRecord) == 16);
+
+}  // namespace
+
+std::optional<uint64_t> ParseLogcatTimestamp(std::string_view text) {
+  std::optional<uint64_t> month = ConsumeNumber(text, 2, 12);
+  if (!month || *month == 0 || !ConsumeChar(text, '-')) {
+    return std::nullopt;
+  }
+  std::optional<uint64_t> day = ConsumeNumber(text, 2, 31);
+  if (!day || *day == 0 || !ConsumeChar(text, ' ')) {
+    return std::nullopt;
+  }
+  std::optional<uint64_t> hour = ConsumeNumber(text, 2, 23);
+  if (!hour || !ConsumeChar(text, ':')) {
+    return std::nullopt;
+  }
+  std::optional<uint64_t> minute = ConsumeNumber(text, 2, 59);
+  if (!minute || !ConsumeChar(text, ':')) {
+    return std::nullopt;
+  }
+  std::optional<uint64_t> second = ConsumeNumber(text, 2, 60);
+  if (!second) {
+    return std::nullopt;
+  }
+  uint64_t millis = 0;
+  if (ConsumeChar(text, '.')) {
+    std::optional<uint64_t> fraction = ConsumeNumber(text, 3, 999);
+    if (!fraction) {
+      return std::nullopt;
+    }
+    millis = *fraction;
+  }
+  // Months are counted as 31 days. That leaves gaps in the keys, but keeps
+  // them in order without knowing the year.
+  const uint64_t days = (*month - 1) * 31 + (*day - 1);
+  const uint64_t seconds = ((days * 24 + *hour) * 60 + *minute) * 60 + *second;
+  return seconds * 1000 + millis;
+}
+
+std::string LogcatIndexPath(std::string_view segment_path) {
+  return absl::StrCat(segment_path, ".idx");
+}
+
+Result<void> AppendLogcatIndexEntry(SharedFD index,
+                                    const LogcatIndexEntry& entry) {
+  const IndexRecord record = {
+      .timestamp_le = htole64(entry.timestamp),
+      .offset_le = htole64(entry.offset),
+  };
+  CF_EXPECTF(WriteAllBinary(index, &record) == sizeof(record),
+             "Failed to write logcat index: {}", index->StrError());
+  return {};
+}
+
+Result<std::vector<LogcatIndexEntry>> ReadLogcatIndex(const std::string& path) {
+  if (!FileExists(path)) {
+    return {};
+  }
+  SharedFD fd = SharedFD::Open(path, O_RDONLY);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", path, fd->StrError());
+  SharedFdIo io(fd);
+  const std::string contents = CF_EXPECT(ReadToString(io));
+
+  std::vector<LogcatIndexEntry> entries;
+  entries.reserve(contents.size() / sizeof(IndexRecord));
+  for (size_t pos = 0; pos + sizeof(IndexRecord) <= contents.size();
+       pos += sizeof(IndexRecord)) {
+    IndexRecord record;
+    memcpy(&record, contents.data() + pos, sizeof(record));
+    entries.push_back(LogcatIndexEntry{
+        .timestamp = le64toh(record.timestamp_le),
+        .offset = le64toh(record.offset_le),
+    });
+  }
+  return entries;
+}
+
+Result<void> TruncateLogcatIndex(const std::string& path,
+                                 uint64_t segment_size) {
+  const std::vector<LogcatIndexEntry> index = CF_EXPECT(ReadLogcatIndex(path));
+  const size_t kept = std::count_if(
+      index.begin(), index.end(), [segment_size](const LogcatIndexEntry& entry) {
+        return entry.offset < segment_size;
+      });
+  if (kept == index.size()) {
+    return {};
+  }
+  SharedFD fd = SharedFD::Open(path, O_WRONLY);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", path, fd->StrError());
+  CF_EXPECT(fd->Truncate(kept * sizeof(IndexRecord)));
+  return {};
+}
+
+uint64_t LogcatIndexSeek(const std::vector<LogcatIndexEntry>& index,
+                         uint64_t since) {
+  const uint64_t target =
+      since > kLogcatIndexSlackMs ? since - kLogcatIndexSlackMs : 0;
+  // The entry after the last one stamped before `target` may already hold
+  // lines at `target`, so start from that last one.
+  auto after = std::lower_bound(
+      index.begin(), index.end(), target,
+      [](const LogcatIndexEntry& entry, uint64_t value) {
+        return entry.timestamp < value;
+      });
+  if (after == index.begin()) {
+    return 0;
+  }
+  return std::prev(after)->offset;
+}
+
+}  // namespace cuttlefish
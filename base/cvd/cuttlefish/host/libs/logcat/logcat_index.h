@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+
+// Converts the "MM-DD hh:mm:ss[.fff]" timestamp at the start of a logcat line
+// to a key that sorts in time order. Logcat doesn't print the year, so keys
+// wrap around at new year. Digits beyond milliseconds are ignored.
+std::optional<uint64_t> ParseLogcatTimestamp(std::string_view text);
+
+// A sparse index point, recorded every few tens of KiB of a segment.
+struct LogcatIndexEntry {
+  // The timestamp key of the line, from ParseLogcatTimestamp.
+  uint64_t timestamp;
+  // Where the line starts in the uncompressed segment.
+  uint64_t offset;
+};
+
+// The index is kept next to the segment, and renamed along with it.
+std::string LogcatIndexPath(std::string_view segment_path);
+
+Result<void> AppendLogcatIndexEntry(SharedFD index, const LogcatIndexEntry&);
+
+// Drops the entries for lines at or past `segment_size`, for when the end of
+// the segment is cut off.
+Result<void> TruncateLogcatIndex(const std::string& path,
+                                 uint64_t segment_size);
+
+// A missing index reads as empty. A partially written last entry is ignored.
+Result<std::vector<LogcatIndexEntry>> ReadLogcatIndex(const std::string& path);
+
+// Returns where to start reading so that no line stamped at or after `since`
+// is skipped. Logcat merges its buffers in close to time order, so lines up to
+// kLogcatIndexSlackMs out of order are still found.
+uint64_t LogcatIndexSeek(const std::vector<LogcatIndexEntry>& index,
+                         uint64_t since);
+
+inline constexpr uint64_t kLogcatIndexSlackMs = 1000;
+
+}  // namespace cuttlefish
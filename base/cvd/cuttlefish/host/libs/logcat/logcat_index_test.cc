@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/logcat/logcat_index.h"
+
+#include <stdint.h>
+
+#include <optional>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cuttlefish {
+namespace {
+
+TEST(ParseLogcatTimestampTest, ParsesThreadtimeFormat) {
+  EXPECT_EQ(ParseLogcatTimestamp("01-01 00:00:01.234  123  456 I tag: hi"),
+            1234);
+  EXPECT_EQ(ParseLogcatTimestamp("01-02 00:00:00.000"), 24 * 3600 * 1000);
+  EXPECT_EQ(ParseLogcatTimestamp("01-01 01:02:03"),
+            ((1 * 60 + 2) * 60 + 3) * 1000);
+  // logcat -v usec
+  EXPECT_EQ(ParseLogcatTimestamp("01-01 00:00:00.123456 I tag: hi"), 123);
+}
+
+TEST(ParseLogcatTimestampTest, RejectsOtherLines) {
+  EXPECT_EQ(ParseLogcatTimestamp("--------- beginning of main"), std::nullopt);
+  EXPECT_EQ(ParseLogcatTimestamp(""), std::nullopt);
+  EXPECT_EQ(ParseLogcatTimestamp("01-01 00:00"), std::nullopt);
+  EXPECT_EQ(ParseLogcatTimestamp("13-01 00:00:00.000"), std::nullopt);
+  EXPECT_EQ(ParseLogcatTimestamp("00-01 00:00:00.000"), std::nullopt);
+  EXPECT_EQ(ParseLogcatTimestamp("01-01 24:00:00.000"), std::nullopt);
+  EXPECT_EQ(ParseLogcatTimestamp("01-01 00:00:00.1"), std::nullopt);
+  EXPECT_EQ(ParseLogcatTimestamp(" 01-01 00:00:00.000"), std::nullopt);
+}
+
+TEST(ParseLogcatTimestampTest, OrderedAcrossMonths) {
+  EXPECT_LT(ParseLogcatTimestamp("01-31 23:59:59.999"),
+            ParseLogcatTimestamp("02-01 00:00:00.000"));
+  EXPECT_LT(ParseLogcatTimestamp("02-29 23:59:59.999"),
+            ParseLogcatTimestamp("03-01 00:00:00.000"));
+}
+
+TEST(LogcatIndexSeekTest, StartsBeforeSlack) {
+  const std::vector<LogcatIndexEntry> index = {
+      {.timestamp = 10000, .offset = 0},
+      {.timestamp = 20000, .offset = 100},
+      {.timestamp = 30000, .offset = 200},
+      {.timestamp = 40000, .offset = 300},
+  };
+
+  EXPECT_EQ(LogcatIndexSeek(index, 0), 0);
+  EXPECT_EQ(LogcatIndexSeek(index, 10000), 0);
+  EXPECT_EQ(LogcatIndexSeek(index, 25000), 100);
+  // Lines up to a second out of order may precede the entry at 30000.
+  EXPECT_EQ(LogcatIndexSeek(index, 30500), 100);
+  EXPECT_EQ(LogcatIndexSeek(index, 31000 + kLogcatIndexSlackMs), 200);
+  EXPECT_EQ(LogcatIndexSeek(index, 100000), 300);
+  EXPECT_EQ(LogcatIndexSeek({}, 100000), 0);
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/logcat/logcat_segments.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "android-base/file.h"
+
+#include "cuttlefish/common/libs/fs/scoped_mmap.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/files/directory_contents.h"
+#include "cuttlefish/files/file_exists.h"
+#include "cuttlefish/host/libs/logcat/logcat_index.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/lz4_legacy.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/write_exact.h"
+#include "cuttlefish/posix/remove.h"
+#include "cuttlefish/posix/rename.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr size_t kTransferSize = 1 << 16;
+// Enough to find the start of the next line and read its timestamp.
+constexpr size_t kIndexWindowSize = 512;
+// "MM-DD hh:mm:ss.fff"
+constexpr size_t kTimestampSize = 18;
+
+bool IsSequence(std::string_view text) {
+  return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) {
+    return c >= '0' && c <= '9';
+  });
+}
+
+Result<void> RenameIndex(const std::string& from, const std::string& to) {
+  const std::string index = LogcatIndexPath(from);
+  if (FileExists(index)) {
+    CF_EXPECT(Rename(index, LogcatIndexPath(to)));
+  }
+  return {};
+}
+
+Result<void> RemoveSegment(const std::string& path) {
+  CF_EXPECT(RemoveFile(path));
+  const std::string index = LogcatIndexPath(path);
+  if (FileExists(index)) {
+    CF_EXPECT(RemoveFile(index));
+  }
+  return {};
+}
+
+Result<void> CompressSegment(const std::string& path) {
+  if (!FileExists(path)) {
+    return {};  // Already deleted for being too old.
+  }
+  SharedFD in = SharedFD::Open(path, O_RDONLY);
+  CF_EXPECTF(in->IsOpen(), "Failed to open '{}': {}", path, in->StrError());
+  const uint64_t size = CF_EXPECT(in->SeekEnd(0));
+
+  const std::string compressed_path = absl::StrCat(path, ".lz4");
+  const std::string temporary_path = absl::StrCat(compressed_path, ".tmp");
+  SharedFD out =
+      SharedFD::Open(temporary_path, O_CREAT | O_TRUNC | O_WRONLY, 0666);
+  CF_EXPECTF(out->IsOpen(), "Failed to open '{}': {}", temporary_path,
+             out->StrError());
+  std::unique_ptr<Writer> writer =
+      CF_EXPECT(Lz4LegacyWriter(std::make_unique<SharedFdIo>(out)));
+  if (size > 0) {
+    ScopedMMap contents = in->MMap(nullptr, size, PROT_READ, MAP_PRIVATE, 0);
+    CF_EXPECTF(static_cast<bool>(contents), "Failed to map '{}': {}", path,
+               in->StrError());
+    // A single call, as the writer ends the frame on the first short block.
+    CF_EXPECT(
+        WriteExact(*writer, static_cast<const char*>(contents.get()), size));
+  }
+
+  // The uncompressed segment stays in place until its replacement is complete.
+  CF_EXPECT(Rename(temporary_path, compressed_path));
+  CF_EXPECT(RenameIndex(path, compressed_path));
+  CF_EXPECT(RemoveFile(path));
+  return {};
+}
+
+Result<void> DeleteOldSegments(const std::string& live_path,
+                               size_t max_rotated_segments) {
+  std::vector<LogcatSegment> segments =
+      CF_EXPECT(ListLogcatSegments(live_path));
+  segments.pop_back();  // The live segment
+  for (size_t i = 0; i + max_rotated_segments < segments.size(); i++) {
+    CF_EXPECT(RemoveSegment(segments[i].path));
+  }
+  return {};
+}
+
+// Returns nullptr if the segment was deleted after it was listed.
+Result<std::unique_ptr<Reader>> OpenSegment(const LogcatSegment& segment,
+                                            uint64_t offset) {
+  if (!FileExists(segment.path)) {
+    if (segment.compressed) {
+      return nullptr;
+    }
+    // It may have been compressed after it was listed.
+    const LogcatSegment compressed = {
+        .path = absl::StrCat(segment.path, ".lz4"),
+        .sequence = segment.sequence,
+        .compressed = true,
+    };
+    return CF_EXPECT(OpenSegment(compressed, offset));
+  }
+  SharedFD fd = SharedFD::Open(segment.path, O_RDONLY);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", segment.path,
+             fd->StrError());
+  std::unique_ptr<SharedFdIo> io = std::make_unique<SharedFdIo>(fd);
+  if (segment.compressed) {
+    return CF_EXPECT(Lz4LegacyReaderAt(std::move(io), offset));
+  }
+  CF_EXPECT(io->SeekSet(offset));
+  return std::unique_ptr<Reader>(std::move(io));
+}
+
+// Copies the lines in a time range, across the segments passed to Copy.
+class LogcatRangeFilter {
+ public:
+  LogcatRangeFilter(std::optional<uint64_t> since,
+                    std::optional<uint64_t> until, Writer& out)
+      : since_(since), until_(until), out_(out), keep_(!since) {}
+
+  // Returns false once the lines are past `until`.
+  Result<bool> Copy(Reader& segment) {
+    char buffer[kTransferSize];
+    while (true) {
+      const uint64_t count = CF_EXPECT(segment.Read(buffer, sizeof(buffer)));
+      if (count == 0) {
+        break;
+      }
+      std::string_view chunk(buffer, count);
+      while (!chunk.empty()) {
+        const size_t newline = chunk.find('\n');
+        if (newline == std::string_view::npos) {
+          partial_.append(chunk);
+          break;
+        }
+        const std::string_view line = chunk.substr(0, newline + 1);
+        chunk.remove_prefix(newline + 1);
+        if (!CF_EXPECT(Line(line))) {
+          return false;
+        }
+      }
+    }
+    // Only the live segment can end in the middle of a line.
+    if (!partial_.empty()) {
+      const std::string line = std::move(partial_);
+      partial_.clear();
+      return CF_EXPECT(Filter(line));
+    }
+    return true;
+  }
+
+  Result<void> Flush() {
+    CF_EXPECT(WriteExact(out_, output_.data(), output_.size()));
+    output_.clear();
+    return {};
+  }
+
+ private:
+  Result<bool> Line(std::string_view line) {
+    if (partial_.empty()) {
+      return CF_EXPECT(Filter(line));
+    }
+    partial_.append(line);
+    const std::string joined = std::move(partial_);
+    partial_.clear();
+    return CF_EXPECT(Filter(joined));
+  }
+
+  Result<bool> Filter(std::string_view line) {
+    if (std::optional<uint64_t> timestamp = ParseLogcatTimestamp(line)) {
+      // Lines can be slightly out of order, so don't stop at the first one
+      // past the end of the range.
+      if (until_ && *timestamp > *until_ + kLogcatIndexSlackMs) {
+        return false;
+      }
+      keep_ = (!since_ || *timestamp >= *since_) &&
+              (!until_ || *timestamp <= *until_);
+    }
+    if (keep_) {
+      output_.append(line);
+      if (output_.size() >= kTransferSize) {
+        CF_EXPECT(Flush());
+      }
+    }
+    return true;
+  }
+
+  const std::optional<uint64_t> since_;
+  const std::optional<uint64_t> until_;
+  Writer& out_;
+  // Whether the last line with a timestamp was in range.
+  bool keep_;
+  std::string partial_;
+  std::string output_;
+};
+
+}  // namespace
+
+Result<std::vector<LogcatSegment>> ListLogcatSegments(
+    const std::string& live_path) {
+  const std::string directory = android::base::Dirname(live_path);
+  const std::string prefix =
+      absl::StrCat(android::base::Basename(live_path), ".");
+
+  std::map<uint64_t, LogcatSegment> rotated;
+  for (const std::string& name : CF_EXPECT(DirectoryContents(directory))) {
+    std::string_view rest = name;
+    if (!absl::ConsumePrefix(&rest, prefix)) {
+      continue;
+    }
+    const bool compressed = absl::ConsumeSuffix(&rest, ".lz4");
+    uint64_t sequence = 0;
+    if (!IsSequence(rest) || !absl::SimpleAtoi(rest, &sequence)) {
+      continue;
+    }
+    LogcatSegment segment = {
+        .path = absl::StrCat(directory, "/", name),
+        .sequence = sequence,
+        .compressed = compressed,
+    };
+    auto [it, inserted] = rotated.try_emplace(sequence, segment);
+    // An interrupted compression leaves both files behind, and only the
+    // uncompressed one is known to be complete.
+    if (!inserted && !compressed) {
+      it->second = std::move(segment);
+    }
+  }
+
+  std::vector<LogcatSegment> segments;
+  segments.reserve(rotated.size() + 1);
+  for (auto& [sequence, segment] : rotated) {
+    segments.emplace_back(std::move(segment));
+  }
+  segments.emplace_back(LogcatSegment{
+      .path = live_path,
+      .sequence = rotated.empty() ? 0 : rotated.rbegin()->first + 1,
+      .compressed = false,
+  });
+  return segments;
+}
+
+LogcatWriter::LogcatWriter(std::string path, LogcatRotationOptions options)
+    : path_(std::move(path)), options_(options) {
+  compression_thread_ = std::thread([this]() { CompressionLoop(); });
+}
+
+LogcatWriter::~LogcatWriter() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_one();
+  compression_thread_.join();
+}
+
+Result<std::unique_ptr<LogcatWriter>> LogcatWriter::Create(
+    std::string path, LogcatRotationOptions options) {
+  std::unique_ptr<LogcatWriter> writer(
+      new LogcatWriter(std::move(path), options));
+  const std::vector<LogcatSegment> segments =
+      CF_EXPECT(ListLogcatSegments(writer->path_));
+  writer->next_sequence_ = segments.back().sequence;
+  CF_EXPECT(writer->OpenLiveSegment(O_CREAT | O_RDWR));
+
+  // Finish the work interrupted by a previous run.
+  for (const LogcatSegment& segment : segments) {
+    if (segment.path != writer->path_ && !segment.compressed) {
+      writer->Enqueue(segment.path);
+    }
+  }
+  writer->Enqueue(std::nullopt);
+  return writer;
+}
+
+Result<bool> LogcatWriter::Ingest(SharedFD in) {
+  const uint64_t moved = CF_EXPECT(Transfer(in));
+  if (moved == 0) {
+    return false;
+  }
+  size_ += moved;
+  CF_EXPECT(UpdateIndex());
+
+  const auto age = std::chrono::steady_clock::now() - segment_start_;
+  if (size_ >= options_.max_segment_size || age >= options_.max_segment_age) {
+    CF_EXPECT(Rotate());
+  }
+  return true;
+}
+
+Result<void> LogcatWriter::OpenLiveSegment(int flags) {
+  // Not O_APPEND, which splice(2) rejects. The file offset is kept at the end
+  // instead.
+  file_ = SharedFD::Open(path_, flags, 0666);
+  CF_EXPECTF(file_->IsOpen(), "Failed to open '{}': {}", path_,
+             file_->StrError());
+  size_ = CF_EXPECT(file_->SeekEnd(0));
+  segment_start_ = std::chrono::steady_clock::now();
+
+  const std::string index_path = LogcatIndexPath(path_);
+  const std::vector<LogcatIndexEntry> index =
+      CF_EXPECT(ReadLogcatIndex(index_path));
+  next_index_offset_ =
+      index.empty() ? 0 : index.back().offset + options_.index_interval;
+  index_ = SharedFD::Open(index_path,
+                          O_CREAT | O_WRONLY | O_APPEND | (flags & O_TRUNC),
+                          0666);
+  CF_EXPECTF(index_->IsOpen(), "Failed to open '{}': {}", index_path,
+             index_->StrError());
+  CF_EXPECT(UpdateIndex());
+  return {};
+}
+
+Result<uint64_t> LogcatWriter::Transfer(SharedFD in) {
+  if (splice_) {
+    const ssize_t moved = file_->Splice(*in, nullptr, nullptr, kTransferSize,
+                                        SPLICE_F_MOVE | SPLICE_F_MORE);
+    if (moved >= 0) {
+      return moved;
+    }
+    CF_EXPECTF(file_->GetErrno() == EINVAL, "Failed to splice logcat: {}",
+               file_->StrError());
+    // `in` isn't a pipe.
+    splice_ = false;
+  }
+  char buffer[kTransferSize];
+  const uint64_t count = CF_EXPECT(in->Read(buffer, sizeof(buffer)));
+  CF_EXPECT(WriteExact(*file_, buffer, count));
+  return count;
+}
+
+Result<void> LogcatWriter::UpdateIndex() {
+  char window[kIndexWindowSize];
+  while (next_index_offset_ < size_) {
+    // Reading from the byte before makes it possible to tell whether a line
+    // starts at `next_index_offset_`.
+    const uint64_t start = next_index_offset_ == 0 ? 0 : next_index_offset_ - 1;
+    const size_t length = std::min<uint64_t>(sizeof(window), size_ - start);
+    const bool at_end = start + length == size_;
+    CF_EXPECT(PReadExact(*file_, window, length, start));
+    const std::string_view data(window, length);
+
+    size_t line_start = 0;
+    if (next_index_offset_ > 0) {
+      const size_t newline = data.find('\n');
+      if (newline == std::string_view::npos) {
+        if (at_end) {
+          return {};
+        }
+        next_index_offset_ = start + length + 1;
+        continue;
+      }
+      line_start = newline + 1;
+    }
+    const std::string_view line = data.substr(line_start);
+    if (line.size() < kTimestampSize &&
+        line.find('\n') == std::string_view::npos) {
+      if (at_end) {
+        return {};  // Wait for the rest of the timestamp.
+      }
+      next_index_offset_ = start + line_start;
+      continue;
+    }
+
+    const uint64_t offset = start + line_start;
+    std::optional<uint64_t> timestamp = ParseLogcatTimestamp(line);
+    if (!timestamp) {
+      // Such as the "--------- beginning of main" separators.
+      next_index_offset_ = offset + 1;
+      continue;
+    }
+    CF_EXPECT(AppendLogcatIndexEntry(index_, LogcatIndexEntry{
+                                                 .timestamp = *timestamp,
+                                                 .offset = offset,
+                                             }));
+    next_index_offset_ = offset + options_.index_interval;
+  }
+  return {};
+}
+
+Result<void> LogcatWriter::Rotate() {
+  // The incomplete last line is carried over to the new segment, unless it's
+  // too long to be a logcat line.
+  char tail[kTransferSize];
+  const uint64_t tail_start = size_ - std::min<uint64_t>(size_, sizeof(tail));
+  const size_t tail_size = size_ - tail_start;
+  CF_EXPECT(PReadExact(*file_, tail, tail_size, tail_start));
+  std::string_view partial;
+  if (const size_t newline = std::string_view(tail, tail_size).rfind('\n');
+      newline != std::string_view::npos) {
+    partial = std::string_view(tail, tail_size).substr(newline + 1);
+  }
+  if (!partial.empty()) {
+    CF_EXPECT(file_->Truncate(size_ - partial.size()));
+    // The start of the partial line may already be indexed.
+    CF_EXPECT(
+        TruncateLogcatIndex(LogcatIndexPath(path_), size_ - partial.size()));
+  }
+
+  const std::string rotated = absl::StrCat(path_, ".", next_sequence_++);
+  CF_EXPECT(Rename(path_, rotated));
+  CF_EXPECT(RenameIndex(path_, rotated));
+  CF_EXPECT(OpenLiveSegment(O_CREAT | O_RDWR | O_TRUNC));
+  CF_EXPECT(WriteExact(*file_, partial.data(), partial.size()));
+  size_ = partial.size();
+  CF_EXPECT(UpdateIndex());
+
+  Enqueue(rotated);
+  return {};
+}
+
+void LogcatWriter::Enqueue(std::optional<std::string> segment) {
+  {
+    std::lock_guard lock(mutex_);
+    pending_.emplace_back(std::move(segment));
+  }
+  condition_.notify_one();
+}
+
+void LogcatWriter::CompressionLoop() {
+  while (true) {
+    std::optional<std::string> segment;
+    {
+      std::unique_lock lock(mutex_);
+      condition_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        return;
+      }
+      segment = std::move(pending_.front());
+      pending_.pop_front();
+    }
+    if (segment && options_.compress) {
+      Result<void> compressed = CompressSegment(*segment);
+      if (!compressed.has_value()) {
+        LOG(ERROR) << "Failed to compress '" << *segment
+                   << "': " << compressed.error();
+      }
+    }
+    // Deleting from this thread keeps it from racing with the compression.
+    Result<void> deleted =
+        DeleteOldSegments(path_, options_.max_rotated_segments);
+    if (!deleted.has_value()) {
+      LOG(ERROR) << "Failed to delete old logcat segments: " << deleted.error();
+    }
+  }
+}
+
+Result<void> CopyLogcatRange(const std::string& live_path,
+                             std::optional<uint64_t> since,
+                             std::optional<uint64_t> until, Writer& out) {
+  const std::vector<LogcatSegment> segments =
+      CF_EXPECT(ListLogcatSegments(live_path));
+  std::vector<std::vector<LogcatIndexEntry>> indexes;
+  indexes.reserve(segments.size());
+  for (const LogcatSegment& segment : segments) {
+    indexes.emplace_back(
+        CF_EXPECT(ReadLogcatIndex(LogcatIndexPath(segment.path))));
+  }
+
+  // Every line of a segment was logged before the lines of the next one, so
+  // only the index of the next segment is needed to skip a whole segment.
+  size_t first = 0;
+  if (since) {
+    for (size_t i = 1; i < segments.size(); i++) {
+      if (!indexes[i].empty() &&
+          indexes[i].front().timestamp + kLogcatIndexSlackMs < *since) {
+        first = i;
+      }
+    }
+  }
+
+  LogcatRangeFilter filter(since, until, out);
+  for (size_t i = first; i < segments.size(); i++) {
+    const uint64_t offset = since ? LogcatIndexSeek(indexes[i], *since) : 0;
+    std::unique_ptr<Reader> reader =
+        CF_EXPECT(OpenSegment(segments[i], offset));
+    if (!reader) {
+      continue;
+    }
+    if (!CF_EXPECT(filter.Copy(*reader))) {
+      break;
+    }
+  }
+  CF_EXPECT(filter.Flush());
+  return {};
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+
+// The guest logcat is written to a live segment at a fixed path, so that tools
+// tailing it keep working. Full segments are renamed to "<path>.<sequence>",
+// and then compressed in the background to "<path>.<sequence>.lz4".
+struct LogcatSegment {
+  std::string path;
+  uint64_t sequence;
+  bool compressed;
+};
+
+// Lists the rotated segments of `live_path` from oldest to newest, followed by
+// the live segment. The live segment's sequence is the one it gets when it's
+// rotated.
+Result<std::vector<LogcatSegment>> ListLogcatSegments(
+    const std::string& live_path);
+
+struct LogcatRotationOptions {
+  uint64_t max_segment_size = 32 << 20;
+  std::chrono::seconds max_segment_age = std::chrono::hours(6);
+  // The oldest segments are deleted past this count, not counting the live one.
+  size_t max_rotated_segments = 10;
+  // The distance between index entries, in bytes of uncompressed log.
+  uint64_t index_interval = 64 << 10;
+  bool compress = true;
+};
+
+class LogcatWriter {
+ public:
+  static Result<std::unique_ptr<LogcatWriter>> Create(
+      std::string path, LogcatRotationOptions options = {});
+  // Waits for pending compression to finish.
+  ~LogcatWriter();
+
+  // Moves the data available from `in` to the live segment, and rotates the
+  // segment if it's full. Pipes are spliced without copying through user
+  // space. Returns false once `in` reaches end of file.
+  Result<bool> Ingest(SharedFD in);
+
+ private:
+  LogcatWriter(std::string path, LogcatRotationOptions options);
+
+  Result<void> OpenLiveSegment(int flags);
+  Result<uint64_t> Transfer(SharedFD in);
+  Result<void> UpdateIndex();
+  Result<void> Rotate();
+
+  void Enqueue(std::optional<std::string> segment);
+  void CompressionLoop();
+
+  const std::string path_;
+  const LogcatRotationOptions options_;
+
+  SharedFD file_;
+  SharedFD index_;
+  uint64_t size_ = 0;
+  uint64_t next_index_offset_ = 0;
+  uint64_t next_sequence_ = 0;
+  std::chrono::steady_clock::time_point segment_start_;
+  bool splice_ = true;
+
+  // Rotated segments waiting to be compressed. A std::nullopt only asks for
+  // old segments to be deleted.
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<std::optional<std::string>> pending_;
+  bool stopping_ = false;
+  std::thread compression_thread_;
+};
+
+// Writes the lines logged from `since` until `until`, inclusive, across all
+// segments of `live_path`. Segments and the parts of segments that precede
+// `since` are skipped with the help of their indexes. Lines without a
+// timestamp are kept together with the line before them.
+Result<void> CopyLogcatRange(const std::string& live_path,
+                             std::optional<uint64_t> since,
+                             std::optional<uint64_t> until, Writer& out);
+
+}  // namespace cuttlefish
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/logcat/logcat_segments.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/fs/shared_buf.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/host/libs/logcat/logcat_index.h"
+#include "cuttlefish/io/in_memory.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/string.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+std::string TempDir() {
+  const char* tmpdir = getenv("TEST_TMPDIR");
+  std::string path = std::string(tmpdir ? tmpdir : "/tmp") + "/logcat_XXXXXX";
+  EXPECT_NE(mkdtemp(path.data()), nullptr);
+  return path;
+}
+
+// A line logged `second` seconds into the year, in the threadtime format.
+std::string LogLine(int second, std::string_view message) {
+  char timestamp[32];
+  snprintf(timestamp, sizeof(timestamp), "01-01 %02d:%02d:%02d.000",
+           second / 3600, second / 60 % 60, second % 60);
+  return std::string(timestamp) + "  1234  5678 I tag: " +
+         std::string(message) + "\n";
+}
+
+std::string Logs(int first_second, int count) {
+  std::string logs;
+  for (int i = first_second; i < first_second + count; i++) {
+    logs += LogLine(i, "message " + std::to_string(i));
+    if (i % 50 == 0) {
+      logs += "--------- beginning of crash\n";
+    }
+  }
+  return logs;
+}
+
+// Writes `logs` through a pipe, in pieces that split lines.
+void Ingest(LogcatWriter& writer, std::string_view logs) {
+  SharedFD read_end;
+  SharedFD write_end;
+  ASSERT_TRUE(SharedFD::Pipe(&read_end, &write_end));
+  for (size_t i = 0; i < logs.size(); i += 1000) {
+    const std::string_view piece = logs.substr(i, 1000);
+    ASSERT_EQ(WriteAll(write_end, piece.data(), piece.size()), piece.size());
+    std::vector<PollSharedFd> poll = {{read_end, POLLIN, 0}};
+    while (SharedFD::Poll(poll, 0) > 0) {
+      ASSERT_THAT(writer.Ingest(read_end), IsOkAndValue(true));
+    }
+  }
+  write_end->Close();
+  ASSERT_THAT(writer.Ingest(read_end), IsOkAndValue(false));
+}
+
+std::string ReadFile(const std::string& path) {
+  SharedFdIo io(SharedFD::Open(path, O_RDONLY));
+  Result<std::string> contents = ReadToString(io);
+  EXPECT_THAT(contents, IsOk());
+  return contents.has_value() ? *contents : "";
+}
+
+std::string CopyRange(const std::string& path, std::optional<uint64_t> since,
+                      std::optional<uint64_t> until) {
+  std::unique_ptr<ReaderWriterSeeker> out = InMemoryIo();
+  EXPECT_THAT(CopyLogcatRange(path, since, until, *out), IsOk());
+  EXPECT_THAT(out->SeekSet(0), IsOk());
+  Result<std::string> contents = ReadToString(*out);
+  EXPECT_THAT(contents, IsOk());
+  return contents.has_value() ? *contents : "";
+}
+
+uint64_t Timestamp(int second) {
+  return *ParseLogcatTimestamp(LogLine(second, ""));
+}
+
+TEST(LogcatWriterTest, RotatesOnLineBoundaries) {
+  const std::string path = TempDir() + "/logcat";
+  const std::string logs = Logs(0, 500);
+  {
+    Result<std::unique_ptr<LogcatWriter>> writer =
+        LogcatWriter::Create(path, {
+                                       .max_segment_size = 4096,
+                                       .max_rotated_segments = 100,
+                                       .index_interval = 512,
+                                       .compress = false,
+                                   });
+    ASSERT_THAT(writer, IsOk());
+    Ingest(**writer, logs);
+  }
+
+  Result<std::vector<LogcatSegment>> segments = ListLogcatSegments(path);
+  ASSERT_THAT(segments, IsOk());
+  ASSERT_GT(segments->size(), 5);
+  std::string joined;
+  for (const LogcatSegment& segment : *segments) {
+    EXPECT_FALSE(segment.compressed);
+    const std::string contents = ReadFile(segment.path);
+    if (contents.empty() && segment.path == path) {
+      continue;  // Rotated right at the end.
+    }
+    EXPECT_EQ(contents.back(), '\n') << segment.path;
+    joined += contents;
+
+    Result<std::vector<LogcatIndexEntry>> index =
+        ReadLogcatIndex(LogcatIndexPath(segment.path));
+    ASSERT_THAT(index, IsOk());
+    ASSERT_FALSE(index->empty());
+    // Separator lines aren't indexed.
+    EXPECT_EQ(index->front().offset, ParseLogcatTimestamp(contents)
+                                         ? 0
+                                         : contents.find('\n') + 1);
+    for (const LogcatIndexEntry& entry : *index) {
+      ASSERT_LT(entry.offset, contents.size());
+      EXPECT_EQ(ParseLogcatTimestamp(contents.substr(entry.offset)),
+                entry.timestamp);
+    }
+  }
+  EXPECT_EQ(joined, logs);
+}
+
+TEST(LogcatWriterTest, CompressesAndDeletesOldSegments) {
+  const std::string path = TempDir() + "/logcat";
+  const std::string logs = Logs(0, 500);
+  {
+    Result<std::unique_ptr<LogcatWriter>> writer =
+        LogcatWriter::Create(path, {
+                                       .max_segment_size = 4096,
+                                       .max_rotated_segments = 2,
+                                   });
+    ASSERT_THAT(writer, IsOk());
+    Ingest(**writer, logs);
+  }
+
+  Result<std::vector<LogcatSegment>> segments = ListLogcatSegments(path);
+  ASSERT_THAT(segments, IsOk());
+  ASSERT_EQ(segments->size(), 3);
+  EXPECT_TRUE((*segments)[0].compressed);
+  EXPECT_TRUE((*segments)[1].compressed);
+  EXPECT_EQ((*segments)[2].path, path);
+
+  const std::string kept = CopyRange(path, std::nullopt, std::nullopt);
+  ASSERT_FALSE(kept.empty());
+  EXPECT_TRUE(std::string_view(logs).ends_with(kept));
+}
+
+TEST(LogcatWriterTest, ContinuesExistingSegments) {
+  const std::string path = TempDir() + "/logcat";
+  const LogcatRotationOptions options = {.max_segment_size = 4096};
+  const std::string first = Logs(0, 200);
+  const std::string second = Logs(200, 200);
+  for (const std::string& logs : {first, second}) {
+    Result<std::unique_ptr<LogcatWriter>> writer =
+        LogcatWriter::Create(path, options);
+    ASSERT_THAT(writer, IsOk());
+    Ingest(**writer, logs);
+  }
+
+  EXPECT_EQ(CopyRange(path, std::nullopt, std::nullopt), first + second);
+}
+
+TEST(CopyLogcatRangeTest, SelectsLinesByTimestamp) {
+  const std::string path = TempDir() + "/logcat";
+  {
+    Result<std::unique_ptr<LogcatWriter>> writer =
+        LogcatWriter::Create(path, {
+                                       .max_segment_size = 4096,
+                                       .max_rotated_segments = 100,
+                                       .index_interval = 512,
+                                   });
+    ASSERT_THAT(writer, IsOk());
+    Ingest(**writer, Logs(0, 1000));
+  }
+
+  // The separator after line 500 is kept along with that line.
+  EXPECT_EQ(CopyRange(path, Timestamp(480), Timestamp(520)), Logs(480, 41));
+  EXPECT_EQ(CopyRange(path, Timestamp(990), std::nullopt), Logs(990, 10));
+  EXPECT_EQ(CopyRange(path, std::nullopt, Timestamp(9)), Logs(0, 10));
+  EXPECT_EQ(CopyRange(path, Timestamp(2000), std::nullopt), "");
+}
+
+}  // namespace
+}  // namespace cuttlefish
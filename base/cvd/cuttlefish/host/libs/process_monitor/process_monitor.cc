@@ -20,29 +20,43 @@
 #include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
 #ifdef __linux__
 #include <sys/prctl.h>
 #endif
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <future>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "absl/log/log.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "android-base/file.h"
 
+#include "cuttlefish/common/libs/fs/epoll.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/transport/channel.h"
 #include "cuttlefish/common/libs/transport/channel_sharedfd.h"
 #include "cuttlefish/common/libs/utils/contains.h"
+#include "cuttlefish/files/directory_contents.h"
 #include "cuttlefish/host/libs/command_util/util.h"
 #include "cuttlefish/host/libs/config/known_paths.h"
 #include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/process/proc_file_utils.h"
 #include "cuttlefish/process/subprocess.h"
 #include "cuttlefish/result/result.h"
 
@@ -58,6 +72,7 @@ enum ParentToChildMessageType : uint8_t {
   kHostResume = 2,
   kHostSuspend = 3,
   kError = 4,
+  kStats = 5,
 };
 
 enum ChildToParentResponseType : uint8_t {
@@ -77,22 +92,6 @@ Result<void> SendEmptyResponse(Channel& channel, uint32_t type) {
   return {};
 }
 
-void LogSubprocessExit(const std::string& name, pid_t pid, int wstatus) {
-  LOG(INFO) << "Detected unexpected exit of monitored subprocess " << name;
-  if (WIFEXITED(wstatus)) {
-    LOG(INFO) << "Subprocess " << name << " (" << pid
-              << ") has exited with exit code " << WEXITSTATUS(wstatus);
-  } else if (WIFSIGNALED(wstatus)) {
-    int sig_num = WTERMSIG(wstatus);
-    LOG(ERROR) << "Subprocess " << name << " (" << pid
-               << ") was interrupted by a signal '" << strsignal(sig_num)
-               << "' (" << sig_num << ")";
-  } else {
-    LOG(INFO) << "subprocess " << name << " (" << pid
-              << ") has exited for unknown reasons";
-  }
-}
-
 void LogSubprocessExit(const std::string& name, const siginfo_t& infop) {
   LOG(INFO) << "Detected unexpected exit of monitored subprocess " << name;
   if (infop.si_code == CLD_EXITED) {
@@ -109,51 +108,38 @@ void LogSubprocessExit(const std::string& name, const siginfo_t& infop) {
   }
 }
 
-Result<void> MonitorLoop(std::atomic_bool& running,
-                         std::mutex& properties_mutex,
-                         const bool restart_subprocesses,
-                         std::vector<MonitorEntry>& monitored) {
-  while (running.load()) {
-    int wstatus;
-    pid_t pid = wait(&wstatus);
-    CF_EXPECTF(pid != -1, "Wait failed: {}", StrError(errno));
-    if (!WIFSIGNALED(wstatus) && !WIFEXITED(wstatus)) {
-      VLOG(0) << "Unexpected status from wait: " << wstatus << " for pid "
-              << pid;
-      continue;
-    }
-    if (!running.load()) {  // Avoid extra restarts near the end
-      break;
-    }
-    auto matches = [pid](const auto& it) { return it.proc->pid() == pid; };
-    std::unique_lock lock(properties_mutex);
-    auto it = std::find_if(monitored.begin(), monitored.end(), matches);
-    if (it == monitored.end()) {
-      LogSubprocessExit("(unknown)", pid, wstatus);
-    } else {
-      LogSubprocessExit(it->cmd->GetShortName(), it->proc->pid(), wstatus);
-      if (restart_subprocesses) {
-        auto options = SubprocessOptions().InGroup(true);
-        // in the future, cmd->Start might not run exec()
-        it->proc.reset(new Subprocess(it->cmd->Start(std::move(options))));
-      } else {
-        bool is_critical = it->is_critical;
-        monitored.erase(it);
-        if (running.load() && is_critical) {
-          LOG(ERROR) << "Stopping all monitored processes due to unexpected "
-                        "exit of critical process";
-          running.store(false);
-          break;
-        }
-      }
-    }
+// Orphaned descendants are reparented to the monitor, which is a subreaper.
+// Nothing signals their exit, so they are reaped periodically.
+constexpr auto kOrphanReapInterval = std::chrono::seconds(10);
+// Exits are polled for when the kernel doesn't support pidfds.
+constexpr auto kExitPollInterval = std::chrono::milliseconds(500);
+
+// Processes are stopped one tier after another, and in parallel within a
+// tier.
+enum class StopTier {
+  // The guest goes first, so that it doesn't see its devices disappear.
+  kVmm,
+  kDefault,
+  // Logs keep being collected while the other processes stop.
+  kLogging,
+};
+
+StopTier GetStopTier(const Command& command) {
+  const std::string name = android::base::Basename(command.Executable());
+  if (name == android::base::Basename(ProcessRestarterBinary()) ||
+      name == "crosvm" || absl::StartsWith(name, "qemu-system") ||
+      name == "gem5") {
+    return StopTier::kVmm;
   }
-  return {};
+  if (name == "log_tee") {
+    return StopTier::kLogging;
+  }
+  return StopTier::kDefault;
 }
 
 Result<void> StopSubprocesses(std::vector<MonitorEntry>& monitored) {
   VLOG(0) << "Stopping monitored subprocesses";
-  auto stop = [](const auto& it) {
+  auto stop = [](MonitorEntry& it) {
     auto stop_result = it.proc->Stop();
     if (stop_result == StopperResult::kFailure) {
       LOG(WARNING) << "Error in stopping \"" << it.cmd->GetShortName() << "\"";
@@ -170,13 +156,113 @@ Result<void> StopSubprocesses(std::vector<MonitorEntry>& monitored) {
     }
     return true;
   };
-  // Processes were started in the order they appear in the vector, stop them in
-  // reverse order for symmetry.
-  size_t stopped = std::count_if(monitored.rbegin(), monitored.rend(), stop);
-  CF_EXPECT(stopped == monitored.size(), "Didn't stop all subprocesses");
+  size_t to_stop = 0;
+  size_t stopped = 0;
+  for (StopTier tier :
+       {StopTier::kVmm, StopTier::kDefault, StopTier::kLogging}) {
+    std::vector<std::future<bool>> tier_stops;
+    for (MonitorEntry& entry : monitored) {
+      // Processes that exited without being restarted are already gone.
+      if (entry.proc && GetStopTier(*entry.cmd) == tier) {
+        tier_stops.emplace_back(
+            std::async(std::launch::async, stop, std::ref(entry)));
+      }
+    }
+    to_stop += tier_stops.size();
+    for (std::future<bool>& tier_stop : tier_stops) {
+      stopped += tier_stop.get() ? 1 : 0;
+    }
+  }
+  CF_EXPECT(stopped == to_stop, "Didn't stop all subprocesses");
   return {};
 }
 
+// One process per line, with tab separated fields.
+std::string SerializeStats(const std::vector<MonitoredProcessStats>& stats) {
+  std::string serialized;
+  for (const MonitoredProcessStats& process : stats) {
+    absl::StrAppend(&serialized, process.name, "\t",
+                    static_cast<int>(process.state), "\t", process.pid, "\t",
+                    process.restarts, "\t", process.cpu_time.count(), "\t",
+                    process.rss_bytes, "\n");
+  }
+  return serialized;
+}
+
+Result<std::vector<MonitoredProcessStats>> ParseStats(
+    std::string_view serialized) {
+  std::vector<MonitoredProcessStats> stats;
+  for (std::string_view line :
+       absl::StrSplit(serialized, '\n', absl::SkipEmpty())) {
+    std::vector<std::string_view> fields = absl::StrSplit(line, '\t');
+    CF_EXPECTF(fields.size() == 6, "Malformed process stats line: '{}'", line);
+    int state;
+    int64_t cpu_ms;
+    MonitoredProcessStats& process = stats.emplace_back();
+    process.name = fields[0];
+    CF_EXPECT(absl::SimpleAtoi(fields[1], &state));
+    process.state = static_cast<MonitoredProcessStats::State>(state);
+    CF_EXPECT(absl::SimpleAtoi(fields[2], &process.pid));
+    CF_EXPECT(absl::SimpleAtoi(fields[3], &process.restarts));
+    CF_EXPECT(absl::SimpleAtoi(fields[4], &cpu_ms));
+    process.cpu_time = std::chrono::milliseconds(cpu_ms);
+    CF_EXPECT(absl::SimpleAtoi(fields[5], &process.rss_bytes));
+  }
+  return stats;
+}
+
+Result<std::vector<MonitoredProcessStats>> CollectStats(
+    std::vector<MonitorEntry>& monitor_entries, std::mutex& properties_mutex) {
+  std::vector<MonitoredProcessStats> stats;
+  // Subprocesses are started in their own process group, so the group id is
+  // the pid of the process that was started.
+  std::unordered_map<pid_t, size_t> group_stats;
+  {
+    std::lock_guard lock(properties_mutex);
+    for (const MonitorEntry& entry : monitor_entries) {
+      MonitoredProcessStats& process = stats.emplace_back();
+      process.name = entry.cmd->GetShortName();
+      if (entry.proc) {
+        process.state = MonitoredProcessStats::State::kRunning;
+      } else if (entry.restart_at) {
+        process.state = MonitoredProcessStats::State::kRestartPending;
+      } else {
+        process.state = MonitoredProcessStats::State::kExited;
+      }
+      process.pid = entry.proc ? entry.proc->pid() : -1;
+      process.restarts = entry.backoff.Restarts();
+      process.cpu_time = std::chrono::milliseconds(0);
+      process.rss_bytes = 0;
+      if (process.pid > 0) {
+        group_stats[process.pid] = stats.size() - 1;
+      }
+    }
+  }
+
+  const uint64_t ticks_per_second = sysconf(_SC_CLK_TCK);
+  const uint64_t page_size = sysconf(_SC_PAGESIZE);
+  for (const std::string& dir : CF_EXPECT(DirectoryContents(kProcDir))) {
+    pid_t pid;
+    if (!absl::SimpleAtoi(dir, &pid)) {
+      continue;
+    }
+    // Processes may exit while this is running.
+    Result<ProcStat> proc_stat = GetProcStat(pid);
+    if (!proc_stat.has_value()) {
+      continue;
+    }
+    auto group = group_stats.find(proc_stat->pgrp);
+    if (group == group_stats.end()) {
+      continue;
+    }
+    MonitoredProcessStats& process = stats[group->second];
+    process.cpu_time += std::chrono::milliseconds(proc_stat->cpu_ticks * 1000 /
+                                                  ticks_per_second);
+    process.rss_bytes += proc_stat->rss_pages * page_size;
+  }
+  return stats;
+}
+
 Result<void> SuspendResumeImpl(std::vector<MonitorEntry>& monitor_entries,
                                std::mutex& properties_mutex,
                                const SharedFD& channel_to_secure_env,
@@ -207,7 +293,7 @@ Result<void> SuspendResumeImpl(std::vector<MonitorEntry>& monitor_entries,
       continue;
     }
     if (!entry.proc) {
-      LOG(ERROR) << "Monitor Entry has a nullptr for proc.";
+      // The process exited, and is not running until it's restarted.
       continue;
     }
     auto prog_name = android::base::Basename(entry.cmd->Executable());
@@ -259,18 +345,147 @@ Result<void> ProcessMonitor::StartSubprocesses(
   for (auto& monitored : properties.entries_) {
     LOG(INFO) << "Starting monitored subprocess: "
               << monitored.cmd->GetShortName();
-    auto options = SubprocessOptions().InGroup(true);
-    std::string short_name = monitored.cmd->GetShortName();
-    auto last_slash = short_name.find_last_of('/');
-    if (last_slash != std::string::npos) {
-      short_name = short_name.substr(last_slash + 1);
-    }
-    if (Contains(properties_.strace_commands_, short_name)) {
-      options.Strace(properties.strace_log_dir_ + "/strace-" + short_name);
-    }
-    monitored.proc.reset(
-        new Subprocess(monitored.cmd->Start(std::move(options))));
-    CF_EXPECT(monitored.proc->Started(), "Failed to start subprocess");
+    CF_EXPECT(StartSubprocess(monitored));
+  }
+  return {};
+}
+
+Result<void> ProcessMonitor::StartSubprocess(MonitorEntry& monitored) {
+  auto options = SubprocessOptions().InGroup(true);
+  std::string short_name = monitored.cmd->GetShortName();
+  auto last_slash = short_name.find_last_of('/');
+  if (last_slash != std::string::npos) {
+    short_name = short_name.substr(last_slash + 1);
+  }
+  if (Contains(properties_.strace_commands_, short_name)) {
+    options.Strace(properties_.strace_log_dir_ + "/strace-" + short_name);
+  }
+  monitored.restart_at.reset();
+  monitored.started = std::chrono::steady_clock::now();
+  monitored.proc.reset(
+      new Subprocess(monitored.cmd->Start(std::move(options))));
+  CF_EXPECT(monitored.proc->Started(), "Failed to start subprocess");
+  running_[monitored.proc->pid()] = &monitored;
+
+  SharedFD pidfd = monitored.proc->pidfd();
+  if (!pidfd->IsOpen()) {
+    if (pidfd_supported_) {
+      LOG(WARNING) << "Polling for subprocess exits, no pidfd for "
+                   << monitored.cmd->GetShortName();
+    }
+    pidfd_supported_ = false;
+    return {};
+  }
+  CF_EXPECT(epoll_.Add(pidfd, EPOLLIN));
+  return {};
+}
+
+Result<void> ProcessMonitor::MonitorLoop(std::atomic_bool& running) {
+  while (running.load()) {
+    using std::chrono::milliseconds;
+    milliseconds timeout = pidfd_supported_ ? kOrphanReapInterval
+                                            : kExitPollInterval;
+    {
+      std::lock_guard lock(properties_mutex_);
+      const auto now = std::chrono::steady_clock::now();
+      for (const MonitorEntry& entry : properties_.entries_) {
+        if (entry.restart_at) {
+          auto until_restart =
+              std::chrono::ceil<milliseconds>(*entry.restart_at - now);
+          timeout = std::clamp(until_restart, milliseconds(0), timeout);
+        }
+      }
+    }
+    // A pidfd event only says that some subprocess exited, the exits are
+    // collected below together with those of orphans.
+    std::optional<EpollEvent> event = CF_EXPECT(epoll_.Wait(timeout));
+    if (event && event->fd == stop_event_) {
+      break;
+    }
+    CF_EXPECT(ReapExitedChildren(running));
+    CF_EXPECT(RestartSubprocesses(running));
+  }
+  return {};
+}
+
+Result<void> ProcessMonitor::ReapExitedChildren(std::atomic_bool& running) {
+  while (running.load()) {  // Avoid extra restarts near the end
+    siginfo_t infop = {};
+    // Peek first, monitored subprocesses are reaped through their Subprocess.
+    if (TEMP_FAILURE_RETRY(waitid(P_ALL, 0, &infop,
+                                  WEXITED | WNOHANG | WNOWAIT)) != 0) {
+      CF_EXPECTF(errno == ECHILD, "Wait failed: {}", StrError(errno));
+      return {};
+    }
+    if (infop.si_pid == 0) {
+      return {};
+    }
+    std::unique_lock lock(properties_mutex_);
+    auto it = running_.find(infop.si_pid);
+    if (it == running_.end()) {
+      CF_EXPECTF(TEMP_FAILURE_RETRY(waitid(P_PID, infop.si_pid, &infop,
+                                           WEXITED)) == 0,
+                 "Wait failed: {}", StrError(errno));
+      LogSubprocessExit("(unknown)", infop);
+      continue;
+    }
+    MonitorEntry& entry = *it->second;
+    running_.erase(it);
+    infop = CF_EXPECT(entry.proc->Wait(WEXITED));
+    if (entry.proc->pidfd()->IsOpen()) {
+      CF_EXPECT(epoll_.Delete(entry.proc->pidfd()));
+    }
+    entry.proc.reset();
+    LogSubprocessExit(entry.cmd->GetShortName(), infop);
+    if (!ScheduleRestart(entry)) {
+      running.store(false);
+    }
+  }
+  return {};
+}
+
+bool ProcessMonitor::ScheduleRestart(MonitorEntry& entry) {
+  const std::string name = entry.cmd->GetShortName();
+  if (properties_.restart_subprocesses_) {
+    const auto now = std::chrono::steady_clock::now();
+    std::optional<std::chrono::milliseconds> delay =
+        entry.backoff.OnExit(entry.started, now);
+    if (delay) {
+      LOG(INFO) << "Restarting " << name << " in " << delay->count() << "ms";
+      entry.restart_at = now + *delay;
+      return true;
+    }
+    LOG(ERROR) << "Not restarting " << name << ", it's crash looping after "
+               << entry.backoff.Restarts() << " restarts";
+  }
+  if (entry.is_critical) {
+    LOG(ERROR) << "Stopping all monitored processes due to unexpected "
+                  "exit of critical process";
+    return false;
+  }
+  return true;
+}
+
+Result<void> ProcessMonitor::RestartSubprocesses(std::atomic_bool& running) {
+  std::lock_guard lock(properties_mutex_);
+  const auto now = std::chrono::steady_clock::now();
+  for (MonitorEntry& entry : properties_.entries_) {
+    if (!running.load()) {
+      break;
+    }
+    if (!entry.restart_at || *entry.restart_at > now) {
+      continue;
+    }
+    // in the future, cmd->Start might not run exec()
+    Result<void> started = StartSubprocess(entry);
+    if (!started.has_value()) {
+      LOG(ERROR) << "Failed to restart " << entry.cmd->GetShortName() << ": "
+                 << started.error();
+      entry.proc.reset();
+      if (!ScheduleRestart(entry)) {
+        running.store(false);
+      }
+    }
   }
   return {};
 }
@@ -289,13 +504,29 @@ Result<void> ProcessMonitor::ReadMonitorSocketLoop(std::atomic_bool& running) {
     auto message = std::move(*message_res);
     if (message->command == ParentToChildMessageType::kStop) {
       running.store(false);
-      // Wake up the wait() loop by giving it an exited child process
-      if (fork() == 0) {
-        std::exit(0);
-      }
+      // Wake up the epoll loop
+      CF_EXPECTF(stop_event_->EventfdWrite(1) == 0,
+                 "Failed to signal the monitor loop: {}",
+                 stop_event_->StrError());
       // will break the for-loop as running is now false
       continue;
     }
+    if (message->command == ParentToChildMessageType::kStats) {
+      Result<std::vector<MonitoredProcessStats>> stats =
+          CollectStats(properties_.entries_, properties_mutex_);
+      if (!stats.has_value()) {
+        LOG(ERROR) << "Failed to collect process stats: " << stats.error();
+        CF_EXPECT(SendEmptyResponse(*child_channel_,
+                                    ChildToParentResponseType::kFailure));
+        continue;
+      }
+      const std::string serialized = SerializeStats(*stats);
+      ManagedMessage response = CF_EXPECT(CreateMessage(
+          ChildToParentResponseType::kSuccess, true, serialized.size()));
+      memcpy(response->payload, serialized.data(), serialized.size());
+      CF_EXPECT(child_channel_->SendResponse(*response));
+      continue;
+    }
     if (message->command == ParentToChildMessageType::kHostSuspend) {
       CF_EXPECT(SuspendHostProcessesImpl());
       continue;
@@ -400,6 +631,21 @@ Result<void> ProcessMonitor::ResumeMonitoredProcesses() {
   return {};
 }
 
+Result<std::vector<MonitoredProcessStats>>
+ProcessMonitor::QueryMonitoredProcessStats() {
+  CF_EXPECT(monitor_ != -1, "The monitor process has already exited.");
+  CF_EXPECT(parent_channel_.has_value());
+  CF_EXPECT(
+      SendEmptyRequest(*parent_channel_, ParentToChildMessageType::kStats));
+
+  ManagedMessage response = CF_EXPECT(parent_channel_->ReceiveMessage());
+  CF_EXPECT(response->command == ChildToParentResponseType::kSuccess,
+            "On kStats, the child run_cvd returned kFailure.");
+  std::string_view payload(reinterpret_cast<const char*>(response->payload),
+                           response->payload_size);
+  return CF_EXPECT(ParseStats(payload));
+}
+
 Result<void> ProcessMonitor::StartAndMonitorProcesses() {
   CF_EXPECT(monitor_ == -1, "The monitor process was already started");
   CF_EXPECT(!parent_channel_.has_value(),
@@ -438,6 +684,11 @@ Result<void> ProcessMonitor::MonitorRoutine() {
 #endif
 
   VLOG(0) << "Monitoring subprocesses";
+  epoll_ = CF_EXPECT(Epoll::Create());
+  stop_event_ = SharedFD::Event();
+  CF_EXPECTF(stop_event_->IsOpen(), "Failed to create eventfd: {}",
+             stop_event_->StrError());
+  CF_EXPECT(epoll_.Add(stop_event_, EPOLLIN));
   CF_EXPECT(StartSubprocesses(properties_));
 
   std::atomic_bool running(true);
@@ -450,9 +701,7 @@ Result<void> ProcessMonitor::MonitorRoutine() {
   auto parent_comms = std::async(std::launch::async, read_monitor_socket_loop,
                                  std::ref(running));
 
-  CF_EXPECT(MonitorLoop(running, properties_mutex_,
-                        properties_.restart_subprocesses_,
-                        properties_.entries_));
+  CF_EXPECT(MonitorLoop(running));
   running.store(false);
   if (child_sock_->IsOpen()) {
     child_sock_->Shutdown(SHUT_RDWR);
@@ -15,16 +15,25 @@
  */
 #pragma once
 
+#include <stdint.h>
+#include <sys/types.h>
+
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "cuttlefish/common/libs/fs/epoll.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/transport/channel_sharedfd.h"
 #include "cuttlefish/host/libs/feature/command_source.h"
+#include "cuttlefish/host/libs/process_monitor/restart_backoff.h"
 #include "cuttlefish/process/command.h"
 #include "cuttlefish/result/result.h"
 
@@ -32,13 +41,37 @@ namespace cuttlefish {
 
 struct MonitorEntry {
   std::unique_ptr<Command> cmd;
+  // Empty while the process is not running.
   std::unique_ptr<Subprocess> proc;
   bool is_critical;
+  std::chrono::steady_clock::time_point started;
+  // Set while waiting out the backoff before a restart.
+  std::optional<std::chrono::steady_clock::time_point> restart_at;
+  RestartBackoff backoff;
 
   MonitorEntry(Command command, bool is_critical)
       : cmd(new Command(std::move(command))), is_critical(is_critical) {}
 };
 
+struct MonitoredProcessStats {
+  enum class State : uint8_t {
+    kRunning = 0,
+    kRestartPending = 1,
+    // Exited and not restarted, either because restarts are disabled or
+    // because it was crash looping.
+    kExited = 2,
+  };
+
+  std::string name;
+  State state;
+  pid_t pid;  // -1 unless running
+  size_t restarts;
+  // Summed over the process group of the running process. Memory shared
+  // between the processes of the group is counted once per process.
+  std::chrono::milliseconds cpu_time;
+  uint64_t rss_bytes;
+};
+
 // Launches and keeps track of subprocesses, decides response if they
 // unexpectedly exit
 class ProcessMonitor {
@@ -71,13 +104,22 @@ class ProcessMonitor {
   Result<void> SuspendMonitoredProcesses();
   // Resume all host subprocesses
   Result<void> ResumeMonitoredProcesses();
+  // CPU and memory use of every host subprocess, in the order they were
+  // added.
+  Result<std::vector<MonitoredProcessStats>> QueryMonitoredProcessStats();
 
   /* Reads on this SharedFD will block while subprocesses are running, */
   SharedFD status() { return status_; };
 
  private:
   Result<void> StartSubprocesses(Properties& properties);
+  Result<void> StartSubprocess(MonitorEntry& entry);
   Result<void> MonitorRoutine();
+  Result<void> MonitorLoop(std::atomic_bool& running);
+  Result<void> ReapExitedChildren(std::atomic_bool& running);
+  // Returns false if all subprocesses should be stopped instead.
+  bool ScheduleRestart(MonitorEntry& entry);
+  Result<void> RestartSubprocesses(std::atomic_bool& running);
   Result<void> ReadMonitorSocketLoop(std::atomic_bool&);
   /*
    * The child run_cvd process suspends the host processes
@@ -95,6 +137,15 @@ class ProcessMonitor {
   std::optional<transport::SharedFdChannel> parent_channel_;
   std::optional<transport::SharedFdChannel> child_channel_;
   SharedFD child_sock_;
+  /*
+   * The child run_cvd process waits on the pidfds of the subprocesses, and on
+   * stop_event_ which is signaled when the parent asks it to stop.
+   */
+  Epoll epoll_;
+  SharedFD stop_event_;
+  bool pidfd_supported_ = true;
+  // The monitored subprocesses that haven't been reaped, by pid.
+  std::unordered_map<pid_t, MonitorEntry*> running_;
 
   /*
    * The lock that should be acquired when multiple threads
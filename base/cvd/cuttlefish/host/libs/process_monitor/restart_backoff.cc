@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/process_monitor/restart_backoff.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+namespace cuttlefish {
+
+RestartBackoff::RestartBackoff(RestartPolicy policy) : policy_(policy) {}
+
+std::optional<std::chrono::milliseconds> RestartBackoff::OnExit(
+    Clock::time_point started, Clock::time_point exited) {
+  if (exited - started >= policy_.stable_uptime) {
+    consecutive_crashes_ = 0;
+  }
+  recent_exits_.push_back(exited);
+  while (exited - recent_exits_.front() > policy_.crash_loop_window) {
+    recent_exits_.pop_front();
+  }
+  if (recent_exits_.size() >= policy_.crash_loop_limit) {
+    return std::nullopt;
+  }
+
+  std::chrono::milliseconds delay = policy_.initial_delay;
+  for (size_t i = 0; i < consecutive_crashes_ && delay < policy_.max_delay;
+       i++) {
+    delay *= 2;
+  }
+  consecutive_crashes_++;
+  restarts_++;
+  return std::min(delay, policy_.max_delay);
+}
+
+}  // namespace cuttlefish
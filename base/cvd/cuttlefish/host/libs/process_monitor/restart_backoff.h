@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <chrono>
+#include <deque>
+#include <optional>
+
+namespace cuttlefish {
+
+struct RestartPolicy {
+  // The delay before the first restart, doubled on every consecutive crash.
+  std::chrono::milliseconds initial_delay = std::chrono::milliseconds(500);
+  std::chrono::milliseconds max_delay = std::chrono::seconds(30);
+  // A process that stays up this long is healthy again, and its next crash
+  // starts over from `initial_delay`.
+  std::chrono::seconds stable_uptime = std::chrono::seconds(60);
+  // A process is crash looping, and is not restarted anymore, once it exits
+  // `crash_loop_limit` times within `crash_loop_window`.
+  size_t crash_loop_limit = 10;
+  std::chrono::seconds crash_loop_window = std::chrono::minutes(5);
+};
+
+// Decides when a crashed subprocess is restarted.
+class RestartBackoff {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit RestartBackoff(RestartPolicy policy = {});
+
+  // Records the exit of a process started at `started`. Returns the delay
+  // before restarting it, or std::nullopt if it's crash looping.
+  std::optional<std::chrono::milliseconds> OnExit(Clock::time_point started,
+                                                  Clock::time_point exited);
+
+  size_t Restarts() const { return restarts_; }
+
+ private:
+  RestartPolicy policy_;
+  size_t consecutive_crashes_ = 0;
+  size_t restarts_ = 0;
+  std::deque<Clock::time_point> recent_exits_;
+};
+
+}  // namespace cuttlefish
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/process_monitor/restart_backoff.h"
+
+#include <chrono>
+#include <optional>
+
+#include "gtest/gtest.h"
+
+namespace cuttlefish {
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+constexpr RestartPolicy kPolicy = {
+    .initial_delay = milliseconds(100),
+    .max_delay = milliseconds(1000),
+    .stable_uptime = seconds(60),
+    .crash_loop_limit = 5,
+    .crash_loop_window = seconds(600),
+};
+
+TEST(RestartBackoffTest, DoublesDelayUpToMaximum) {
+  RestartBackoff backoff(kPolicy);
+  RestartBackoff::Clock::time_point now;
+
+  EXPECT_EQ(backoff.OnExit(now, now + seconds(1)), milliseconds(100));
+  now += seconds(1);
+  EXPECT_EQ(backoff.OnExit(now, now + seconds(1)), milliseconds(200));
+  now += seconds(1);
+  EXPECT_EQ(backoff.OnExit(now, now + seconds(1)), milliseconds(400));
+  now += seconds(1);
+  EXPECT_EQ(backoff.OnExit(now, now + seconds(1)), milliseconds(800));
+  EXPECT_EQ(backoff.Restarts(), 4);
+}
+
+TEST(RestartBackoffTest, StableProcessStartsOver) {
+  RestartPolicy policy = kPolicy;
+  policy.crash_loop_limit = 100;
+  RestartBackoff backoff(policy);
+  RestartBackoff::Clock::time_point now;
+
+  for (int i = 0; i < 10; i++) {
+    std::optional<milliseconds> delay = backoff.OnExit(now, now + seconds(1));
+    ASSERT_TRUE(delay.has_value());
+    EXPECT_LE(*delay, policy.max_delay);
+    now += seconds(1);
+  }
+  EXPECT_EQ(backoff.OnExit(now, now + seconds(60)), milliseconds(100));
+}
+
+TEST(RestartBackoffTest, StopsRestartingCrashLoop) {
+  RestartBackoff backoff(kPolicy);
+  RestartBackoff::Clock::time_point now;
+
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(backoff.OnExit(now, now + seconds(1)).has_value());
+    now += seconds(1);
+  }
+  EXPECT_EQ(backoff.OnExit(now, now + seconds(1)), std::nullopt);
+  EXPECT_EQ(backoff.Restarts(), 4);
+}
+
+TEST(RestartBackoffTest, OldExitsLeaveCrashLoopWindow) {
+  RestartBackoff backoff(kPolicy);
+  RestartBackoff::Clock::time_point now;
+
+  for (int i = 0; i < 20; i++) {
+    EXPECT_TRUE(backoff.OnExit(now, now + seconds(200)).has_value());
+    now += seconds(200);
+  }
+}
+
+}  // namespace
+}  // namespace cuttlefish
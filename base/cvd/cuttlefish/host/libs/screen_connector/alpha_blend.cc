@@ -0,0 +1,103 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "libyuv.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr int kBytesPerPixel = 4;
+
+// Number of pixels classified together. Large enough to amortize the libyuv
+// call overhead, small enough to find the transparent parts of typical
+// overlays such as rounded corners or partially covered displays.
+constexpr int kSpanPixels = 64;
+
+enum class SpanAlpha { kTransparent, kOpaque, kMixed };
+
+SpanAlpha ClassifySpan(const uint8_t* pixels, int count) {
+  uint8_t any = 0;
+  uint8_t all = 0xff;
+  for (int i = 0; i < count; i++) {
+    const uint8_t alpha = pixels[i * kBytesPerPixel + 3];
+    any |= alpha;
+    all &= alpha;
+  }
+  if (any == 0) {
+    return SpanAlpha::kTransparent;
+  } else if (all == 0xff) {
+    return SpanAlpha::kOpaque;
+  }
+  return SpanAlpha::kMixed;
+}
+
+}  // namespace
+
+void OverlayBlender::Blend(const uint8_t* overlay, int overlay_stride,
+                           const uint8_t* base, int base_stride, uint8_t* dst,
+                           int dst_stride, int width, int height) {
+  for (int row = 0; row < height; row++) {
+    BlendRow(overlay + row * overlay_stride, base + row * base_stride,
+             dst + row * dst_stride, width);
+  }
+}
+
+void OverlayBlender::BlendRow(const uint8_t* overlay, const uint8_t* base,
+                              uint8_t* dst, int width) {
+  int start = 0;
+  while (start < width) {
+    int end = std::min(start + kSpanPixels, width);
+    const SpanAlpha kind =
+        ClassifySpan(overlay + start * kBytesPerPixel, end - start);
+    while (end < width) {
+      const int next = std::min(end + kSpanPixels, width);
+      if (ClassifySpan(overlay + end * kBytesPerPixel, next - end) != kind) {
+        break;
+      }
+      end = next;
+    }
+
+    const size_t offset = start * kBytesPerPixel;
+    const size_t bytes = (end - start) * kBytesPerPixel;
+    switch (kind) {
+      case SpanAlpha::kTransparent:
+        if (dst != base) {
+          memcpy(dst + offset, base + offset, bytes);
+        }
+        break;
+      case SpanAlpha::kOpaque:
+        memcpy(dst + offset, overlay + offset, bytes);
+        break;
+      case SpanAlpha::kMixed:
+        // libyuv blends premultiplied pixels: dst = src + base * (1 - alpha)
+        attenuated_.resize(std::max(attenuated_.size(), bytes));
+        libyuv::ARGBAttenuate(overlay + offset, bytes, attenuated_.data(),
+                              bytes, end - start, 1);
+        libyuv::ARGBBlend(attenuated_.data(), bytes, base + offset, bytes,
+                          dst + offset, bytes, end - start, 1);
+        break;
+    }
+    start = end;
+  }
+}
+
+}  // namespace cuttlefish
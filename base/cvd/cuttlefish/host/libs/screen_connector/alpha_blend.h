@@ -0,0 +1,50 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace cuttlefish {
+
+/*
+ * Blends 32-bit overlay pixels with straight (non-premultiplied) alpha in the
+ * fourth byte over a base layer. The remaining channels are blended
+ * independently, so the same code serves ARGB and ABGR layouts.
+ *
+ * Rows are split into spans that are classified by their overlay alpha: fully
+ * transparent spans leave the base untouched, fully opaque spans are copied
+ * and only mixed spans go through the libyuv integer blend kernels.
+ */
+class OverlayBlender {
+ public:
+  // Blends `height` rows of `width` pixels of `overlay` over `base` into
+  // `dst`. `dst` may be the same buffer as `base`. Blended pixels are left
+  // fully opaque.
+  void Blend(const uint8_t* overlay, int overlay_stride, const uint8_t* base,
+             int base_stride, uint8_t* dst, int dst_stride, int width,
+             int height);
+
+ private:
+  void BlendRow(const uint8_t* overlay, const uint8_t* base, uint8_t* dst,
+                int width);
+
+  // Premultiplied copy of the overlay pixels of the current span.
+  std::vector<uint8_t> attenuated_;
+};
+
+}  // namespace cuttlefish
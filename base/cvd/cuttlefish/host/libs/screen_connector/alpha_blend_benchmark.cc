@@ -0,0 +1,199 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Blends a `--width` x `--height` overlay over a frame with `OverlayBlender`
+// and with the per pixel floating point blend it replaced, for transparent,
+// opaque and mixed overlays. Then composes frames the way
+// `CompositionManager::ComposeFrame` does, blending the mixed overlay and
+// converting the result to I420, as a copy of the whole frame followed by
+// two passes over it and in strips of rows.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "libyuv.h"
+
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kStripRows = 16;
+
+// The blend CompositionManager used before OverlayBlender.
+void FloatBlend(uint8_t* frame, const uint8_t* overlay, int width,
+                int height) {
+  for (int i = 0; i < width * height; i++) {
+    const uint8_t* src = overlay + i * 4;
+    uint8_t* dst = frame + i * 4;
+    const float a = src[3] / 255.0f;
+    const float a_inv = 1.0f - a;
+    for (int channel = 0; channel < 3; channel++) {
+      dst[channel] = (uint8_t)(src[channel] * a + dst[channel] * a_inv);
+    }
+    dst[3] = 255;
+  }
+}
+
+std::vector<uint8_t> Pixels(int width, int height, std::mt19937& random,
+                            const std::function<uint8_t()>& alpha) {
+  std::vector<uint8_t> pixels(width * height * 4);
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    pixels[i] = random();
+    pixels[i + 1] = random();
+    pixels[i + 2] = random();
+    pixels[i + 3] = alpha();
+  }
+  return pixels;
+}
+
+struct I420Frame {
+  I420Frame(int width, int height)
+      : chroma_width((width + 1) / 2),
+        y(width * height),
+        u(chroma_width * ((height + 1) / 2)),
+        v(u.size()) {}
+
+  int chroma_width;
+  std::vector<uint8_t> y;
+  std::vector<uint8_t> u;
+  std::vector<uint8_t> v;
+};
+
+void Report(const std::string& name, size_t iterations,
+            const std::function<void()>& run) {
+  std::vector<Clock::duration> samples;
+  for (size_t i = 0; i < iterations; i++) {
+    Clock::time_point begin = Clock::now();
+    run();
+    samples.emplace_back(Clock::now() - begin);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  auto micros = [](Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  };
+  std::cout << name << ": min " << micros(samples.front()) << "us, median "
+            << micros(samples[samples.size() / 2]) << "us\n";
+}
+
+Result<void> AlphaBlendBenchmarkMain(int argc, char** argv) {
+  int32_t width = 720;
+  int32_t height = 1280;
+  size_t iterations = 200;
+  std::vector<Flag> flags;
+  flags.emplace_back(
+      GflagsCompatFlag("width", width).Help("Frame width in pixels."));
+  flags.emplace_back(
+      GflagsCompatFlag("height", height).Help("Frame height in pixels."));
+  flags.emplace_back(GflagsCompatFlag("iterations", iterations)
+                         .Help("How many frames to process per method."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(width, 0);
+  CF_EXPECT_GT(height, 0);
+  CF_EXPECT_GT(iterations, 0u);
+
+  std::mt19937 random(42);
+  const int stride = width * 4;
+  const std::vector<uint8_t> base =
+      Pixels(width, height, random, []() { return 255; });
+  const std::vector<uint8_t> transparent =
+      Pixels(width, height, random, []() { return 0; });
+  const std::vector<uint8_t> opaque =
+      Pixels(width, height, random, []() { return 255; });
+  const std::vector<uint8_t> mixed =
+      Pixels(width, height, random, [&random]() { return random(); });
+  std::vector<uint8_t> frame(base);
+  OverlayBlender blender;
+
+  std::cout << "Blending " << width << "x" << height << " frames "
+            << iterations << " times per method\n";
+  for (const auto& [name, overlay] :
+       {std::make_pair("transparent", &transparent),
+        std::make_pair("opaque", &opaque), std::make_pair("mixed", &mixed)}) {
+    Report(std::string(name) + " overlay, float", iterations,
+           [&frame, overlay, width, height]() {
+             FloatBlend(frame.data(), overlay->data(), width, height);
+           });
+    Report(std::string(name) + " overlay, OverlayBlender", iterations,
+           [&frame, &blender, overlay, stride, width, height]() {
+             blender.Blend(overlay->data(), stride, frame.data(), stride,
+                           frame.data(), stride, width, height);
+           });
+  }
+
+  std::vector<uint8_t> work(base.size());
+  std::vector<uint8_t> strip(stride * kStripRows);
+  I420Frame i420(width, height);
+  Report("compose, whole frame, float", iterations, [&]() {
+    memcpy(work.data(), base.data(), base.size());
+    FloatBlend(work.data(), mixed.data(), width, height);
+    libyuv::ARGBToI420(work.data(), stride, i420.y.data(), width,
+                       i420.u.data(), i420.chroma_width, i420.v.data(),
+                       i420.chroma_width, width, height);
+  });
+  Report("compose, whole frame, OverlayBlender", iterations, [&]() {
+    memcpy(work.data(), base.data(), base.size());
+    blender.Blend(mixed.data(), stride, work.data(), stride, work.data(),
+                  stride, width, height);
+    libyuv::ARGBToI420(work.data(), stride, i420.y.data(), width,
+                       i420.u.data(), i420.chroma_width, i420.v.data(),
+                       i420.chroma_width, width, height);
+  });
+  Report("compose, strips, OverlayBlender", iterations, [&]() {
+    for (int row = 0; row < height; row += kStripRows) {
+      const int rows = std::min(kStripRows, height - row);
+      blender.Blend(mixed.data() + row * stride, stride,
+                    base.data() + row * stride, stride, strip.data(), stride,
+                    width, rows);
+      libyuv::ARGBToI420(strip.data(), stride, i420.y.data() + row * width,
+                         width, i420.u.data() + row / 2 * i420.chroma_width,
+                         i420.chroma_width,
+                         i420.v.data() + row / 2 * i420.chroma_width,
+                         i420.chroma_width, width, rows);
+    }
+  });
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::AlphaBlendBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,128 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr int kWidth = 200;  // Not a multiple of the blend span
+constexpr int kHeight = 3;
+constexpr int kStride = kWidth * 4;
+
+std::vector<uint8_t> Fill(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+  std::vector<uint8_t> pixels(kStride * kHeight);
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    pixels[i] = r;
+    pixels[i + 1] = g;
+    pixels[i + 2] = b;
+    pixels[i + 3] = a;
+  }
+  return pixels;
+}
+
+// The straight alpha "over" operator in floating point.
+uint8_t Reference(uint8_t overlay, uint8_t base, uint8_t alpha) {
+  const float a = alpha / 255.0f;
+  return static_cast<uint8_t>(overlay * a + base * (1.0f - a) + 0.5f);
+}
+
+TEST(OverlayBlenderTest, TransparentOverlayKeepsBase) {
+  std::vector<uint8_t> overlay = Fill(10, 20, 30, 0);
+  std::vector<uint8_t> base = Fill(40, 50, 60, 255);
+  std::vector<uint8_t> dst(base.size());
+
+  OverlayBlender blender;
+  blender.Blend(overlay.data(), kStride, base.data(), kStride, dst.data(),
+                kStride, kWidth, kHeight);
+
+  EXPECT_EQ(dst, base);
+}
+
+TEST(OverlayBlenderTest, OpaqueOverlayReplacesBase) {
+  std::vector<uint8_t> overlay = Fill(10, 20, 30, 255);
+  std::vector<uint8_t> frame = Fill(40, 50, 60, 255);
+
+  OverlayBlender blender;
+  blender.Blend(overlay.data(), kStride, frame.data(), kStride, frame.data(),
+                kStride, kWidth, kHeight);
+
+  EXPECT_EQ(frame, overlay);
+}
+
+TEST(OverlayBlenderTest, MixedAlphaMatchesReference) {
+  std::mt19937 rng(1234);
+  std::vector<uint8_t> overlay(kStride * kHeight);
+  std::vector<uint8_t> base(kStride * kHeight);
+  for (size_t i = 0; i < overlay.size(); i++) {
+    overlay[i] = rng();
+    base[i] = rng();
+  }
+  // Include transparent and opaque spans next to the mixed ones.
+  for (int x = 0; x < 64; x++) {
+    overlay[x * 4 + 3] = 0;
+    overlay[kStride + x * 4 + 3] = 255;
+  }
+
+  OverlayBlender blender;
+  std::vector<uint8_t> dst = base;
+  blender.Blend(overlay.data(), kStride, dst.data(), kStride, dst.data(),
+                kStride, kWidth, kHeight);
+
+  for (size_t i = 0; i < dst.size(); i += 4) {
+    const uint8_t alpha = overlay[i + 3];
+    for (size_t c = 0; c < 3; c++) {
+      EXPECT_NEAR(dst[i + c], Reference(overlay[i + c], base[i + c], alpha), 2)
+          << "pixel " << i / 4 << " channel " << c << " alpha " << int(alpha);
+    }
+  }
+}
+
+TEST(OverlayBlenderTest, HonoursStrides) {
+  constexpr int kPadding = 16;
+  std::vector<uint8_t> overlay(kStride * kHeight, 0);
+  for (int y = 0; y < kHeight; y++) {
+    for (int x = 0; x < kWidth; x++) {
+      overlay[y * kStride + x * 4 + (y % 3)] = 200;
+      overlay[y * kStride + x * 4 + 3] = 255;
+    }
+  }
+  std::vector<uint8_t> dst((kStride + kPadding) * kHeight, 7);
+
+  OverlayBlender blender;
+  blender.Blend(overlay.data(), kStride, dst.data(), kStride + kPadding,
+                dst.data(), kStride + kPadding, kWidth, kHeight);
+
+  for (int y = 0; y < kHeight; y++) {
+    const uint8_t* row = dst.data() + y * (kStride + kPadding);
+    EXPECT_EQ(std::vector<uint8_t>(row, row + kStride),
+              std::vector<uint8_t>(overlay.data() + y * kStride,
+                                   overlay.data() + (y + 1) * kStride));
+    EXPECT_THAT(std::vector<uint8_t>(row + kStride, row + kStride + kPadding),
+                testing::Each(7));
+  }
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -29,6 +29,7 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <string_view>
@@ -42,32 +43,19 @@
 #include "libyuv.h"
 
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
 #include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
 #include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
 
-static const int kRedIdx = 0;
-static const int kGreenIdx = 1;
-static const int kBlueIdx = 2;
-static const int kAlphaIdx = 3;
-
 namespace cuttlefish {
+namespace {
 
-void alpha_blend_layer(uint8_t* frame_pixels, uint32_t h, uint32_t w,
-                       uint8_t* overlay) {
-  uint8_t* dst = frame_pixels;
-  uint8_t* src = overlay;
-  int max = w * h;
-  for (int idx = 0; idx < max; idx++) {
-    float a = ((float)src[kAlphaIdx]) / 255.0f;
-    float a_inv = 1.0f - a;
-    dst[kRedIdx] = (uint8_t)((src[kRedIdx] * a) + (dst[kRedIdx] * a_inv));
-    dst[kBlueIdx] = (uint8_t)((src[kBlueIdx] * a) + (dst[kBlueIdx] * a_inv));
-    dst[kGreenIdx] = (uint8_t)((src[kGreenIdx] * a) + (dst[kGreenIdx] * a_inv));
-    dst[kAlphaIdx] = 255;
-    dst += 4;
-    src += 4;
-  }
-}
+// Rows composed and converted together in ComposeFrame. Even, so that every
+// strip starts on a chroma row, and small enough for the blended strip to stay
+// in cache until it is converted.
+constexpr int kComposeStripRows = 16;
+
+}  // namespace
 
 std::map<int, std::vector<CompositionManager::DisplayOverlay>>
 CompositionManager::ParseOverlays(std::vector<std::string> overlay_items) {
@@ -228,64 +216,98 @@ void CompositionManager::ComposeFrame(
                last_frame_info.frame_stride_bytes_, buffer);
 }
 
-uint8_t* CompositionManager::AlphaBlendLayers(uint8_t* frame_pixels,
-                                              int display_number,
-                                              int frame_width,
-                                              int frame_height) {
-  if (cfg_overlays_.count(display_number) == 0) {
-    return frame_pixels;
+std::vector<const uint8_t*> CompositionManager::ReadOverlays(
+    int display_number, int frame_width, int frame_height) {
+  std::vector<const uint8_t*> overlays;
+  auto cfg_overlays = cfg_overlays_.find(display_number);
+  if (cfg_overlays == cfg_overlays_.end()) {
+    return overlays;
   }
-
-  std::vector<DisplayOverlay>& cfg_overlays = cfg_overlays_[display_number];
-  int num_overlays = cfg_overlays.size();
-
-  std::vector<void*> overlays;
-  overlays.resize(num_overlays, nullptr);
-
-  for (int i = 0; i < num_overlays; i++) {
-    if (overlays[i] != nullptr) {
-      continue;
-    }
-
-    DisplayOverlay& layer = cfg_overlays[i];
-
-    overlays[i] = display_ring_buffer_manager_.ReadFrame(
+  for (const DisplayOverlay& layer : cfg_overlays->second) {
+    const uint8_t* overlay = display_ring_buffer_manager_.ReadFrame(
         layer.src_vm_index, layer.src_display_index, frame_width, frame_height);
+    if (overlay) {
+      overlays.push_back(overlay);
+    }
   }
+  return overlays;
+}
 
-  for (auto i : overlays) {
-    if (i) {
-      alpha_blend_layer(frame_pixels, frame_height, frame_width, (uint8_t*)i);
+// Blends every overlay over rows [first_row, first_row + rows) of `base`,
+// writing the result to `dst`. All overlays are applied to a row before moving
+// on to the next one so that each destination row is only brought into cache
+// once.
+void CompositionManager::BlendOverlays(
+    OverlayBlender& blender, const std::vector<const uint8_t*>& overlays,
+    int frame_width, int first_row, int rows, const uint8_t* base,
+    int base_stride, uint8_t* dst, int dst_stride) {
+  const int overlay_stride = frame_width * 4;
+  for (int row = 0; row < rows; row++) {
+    const uint8_t* src = base + row * base_stride;
+    uint8_t* dst_row = dst + row * dst_stride;
+    for (const uint8_t* overlay : overlays) {
+      blender.Blend(overlay + (first_row + row) * overlay_stride,
+                    overlay_stride, src, base_stride, dst_row, dst_stride,
+                    frame_width, 1);
+      src = dst_row;
     }
   }
-  return (uint8_t*)frame_pixels;
 }
 
+uint8_t* CompositionManager::AlphaBlendLayers(uint8_t* frame_pixels,
+                                              int display_number,
+                                              int frame_width,
+                                              int frame_height) {
+  std::vector<const uint8_t*> overlays =
+      ReadOverlays(display_number, frame_width, frame_height);
+  if (!overlays.empty()) {
+    const int stride = frame_width * 4;
+    BlendOverlays(frame_blender_, overlays, frame_width, 0, frame_height,
+                  frame_pixels, stride, frame_pixels, stride);
+  }
+  return frame_pixels;
+}
+
+// Blends and converts the frame in strips of rows rather than as two passes
+// over the whole frame, so every pixel is read from memory once. Frames
+// without overlays are converted straight from the shared memory buffer.
 void CompositionManager::ComposeFrame(
     int display, int width, int height, uint32_t frame_fourcc_format,
     uint32_t frame_stride_bytes,
     std::shared_ptr<PlanarVideoFrameBuffer> buffer) {
-  uint8_t* shmem_local_display = display_ring_buffer_manager_.ReadFrame(
-      cluster_index_, display, width, height);
-
-  if (frame_work_buffer_.find(display) == frame_work_buffer_.end()) {
-    frame_work_buffer_[display] = std::vector<uint8_t>(width * height * 4);
-  }
-  uint8_t* tmp_buffer = frame_work_buffer_[display].data();
-  memcpy(tmp_buffer, shmem_local_display, width * height * 4);
-
-  AlphaBlendLayers(tmp_buffer, display, width, height);
-
+  decltype(&libyuv::ARGBToI420) to_i420;
   if (frame_fourcc_format == DRM_FORMAT_ARGB8888 ||
       frame_fourcc_format == DRM_FORMAT_XRGB8888) {
-    libyuv::ARGBToI420(tmp_buffer, frame_stride_bytes, buffer->DataY(),
-                       buffer->StrideY(), buffer->DataU(), buffer->StrideU(),
-                       buffer->DataV(), buffer->StrideV(), width, height);
+    to_i420 = &libyuv::ARGBToI420;
   } else if (frame_fourcc_format == DRM_FORMAT_ABGR8888 ||
              frame_fourcc_format == DRM_FORMAT_XBGR8888) {
-    libyuv::ABGRToI420(tmp_buffer, frame_stride_bytes, buffer->DataY(),
-                       buffer->StrideY(), buffer->DataU(), buffer->StrideU(),
-                       buffer->DataV(), buffer->StrideV(), width, height);
+    to_i420 = &libyuv::ABGRToI420;
+  } else {
+    return;
+  }
+
+  const uint8_t* shmem_local_display = display_ring_buffer_manager_.ReadFrame(
+      cluster_index_, display, width, height);
+  std::vector<const uint8_t*> overlays = ReadOverlays(display, width, height);
+
+  const int strip_stride = width * 4;
+  std::vector<uint8_t>& strip = frame_work_buffer_[display];
+  strip.resize(strip_stride * kComposeStripRows);
+
+  for (int row = 0; row < height; row += kComposeStripRows) {
+    const int rows = std::min(kComposeStripRows, height - row);
+    const uint8_t* src = shmem_local_display + row * frame_stride_bytes;
+    int src_stride = frame_stride_bytes;
+    if (!overlays.empty()) {
+      BlendOverlays(compose_blender_, overlays, width, row, rows, src,
+                    src_stride, strip.data(), strip_stride);
+      src = strip.data();
+      src_stride = strip_stride;
+    }
+    to_i420(src, src_stride, buffer->DataY() + row * buffer->StrideY(),
+            buffer->StrideY(), buffer->DataU() + row / 2 * buffer->StrideU(),
+            buffer->StrideU(), buffer->DataV() + row / 2 * buffer->StrideV(),
+            buffer->StrideV(), width, rows);
   }
 }
 
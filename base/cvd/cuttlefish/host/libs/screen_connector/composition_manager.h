@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
 #include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
 #include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
 #include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
@@ -74,6 +75,13 @@ class CompositionManager {
   };
   static std::map<int, std::vector<CompositionManager::DisplayOverlay>>
   ParseOverlays(std::vector<std::string> overlay_items);
+  std::vector<const uint8_t*> ReadOverlays(int display, int frame_width,
+                                           int frame_height);
+  static void BlendOverlays(OverlayBlender& blender,
+                            const std::vector<const uint8_t*>& overlays,
+                            int frame_width, int first_row, int rows,
+                            const uint8_t* base, int base_stride, uint8_t* dst,
+                            int dst_stride);
   uint8_t* AlphaBlendLayers(uint8_t* frame_pixels, int display, int frame_width,
                             int frame_height);
   void ComposeFrame(int display, int width, int height,
@@ -84,7 +92,12 @@ class CompositionManager {
   std::string group_uuid_;
   std::map<int, std::vector<DisplayOverlay>> cfg_overlays_;
   std::map<int, LastFrameInfo> last_frame_info_map_;
+  // Strip of blended rows per display, see ComposeFrame.
   std::map<int, std::vector<uint8_t>> frame_work_buffer_;
+  // OnFrame and ComposeFrame run on different threads, so each gets its own
+  // blender scratch space.
+  OverlayBlender frame_blender_;
+  OverlayBlender compose_blender_;
 };
 
 }  // namespace cuttlefish
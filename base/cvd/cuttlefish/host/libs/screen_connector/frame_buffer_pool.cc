@@ -0,0 +1,170 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/screen_connector/frame_buffer_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint32_t kBytesPerPixel = 4;
+
+// Frames whose damage is remembered. Buffers older than that are refreshed in
+// full. The streamer rarely holds on to more than a couple of frames.
+constexpr size_t kMaxHistory = 4;
+
+// Free buffers kept around. Any others are released.
+constexpr size_t kMaxFreeBuffers = 4;
+
+FrameDamage Union(const FrameDamage& a, const FrameDamage& b) {
+  if (a.IsEmpty()) {
+    return b;
+  } else if (b.IsEmpty()) {
+    return a;
+  }
+  const uint32_t x = std::min(a.x, b.x);
+  const uint32_t y = std::min(a.y, b.y);
+  return FrameDamage{
+      .x = x,
+      .y = y,
+      .width = std::max(a.x + a.width, b.x + b.width) - x,
+      .height = std::max(a.y + a.height, b.y + b.height) - y,
+  };
+}
+
+}  // namespace
+
+FrameBufferPool::FrameBufferPool()
+    : free_list_(std::make_shared<FreeList>()) {}
+
+FrameBufferPool::~FrameBufferPool() = default;
+
+FrameBufferPool::Buffer FrameBufferPool::Copy(const uint8_t* pixels,
+                                              uint32_t stride, uint32_t height,
+                                              const FrameDamage& damage) {
+  if (stride != stride_ || height != height_) {
+    Reset();
+    stride_ = stride;
+    height_ = height;
+  }
+  if (damage.IsEmpty() && latest_) {
+    return latest_;
+  }
+
+  frame_++;
+  history_.push_back(damage);
+  if (history_.size() > kMaxHistory) {
+    history_.pop_front();
+  }
+
+  FreeBuffer buffer = Acquire();
+  const std::optional<FrameDamage> stale = DamageSince(buffer.frame);
+  uint8_t* data = buffer.data->data();
+  if (!stale) {
+    memcpy(data, pixels, static_cast<size_t>(stride) * height);
+  } else if (!stale->IsEmpty()) {
+    const uint32_t width = stride / kBytesPerPixel;
+    const uint32_t x = std::min(stale->x, width);
+    const uint32_t y = std::min(stale->y, height);
+    const size_t row_bytes =
+        static_cast<size_t>(std::min(stale->width, width - x)) *
+        kBytesPerPixel;
+    const uint32_t rows = std::min(stale->height, height - y);
+    for (uint32_t row = y; row < y + rows; row++) {
+      const size_t offset =
+          static_cast<size_t>(row) * stride + x * kBytesPerPixel;
+      memcpy(data + offset, pixels + offset, row_bytes);
+    }
+  }
+  latest_ = Share(std::move(buffer.data));
+  return latest_;
+}
+
+void FrameBufferPool::Reset() {
+  {
+    std::lock_guard<std::mutex> lock(free_list_->mutex);
+    free_list_->buffers.clear();
+  }
+  // Buffers still in use return to a new list, with contents the pool no
+  // longer knows about.
+  free_list_ = std::make_shared<FreeList>();
+  history_.clear();
+  latest_.reset();
+}
+
+FrameBufferPool::FreeBuffer FrameBufferPool::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock(free_list_->mutex);
+    std::vector<FreeBuffer>& buffers = free_list_->buffers;
+    if (!buffers.empty()) {
+      // The most recent frame needs the least copying.
+      auto newest = std::max_element(
+          buffers.begin(), buffers.end(),
+          [](const FreeBuffer& a, const FreeBuffer& b) {
+            return a.frame < b.frame;
+          });
+      FreeBuffer buffer = std::move(*newest);
+      buffers.erase(newest);
+      return buffer;
+    }
+  }
+  return FreeBuffer{
+      .data = std::make_unique<std::vector<uint8_t>>(
+          static_cast<size_t>(stride_) * height_),
+      .frame = 0,
+  };
+}
+
+FrameBufferPool::Buffer FrameBufferPool::Share(
+    std::unique_ptr<std::vector<uint8_t>> data) {
+  std::weak_ptr<FreeList> free_list = free_list_;
+  const uint64_t frame = frame_;
+  return Buffer(data.release(), [free_list, frame](std::vector<uint8_t>* data) {
+    std::unique_ptr<std::vector<uint8_t>> owned(data);
+    std::shared_ptr<FreeList> list = free_list.lock();
+    if (!list) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(list->mutex);
+    if (list->buffers.size() < kMaxFreeBuffers) {
+      list->buffers.push_back(FreeBuffer{std::move(owned), frame});
+    }
+  });
+}
+
+std::optional<FrameDamage> FrameBufferPool::DamageSince(uint64_t frame) const {
+  if (frame == 0 || frame_ - frame > history_.size()) {
+    return std::nullopt;
+  }
+  FrameDamage damage{0, 0, 0, 0};
+  for (size_t i = history_.size() - (frame_ - frame); i < history_.size();
+       i++) {
+    damage = Union(damage, history_[i]);
+  }
+  return damage;
+}
+
+}  // namespace cuttlefish
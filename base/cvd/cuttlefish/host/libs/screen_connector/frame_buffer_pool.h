@@ -0,0 +1,84 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
+
+namespace cuttlefish {
+
+/*
+ * Recycles the buffers that frames of one display are copied into.
+ *
+ * Buffers are handed out as shared pointers and return to the pool when the
+ * last reference is dropped, from any thread. Every buffer remembers which
+ * frame it holds, and the pool remembers the damage of the latest frames, so
+ * refreshing a recycled buffer only copies the pixels that changed since it
+ * was last written, like EGL_EXT_buffer_age. A frame without damage reuses
+ * the buffer of the previous frame without copying anything.
+ *
+ * Copy() must not be called concurrently.
+ */
+class FrameBufferPool {
+ public:
+  using Buffer = std::shared_ptr<std::vector<uint8_t>>;
+
+  FrameBufferPool();
+  ~FrameBufferPool();
+
+  // Returns a buffer holding `height` rows of `stride` bytes of 32-bit pixels
+  // from `pixels`. `damage` is relative to the frame of the previous call.
+  Buffer Copy(const uint8_t* pixels, uint32_t stride, uint32_t height,
+              const FrameDamage& damage);
+
+  // Forgets the contents of all buffers, so that the next frame is copied in
+  // full.
+  void Reset();
+
+ private:
+  struct FreeBuffer {
+    std::unique_ptr<std::vector<uint8_t>> data;
+    uint64_t frame;  // 0 when the contents are unknown
+  };
+  struct FreeList {
+    std::mutex mutex;
+    std::vector<FreeBuffer> buffers;
+  };
+
+  FreeBuffer Acquire();
+  Buffer Share(std::unique_ptr<std::vector<uint8_t>> data);
+  // Bounding box of the damage of the frames after `frame`, or nullopt when
+  // the pool doesn't remember all of them.
+  std::optional<FrameDamage> DamageSince(uint64_t frame) const;
+
+  std::shared_ptr<FreeList> free_list_;
+  // Damage of the latest frames, the last element belongs to frame_.
+  std::deque<FrameDamage> history_;
+  uint64_t frame_ = 0;
+  uint32_t stride_ = 0;
+  uint32_t height_ = 0;
+  Buffer latest_;
+};
+
+}  // namespace cuttlefish
@@ -0,0 +1,167 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/screen_connector/frame_buffer_pool.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint32_t kWidth = 8;
+constexpr uint32_t kHeight = 6;
+constexpr uint32_t kStride = kWidth * 4;
+
+constexpr FrameDamage kFull{0, 0, kWidth, kHeight};
+constexpr FrameDamage kNone{0, 0, 0, 0};
+
+std::vector<uint8_t> Frame(uint8_t value) {
+  return std::vector<uint8_t>(kStride * kHeight, value);
+}
+
+uint8_t Pixel(const std::vector<uint8_t>& frame, uint32_t x, uint32_t y) {
+  return frame[y * kStride + x * 4];
+}
+
+void Paint(std::vector<uint8_t>& frame, const FrameDamage& rect,
+           uint8_t value) {
+  for (uint32_t y = rect.y; y < rect.y + rect.height; y++) {
+    for (uint32_t x = rect.x * 4; x < (rect.x + rect.width) * 4; x++) {
+      frame[y * kStride + x] = value;
+    }
+  }
+}
+
+TEST(FrameBufferPoolTest, FirstFrameIsCopied) {
+  FrameBufferPool pool;
+  std::vector<uint8_t> frame = Frame(1);
+
+  FrameBufferPool::Buffer buffer =
+      pool.Copy(frame.data(), kStride, kHeight, kNone);
+
+  EXPECT_EQ(*buffer, frame);
+}
+
+TEST(FrameBufferPoolTest, UndamagedFrameReusesBuffer) {
+  FrameBufferPool pool;
+  std::vector<uint8_t> frame = Frame(1);
+  FrameBufferPool::Buffer first =
+      pool.Copy(frame.data(), kStride, kHeight, kFull);
+
+  FrameBufferPool::Buffer second =
+      pool.Copy(frame.data(), kStride, kHeight, kNone);
+
+  EXPECT_EQ(first, second);
+}
+
+TEST(FrameBufferPoolTest, RecycledBufferOnlyCopiesDamage) {
+  FrameBufferPool pool;
+  std::vector<uint8_t> frame = Frame(1);
+  const uint8_t* first_data =
+      pool.Copy(frame.data(), kStride, kHeight, kFull)->data();
+  // The pool holds on to the latest frame, so the first buffer is only free
+  // once there is a newer one.
+  pool.Copy(frame.data(), kStride, kHeight, FrameDamage{0, 0, 1, 1});
+
+  // Pixels outside of the reported damage are not expected to change, so
+  // changing them shows what was copied.
+  const FrameDamage damage{2, 1, 3, 2};
+  frame = Frame(2);
+  Paint(frame, damage, 3);
+  FrameBufferPool::Buffer third =
+      pool.Copy(frame.data(), kStride, kHeight, damage);
+
+  EXPECT_EQ(third->data(), first_data);
+  EXPECT_EQ(Pixel(*third, 0, 0), 2);
+  EXPECT_EQ(Pixel(*third, 2, 1), 3);
+  EXPECT_EQ(Pixel(*third, 4, 2), 3);
+  EXPECT_EQ(Pixel(*third, 6, 1), 1);
+  EXPECT_EQ(Pixel(*third, 5, 2), 1);
+  EXPECT_EQ(Pixel(*third, 2, 3), 1);
+}
+
+TEST(FrameBufferPoolTest, AccumulatesDamageOfFramesInUse) {
+  FrameBufferPool pool;
+  std::vector<uint8_t> frame = Frame(0);
+  FrameBufferPool::Buffer first =
+      pool.Copy(frame.data(), kStride, kHeight, kFull);
+
+  Paint(frame, FrameDamage{0, 0, 1, 1}, 1);
+  FrameBufferPool::Buffer second =
+      pool.Copy(frame.data(), kStride, kHeight, FrameDamage{0, 0, 1, 1});
+  EXPECT_NE(first, second);
+  EXPECT_EQ(*second, frame);
+
+  // The first buffer is refreshed with the damage of both later frames.
+  first.reset();
+  Paint(frame, FrameDamage{7, 5, 1, 1}, 2);
+  FrameBufferPool::Buffer third =
+      pool.Copy(frame.data(), kStride, kHeight, FrameDamage{7, 5, 1, 1});
+  EXPECT_EQ(*third, frame);
+}
+
+TEST(FrameBufferPoolTest, OldBuffersAreCopiedInFull) {
+  FrameBufferPool pool;
+  std::vector<uint8_t> frame = Frame(0);
+  FrameBufferPool::Buffer oldest =
+      pool.Copy(frame.data(), kStride, kHeight, kFull);
+
+  std::vector<FrameBufferPool::Buffer> in_use;
+  for (uint8_t i = 1; i < 10; i++) {
+    Paint(frame, FrameDamage{0, 0, 1, 1}, i);
+    in_use.push_back(
+        pool.Copy(frame.data(), kStride, kHeight, FrameDamage{0, 0, 1, 1}));
+  }
+  oldest.reset();
+
+  // Claims to only change one pixel, but the recycled buffer is too old to
+  // be patched so all of it is refreshed.
+  frame = Frame(7);
+  FrameBufferPool::Buffer buffer =
+      pool.Copy(frame.data(), kStride, kHeight, FrameDamage{0, 0, 1, 1});
+
+  EXPECT_EQ(*buffer, frame);
+}
+
+TEST(FrameBufferPoolTest, ResizeStartsOver) {
+  FrameBufferPool pool;
+  std::vector<uint8_t> frame = Frame(1);
+  pool.Copy(frame.data(), kStride, kHeight, kFull);
+
+  std::vector<uint8_t> smaller(kStride * 2, 5);
+  FrameBufferPool::Buffer buffer =
+      pool.Copy(smaller.data(), kStride, 2, kNone);
+
+  EXPECT_EQ(*buffer, smaller);
+}
+
+TEST(FrameBufferPoolTest, BuffersMayOutliveThePool) {
+  FrameBufferPool::Buffer buffer;
+  {
+    FrameBufferPool pool;
+    std::vector<uint8_t> frame = Frame(1);
+    buffer = pool.Copy(frame.data(), kStride, kHeight, kFull);
+  }
+  EXPECT_EQ(*buffer, Frame(1));
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -91,6 +91,7 @@ class ScreenConnector : public ScreenConnectorFrameRenderer {
       uint32_t /*display_number*/, uint32_t /*frame_width*/,
       uint32_t /*frame_height*/, uint32_t /*frame_fourcc_format*/,
       uint32_t /*frame_stride_bytes*/, uint8_t* /*frame_bytes*/,
+      const FrameDamage& /*damage*/,
       /* ScImpl enqueues this type into the Q */
       ProcessedFrameType& msg)>;
 
@@ -106,35 +107,55 @@ class ScreenConnector : public ScreenConnectorFrameRenderer {
     callback_from_streamer_ = std::move(frame_callback);
     streamer_callback_set_cv_.notify_all();
 
+    // The frame callback gets its own copy of the streamer callback so that
+    // frames don't need to take streamer_callback_mutex_.
     sc_android_src_.SetFrameCallback(
-        [this](uint32_t display_number, uint32_t frame_w, uint32_t frame_h,
-               uint32_t frame_fourcc_format, uint32_t frame_stride_bytes,
-               uint8_t* frame_bytes) {
-          InjectFrame(display_number, frame_w, frame_h, frame_fourcc_format,
-                      frame_stride_bytes, frame_bytes);
+        [this, callback = callback_from_streamer_](
+            uint32_t display_number, uint32_t frame_w, uint32_t frame_h,
+            uint32_t frame_fourcc_format, uint32_t frame_stride_bytes,
+            uint8_t* frame_bytes, const FrameDamage& damage) {
+          InjectFrame(callback, display_number, frame_w, frame_h,
+                      frame_fourcc_format, frame_stride_bytes, frame_bytes,
+                      damage);
         });
   }
 
-  void InjectFrame(uint32_t display_number, uint32_t frame_w, uint32_t frame_h,
+  void InjectFrame(const GenerateProcessedFrameCallback& callback,
+                   uint32_t display_number, uint32_t frame_w, uint32_t frame_h,
                    uint32_t frame_fourcc_format, uint32_t frame_stride_bytes,
-                   uint8_t* frame_bytes) {
+                   uint8_t* frame_bytes, FrameDamage damage) {
     const bool is_confui_mode = host_mode_ctrl_.IsConfirmatioUiMode();
-    if (is_confui_mode) {
-      return;
+    {
+      std::lock_guard<std::mutex> lock(stale_displays_mutex_);
+      if (is_confui_mode) {
+        // The damage of skipped frames is lost, the next one has to be
+        // complete.
+        stale_displays_.insert(display_number);
+        return;
+      }
+      if (stale_displays_.erase(display_number)) {
+        damage = FrameDamage{0, 0, frame_w, frame_h};
+      }
     }
 
     ProcessedFrameType processed_frame;
-
-    {
-      std::lock_guard<std::mutex> lock(streamer_callback_mutex_);
-      callback_from_streamer_(display_number, frame_w, frame_h,
-                              frame_fourcc_format, frame_stride_bytes,
-                              frame_bytes, processed_frame);
-    }
+    callback(display_number, frame_w, frame_h, frame_fourcc_format,
+             frame_stride_bytes, frame_bytes, damage, processed_frame);
 
     sc_frame_multiplexer_.PushToAndroidQueue(std::move(processed_frame));
   }
 
+  // Guest frames that were replaced by a newer frame of the same display
+  // before the streamer consumed them.
+  uint64_t DroppedFrames() const {
+    return sc_frame_multiplexer_.DroppedFrames();
+  }
+
+  // Frames consumed by the streamer in place of at least one dropped frame.
+  uint64_t CoalescedFrames() const {
+    return sc_frame_multiplexer_.CoalescedFrames();
+  }
+
   bool IsCallbackSet() const override {
     if (callback_from_streamer_) {
       return true;
@@ -176,9 +197,16 @@ class ScreenConnector : public ScreenConnectorFrameRenderer {
     ConfUiLogDebug << this_thread_name
                    << "is sending a #" + std::to_string(render_confui_cnt_)
                    << "Conf UI frame";
-    callback_from_streamer_(display_number, frame_width, frame_height,
-                            frame_fourcc_format, frame_stride_bytes,
-                            frame_bytes, processed_frame);
+    {
+      // The dialog replaces the latest guest frame in the display's buffers,
+      // so the damage of the next guest frame doesn't cover all of it.
+      std::lock_guard<std::mutex> lock(stale_displays_mutex_);
+      stale_displays_.insert(display_number);
+    }
+    callback_from_streamer_(
+        display_number, frame_width, frame_height, frame_fourcc_format,
+        frame_stride_bytes, frame_bytes,
+        FrameDamage{0, 0, frame_width, frame_height}, processed_frame);
     // now add processed_frame to the queue
     sc_frame_multiplexer_.PushToConfUiQueue(std::move(processed_frame));
     return true;
@@ -199,6 +227,11 @@ class ScreenConnector : public ScreenConnectorFrameRenderer {
    * at a time from the right queue
    */
   FrameMultiplexer sc_frame_multiplexer_;
+  // Displays whose next guest frame has to be copied in full, because guest
+  // frames were dropped or a confirmation UI frame was shown since the last
+  // one.
+  std::mutex stale_displays_mutex_;
+  std::unordered_set<uint32_t> stale_displays_;
   GenerateProcessedFrameCallback callback_from_streamer_;
   std::mutex
       streamer_callback_mutex_;  // mutex to set & read callback_from_streamer_
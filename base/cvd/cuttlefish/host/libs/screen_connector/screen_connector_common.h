@@ -21,6 +21,8 @@
 #include <functional>
 #include <type_traits>
 
+#include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
+
 namespace cuttlefish {
 
 template <typename T>
@@ -37,7 +39,8 @@ using GenerateProcessedFrameCallbackImpl =
                        uint32_t /*frame_height*/,         //
                        uint32_t /*frame_fourcc_format*/,  //
                        uint32_t /*frame_stride_bytes*/,   //
-                       uint8_t* /*frame_pixels*/)>;
+                       uint8_t* /*frame_pixels*/,         //
+                       const FrameDamage& /*damage*/)>;
 
 namespace ScreenConnectorInfo {
 
@@ -18,6 +18,8 @@
 
 #include <stdint.h>
 
+#include <utility>
+
 #include "cuttlefish/common/libs/concurrency/multiplexer.h"
 #include "cuttlefish/host/libs/confui/host_mode_ctrl.h"
 #include "cuttlefish/host/libs/screen_connector/screen_connector_queue.h"
@@ -31,10 +33,11 @@ class ScreenConnectorInputMultiplexer {
  public:
   ScreenConnectorInputMultiplexer(HostModeCtrl& host_mode_ctrl)
       : host_mode_ctrl_(host_mode_ctrl) {
-    sc_android_queue_id_ =
-        multiplexer_.RegisterQueue(multiplexer_.CreateQueue(/* q size */ 2));
+    auto android_queue = multiplexer_.CreateQueue();
+    android_queue_ = android_queue.get();
+    sc_android_queue_id_ = multiplexer_.RegisterQueue(std::move(android_queue));
     sc_confui_queue_id_ =
-        multiplexer_.RegisterQueue(multiplexer_.CreateQueue(/* q size */ 2));
+        multiplexer_.RegisterQueue(multiplexer_.CreateQueue());
   }
 
   virtual ~ScreenConnectorInputMultiplexer() = default;
@@ -47,6 +50,12 @@ class ScreenConnectorInputMultiplexer {
     multiplexer_.Push(sc_confui_queue_id_, std::move(t));
   }
 
+  // Android frames replaced by a newer frame before the streamer got them.
+  uint64_t DroppedFrames() const { return android_queue_->DroppedFrames(); }
+
+  // Android frames delivered in place of at least one dropped frame.
+  uint64_t CoalescedFrames() const { return android_queue_->CoalescedFrames(); }
+
   // customize Pop()
   ProcessedFrameType Pop() {
     on_next_frame_cnt_++;
@@ -93,6 +102,7 @@ class ScreenConnectorInputMultiplexer {
  private:
   HostModeCtrl& host_mode_ctrl_;
   Multiplexer multiplexer_;
+  Queue* android_queue_;  // Owned by multiplexer_
   unsigned long long int on_next_frame_cnt_;
   int sc_android_queue_id_;
   int sc_confui_queue_id_;
@@ -16,94 +16,162 @@
 
 #pragma once
 
-#include <condition_variable>
-#include <deque>
-#include <memory>
-#include <mutex>
-#include <thread>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <optional>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
 
-#include "cuttlefish/common/libs/concurrency/semaphore.h"
 #include "cuttlefish/host/libs/screen_connector/screen_connector_common.h"
 
 namespace cuttlefish {
-// move-based concurrent queue
+
+/*
+ * Frame queue with "latest frame wins" semantics, keyed by the display_number_
+ * of the frames.
+ *
+ * Every display has a lock-free single-producer/single-consumer slot. Pushing a
+ * frame for a display whose previous frame has not been popped yet replaces
+ * that frame instead of waiting for the consumer, so a slow consumer never
+ * stalls the producer, and frames of one display never wait behind those of
+ * another.
+ *
+ * Only one thread may Push and only one thread may Pop at a time.
+ */
 template <typename T>
 class ScreenConnectorQueue {
  public:
   static_assert(is_movable<T>::value,
                 "Items in ScreenConnectorQueue should be std::mov-able");
 
-  ScreenConnectorQueue(const int q_max_size = 2)
-      : q_mutex_(std::make_unique<std::mutex>()), q_max_size_{q_max_size} {}
+  // virtio-gpu supports at most 16 scanouts.
+  static constexpr size_t kMaxDisplays = 16;
+
+  ScreenConnectorQueue() = default;
   ScreenConnectorQueue(ScreenConnectorQueue&& cq) = delete;
   ScreenConnectorQueue(const ScreenConnectorQueue& cq) = delete;
   ScreenConnectorQueue& operator=(const ScreenConnectorQueue& cq) = delete;
   ScreenConnectorQueue& operator=(ScreenConnectorQueue&& cq) = delete;
 
-  bool IsEmpty() const {
-    const std::lock_guard<std::mutex> lock(*q_mutex_);
-    return buffer_.empty();
-  }
-
-  auto Size() const {
-    const std::lock_guard<std::mutex> lock(*q_mutex_);
-    return buffer_.size();
-  }
+  bool IsEmpty() const { return Size() == 0; }
 
-  void WaitEmpty() {
-    auto is_empty = [this](void) { return buffer_.empty(); };
-    std::unique_lock<std::mutex> lock(*q_mutex_);
-    q_empty_.wait(lock, is_empty);
+  size_t Size() const {
+    size_t size = 0;
+    for (const Slot& slot : slots_) {
+      size += slot.HasFrame() ? 1 : 0;
+    }
+    return size;
   }
 
   /*
-   * Push( std::move(src) );
-   *
-   * Note: this queue is supposed to be used only by ScreenConnector-
-   * related components such as ScreenConnectorSource
-   *
-   * The traditional assumption was that when webRTC calls
-   * OnFrameAfter, the call should be block until it could return
-   * one frame.
-   *
-   * Thus, the producers of this queue must not produce frames
-   * much faster than the consumer, WebRTC consumes.
-   * Therefore, when the small buffer is full -- which means
-   * WebRTC would not call OnNextFrame --, the producer
-   * should stop adding items to the queue.
-   *
+   * Returns false when `item` replaced a frame of the same display that was
+   * still waiting to be popped, and true when the queue grew by one item.
    */
-  void Push(T&& item) {
-    std::unique_lock<std::mutex> lock(*q_mutex_);
-    if (Full()) {
-      auto is_empty = [this](void) { return buffer_.empty(); };
-      q_empty_.wait(lock, is_empty);
+  bool Push(T&& item) {
+    CHECK_LT(item.display_number_, kMaxDisplays) << "Display out of range";
+    if (slots_[item.display_number_].Put(std::move(item))) {
+      return true;
     }
-    buffer_.push_back(std::move(item));
+    dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+    return false;
   }
-  void Push(T& item) = delete;
-  void Push(const T& item) = delete;
+  bool Push(T& item) = delete;
+  bool Push(const T& item) = delete;
 
+  /*
+   * Pops the latest frame of one of the displays, visiting the displays in
+   * turn so that a busy display can't starve the others. Must only be called
+   * when the queue is not empty.
+   */
   T Pop() {
-    const std::lock_guard<std::mutex> lock(*q_mutex_);
-    auto item = std::move(buffer_.front());
-    buffer_.pop_front();
-    if (buffer_.empty()) {
-      q_empty_.notify_all();
+    for (size_t i = 0; i < kMaxDisplays; i++) {
+      const size_t display = (next_display_ + i) % kMaxDisplays;
+      bool coalesced = false;
+      std::optional<T> item = slots_[display].Take(coalesced);
+      if (item) {
+        next_display_ = display + 1;
+        if (coalesced) {
+          coalesced_frames_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return std::move(*item);
+      }
     }
-    return item;
+    LOG(FATAL) << "Pop() called on an empty ScreenConnectorQueue";
   }
 
- private:
-  bool Full() const {
-    // call this in a critical section
-    // after acquiring q_mutex_
-    return q_max_size_ == buffer_.size();
+  // Frames that were replaced by a newer frame before being popped.
+  uint64_t DroppedFrames() const {
+    return dropped_frames_.load(std::memory_order_relaxed);
   }
-  std::deque<T> buffer_;
-  std::unique_ptr<std::mutex> q_mutex_;
-  std::condition_variable q_empty_;
-  const int q_max_size_;
+
+  // Popped frames that stood in for at least one dropped frame.
+  uint64_t CoalescedFrames() const {
+    return coalesced_frames_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /*
+   * Triple buffer: the producer fills the back buffer and swaps it with the
+   * middle one, the consumer swaps the middle buffer with the front one when
+   * it holds a frame it has not taken yet. Neither side ever waits.
+   */
+  class alignas(64) Slot {
+   public:
+    // Producer side, returns whether the slot was empty.
+    bool Put(T&& item) {
+      buffers_[back_] = std::move(item);
+      uint8_t previous = middle_.load(std::memory_order_relaxed);
+      uint8_t next;
+      do {
+        next = back_ | kFresh | ((previous & kFresh) ? kCoalesced : 0);
+      } while (!middle_.compare_exchange_weak(previous, next,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_relaxed));
+      back_ = previous & kIndexMask;
+      if (previous & kFresh) {
+        // Release the stale frame now rather than when the buffer is reused.
+        buffers_[back_] = T();
+        return false;
+      }
+      return true;
+    }
+
+    // Consumer side.
+    std::optional<T> Take(bool& coalesced) {
+      if (!HasFrame()) {
+        return std::nullopt;
+      }
+      const uint8_t previous =
+          middle_.exchange(front_, std::memory_order_acq_rel);
+      front_ = previous & kIndexMask;
+      coalesced = previous & kCoalesced;
+      return std::move(buffers_[front_]);
+    }
+
+    bool HasFrame() const {
+      return middle_.load(std::memory_order_acquire) & kFresh;
+    }
+
+   private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+    static constexpr uint8_t kCoalesced = 0x8;
+
+    std::array<T, 3> buffers_;
+    // Index of the middle buffer, plus the kFresh and kCoalesced flags.
+    std::atomic<uint8_t> middle_ = 0;
+    uint8_t back_ = 1;   // Only accessed by the producer
+    uint8_t front_ = 2;  // Only accessed by the consumer
+  };
+
+  std::array<Slot, kMaxDisplays> slots_;
+  size_t next_display_ = 0;  // Only accessed by the consumer
+  std::atomic<uint64_t> dropped_frames_ = 0;
+  std::atomic<uint64_t> coalesced_frames_ = 0;
 };
 
 }  // namespace cuttlefish
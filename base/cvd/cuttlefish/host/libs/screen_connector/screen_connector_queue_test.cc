@@ -0,0 +1,122 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/screen_connector/screen_connector_queue.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/concurrency/multiplexer.h"
+#include "cuttlefish/host/libs/screen_connector/screen_connector_common.h"
+
+namespace cuttlefish {
+namespace {
+
+struct Frame : ScreenConnectorFrameInfo {
+  Frame() = default;
+  Frame(uint32_t display, int id) : id(std::make_unique<int>(id)) {
+    display_number_ = display;
+  }
+
+  std::unique_ptr<int> id;
+};
+
+TEST(ScreenConnectorQueueTest, LatestFrameWins) {
+  ScreenConnectorQueue<Frame> queue;
+
+  EXPECT_TRUE(queue.Push(Frame(0, 1)));
+  EXPECT_FALSE(queue.Push(Frame(0, 2)));
+  EXPECT_FALSE(queue.Push(Frame(0, 3)));
+  EXPECT_EQ(queue.Size(), 1);
+
+  Frame frame = queue.Pop();
+  EXPECT_EQ(*frame.id, 3);
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_EQ(queue.DroppedFrames(), 2);
+  EXPECT_EQ(queue.CoalescedFrames(), 1);
+
+  EXPECT_TRUE(queue.Push(Frame(0, 4)));
+  EXPECT_EQ(*queue.Pop().id, 4);
+  EXPECT_EQ(queue.DroppedFrames(), 2);
+  EXPECT_EQ(queue.CoalescedFrames(), 1);
+}
+
+TEST(ScreenConnectorQueueTest, DisplaysAreIndependent) {
+  ScreenConnectorQueue<Frame> queue;
+
+  EXPECT_TRUE(queue.Push(Frame(0, 1)));
+  EXPECT_TRUE(queue.Push(Frame(3, 2)));
+  EXPECT_FALSE(queue.Push(Frame(0, 3)));
+  EXPECT_EQ(queue.Size(), 2);
+
+  std::map<uint32_t, int> popped;
+  for (int i = 0; i < 2; i++) {
+    Frame frame = queue.Pop();
+    popped[frame.display_number_] = *frame.id;
+  }
+  EXPECT_EQ(popped, (std::map<uint32_t, int>{{0, 3}, {3, 2}}));
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(ScreenConnectorQueueTest, BusyDisplayDoesNotStarveOthers) {
+  ScreenConnectorQueue<Frame> queue;
+
+  queue.Push(Frame(0, 1));
+  queue.Push(Frame(1, 2));
+  EXPECT_EQ(queue.Pop().display_number_, 0);
+  queue.Push(Frame(0, 3));
+  EXPECT_EQ(queue.Pop().display_number_, 1);
+  EXPECT_EQ(queue.Pop().display_number_, 0);
+}
+
+TEST(ScreenConnectorQueueTest, MultiplexerCountsOnlyNewFrames) {
+  using Queue = ScreenConnectorQueue<Frame>;
+  Multiplexer<Frame, Queue> multiplexer;
+  const int id = multiplexer.RegisterQueue(multiplexer.CreateQueue());
+
+  constexpr int kDisplays = 4;
+  constexpr int kFramesPerDisplay = 20000;
+  std::thread producer([&multiplexer, id]() {
+    for (int i = 1; i <= kFramesPerDisplay; i++) {
+      for (int display = 0; display < kDisplays; display++) {
+        multiplexer.Push(id, Frame(display, i));
+      }
+    }
+  });
+
+  // Every Pop() must find a frame, and each display must see its frames in
+  // order and end with the last one.
+  std::map<uint32_t, int> last;
+  while (last.size() < kDisplays ||
+         std::any_of(last.begin(), last.end(), [](const auto& entry) {
+           return entry.second != kFramesPerDisplay;
+         })) {
+    Frame frame = multiplexer.Pop();
+    int& previous = last[frame.display_number_];
+    ASSERT_GT(*frame.id, previous);
+    previous = *frame.id;
+  }
+  producer.join();
+  EXPECT_TRUE(multiplexer.IsEmpty(id));
+}
+
+}  // namespace
+}  // namespace cuttlefish
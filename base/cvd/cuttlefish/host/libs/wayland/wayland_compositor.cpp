@@ -74,6 +74,11 @@ void surface_damage(wl_client*, wl_resource* surface_resource, int32_t x,
                     int32_t y, int32_t w, int32_t h) {
   VLOG(1) << __FUNCTION__ << " surface=" << surface_resource << " x=" << x
           << " y=" << y << " w=" << w << " h=" << h;
+
+  // Buffer scale and transform are not supported, so surface coordinates are
+  // buffer coordinates.
+  GetUserData<Surface>(surface_resource)
+      ->Damage(Surface::Region{.x = x, .y = y, .w = w, .h = h});
 }
 
 void surface_frame(wl_client*, wl_resource* surface, uint32_t) {
@@ -119,6 +124,9 @@ void surface_damage_buffer(wl_client*, wl_resource* surface_resource, int32_t x,
                            int32_t y, int32_t w, int32_t h) {
   VLOG(1) << __FUNCTION__ << " surface=" << surface_resource << " x=" << x
           << " y=" << y << " w=" << w << " h=" << h;
+
+  GetUserData<Surface>(surface_resource)
+      ->Damage(Surface::Region{.x = x, .y = y, .w = w, .h = h});
 }
 
 const struct wl_surface_interface surface_implementation = {
@@ -31,5 +31,17 @@ struct DisplayDestroyedEvent {
   uint32_t display_number;
 };
 
+// Bounding box of the pixels of a frame that may differ from the previous frame
+// of the same display. Frames with an empty damage are identical to the
+// previous frame.
+struct FrameDamage {
+  uint32_t x;
+  uint32_t y;
+  uint32_t width;
+  uint32_t height;
+
+  bool IsEmpty() const { return width == 0 || height == 0; }
+};
+
 using DisplayEvent = std::variant<DisplayCreatedEvent, DisplayDestroyedEvent>;
 using DisplayEventCallback = std::function<void(const DisplayEvent&)>;
@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <sys/mman.h>
 
+#include <algorithm>
 #include <mutex>
 
 #include "absl/log/check.h"
@@ -60,6 +61,53 @@ void Surface::SetRegion(const Region& region) {
   state_.region = region;
 }
 
+void Surface::Damage(const Region& region) {
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  state_.client_reports_damage = true;
+  if (!state_.pending_damage) {
+    state_.pending_damage = region;
+    return;
+  }
+  // Clients commonly damage the whole surface with INT32_MAX sized regions.
+  Region& damage = *state_.pending_damage;
+  const int64_t right = std::max<int64_t>(int64_t{damage.x} + damage.w,
+                                          int64_t{region.x} + region.w);
+  const int64_t bottom = std::max<int64_t>(int64_t{damage.y} + damage.h,
+                                           int64_t{region.y} + region.h);
+  damage.x = std::min(damage.x, region.x);
+  damage.y = std::min(damage.y, region.y);
+  damage.w = std::min<int64_t>(right - damage.x, INT32_MAX);
+  damage.h = std::min<int64_t>(bottom - damage.y, INT32_MAX);
+}
+
+FrameDamage Surface::TakeDamage(uint32_t frame_width, uint32_t frame_height) {
+  std::optional<Region> pending = std::move(state_.pending_damage);
+  state_.pending_damage.reset();
+
+  const bool size_changed = frame_width != state_.last_frame_width ||
+                            frame_height != state_.last_frame_height;
+  state_.last_frame_width = frame_width;
+  state_.last_frame_height = frame_height;
+  if (size_changed || !state_.client_reports_damage) {
+    return FrameDamage{0, 0, frame_width, frame_height};
+  }
+  if (!pending) {
+    return FrameDamage{0, 0, 0, 0};
+  }
+  const int64_t left = std::clamp<int64_t>(pending->x, 0, frame_width);
+  const int64_t top = std::clamp<int64_t>(pending->y, 0, frame_height);
+  const int64_t right =
+      std::clamp<int64_t>(int64_t{pending->x} + pending->w, left, frame_width);
+  const int64_t bottom =
+      std::clamp<int64_t>(int64_t{pending->y} + pending->h, top, frame_height);
+  return FrameDamage{
+      static_cast<uint32_t>(left),
+      static_cast<uint32_t>(top),
+      static_cast<uint32_t>(right - left),
+      static_cast<uint32_t>(bottom - top),
+  };
+}
+
 void Surface::Attach(struct wl_resource* buffer) {
   std::unique_lock<std::mutex> lock(state_mutex_);
   state_.pending_buffer = buffer;
@@ -129,7 +177,8 @@ void Surface::Commit() {
     if (buffer_pixels != nullptr) {
       surfaces_.HandleSurfaceFrame(display_number, buffer_w, buffer_h,
                                    buffer_drm_format, buffer_stride_bytes,
-                                   buffer_pixels);
+                                   buffer_pixels,
+                                   TakeDamage(buffer_w, buffer_h));
     }
 
     if (shm_buffer != nullptr) {
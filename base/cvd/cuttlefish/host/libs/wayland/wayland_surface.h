@@ -23,6 +23,8 @@
 
 #include "wayland-server-core.h"
 
+#include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
+
 namespace wayland {
 
 class Surfaces;
@@ -48,6 +50,9 @@ class Surface {
 
   void SetRegion(const Region& region);
 
+  // Marks a part of the pending frame as changed.
+  void Damage(const Region& region);
+
   // Sets the buffer of the pending frame.
   void Attach(struct wl_resource* buffer);
 
@@ -57,6 +62,10 @@ class Surface {
   void SetVirtioGpuScanoutId(uint32_t scanout);
 
  private:
+  // Consumes the damage of the frame being committed. Called with
+  // state_mutex_ held.
+  FrameDamage TakeDamage(uint32_t frame_width, uint32_t frame_height);
+
   Surfaces& surfaces_;
 
   struct VirtioGpuMetadata {
@@ -75,6 +84,16 @@ class Surface {
     // The buffers expected dimensions.
     Region region;
 
+    // Bounding box of the damage reported since the last frame.
+    std::optional<Region> pending_damage;
+
+    // Clients that never report damage get every frame fully damaged.
+    bool client_reports_damage = false;
+
+    // Size of the last frame, the first frame of any size is fully damaged.
+    uint32_t last_frame_width = 0;
+    uint32_t last_frame_height = 0;
+
     VirtioGpuMetadata virtio_gpu_metadata_;
 
     bool has_notified_surface_create = false;
@@ -45,7 +45,8 @@ void Surfaces::HandleSurfaceFrame(uint32_t display_number, uint32_t frame_width,
                                   uint32_t frame_height,
                                   uint32_t frame_fourcc_format,
                                   uint32_t frame_stride_bytes,
-                                  uint8_t* frame_bytes) {
+                                  uint8_t* frame_bytes,
+                                  const FrameDamage& damage) {
   if (frames_are_rgba_) {
     frame_fourcc_format = DRM_FORMAT_ABGR8888;
   }
@@ -54,7 +55,8 @@ void Surfaces::HandleSurfaceFrame(uint32_t display_number, uint32_t frame_width,
 
   if (callback_) {
     (callback_.value())(display_number, frame_width, frame_height,
-                        frame_fourcc_format, frame_stride_bytes, frame_bytes);
+                        frame_fourcc_format, frame_stride_bytes, frame_bytes,
+                        damage);
   }
 }
 
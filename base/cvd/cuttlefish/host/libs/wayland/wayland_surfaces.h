@@ -47,7 +47,8 @@ class Surfaces {
                                            uint32_t /*frame_height*/,         //
                                            uint32_t /*frame_fourcc_format*/,  //
                                            uint32_t /*frame_stride_bytes*/,   //
-                                           uint8_t* /*frame_bytes*/)>;
+                                           uint8_t* /*frame_bytes*/,          //
+                                           const FrameDamage& /*damage*/)>;
 
   void SetFrameCallback(FrameCallback callback);
 
@@ -62,7 +63,8 @@ class Surfaces {
                           uint32_t frame_height,         //
                           uint32_t frame_fourcc_format,  //
                           uint32_t frame_stride_bytes,   //
-                          uint8_t* frame_bytes);
+                          uint8_t* frame_bytes,          //
+                          const FrameDamage& damage);
 
   void HandleSurfaceCreated(uint32_t display_number, uint32_t display_width,
                             uint32_t display_height);
@@ -96,12 +96,14 @@ AndroidBuildApi::AndroidBuildApi(HttpClient& http_client,
                                  AndroidBuildUrl& android_build_url,
                                  CredentialSource* credential_source,
                                  const std::chrono::seconds retry_period,
-                                 CasDownloader* cas_downloader)
+                                 CasDownloader* cas_downloader,
+                                 RangedDownloadOptions download_options)
     : http_client_(http_client),
       android_build_url_(android_build_url),
       credential_source_(credential_source),
       retry_period_(retry_period),
-      cas_downloader_(cas_downloader) {}
+      cas_downloader_(cas_downloader),
+      download_options_(download_options) {}
 
 Result<Build> AndroidBuildApi::GetBuild(const DeviceBuildString& build_string) {
   CF_EXPECT(
@@ -395,7 +397,8 @@ Result<void> AndroidBuildApi::ArtifactToFile(const DeviceBuild& build,
                                              const std::string& artifact,
                                              const std::string& path) {
   const auto url = CF_EXPECT(GetArtifactDownloadUrl(build, artifact));
-  auto response = CF_EXPECT(HttpGetToFile(http_client_, url, path));
+  auto response = CF_EXPECT(
+      HttpGetToFileRanged(http_client_, url, path, {}, download_options_));
   CF_EXPECTF(response.HttpSuccess(), "Failed to download file: {}",
              response.StatusDescription());
   return {};
@@ -30,6 +30,7 @@
 #include "cuttlefish/host/libs/web/cas/cas_downloader.h"
 #include "cuttlefish/host/libs/web/credential_source.h"
 #include "cuttlefish/host/libs/web/http_client/http_client.h"
+#include "cuttlefish/host/libs/web/http_client/http_file.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/result/result.h"
 
@@ -44,7 +45,8 @@ class AndroidBuildApi : public BuildApi {
       HttpClient& http_client, AndroidBuildUrl& android_build_url,
       CredentialSource* credential_source = nullptr,
       std::chrono::seconds retry_period = std::chrono::seconds::zero(),
-      CasDownloader* cas_downloader = nullptr);
+      CasDownloader* cas_downloader = nullptr,
+      RangedDownloadOptions download_options = {});
 
   Result<Build> GetBuild(const BuildString& build_string) override;
 
@@ -117,6 +119,7 @@ class AndroidBuildApi : public BuildApi {
   CredentialSource* credential_source_;
   std::chrono::seconds retry_period_;
   CasDownloader* cas_downloader_;
+  RangedDownloadOptions download_options_;
 };
 
 std::tuple<std::string, std::string> GetBuildIdAndTarget(const Build& build);
@@ -0,0 +1,426 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/web/artifact_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "android-base/file.h"
+#include "fmt/format.h"
+#include "json/value.h"
+#include "json/writer.h"
+#include "openssl/sha.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/common/libs/utils/json.h"
+#include "cuttlefish/files/file_exists.h"
+#include "cuttlefish/io/copy.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/posix/remove.h"
+#include "cuttlefish/posix/rename.h"
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr char kIndexFile[] = "index.json";
+// Lookups append "<digest> <last access>" lines here instead of rewriting the
+// index, and the next rewrite of the index folds them in.
+constexpr char kAccessLogFile[] = "access.log";
+constexpr char kLockFile[] = "index.lock";
+constexpr char kObjectsDirectory[] = "objects";
+constexpr char kStagingDirectory[] = "staging";
+
+constexpr size_t kHashBufferSize = 1 << 20;
+constexpr size_t kCopyBufferSize = 1 << 20;
+
+struct StoredObject {
+  uint64_t size = 0;
+  // Milliseconds since the epoch
+  int64_t last_access = 0;
+  std::set<std::string> references;
+};
+
+struct Index {
+  // Always the sum of the sizes in `objects`
+  uint64_t total_size = 0;
+  // Keyed by the hex SHA-256 digest of the contents
+  std::map<std::string, StoredObject> objects;
+  // Maps every reference back to the digest of its object
+  std::map<std::string, std::string> digests;
+  // The largest `last_access` in `objects`
+  int64_t latest_access = 0;
+};
+
+struct HashedFile {
+  std::string digest;
+  uint64_t size;
+};
+
+// Access times are kept increasing so that accesses within the same
+// millisecond, or across a clock adjustment, still evict in order.
+int64_t NextAccess(const Index& index) {
+  const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+  return std::max(now, index.latest_access + 1);
+}
+
+void Touch(Index& index, StoredObject& object) {
+  index.latest_access = NextAccess(index);
+  object.last_access = index.latest_access;
+}
+
+std::string ObjectPath(const std::string& root, const std::string& digest) {
+  // Fanning out on the first byte keeps directories small for large caches.
+  return fmt::format("{}/{}/{}/{}", root, kObjectsDirectory,
+                     digest.substr(0, 2), digest);
+}
+
+Result<HashedFile> HashFile(const std::string& path) {
+  SharedFD fd = SharedFD::Open(path, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open \"{}\": {}", path, fd->StrError());
+
+  SHA256_CTX context;
+  SHA256_Init(&context);
+  std::vector<char> buffer(kHashBufferSize);
+  HashedFile result{.size = 0};
+  uint64_t bytes_read;
+  while ((bytes_read = CF_EXPECT(fd->Read(buffer.data(), buffer.size()))) >
+         0) {
+    SHA256_Update(&context, buffer.data(), bytes_read);
+    result.size += bytes_read;
+  }
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256_Final(digest, &context);
+  for (const uint8_t byte : digest) {
+    fmt::format_to(std::back_inserter(result.digest), "{:02x}", byte);
+  }
+  return result;
+}
+
+// The lock is held until the returned descriptor is closed. Lookups share it,
+// everything that rewrites the index holds it exclusively.
+Result<SharedFD> LockIndex(const std::string& root, int operation = LOCK_EX) {
+  const std::string path = fmt::format("{}/{}", root, kLockFile);
+  SharedFD fd = SharedFD::Open(path, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open \"{}\": {}", path, fd->StrError());
+  CF_EXPECT(fd->Flock(operation));
+  return fd;
+}
+
+// Appends are single small writes to an O_APPEND file, so concurrent lookups
+// holding the shared lock don't interleave their lines.
+Result<void> LogAccess(const std::string& root, const std::string& digest,
+                       int64_t last_access) {
+  const std::string path = fmt::format("{}/{}", root, kAccessLogFile);
+  SharedFD fd = SharedFD::Open(path, O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
+                               0644);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open \"{}\": {}", path, fd->StrError());
+  const std::string line = fmt::format("{} {}\n", digest, last_access);
+  CF_EXPECTF(fd->Write(line.data(), line.size()) ==
+                 static_cast<ssize_t>(line.size()),
+             "Failed to write \"{}\": {}", path, fd->StrError());
+  return {};
+}
+
+// Unparseable lines, such as one torn by a crash, only lose an access time.
+void ApplyAccessLog(const std::string& root, Index& index) {
+  std::string log;
+  if (!android::base::ReadFileToString(
+          fmt::format("{}/{}", root, kAccessLogFile), &log)) {
+    return;
+  }
+  std::istringstream lines(log);
+  std::string line;
+  while (std::getline(lines, line)) {
+    std::istringstream fields(line);
+    std::string digest;
+    int64_t last_access;
+    if (!(fields >> digest >> last_access)) {
+      continue;
+    }
+    auto it = index.objects.find(digest);
+    if (it == index.objects.end()) {
+      continue;  // Evicted since
+    }
+    it->second.last_access = std::max(it->second.last_access, last_access);
+    index.latest_access = std::max(index.latest_access, last_access);
+  }
+}
+
+Result<Index> LoadIndex(const std::string& root) {
+  const std::string path = fmt::format("{}/{}", root, kIndexFile);
+  Index index;
+  if (!FileExists(path)) {
+    ApplyAccessLog(root, index);
+    return index;
+  }
+  const Json::Value json = CF_EXPECTF(
+      LoadFromFile(path),
+      "Unreadable artifact store index \"{}\", `cvd cache empty` resets it",
+      path);
+  index.total_size = json["total_size"].asUInt64();
+  const Json::Value& objects = json["objects"];
+  for (const std::string& digest : objects.getMemberNames()) {
+    const Json::Value& entry = objects[digest];
+    StoredObject& object = index.objects[digest];
+    object.size = entry["size"].asUInt64();
+    object.last_access = entry["last_access"].asInt64();
+    index.latest_access = std::max(index.latest_access, object.last_access);
+    for (const Json::Value& reference : entry["references"]) {
+      object.references.insert(reference.asString());
+      index.digests[reference.asString()] = digest;
+    }
+  }
+  ApplyAccessLog(root, index);
+  return index;
+}
+
+Result<void> SaveIndex(const std::string& root, const Index& index) {
+  Json::Value json(Json::objectValue);
+  json["total_size"] = Json::UInt64(index.total_size);
+  Json::Value& objects = json["objects"] = Json::Value(Json::objectValue);
+  for (const auto& [digest, object] : index.objects) {
+    Json::Value& entry = objects[digest];
+    entry["size"] = Json::UInt64(object.size);
+    entry["last_access"] = Json::Int64(object.last_access);
+    Json::Value& references = entry["references"] =
+        Json::Value(Json::arrayValue);
+    for (const std::string& reference : object.references) {
+      references.append(reference);
+    }
+  }
+  Json::StreamWriterBuilder factory;
+  factory["indentation"] = "";
+
+  // Written aside and renamed over so that a crash never leaves a torn index.
+  const std::string path = fmt::format("{}/{}", root, kIndexFile);
+  const std::string temporary_path = path + ".tmp";
+  CF_EXPECTF(android::base::WriteStringToFile(Json::writeString(factory, json),
+                                              temporary_path),
+             "Failed to write \"{}\": {}", temporary_path, StrError(errno));
+  CF_EXPECT(Rename(temporary_path, path));
+  // The index now holds every logged access.
+  const std::string access_log = fmt::format("{}/{}", root, kAccessLogFile);
+  CF_EXPECTF(unlink(access_log.c_str()) == 0 || errno == ENOENT,
+             "Failed to unlink \"{}\": {}", access_log, StrError(errno));
+  return {};
+}
+
+Result<void> RemoveObject(const std::string& root, Index& index,
+                          const std::string& digest) {
+  auto it = index.objects.find(digest);
+  if (it == index.objects.end()) {
+    return {};
+  }
+  const std::string path = ObjectPath(root, digest);
+  CF_EXPECTF(unlink(path.c_str()) == 0 || errno == ENOENT,
+             "Failed to unlink \"{}\": {}", path, StrError(errno));
+  for (const std::string& reference : it->second.references) {
+    index.digests.erase(reference);
+  }
+  index.total_size -= it->second.size;
+  index.objects.erase(it);
+  return {};
+}
+
+// Objects are deleted as soon as nothing refers to them, as no key could ever
+// find them again.
+Result<void> RemoveReference(const std::string& root, Index& index,
+                             const std::string& key) {
+  auto it = index.digests.find(key);
+  if (it == index.digests.end()) {
+    return {};
+  }
+  const std::string digest = it->second;
+  index.digests.erase(it);
+  StoredObject& object = index.objects[digest];
+  object.references.erase(key);
+  if (object.references.empty()) {
+    CF_EXPECT(RemoveObject(root, index, digest));
+  }
+  return {};
+}
+
+}  // namespace
+
+ArtifactStore::ArtifactStore(std::string root) : root_(std::move(root)) {}
+
+Result<ArtifactStore> ArtifactStore::Open(std::string root) {
+  CF_EXPECT(EnsureDirectoryExists(root));
+  return ArtifactStore(std::move(root));
+}
+
+Result<std::optional<std::string>> ArtifactStore::Lookup(
+    const std::string& key) {
+  SharedFD lock = CF_EXPECT(LockIndex(root_, LOCK_SH));
+  Index index = CF_EXPECT(LoadIndex(root_));
+  auto it = index.digests.find(key);
+  if (it == index.digests.end()) {
+    VLOG(1) << "\"" << key << "\" not in artifact store";
+    return std::nullopt;
+  }
+  const std::string digest = it->second;
+  const std::string path = ObjectPath(root_, digest);
+  if (!FileExists(path)) {
+    LOG(WARNING) << "Artifact store object \"" << path
+                 << "\" is missing, dropping it from the index";
+    lock->Close();
+    lock = CF_EXPECT(LockIndex(root_));
+    index = CF_EXPECT(LoadIndex(root_));
+    if (!FileExists(path)) {
+      CF_EXPECT(RemoveObject(root_, index, digest));
+      CF_EXPECT(SaveIndex(root_, index));
+    }
+    return std::nullopt;
+  }
+  CF_EXPECT(LogAccess(root_, digest, NextAccess(index)));
+  VLOG(1) << "Found \"" << key << "\" in artifact store as \"" << path << "\"";
+  return path;
+}
+
+Result<std::string> ArtifactStore::Insert(const std::string& key,
+                                          const std::string& file) {
+  // Hashing can take a while for large images, so it happens before taking
+  // the lock.
+  const HashedFile hashed = CF_EXPECT(HashFile(file));
+
+  SharedFD lock = CF_EXPECT(LockIndex(root_));
+  Index index = CF_EXPECT(LoadIndex(root_));
+  auto previous = index.digests.find(key);
+  if (previous != index.digests.end() && previous->second != hashed.digest) {
+    CF_EXPECT(RemoveReference(root_, index, key));
+  }
+
+  const std::string path = ObjectPath(root_, hashed.digest);
+  auto existing = index.objects.find(hashed.digest);
+  if (existing != index.objects.end() && FileExists(path)) {
+    VLOG(1) << "\"" << key << "\" has the same contents as \"" << path << "\"";
+    CF_EXPECT(RemoveFile(file));
+  } else {
+    // Drops any index entry whose file went missing.
+    CF_EXPECT(RemoveObject(root_, index, hashed.digest));
+    CF_EXPECT(EnsureDirectoryExists(android::base::Dirname(path)));
+    CF_EXPECT(Rename(file, path));
+    index.objects[hashed.digest].size = hashed.size;
+    index.total_size += hashed.size;
+  }
+  StoredObject& object = index.objects[hashed.digest];
+  object.references.insert(key);
+  Touch(index, object);
+  index.digests[key] = hashed.digest;
+  CF_EXPECT(SaveIndex(root_, index));
+  return path;
+}
+
+Result<std::string> ArtifactStore::CreateStagingDirectory() {
+  const std::string parent = fmt::format("{}/{}", root_, kStagingDirectory);
+  CF_EXPECT(EnsureDirectoryExists(parent));
+  std::string path = parent + "/XXXXXX";
+  CF_EXPECTF(mkdtemp(path.data()) != nullptr,
+             "Failed to create a directory in \"{}\": {}", parent,
+             StrError(errno));
+  return path;
+}
+
+Result<uint64_t> ArtifactStore::Size() {
+  SharedFD lock = CF_EXPECT(LockIndex(root_, LOCK_SH));
+  return CF_EXPECT(LoadIndex(root_)).total_size;
+}
+
+Result<uint64_t> ArtifactStore::Evict(const uint64_t allowed_size_bytes) {
+  SharedFD lock = CF_EXPECT(LockIndex(root_));
+  Index index = CF_EXPECT(LoadIndex(root_));
+  if (index.total_size <= allowed_size_bytes) {
+    return 0;
+  }
+  std::vector<std::pair<int64_t, std::string>> by_access;
+  for (const auto& [digest, object] : index.objects) {
+    by_access.emplace_back(object.last_access, digest);
+  }
+  std::sort(by_access.begin(), by_access.end());
+
+  uint64_t freed = 0;
+  for (const auto& [last_access, digest] : by_access) {
+    if (index.total_size <= allowed_size_bytes) {
+      break;
+    }
+    const uint64_t size = index.objects[digest].size;
+    VLOG(0) << "Evicting \"" << ObjectPath(root_, digest) << "\" (" << size
+            << " bytes) from the artifact store";
+    CF_EXPECT(RemoveObject(root_, index, digest));
+    freed += size;
+  }
+  CF_EXPECT(SaveIndex(root_, index));
+  return freed;
+}
+
+Result<std::string> MaterializeArtifact(const std::string& object,
+                                        const std::string& destination) {
+  // This also replaces hard links to the object, through which writes to
+  // `destination` would change the stored contents.
+  if (FileExists(destination)) {
+    CF_EXPECTF(unlink(destination.c_str()) == 0,
+               "Failed to unlink \"{}\": {}", destination, StrError(errno));
+  }
+
+  struct stat object_stat;
+  CF_EXPECTF(stat(object.c_str(), &object_stat) == 0,
+             "Failed to stat \"{}\": {}", object, StrError(errno));
+  SharedFD in = SharedFD::Open(object, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(in->IsOpen(), "Failed to open \"{}\": {}", object,
+             in->StrError());
+  // The umask does not apply to reflinks or hard links either.
+  const mode_t mode = object_stat.st_mode & 07777;
+  SharedFD out = SharedFD::Open(
+      destination, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, mode);
+  CF_EXPECTF(out->IsOpen(), "Failed to create \"{}\": {}", destination,
+             out->StrError());
+  if (out->CloneRange(*in, 0, 0, 0) == 0) {
+    VLOG(1) << "Created reflink from \"" << object << "\" to \""
+            << destination << "\"";
+  } else {
+    SharedFdIo reader(in);
+    SharedFdIo writer(out);
+    CF_EXPECTF(Copy(reader, writer, kCopyBufferSize),
+               "Failed to copy \"{}\" to \"{}\"", object, destination);
+  }
+  CF_EXPECTF(out->Chmod(mode), "Failed to chmod \"{}\": {}", destination,
+             out->StrError());
+  return destination;
+}
+
+}  // namespace cuttlefish
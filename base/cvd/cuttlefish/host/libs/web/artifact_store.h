@@ -0,0 +1,95 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <optional>
+#include <string>
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+/** Subdirectory of the fetch cache that holds the artifact store. */
+inline constexpr char kArtifactStoreDirectory[] = "store";
+
+/**
+ * A content-addressed store of downloaded build artifacts.
+ *
+ * Each distinct file content is kept once, as `objects/<sha256>`, no matter
+ * how many builds refer to it. Artifacts are looked up by a key such as
+ * `<build id>/<target>/<artifact name>`, and an object is referenced by every
+ * key that resolved to its content.
+ *
+ * `index.json` records the size, last access time and references of every
+ * object along with the total stored size, so accounting and eviction never
+ * have to walk the directory. It is only rewritten when objects are inserted
+ * or removed: lookups append their access times to `access.log`, which the
+ * next rewrite folds in. Concurrent `cvd fetch` processes coordinate with an
+ * advisory lock on `index.lock`, shared by lookups and exclusive otherwise.
+ */
+class ArtifactStore {
+ public:
+  static Result<ArtifactStore> Open(std::string root);
+
+  /**
+   * Returns the path of the object stored under `key` and marks it as
+   * recently used, or nullopt if the key is unknown.
+   */
+  Result<std::optional<std::string>> Lookup(const std::string& key);
+
+  /**
+   * Moves `file` into the store under `key` and returns the path of the
+   * object. When an object with the same contents already exists, `file` is
+   * deleted instead and the existing object gains a reference.
+   */
+  Result<std::string> Insert(const std::string& key, const std::string& file);
+
+  /**
+   * Creates an empty directory on the same filesystem as the objects, so that
+   * files downloaded into it can be inserted without copying them.
+   */
+  Result<std::string> CreateStagingDirectory();
+
+  /** Total size in bytes of the stored objects. */
+  Result<uint64_t> Size();
+
+  /**
+   * Deletes least recently used objects until at most `allowed_size_bytes`
+   * remain, returning the number of bytes freed.
+   */
+  Result<uint64_t> Evict(uint64_t allowed_size_bytes);
+
+ private:
+  explicit ArtifactStore(std::string root);
+
+  std::string root_;
+};
+
+/**
+ * Places a copy of the stored `object` at `destination`, replacing any other
+ * file there.
+ *
+ * A reflink is preferred, as it shares the data blocks with the store while
+ * keeping later writes to `destination` out of the store. Filesystems without
+ * reflink support get a full copy. Never a hard link, as changing the
+ * artifact in place would then change the stored object under its digest.
+ */
+Result<std::string> MaterializeArtifact(const std::string& object,
+                                        const std::string& destination);
+
+}  // namespace cuttlefish
@@ -0,0 +1,163 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/web/artifact_store.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <optional>
+#include <string>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/files/file_exists.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+class ArtifactStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Result<ArtifactStore> store =
+        ArtifactStore::Open(std::string(temp_dir_.path) + "/store");
+    ASSERT_THAT(store, IsOk());
+    store_.emplace(std::move(*store));
+  }
+
+  // Writes `contents` into a fresh staging directory, like a download would.
+  Result<std::string> Stage(const std::string& contents) {
+    const std::string directory = CF_EXPECT(store_->CreateStagingDirectory());
+    const std::string path = directory + "/artifact";
+    CF_EXPECT(android::base::WriteStringToFile(contents, path));
+    return path;
+  }
+
+  Result<std::string> Insert(const std::string& key,
+                             const std::string& contents) {
+    return CF_EXPECT(store_->Insert(key, CF_EXPECT(Stage(contents))));
+  }
+
+  TemporaryDir temp_dir_;
+  std::optional<ArtifactStore> store_;
+};
+
+TEST_F(ArtifactStoreTest, LookupFindsInsertedArtifact) {
+  Result<std::string> object = Insert("1/target/a.img", "contents");
+  ASSERT_THAT(object, IsOk());
+
+  EXPECT_THAT(store_->Lookup("1/target/a.img"), IsOkAndValue(*object));
+  EXPECT_THAT(store_->Lookup("1/target/b.img"), IsOkAndValue(std::nullopt));
+  std::string stored;
+  ASSERT_TRUE(android::base::ReadFileToString(*object, &stored));
+  EXPECT_EQ(stored, "contents");
+  EXPECT_THAT(store_->Size(), IsOkAndValue(8));
+}
+
+TEST_F(ArtifactStoreTest, IdenticalContentsAreStoredOnce) {
+  Result<std::string> first = Insert("1/target/a.img", "contents");
+  Result<std::string> second = Insert("2/target/a.img", "contents");
+  ASSERT_THAT(first, IsOk());
+  ASSERT_THAT(second, IsOk());
+
+  EXPECT_EQ(*first, *second);
+  EXPECT_THAT(store_->Size(), IsOkAndValue(8));
+}
+
+TEST_F(ArtifactStoreTest, ReplacedContentsAreDropped) {
+  Result<std::string> old_object = Insert("1/target/a.img", "old");
+  ASSERT_THAT(old_object, IsOk());
+  Result<std::string> new_object = Insert("1/target/a.img", "newer");
+  ASSERT_THAT(new_object, IsOk());
+
+  EXPECT_FALSE(FileExists(*old_object));
+  EXPECT_THAT(store_->Lookup("1/target/a.img"), IsOkAndValue(*new_object));
+  EXPECT_THAT(store_->Size(), IsOkAndValue(5));
+}
+
+TEST_F(ArtifactStoreTest, EvictsLeastRecentlyUsed) {
+  ASSERT_THAT(Insert("1/target/a.img", "aaaa"), IsOk());
+  ASSERT_THAT(Insert("1/target/b.img", "bbbb"), IsOk());
+  ASSERT_THAT(Insert("1/target/c.img", "cccc"), IsOk());
+  ASSERT_THAT(store_->Lookup("1/target/a.img"), IsOk());
+
+  EXPECT_THAT(store_->Evict(8), IsOkAndValue(4));
+
+  EXPECT_THAT(store_->Lookup("1/target/b.img"), IsOkAndValue(std::nullopt));
+  EXPECT_THAT(store_->Lookup("1/target/a.img"),
+              IsOkAndValue(testing::Ne(std::nullopt)));
+  EXPECT_THAT(store_->Lookup("1/target/c.img"),
+              IsOkAndValue(testing::Ne(std::nullopt)));
+  EXPECT_THAT(store_->Size(), IsOkAndValue(8));
+}
+
+TEST_F(ArtifactStoreTest, MissingObjectIsForgotten) {
+  Result<std::string> object = Insert("1/target/a.img", "contents");
+  ASSERT_THAT(object, IsOk());
+  ASSERT_EQ(unlink(object->c_str()), 0);
+
+  EXPECT_THAT(store_->Lookup("1/target/a.img"), IsOkAndValue(std::nullopt));
+  EXPECT_THAT(store_->Size(), IsOkAndValue(0));
+}
+
+TEST_F(ArtifactStoreTest, MaterializeReplacesDestination) {
+  Result<std::string> object = Insert("1/target/a.img", "contents");
+  ASSERT_THAT(object, IsOk());
+  const std::string destination = std::string(temp_dir_.path) + "/a.img";
+  ASSERT_TRUE(android::base::WriteStringToFile("stale", destination));
+
+  EXPECT_THAT(MaterializeArtifact(*object, destination),
+              IsOkAndValue(destination));
+
+  std::string materialized;
+  ASSERT_TRUE(android::base::ReadFileToString(destination, &materialized));
+  EXPECT_EQ(materialized, "contents");
+}
+
+TEST_F(ArtifactStoreTest, LookupLeavesIndexInPlace) {
+  ASSERT_THAT(Insert("1/target/a.img", "contents"), IsOk());
+  const std::string index = std::string(temp_dir_.path) + "/store/index.json";
+  struct stat before {};
+  ASSERT_EQ(stat(index.c_str(), &before), 0);
+
+  ASSERT_THAT(store_->Lookup("1/target/a.img"),
+              IsOkAndValue(testing::Ne(std::nullopt)));
+
+  struct stat after {};
+  ASSERT_EQ(stat(index.c_str(), &after), 0);
+  EXPECT_EQ(before.st_ino, after.st_ino);
+}
+
+TEST_F(ArtifactStoreTest, MaterializedArtifactIsIndependentOfObject) {
+  Result<std::string> object = Insert("1/target/a.img", "contents");
+  ASSERT_THAT(object, IsOk());
+  const std::string destination = std::string(temp_dir_.path) + "/a.img";
+  ASSERT_EQ(link(object->c_str(), destination.c_str()), 0);
+
+  ASSERT_THAT(MaterializeArtifact(*object, destination),
+              IsOkAndValue(destination));
+  ASSERT_TRUE(android::base::WriteStringToFile("modified", destination));
+
+  std::string stored;
+  ASSERT_TRUE(android::base::ReadFileToString(*object, &stored));
+  EXPECT_EQ(stored, "contents");
+}
+
+}  // namespace
+}  // namespace cuttlefish
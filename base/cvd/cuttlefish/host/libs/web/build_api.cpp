@@ -16,12 +16,20 @@
 #include "cuttlefish/host/libs/web/build_api.h"
 
 #include <string>
+#include <vector>
 
 #include "cuttlefish/host/libs/web/android_build.h"
+#include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
+Result<SeekableZipSource> BuildApi::FileReaderForMembers(
+    const Build& build, const std::string& artifact_name,
+    const std::vector<std::string>&) {
+  return CF_EXPECT(FileReader(build, artifact_name));
+}
+
 Result<std::string> DownloadFileWithBackup(
     BuildApi& build_api, const Build& build,
     const std::string& target_directory, const std::string& artifact_name,
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "cuttlefish/host/libs/web/android_build.h"
 #include "cuttlefish/host/libs/web/android_build_string.h"
@@ -35,6 +36,13 @@ class BuildApi {
 
   virtual Result<SeekableZipSource> FileReader(
       const Build&, const std::string& artifact_name) = 0;
+
+  /* Like `FileReader`, for an archive whose `members` will be extracted in
+   * the given order. Implementations that fetch the archive lazily can use
+   * this to fetch the members before they are read. */
+  virtual Result<SeekableZipSource> FileReaderForMembers(
+      const Build&, const std::string& artifact_name,
+      const std::vector<std::string>& members);
 };
 
 Result<std::string> DownloadFileWithBackup(
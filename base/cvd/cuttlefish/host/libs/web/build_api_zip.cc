@@ -17,6 +17,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "cuttlefish/host/libs/web/android_build.h"
 #include "cuttlefish/host/libs/web/build_api.h"
@@ -28,8 +29,10 @@
 namespace cuttlefish {
 
 Result<ReadableZip> OpenZip(BuildApi& build_api, const Build& build,
-                            const std::string& name) {
-  SeekableZipSource source = CF_EXPECT(build_api.FileReader(build, name));
+                            const std::string& name,
+                            const std::vector<std::string>& prefetch_members) {
+  SeekableZipSource source = CF_EXPECT(
+      build_api.FileReaderForMembers(build, name, prefetch_members));
 
   SeekableZipSource buffered =
       CF_EXPECT(BufferZipSource(std::move(source), 1 << 26));
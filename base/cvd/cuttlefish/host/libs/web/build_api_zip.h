@@ -16,6 +16,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "cuttlefish/host/libs/web/android_build.h"
 #include "cuttlefish/host/libs/web/build_api.h"
@@ -24,6 +25,9 @@
 
 namespace cuttlefish {
 
-Result<ReadableZip> OpenZip(BuildApi&, const Build&, const std::string& name);
+/* `prefetch_members` are the members that will be extracted, in order. */
+Result<ReadableZip> OpenZip(
+    BuildApi&, const Build&, const std::string& name,
+    const std::vector<std::string>& prefetch_members = {});
 
 }  // namespace cuttlefish
@@ -15,8 +15,13 @@
 
 #include "cuttlefish/host/libs/web/caching_build_api.h"
 
+#include <stddef.h>
+
+#include <algorithm>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/log/log.h"
 #include "android-base/file.h"
@@ -25,10 +30,11 @@
 
 #include "cuttlefish/common/libs/utils/files.h"
 #include "cuttlefish/files/file_exists.h"
-#include "cuttlefish/files/link_or_copy.h"
+#include "cuttlefish/files/recursively_remove_directory.h"
 #include "cuttlefish/host/libs/web/android_build.h"
 #include "cuttlefish/host/libs/web/android_build_api.h"
 #include "cuttlefish/host/libs/web/android_build_string.h"
+#include "cuttlefish/host/libs/web/artifact_store.h"
 #include "cuttlefish/host/libs/web/build_api.h"
 #include "cuttlefish/host/libs/zip/cached_zip_source.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
@@ -37,40 +43,6 @@
 namespace cuttlefish {
 namespace {
 
-constexpr bool kOverwriteExistingFile = true;
-
-struct CachingPaths {
-  std::string build_cache;
-  std::string target_artifact;
-  std::string cache_artifact;
-  std::string target_backup_artifact;
-  std::string cache_backup_artifact;
-};
-
-Result<CachingPaths> ConstructCachePaths(
-    const std::string& cache_base, const Build& build,
-    const std::string& target_directory, const std::string& artifact,
-    const std::string& backup_artifact = "") {
-  const auto [id, target] = GetBuildIdAndTarget(build);
-  auto result = CachingPaths{
-      .build_cache = fmt::format("{}/{}/{}", cache_base, id, target),
-      .target_artifact = ConstructTargetFilepath(target_directory, artifact),
-  };
-  result.cache_artifact = ConstructTargetFilepath(result.build_cache, artifact);
-  CF_EXPECT(EnsureDirectoryExists(result.build_cache));
-  CF_EXPECT(
-      EnsureDirectoryExists(android::base::Dirname(result.target_artifact)));
-  if (!backup_artifact.empty()) {
-    result.target_backup_artifact =
-        ConstructTargetFilepath(target_directory, backup_artifact);
-    result.cache_backup_artifact =
-        ConstructTargetFilepath(result.build_cache, backup_artifact);
-    CF_EXPECT(EnsureDirectoryExists(
-        android::base::Dirname(result.target_backup_artifact)));
-  }
-  return result;
-}
-
 bool IsInCache(const std::string& filepath) {
   const bool exists = FileExists(filepath);
   if (exists) {
@@ -84,8 +56,11 @@ bool IsInCache(const std::string& filepath) {
 }  // namespace
 
 CachingBuildApi::CachingBuildApi(BuildApi& build_api,
-                                 std::string cache_base_path)
-    : build_api_(build_api), cache_base_path_(std::move(cache_base_path)) {};
+                                 std::string cache_base_path,
+                                 size_t reader_connections)
+    : build_api_(build_api),
+      cache_base_path_(std::move(cache_base_path)),
+      reader_connections_(std::max<size_t>(reader_connections, 1)) {};
 
 Result<Build> CachingBuildApi::GetBuild(const BuildString& build_string) {
   return CF_EXPECT(build_api_.GetBuild(build_string));
@@ -94,20 +69,55 @@ Result<Build> CachingBuildApi::GetBuild(const BuildString& build_string) {
 Result<std::string> CachingBuildApi::DownloadFile(
     const Build& build, const std::string& target_directory,
     const std::string& artifact_name) {
-  const auto paths = CF_EXPECT(ConstructCachePaths(
-      cache_base_path_, build, target_directory, artifact_name));
-  if (!IsInCache(paths.cache_artifact)) {
-    CF_EXPECT(build_api_.DownloadFile(build, paths.build_cache, artifact_name));
+  const auto [id, target] = GetBuildIdAndTarget(build);
+  const std::string key = fmt::format("{}/{}/{}", id, target, artifact_name);
+  const std::string target_artifact =
+      ConstructTargetFilepath(target_directory, artifact_name);
+  CF_EXPECT(EnsureDirectoryExists(android::base::Dirname(target_artifact)));
+
+  ArtifactStore store = CF_EXPECT(ArtifactStore::Open(
+      fmt::format("{}/{}", cache_base_path_, kArtifactStoreDirectory)));
+  std::optional<std::string> object = CF_EXPECT(store.Lookup(key));
+  if (!object) {
+    object = CF_EXPECT(AddToStore(store, build, key, artifact_name));
+  }
+  return CF_EXPECT(MaterializeArtifact(*object, target_artifact));
+}
+
+Result<std::string> CachingBuildApi::AddToStore(
+    ArtifactStore& store, const Build& build, const std::string& key,
+    const std::string& artifact_name) {
+  // Artifacts cached before the store existed are moved into it rather than
+  // downloaded again.
+  const std::string legacy_artifact =
+      ConstructTargetFilepath(cache_base_path_, key);
+  if (IsInCache(legacy_artifact)) {
+    return CF_EXPECT(store.Insert(key, legacy_artifact));
   }
-  return CF_EXPECT(LinkOrCopy(paths.cache_artifact, paths.target_artifact,
-                              kOverwriteExistingFile));
+  const std::string staging = CF_EXPECT(store.CreateStagingDirectory());
+  Result<std::string> object = [&]() -> Result<std::string> {
+    const std::string downloaded =
+        CF_EXPECT(build_api_.DownloadFile(build, staging, artifact_name));
+    return CF_EXPECT(store.Insert(key, downloaded));
+  }();
+  CF_EXPECT(RecursivelyRemoveDirectory(staging));
+  return CF_EXPECT(std::move(object));
 }
 
 Result<SeekableZipSource> CachingBuildApi::FileReader(
     const Build& build, const std::string& artifact) {
-  SeekableZipSource source = CF_EXPECT(build_api_.FileReader(build, artifact));
+  return CF_EXPECT(FileReaderForMembers(build, artifact, {}));
+}
+
+Result<SeekableZipSource> CachingBuildApi::FileReaderForMembers(
+    const Build& build, const std::string& artifact,
+    const std::vector<std::string>& members) {
+  std::vector<SeekableZipSource> sources;
+  for (size_t i = 0; i < reader_connections_; i++) {
+    sources.emplace_back(CF_EXPECT(build_api_.FileReader(build, artifact)));
+  }
   std::string cache_path = fmt::format("{}/{}", cache_base_path_, artifact);
-  return CF_EXPECT(CacheZipSource(std::move(source), cache_path));
+  return CF_EXPECT(CacheZipSource(std::move(sources), cache_path, members));
 }
 
 }  // namespace cuttlefish
@@ -15,9 +15,13 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #include <string>
+#include <vector>
 
 #include "cuttlefish/host/libs/web/android_build.h"
+#include "cuttlefish/host/libs/web/artifact_store.h"
 #include "cuttlefish/host/libs/web/build_api.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/result/result.h"
@@ -26,7 +30,10 @@ namespace cuttlefish {
 
 class CachingBuildApi : public BuildApi {
  public:
-  CachingBuildApi(BuildApi& build_api, std::string cache_base_path);
+  /* `reader_connections` sources are opened for each `FileReader` call and
+   * used to fetch uncached parts of the archive in parallel. */
+  CachingBuildApi(BuildApi& build_api, std::string cache_base_path,
+                  size_t reader_connections = 1);
 
   Result<Build> GetBuild(const BuildString& build_string) override;
   Result<std::string> DownloadFile(const Build& build,
@@ -35,10 +42,18 @@ class CachingBuildApi : public BuildApi {
 
   Result<SeekableZipSource> FileReader(const Build&,
                                        const std::string& artifact) override;
+  Result<SeekableZipSource> FileReaderForMembers(
+      const Build&, const std::string& artifact,
+      const std::vector<std::string>& members) override;
 
  private:
+  Result<std::string> AddToStore(ArtifactStore& store, const Build& build,
+                                 const std::string& key,
+                                 const std::string& artifact_name);
+
   BuildApi& build_api_;
   std::string cache_base_path_;
+  size_t reader_connections_;
 };
 
 }  // namespace cuttlefish
@@ -101,72 +101,139 @@ Result<ManagedCurlSlist> SlistFromStrings(
   return curl_headers;
 }
 
-class CurlClient : public HttpClient {
+// Lets concurrent transfers reuse each other's DNS lookups and TLS sessions.
+// The connection cache is not shared, as libcurl doesn't support using a
+// shared one from concurrent threads; every pooled handle keeps its own
+// connections open instead.
+class CurlShare {
  public:
-  CurlClient(const bool use_logging_debug_function)
-      : use_logging_debug_function_(use_logging_debug_function) {
-    curl_ = curl_easy_init();
-    if (!curl_) {
-      LOG(ERROR) << "failed to initialize curl";
+  CurlShare() : share_(curl_share_init()) {
+    if (!share_) {
+      LOG(ERROR) << "failed to initialize curl share";
       return;
     }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, Lock);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, Unlock);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  }
+  ~CurlShare() { curl_share_cleanup(share_); }
+
+  CURLSH* get() { return share_; }
+
+ private:
+  static void Lock(CURL*, curl_lock_data data, curl_lock_access, void* self) {
+    static_cast<CurlShare*>(self)->MutexFor(data).lock();
+  }
+  static void Unlock(CURL*, curl_lock_data data, void* self) {
+    static_cast<CurlShare*>(self)->MutexFor(data).unlock();
   }
-  ~CurlClient() { curl_easy_cleanup(curl_); }
+
+  std::mutex& MutexFor(curl_lock_data data) {
+    return mutexes_[data % CURL_LOCK_DATA_LAST];
+  }
+
+  CURLSH* share_;
+  std::mutex mutexes_[CURL_LOCK_DATA_LAST];
+};
+
+using ManagedCurl = std::unique_ptr<CURL, decltype(&curl_easy_cleanup)>;
+
+class CurlClient : public HttpClient {
+ public:
+  CurlClient(const bool use_logging_debug_function)
+      : use_logging_debug_function_(use_logging_debug_function) {}
 
   Result<HttpResponse<void>> DownloadToCallback(
       HttpRequest request, DataCallback callback) override {
-    std::lock_guard<std::mutex> lock(mutex_);
     VLOG(0) << "Downloading '" << request.url << "'";
     CF_EXPECT(
         request.data_to_write.empty() || request.method == HttpMethod::kPost,
         "data must be empty for non POST requests");
-    CF_EXPECT(curl_ != nullptr, "curl was not initialized");
+    ManagedCurl curl = AcquireHandle();
+    CF_EXPECT(curl != nullptr, "curl was not initialized");
+    Result<HttpResponse<void>> response =
+        Perform(curl.get(), request, callback);
+    ReleaseHandle(std::move(curl));
+    return CF_EXPECT(std::move(response));
+  }
+
+ private:
+  // Each request in flight gets its own handle, so callers on different
+  // threads transfer concurrently. Idle handles are kept for reuse.
+  ManagedCurl AcquireHandle() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!idle_handles_.empty()) {
+        ManagedCurl curl = std::move(idle_handles_.back());
+        idle_handles_.pop_back();
+        return curl;
+      }
+    }
+    ManagedCurl curl(curl_easy_init(), curl_easy_cleanup);
+    if (!curl) {
+      LOG(ERROR) << "failed to initialize curl";
+    }
+    return curl;
+  }
+
+  void ReleaseHandle(ManagedCurl curl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_handles_.emplace_back(std::move(curl));
+  }
+
+  Result<HttpResponse<void>> Perform(CURL* curl, const HttpRequest& request,
+                                     DataCallback& callback) {
     CF_EXPECT(callback(nullptr, 0) /* Signal start of data */,
               "callback failure");
     auto curl_headers = CF_EXPECT(SlistFromStrings(request.headers));
 
-    curl_easy_reset(curl_);
+    curl_easy_reset(curl);
     switch (request.method) {
       case HttpMethod::kDelete:
-        curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "DELETE");
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
         break;
       case HttpMethod::kPost:
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE,
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
                          request.data_to_write.size());
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDS,
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS,
                          request.data_to_write.c_str());
         break;
       case HttpMethod::kHead:
-        curl_easy_setopt(curl_, CURLOPT_NOBODY, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
         break;
       default:
         break;
     }
-    curl_easy_setopt(curl_, CURLOPT_CAINFO,
+    if (share_.get()) {
+      curl_easy_setopt(curl, CURLOPT_SHARE, share_.get());
+    }
+    curl_easy_setopt(curl, CURLOPT_CAINFO,
                      "/etc/ssl/certs/ca-certificates.crt");
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, curl_headers.get());
-    curl_easy_setopt(curl_, CURLOPT_URL, request.url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, curl_to_function_cb);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &callback);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, curl_headers.get());
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_to_function_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &callback);
     char error_buf[CURL_ERROR_SIZE];
-    curl_easy_setopt(curl_, CURLOPT_ERRORBUFFER, error_buf);
-    curl_easy_setopt(curl_, CURLOPT_VERBOSE, 1L);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, error_buf);
+    curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
     // CURLOPT_VERBOSE must be set for CURLOPT_DEBUGFUNCTION be utilized
     if (use_logging_debug_function_) {
-      curl_easy_setopt(curl_, CURLOPT_DEBUGFUNCTION, LoggingCurlDebugFunction);
+      curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, LoggingCurlDebugFunction);
     }
-    CURLcode res = curl_easy_perform(curl_);
+    CURLcode res = curl_easy_perform(curl);
     CF_EXPECT(res == CURLE_OK,
               "curl_easy_perform() failed. "
                   << "Code was \"" << res << "\". "
                   << "Strerror was \"" << curl_easy_strerror(res) << "\". "
                   << "Error buffer was \"" << error_buf << "\".");
     long http_code = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
 
     std::vector<HttpHeader> headers;
     curl_header* raw_header = nullptr;
-    while ((raw_header = curl_easy_nextheader(curl_, CURLH_HEADER, 0,
+    while ((raw_header = curl_easy_nextheader(curl, CURLH_HEADER, 0,
                                               raw_header)) != nullptr) {
       headers.emplace_back(HttpHeader{
           .name = raw_header->name,
@@ -178,9 +245,9 @@ class CurlClient : public HttpClient {
         .data = {}, .http_code = http_code, .headers = std::move(headers)};
   }
 
- private:
-  CURL* curl_;
+  CurlShare share_;
   std::mutex mutex_;
+  std::vector<ManagedCurl> idle_handles_;
   bool use_logging_debug_function_;
 };
 
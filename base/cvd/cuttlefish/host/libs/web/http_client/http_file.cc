@@ -18,21 +18,178 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "absl/log/log.h"
+#include "absl/strings/numbers.h"
+#include "fmt/format.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/fs/shared_fd_stream.h"
 #include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/common/libs/utils/task_graph.h"
 #include "cuttlefish/host/libs/web/http_client/http_client.h"
+#include "cuttlefish/io/write_exact.h"
 #include "cuttlefish/posix/remove.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
+namespace {
+
+constexpr long kHttpPartialContent = 206;
+constexpr long kHttpRangeNotSatisfiable = 416;
+
+// Reads the complete length from a `bytes <first>-<last>/<total>` or
+// `bytes */<total>` Content-Range header.
+Result<uint64_t> ContentRangeTotal(const std::vector<HttpHeader>& headers) {
+  std::optional<std::string_view> content_range =
+      HeaderValue(headers, "Content-Range");
+  CF_EXPECT(content_range.has_value(), "Missing Content-Range header");
+  const size_t slash = content_range->rfind('/');
+  CF_EXPECTF(slash != std::string_view::npos,
+             "Malformed Content-Range header \"{}\"", *content_range);
+  uint64_t total;
+  CF_EXPECTF(absl::SimpleAtoi(content_range->substr(slash + 1), &total),
+             "No complete length in Content-Range header \"{}\"",
+             *content_range);
+  return total;
+}
+
+// Requests the bytes of `url` from `offset` through `last` and writes them
+// into `fd` at the offsets they have in the file. Unless `bounded`, a response
+// with more data than requested is accepted too. `received` ends up as the
+// number of bytes from the final attempt the client made.
+Result<HttpResponse<void>> GetRangeToFd(HttpClient& http_client,
+                                        const std::string& url,
+                                        std::vector<std::string> headers,
+                                        SharedFD fd, const uint64_t offset,
+                                        const uint64_t last, const bool bounded,
+                                        uint64_t& received,
+                                        std::atomic<uint64_t>& progress) {
+  headers.emplace_back(fmt::format("Range: bytes={}-{}", offset, last));
+  auto callback = [&](char* data, size_t size) -> bool {
+    // A retry starts over from `offset`.
+    if (data == nullptr) {
+      progress -= received;
+      received = 0;
+      return true;
+    }
+    if (bounded && offset + received + size > last + 1) {
+      LOG(ERROR) << "Server sent more than the requested range of '" << url
+                 << "'";
+      return false;
+    }
+    Result<void> written = PWriteExact(*fd, data, size, offset + received);
+    if (!written.has_value()) {
+      LOG(ERROR) << written.error();
+      return false;
+    }
+    received += size;
+    progress += size;
+    return true;
+  };
+  HttpRequest request = {
+      .method = HttpMethod::kGet,
+      .url = url,
+      .headers = std::move(headers),
+  };
+  return CF_EXPECT(
+      http_client.DownloadToCallback(std::move(request), callback));
+}
+
+// Downloads the bytes of `url` in [begin, end) into `fd`, resuming from the
+// last byte received when a transfer breaks off.
+Result<void> DownloadChunk(HttpClient& http_client, const std::string& url,
+                           const std::vector<std::string>& headers, SharedFD fd,
+                           const uint64_t begin, const uint64_t end,
+                           const int resume_attempts,
+                           std::atomic<uint64_t>& progress) {
+  uint64_t done = 0;
+  for (int attempt = 0;; attempt++) {
+    uint64_t received = 0;
+    Result<HttpResponse<void>> response =
+        GetRangeToFd(http_client, url, headers, fd, begin + done, end - 1,
+                     /* bounded= */ true, received, progress);
+    done += received;
+    if (response.has_value()) {
+      CF_EXPECTF(response->http_code == kHttpPartialContent,
+                 "Request for bytes {}-{} of '{}' failed: {}", begin + done,
+                 end - 1, url, response->StatusDescription());
+      if (begin + done == end) {
+        return {};
+      }
+    }
+    CF_EXPECTF(attempt < resume_attempts,
+               "Download of bytes {}-{} of '{}' stopped at byte {}: {}", begin,
+               end - 1, url, begin + done,
+               response.has_value() ? "connection closed"
+                                    : response.error().FormatForEnv());
+    VLOG(0) << "Resuming '" << url << "' from byte " << begin + done;
+  }
+}
+
+Result<HttpResponse<void>> DownloadInRanges(
+    HttpClient& http_client, const std::string& url,
+    const std::vector<std::string>& headers, SharedFD fd,
+    const RangedDownloadOptions& options) {
+  CF_EXPECT_GT(options.chunk_size, 0);
+  std::atomic<uint64_t> progress = 0;
+  uint64_t received = 0;
+  // The first chunk doubles as a probe for range support and the file size.
+  // It is not bounded, as a server that ignores `Range` sends everything.
+  HttpResponse<void> first = CF_EXPECT(
+      GetRangeToFd(http_client, url, headers, fd, 0, options.chunk_size - 1,
+                   /* bounded= */ false, received, progress));
+  if (first.http_code == kHttpRangeNotSatisfiable) {
+    // Any range of an empty file is unsatisfiable.
+    Result<uint64_t> total = ContentRangeTotal(first.headers);
+    if (total.has_value() && *total == 0) {
+      CF_EXPECT(fd->Truncate(0));
+      first.http_code = 200;
+    }
+    return first;
+  }
+  if (first.http_code != kHttpPartialContent) {
+    if (first.HttpSuccess()) {
+      CF_EXPECT(fd->Truncate(received));
+    }
+    return first;
+  }
+
+  const uint64_t total = CF_EXPECT(ContentRangeTotal(first.headers));
+  TaskGraph chunks;
+  for (uint64_t begin = 0; begin < total; begin += options.chunk_size) {
+    const uint64_t end = std::min(begin + options.chunk_size, total);
+    // Picks up the first chunk where the probe left off.
+    const uint64_t start = begin == 0 ? std::min(received, end) : begin;
+    if (start == end) {
+      continue;
+    }
+    chunks.Add(fmt::format("bytes {}-{}", start, end - 1),
+               [&, start, end]() -> Result<void> {
+                 CF_EXPECT(DownloadChunk(http_client, url, headers, fd, start,
+                                         end, options.resume_attempts,
+                                         progress));
+                 VLOG(0) << "Downloaded " << progress << " of " << total
+                         << " bytes";
+                 return {};
+               });
+  }
+  CF_EXPECT(chunks.Run(std::max<size_t>(options.connections, 1)));
+  // Drops anything past the end left over from error responses that were
+  // retried.
+  CF_EXPECT(fd->Truncate(total));
+  return first;
+}
+
+}  // namespace
 
 Result<HttpResponse<std::string>> HttpGetToFile(
     HttpClient& http_client, const std::string& url, const std::string& path,
@@ -101,4 +258,32 @@ Result<HttpResponse<std::string>> HttpGetToFile(
   };
 }
 
+Result<HttpResponse<std::string>> HttpGetToFileRanged(
+    HttpClient& http_client, const std::string& url, const std::string& path,
+    const std::vector<std::string>& headers,
+    const RangedDownloadOptions& options) {
+  VLOG(0) << "Saving '" << url << "' to '" << path << "' in ranges";
+
+  auto [fd, temp_path] = CF_EXPECT(SharedFD::Mkostemp(path));
+  Result<HttpResponse<void>> http_response =
+      DownloadInRanges(http_client, url, headers, fd, options);
+  if (!http_response.has_value() || !http_response->HttpSuccess()) {
+    CF_EXPECTF(
+        RemoveFile(temp_path),
+        "Unable to remove temporary file \"{}\"\nMay require manual removal",
+        temp_path);
+  }
+  HttpResponse<void> response = CF_EXPECT(std::move(http_response));
+  VLOG(0) << "Downloaded '" << url << "' to '" << path << "'.";
+
+  if (response.HttpSuccess()) {
+    CF_EXPECT(RenameFile(temp_path, path));
+  }
+  return HttpResponse<std::string>{
+      .data = path,
+      .http_code = response.http_code,
+      .headers = std::move(response.headers),
+  };
+}
+
 }  // namespace cuttlefish
@@ -15,6 +15,9 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
 #include <vector>
 
@@ -27,4 +30,21 @@ Result<HttpResponse<std::string>> HttpGetToFile(
     HttpClient&, const std::string& url, const std::string& path,
     const std::vector<std::string>& headers = {});
 
+struct RangedDownloadOptions {
+  // Bytes requested at a time. Smaller files are fetched in one request.
+  uint64_t chunk_size = uint64_t{64} << 20;
+  // Range requests in flight at the same time.
+  size_t connections = 4;
+  // Times a range that breaks off is resumed from its last received byte.
+  int resume_attempts = 3;
+};
+
+// Like `HttpGetToFile`, but splits the download into HTTP range requests that
+// run over concurrent connections and write straight into their place in the
+// file. Falls back to a single request when the server ignores `Range`.
+Result<HttpResponse<std::string>> HttpGetToFileRanged(
+    HttpClient&, const std::string& url, const std::string& path,
+    const std::vector<std::string>& headers = {},
+    const RangedDownloadOptions& options = {});
+
 }  // namespace cuttlefish
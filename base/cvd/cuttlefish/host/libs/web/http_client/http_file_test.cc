@@ -0,0 +1,190 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/web/http_client/http_file.h"
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "android-base/file.h"
+#include "fmt/format.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/files/file_exists.h"
+#include "cuttlefish/host/libs/web/http_client/fake_http_client.h"
+#include "cuttlefish/host/libs/web/http_client/http_client.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr char kUrl[] = "https://example.com/artifact";
+
+std::string Contents(size_t size) {
+  std::string contents;
+  for (size_t i = 0; i < size; i++) {
+    contents.push_back('a' + i % 26);
+  }
+  return contents;
+}
+
+// Stands in for a server that supports range requests, counting the ranges
+// it serves. `short_ranges` many responses are cut off after half the data.
+FakeHttpClient::Handler RangeServer(std::string contents,
+                                    std::shared_ptr<std::atomic<int>> ranges,
+                                    int short_ranges = 0) {
+  auto shorts_left = std::make_shared<std::atomic<int>>(short_ranges);
+  return [contents, ranges, shorts_left](const HttpRequest& request) {
+    for (const std::string& header : request.headers) {
+      uint64_t first;
+      uint64_t last;
+      if (sscanf(header.c_str(), "Range: bytes=%" SCNu64 "-%" SCNu64, &first,
+                 &last) != 2) {
+        continue;
+      }
+      (*ranges)++;
+      if (first >= contents.size()) {
+        return HttpResponse<std::string>{
+            .http_code = 416,
+            .headers = {{"Content-Range",
+                         fmt::format("bytes */{}", contents.size())}},
+        };
+      }
+      last = std::min<uint64_t>(last, contents.size() - 1);
+      std::string data = contents.substr(first, last - first + 1);
+      if (data.size() > 1 && (*shorts_left)-- > 0) {
+        data.resize(data.size() / 2);
+      }
+      return HttpResponse<std::string>{
+          .data = std::move(data),
+          .http_code = 206,
+          .headers = {{"Content-Range",
+                       fmt::format("bytes {}-{}/{}", first, last,
+                                   contents.size())}},
+      };
+    }
+    return HttpResponse<std::string>{.data = contents, .http_code = 200};
+  };
+}
+
+class HttpGetToFileRangedTest : public ::testing::Test {
+ protected:
+  std::string Path() const { return std::string(temp_dir_.path) + "/file"; }
+
+  std::string Downloaded() const {
+    std::string contents;
+    EXPECT_TRUE(android::base::ReadFileToString(Path(), &contents));
+    return contents;
+  }
+
+  TemporaryDir temp_dir_;
+  FakeHttpClient http_client_;
+  std::shared_ptr<std::atomic<int>> ranges_ =
+      std::make_shared<std::atomic<int>>(0);
+};
+
+TEST_F(HttpGetToFileRangedTest, DownloadsInChunks) {
+  const std::string contents = Contents(1000);
+  http_client_.SetResponse(RangeServer(contents, ranges_));
+
+  Result<HttpResponse<std::string>> response = HttpGetToFileRanged(
+      http_client_, kUrl, Path(), {},
+      RangedDownloadOptions{.chunk_size = 64, .connections = 3});
+
+  ASSERT_THAT(response, IsOk());
+  EXPECT_TRUE(response->HttpSuccess());
+  EXPECT_EQ(Downloaded(), contents);
+  EXPECT_EQ(*ranges_, 16);
+}
+
+TEST_F(HttpGetToFileRangedTest, SmallFileTakesOneRequest) {
+  const std::string contents = Contents(10);
+  http_client_.SetResponse(RangeServer(contents, ranges_));
+
+  Result<HttpResponse<std::string>> response = HttpGetToFileRanged(
+      http_client_, kUrl, Path(), {}, RangedDownloadOptions{.chunk_size = 64});
+
+  ASSERT_THAT(response, IsOk());
+  EXPECT_EQ(Downloaded(), contents);
+  EXPECT_EQ(*ranges_, 1);
+}
+
+TEST_F(HttpGetToFileRangedTest, ResumesShortRanges) {
+  const std::string contents = Contents(1000);
+  http_client_.SetResponse(RangeServer(contents, ranges_, 3));
+
+  Result<HttpResponse<std::string>> response = HttpGetToFileRanged(
+      http_client_, kUrl, Path(), {},
+      RangedDownloadOptions{.chunk_size = 100, .connections = 2});
+
+  ASSERT_THAT(response, IsOk());
+  EXPECT_EQ(Downloaded(), contents);
+  EXPECT_EQ(*ranges_, 13);
+}
+
+TEST_F(HttpGetToFileRangedTest, GivesUpAfterResumeAttempts) {
+  const std::string contents = Contents(1000);
+  http_client_.SetResponse(RangeServer(contents, ranges_, 1000));
+
+  Result<HttpResponse<std::string>> response = HttpGetToFileRanged(
+      http_client_, kUrl, Path(), {},
+      RangedDownloadOptions{.chunk_size = 100, .resume_attempts = 1});
+
+  EXPECT_THAT(response, IsError());
+  EXPECT_FALSE(FileExists(Path()));
+}
+
+TEST_F(HttpGetToFileRangedTest, ServerWithoutRangeSupport) {
+  const std::string contents = Contents(1000);
+  http_client_.SetResponse(contents);
+
+  Result<HttpResponse<std::string>> response = HttpGetToFileRanged(
+      http_client_, kUrl, Path(), {}, RangedDownloadOptions{.chunk_size = 64});
+
+  ASSERT_THAT(response, IsOk());
+  EXPECT_TRUE(response->HttpSuccess());
+  EXPECT_EQ(Downloaded(), contents);
+}
+
+TEST_F(HttpGetToFileRangedTest, EmptyFile) {
+  http_client_.SetResponse(RangeServer("", ranges_));
+
+  Result<HttpResponse<std::string>> response =
+      HttpGetToFileRanged(http_client_, kUrl, Path());
+
+  ASSERT_THAT(response, IsOk());
+  EXPECT_TRUE(response->HttpSuccess());
+  EXPECT_EQ(Downloaded(), "");
+}
+
+TEST_F(HttpGetToFileRangedTest, NotFound) {
+  Result<HttpResponse<std::string>> response =
+      HttpGetToFileRanged(http_client_, kUrl, Path());
+
+  ASSERT_THAT(response, IsOk());
+  EXPECT_TRUE(response->HttpClientError());
+  EXPECT_FALSE(FileExists(Path()));
+}
+
+}  // namespace
+}  // namespace cuttlefish
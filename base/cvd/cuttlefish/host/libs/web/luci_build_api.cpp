@@ -153,7 +153,7 @@ Result<void> LuciBuildApi::DownloadArtifact(const std::string& artifact_link,
       UrlEscape(bucket), UrlEscape(object));
 
   auto headers = CF_EXPECT(CloudStorageHeaders());
-  CF_EXPECT(HttpGetToFile(http_client_, url, target_path, headers));
+  CF_EXPECT(HttpGetToFileRanged(http_client_, url, target_path, headers));
   return {};
 }
 
@@ -18,15 +18,19 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/log/log.h"
 
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/source_callback.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/stat.h"
+#include "cuttlefish/host/libs/zip/zip_layout.h"
+#include "cuttlefish/io/fake_seek.h"
 #include "cuttlefish/io/io.h"
 #include "cuttlefish/io/lazily_loaded_file.h"
 #include "cuttlefish/result/result.h"
@@ -81,18 +85,70 @@ class CachedZipSourceCallbacks : public SeekableZipSourceCallback {
   const size_t size_;
 };
 
+class LazilyLoadedFileView : public ReaderFakeSeeker {
+ public:
+  LazilyLoadedFileView(const LazilyLoadedFile& file, uint64_t size)
+      : ReaderFakeSeeker(size), file_(file) {}
+
+  Result<uint64_t> PRead(void* buf, uint64_t count,
+                         uint64_t offset) const override {
+    return CF_EXPECT(file_.PRead(static_cast<char*>(buf), count, offset));
+  }
+
+ private:
+  const LazilyLoadedFile& file_;
+};
+
+Result<void> PrefetchMembers(LazilyLoadedFile& file, size_t size,
+                             const std::vector<std::string>& members) {
+  LazilyLoadedFileView view(file, size);
+  ZipLayout layout = CF_EXPECT(ReadZipLayout(view, size));
+  for (const std::string& name : members) {
+    auto it = std::find_if(
+        layout.members.begin(), layout.members.end(),
+        [&name](const ZipMemberRange& member) { return member.name == name; });
+    if (it == layout.members.end()) {
+      VLOG(1) << "Not prefetching missing member '" << name << "'";
+      continue;
+    }
+    CF_EXPECT(file.Prefetch(it->offset, it->length));
+  }
+  return {};
+}
+
 }  // namespace
 
 Result<SeekableZipSource> CacheZipSource(SeekableZipSource inner,
                                          std::string file_path) {
-  ZipStat zip_stat = CF_EXPECT(inner.Stat());
+  std::vector<SeekableZipSource> sources;
+  sources.emplace_back(std::move(inner));
+  return CF_EXPECT(CacheZipSource(std::move(sources), std::move(file_path)));
+}
+
+Result<SeekableZipSource> CacheZipSource(
+    std::vector<SeekableZipSource> inner, std::string file_path,
+    const std::vector<std::string>& prefetch_members) {
+  CF_EXPECT(!inner.empty(), "At least one source is required");
+  ZipStat zip_stat = CF_EXPECT(inner.front().Stat());
   size_t size = CF_EXPECT(std::move(zip_stat.size));
 
-  std::unique_ptr<ReaderSeeker> reader =
-      CF_EXPECT(ZipSourceAsReaderSeeker(std::move(inner)));
+  std::vector<std::unique_ptr<ReaderSeeker>> readers;
+  for (SeekableZipSource& source : inner) {
+    readers.emplace_back(CF_EXPECT(ZipSourceAsReaderSeeker(std::move(source))));
+  }
 
   LazilyLoadedFile file = CF_EXPECT(
-      LazilyLoadedFile::Create(std::move(file_path), size, std::move(reader)));
+      LazilyLoadedFile::Create(std::move(file_path), size, std::move(readers)));
+
+  // Opening the archive starts with a search for the central directory.
+  const size_t trailer_size = std::min<size_t>(size, kZipTrailerSearchSize);
+  CF_EXPECT(file.Prefetch(size - trailer_size, trailer_size));
+  if (!prefetch_members.empty()) {
+    Result<void> res = PrefetchMembers(file, size, prefetch_members);
+    if (!res.has_value()) {
+      LOG(WARNING) << "Not prefetching archive members: " << res.error();
+    }
+  }
 
   CachedZipSourceCallbacks callbacks(std::move(file), size);
 
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/result/result.h"
@@ -25,4 +26,13 @@ namespace cuttlefish {
 Result<SeekableZipSource> CacheZipSource(SeekableZipSource inner,
                                          std::string file_path);
 
+/* Caches data from `inner` at `file_path`, fetching missing data through all
+ * of the sources in parallel. Every source must present the same archive.
+ *
+ * The central directory is fetched in the background right away, followed by
+ * `prefetch_members` in the given order. */
+Result<SeekableZipSource> CacheZipSource(
+    std::vector<SeekableZipSource> inner, std::string file_path,
+    const std::vector<std::string>& prefetch_members = {});
+
 }  // namespace cuttlefish
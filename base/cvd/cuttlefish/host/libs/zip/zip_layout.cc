@@ -0,0 +1,196 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/zip/zip_layout.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+// Record layouts are from section 4.3 of the PKWARE APPNOTE.TXT.
+constexpr uint32_t kCentralDirectoryHeaderSignature = 0x02014b50;
+constexpr uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+constexpr uint32_t kZip64EndOfCentralDirectorySignature = 0x06064b50;
+constexpr uint32_t kZip64LocatorSignature = 0x07064b50;
+constexpr uint16_t kZip64ExtraFieldId = 0x0001;
+
+constexpr uint64_t kCentralDirectoryHeaderSize = 46;
+constexpr uint64_t kEndOfCentralDirectorySize = 22;
+constexpr uint64_t kZip64EndOfCentralDirectorySize = 56;
+constexpr uint64_t kZip64LocatorSize = 20;
+
+// Fields with this value are stored in the zip64 records instead.
+constexpr uint32_t kZip64Marker32 = 0xffffffff;
+constexpr uint16_t kZip64Marker16 = 0xffff;
+
+uint64_t LittleEndian(std::string_view data, size_t offset, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = bytes; i > 0; i--) {
+    value = (value << 8) | static_cast<uint8_t>(data[offset + i - 1]);
+  }
+  return value;
+}
+
+uint16_t Le16(std::string_view data, size_t offset) {
+  return LittleEndian(data, offset, 2);
+}
+
+uint32_t Le32(std::string_view data, size_t offset) {
+  return LittleEndian(data, offset, 4);
+}
+
+uint64_t Le64(std::string_view data, size_t offset) {
+  return LittleEndian(data, offset, 8);
+}
+
+Result<std::string> ReadAt(const ReaderSeeker& archive, uint64_t offset,
+                           uint64_t size) {
+  std::string data(size, '\0');
+  CF_EXPECT(PReadExact(archive, data.data(), data.size(), offset));
+  return data;
+}
+
+// Returns the position of the end of central directory record in `trailer`.
+// The record is followed by a comment of variable length, so it is found by
+// searching backwards for a signature whose comment ends at the end of file.
+Result<uint64_t> FindEndOfCentralDirectory(std::string_view trailer) {
+  CF_EXPECT_GE(trailer.size(), kEndOfCentralDirectorySize,
+               "Too small to be a zip archive");
+  for (uint64_t pos = trailer.size() - kEndOfCentralDirectorySize + 1;
+       pos > 0; pos--) {
+    const uint64_t record = pos - 1;
+    if (Le32(trailer, record) == kEndOfCentralDirectorySignature &&
+        record + kEndOfCentralDirectorySize + Le16(trailer, record + 20) ==
+            trailer.size()) {
+      return record;
+    }
+  }
+  return CF_ERR("No end of central directory record");
+}
+
+// Reads the local header offset out of a zip64 extended information extra
+// field. The field only contains the values whose regular field is saturated,
+// in a fixed order.
+Result<uint64_t> Zip64Offset(std::string_view extra, bool uncompressed_in_extra,
+                             bool compressed_in_extra) {
+  size_t pos = 0;
+  while (pos + 4 <= extra.size()) {
+    const uint16_t id = Le16(extra, pos);
+    const uint16_t size = Le16(extra, pos + 2);
+    CF_EXPECT_LE(pos + 4 + size, extra.size(), "Truncated extra field");
+    if (id == kZip64ExtraFieldId) {
+      const size_t offset_pos = (uncompressed_in_extra ? 8 : 0) +
+                                (compressed_in_extra ? 8 : 0);
+      CF_EXPECT_LE(offset_pos + 8, size, "Truncated zip64 extra field");
+      return Le64(extra, pos + 4 + offset_pos);
+    }
+    pos += 4 + size;
+  }
+  return CF_ERR("Missing zip64 extra field");
+}
+
+}  // namespace
+
+Result<ZipLayout> ReadZipLayout(const ReaderSeeker& archive, uint64_t size) {
+  const uint64_t trailer_size = std::min(size, kZipTrailerSearchSize);
+  const uint64_t trailer_offset = size - trailer_size;
+  const std::string trailer =
+      CF_EXPECT(ReadAt(archive, trailer_offset, trailer_size));
+  const uint64_t end_record = CF_EXPECT(FindEndOfCentralDirectory(trailer));
+
+  uint64_t entries = Le16(trailer, end_record + 10);
+  ZipLayout layout = {
+      .central_directory_offset = Le32(trailer, end_record + 16),
+      .central_directory_size = Le32(trailer, end_record + 12),
+  };
+  if (entries == kZip64Marker16 ||
+      layout.central_directory_size == kZip64Marker32 ||
+      layout.central_directory_offset == kZip64Marker32) {
+    CF_EXPECT_GE(trailer_offset + end_record, kZip64LocatorSize,
+                 "Missing zip64 end of central directory locator");
+    const uint64_t locator_offset =
+        trailer_offset + end_record - kZip64LocatorSize;
+    const std::string locator =
+        CF_EXPECT(ReadAt(archive, locator_offset, kZip64LocatorSize));
+    CF_EXPECT_EQ(Le32(locator, 0), kZip64LocatorSignature);
+    const std::string record = CF_EXPECT(
+        ReadAt(archive, Le64(locator, 8), kZip64EndOfCentralDirectorySize));
+    CF_EXPECT_EQ(Le32(record, 0), kZip64EndOfCentralDirectorySignature);
+    entries = Le64(record, 32);
+    layout.central_directory_size = Le64(record, 40);
+    layout.central_directory_offset = Le64(record, 48);
+  }
+  CF_EXPECT_LE(layout.central_directory_offset, size);
+  CF_EXPECT_LE(layout.central_directory_size,
+               size - layout.central_directory_offset);
+
+  const std::string directory =
+      CF_EXPECT(ReadAt(archive, layout.central_directory_offset,
+                       layout.central_directory_size));
+  const std::string_view view = directory;
+  size_t pos = 0;
+  for (uint64_t i = 0; i < entries; i++) {
+    CF_EXPECT_LE(pos + kCentralDirectoryHeaderSize, view.size(),
+                 "Truncated central directory");
+    CF_EXPECT_EQ(Le32(view, pos), kCentralDirectoryHeaderSignature);
+    const uint16_t name_size = Le16(view, pos + 28);
+    const uint16_t extra_size = Le16(view, pos + 30);
+    const uint16_t comment_size = Le16(view, pos + 32);
+    const size_t name_pos = pos + kCentralDirectoryHeaderSize;
+    const size_t next = name_pos + name_size + extra_size + comment_size;
+    CF_EXPECT_LE(next, view.size(), "Truncated central directory");
+
+    uint64_t offset = Le32(view, pos + 42);
+    if (offset == kZip64Marker32) {
+      offset = CF_EXPECT(
+          Zip64Offset(view.substr(name_pos + name_size, extra_size),
+                      Le32(view, pos + 24) == kZip64Marker32,
+                      Le32(view, pos + 20) == kZip64Marker32));
+    }
+    CF_EXPECT_LE(offset, layout.central_directory_offset);
+    layout.members.emplace_back(ZipMemberRange{
+        .name = std::string(view.substr(name_pos, name_size)),
+        .offset = offset,
+    });
+    pos = next;
+  }
+
+  // Members are stored back to back, so each one ends where the next begins.
+  std::sort(layout.members.begin(), layout.members.end(),
+            [](const ZipMemberRange& a, const ZipMemberRange& b) {
+              return a.offset < b.offset;
+            });
+  for (size_t i = 0; i < layout.members.size(); i++) {
+    const uint64_t end = i + 1 < layout.members.size()
+                             ? layout.members[i + 1].offset
+                             : layout.central_directory_offset;
+    layout.members[i].length = end - layout.members[i].offset;
+  }
+  return layout;
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,49 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+/* How many bytes at the end of an archive hold the records that locate the
+ * central directory, in the worst case. */
+inline constexpr uint64_t kZipTrailerSearchSize = 0xffff + 22 + 20;
+
+struct ZipMemberRange {
+  std::string name;
+  // Covers the local header and the compressed data.
+  uint64_t offset;
+  uint64_t length;
+};
+
+struct ZipLayout {
+  uint64_t central_directory_offset;
+  uint64_t central_directory_size;
+  // Ordered by offset.
+  std::vector<ZipMemberRange> members;
+};
+
+/* Locates the members of the `size` byte zip archive in `archive` by parsing
+ * its central directory, without decompressing anything. */
+Result<ZipLayout> ReadZipLayout(const ReaderSeeker& archive, uint64_t size);
+
+}  // namespace cuttlefish
@@ -0,0 +1,89 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/zip/zip_layout.h"
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/host/libs/zip/libzip_cc/archive.h"
+#include "cuttlefish/host/libs/zip/libzip_cc/writable_source.h"
+#include "cuttlefish/host/libs/zip/zip_string.h"
+#include "cuttlefish/io/in_memory.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+Result<std::string> ZipArchive(
+    const std::map<std::string, std::string>& contents) {
+  std::string data(4096, '\0');
+
+  WritableZipSource source =
+      CF_EXPECT(WritableZipSource::BorrowData(data.data(), data.size()));
+  WritableZip zip = CF_EXPECT(WritableZip::FromSource(std::move(source)));
+
+  for (const auto& [path, member_data] : contents) {
+    CF_EXPECT(AddStringAt(zip, member_data, path));
+  }
+
+  source = CF_EXPECT(WritableZipSource::FromZip(std::move(zip)));
+
+  return CF_EXPECT(ReadToString(source));
+}
+
+TEST(ZipLayoutTest, MembersCoverArchiveInOrder) {
+  Result<std::string> archive =
+      ZipArchive({{"a.txt", "abc"}, {"b.txt", std::string(1000, 'b')}});
+  ASSERT_THAT(archive, IsOk());
+  std::unique_ptr<ReaderWriterSeeker> io = InMemoryIo(*archive);
+
+  Result<ZipLayout> layout = ReadZipLayout(*io, archive->size());
+  ASSERT_THAT(layout, IsOk());
+
+  ASSERT_EQ(layout->members.size(), 2);
+  EXPECT_EQ(layout->members[0].offset, 0);
+  uint64_t end = 0;
+  for (const ZipMemberRange& member : layout->members) {
+    EXPECT_EQ(member.offset, end);
+    end = member.offset + member.length;
+  }
+  EXPECT_EQ(end, layout->central_directory_offset);
+  EXPECT_LE(layout->central_directory_offset + layout->central_directory_size,
+            archive->size());
+  EXPECT_THAT(layout->members,
+              testing::UnorderedElementsAre(
+                  testing::Field(&ZipMemberRange::name, "a.txt"),
+                  testing::Field(&ZipMemberRange::name, "b.txt")));
+}
+
+TEST(ZipLayoutTest, RejectsOtherData) {
+  const std::string data = "not a zip archive, but long enough to search";
+  std::unique_ptr<ReaderWriterSeeker> io = InMemoryIo(data);
+
+  EXPECT_THAT(ReadZipLayout(*io, data.size()), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -0,0 +1,201 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/android_sparse.h"
+
+#include <endian.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "cuttlefish/io/fake_seek.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/length.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint32_t kSparseHeaderMagic = 0xed26ff3a;
+constexpr uint16_t kMajorVersion = 1;
+
+constexpr uint16_t kChunkTypeRaw = 0xCAC1;
+constexpr uint16_t kChunkTypeFill = 0xCAC2;
+constexpr uint16_t kChunkTypeDontCare = 0xCAC3;
+constexpr uint16_t kChunkTypeCrc32 = 0xCAC4;
+
+// All fields are little-endian.
+struct __attribute__((packed)) SparseHeader {
+  uint32_t magic;
+  uint16_t major_version;
+  uint16_t minor_version;
+  uint16_t file_hdr_sz;
+  uint16_t chunk_hdr_sz;
+  uint32_t blk_sz;
+  uint32_t total_blks;
+  uint32_t total_chunks;
+  uint32_t image_checksum;
+};
+
+// All fields are little-endian.
+struct __attribute__((packed)) ChunkHeader {
+  uint16_t chunk_type;
+  uint16_t reserved1;
+  uint32_t chunk_sz;  // In blocks
+  uint32_t total_sz;  // In bytes, including this header
+};
+
+struct Chunk {
+  enum class Type { kRaw, kFill, kDontCare };
+
+  Type type;
+  uint64_t length;
+  // Offset in the sparse image where the data of a raw chunk starts.
+  uint64_t raw_offset = 0;
+  // Repeating 4-byte pattern of a fill chunk, in file order.
+  uint8_t fill[4] = {};
+};
+
+class AndroidSparseReaderSeeker : public ReaderFakeSeeker {
+ public:
+  AndroidSparseReaderSeeker(std::unique_ptr<ReaderSeeker> sparse,
+                            std::map<uint64_t, Chunk> chunks, uint64_t length)
+      : ReaderFakeSeeker(length),
+        sparse_(std::move(sparse)),
+        chunks_(std::move(chunks)),
+        length_(length) {}
+
+  Result<uint64_t> PRead(void* buf, uint64_t count,
+                         uint64_t offset) const override {
+    if (offset >= length_ || count == 0) {
+      return 0;
+    }
+    auto it = chunks_.upper_bound(offset);
+    CF_EXPECT(it != chunks_.begin(), "Could not find chunk");
+    it--;
+    const uint64_t chunk_offset = offset - it->first;
+    const Chunk& chunk = it->second;
+    // Relies on callers to retry reads that are cut short at chunk ends.
+    count = std::min(count, chunk.length - chunk_offset);
+    switch (chunk.type) {
+      case Chunk::Type::kRaw:
+        return CF_EXPECT(
+            sparse_->PRead(buf, count, chunk.raw_offset + chunk_offset));
+      case Chunk::Type::kFill: {
+        char* out = static_cast<char*>(buf);
+        for (uint64_t i = 0; i < count; i++) {
+          out[i] = chunk.fill[(chunk_offset + i) % sizeof(chunk.fill)];
+        }
+        return count;
+      }
+      case Chunk::Type::kDontCare:
+        memset(buf, 0, count);
+        return count;
+    }
+    return CF_ERR("Unknown chunk type");
+  }
+
+ private:
+  std::unique_ptr<ReaderSeeker> sparse_;
+  std::map<uint64_t, Chunk> chunks_;
+  uint64_t length_;
+};
+
+}  // namespace
+
+Result<bool> IsAndroidSparse(const ReaderSeeker& reader) {
+  uint32_t magic;
+  if (CF_EXPECT(reader.PRead(&magic, sizeof(magic), 0)) != sizeof(magic)) {
+    return false;
+  }
+  return le32toh(magic) == kSparseHeaderMagic;
+}
+
+Result<std::unique_ptr<ReaderSeeker>> AndroidSparseReader(
+    std::unique_ptr<ReaderSeeker> sparse) {
+  CF_EXPECT(sparse.get());
+  const uint64_t sparse_length = CF_EXPECT(Length(*sparse));
+
+  SparseHeader header = CF_EXPECT(PReadExactBinary<SparseHeader>(*sparse, 0));
+  CF_EXPECT_EQ(le32toh(header.magic), kSparseHeaderMagic, "Not a sparse image");
+  CF_EXPECT_EQ(le16toh(header.major_version), kMajorVersion);
+  const uint16_t file_hdr_sz = le16toh(header.file_hdr_sz);
+  const uint16_t chunk_hdr_sz = le16toh(header.chunk_hdr_sz);
+  const uint32_t blk_sz = le32toh(header.blk_sz);
+  CF_EXPECT_GE(file_hdr_sz, sizeof(SparseHeader));
+  CF_EXPECT_GE(chunk_hdr_sz, sizeof(ChunkHeader));
+  CF_EXPECT(blk_sz > 0 && blk_sz % 4 == 0, "Invalid block size " << blk_sz);
+
+  std::map<uint64_t, Chunk> chunks;
+  uint64_t sparse_offset = file_hdr_sz;
+  uint64_t expanded_offset = 0;
+  const uint32_t total_chunks = le32toh(header.total_chunks);
+  for (uint32_t i = 0; i < total_chunks; i++) {
+    ChunkHeader chunk_header =
+        CF_EXPECT(PReadExactBinary<ChunkHeader>(*sparse, sparse_offset));
+    const uint64_t data_offset = sparse_offset + chunk_hdr_sz;
+    const uint64_t total_sz = le32toh(chunk_header.total_sz);
+    CF_EXPECTF(total_sz >= chunk_hdr_sz, "Chunk {} is too small", i);
+    const uint64_t data_sz = total_sz - chunk_hdr_sz;
+    CF_EXPECTF(data_offset + data_sz <= sparse_length,
+               "Chunk {} extends past the end of the image", i);
+
+    Chunk chunk;
+    chunk.length = uint64_t{le32toh(chunk_header.chunk_sz)} * blk_sz;
+    switch (le16toh(chunk_header.chunk_type)) {
+      case kChunkTypeRaw:
+        CF_EXPECTF(data_sz == chunk.length, "Raw chunk {} has wrong size", i);
+        chunk.type = Chunk::Type::kRaw;
+        chunk.raw_offset = data_offset;
+        break;
+      case kChunkTypeFill:
+        CF_EXPECTF(data_sz == sizeof(chunk.fill), "Bad fill chunk {}", i);
+        chunk.type = Chunk::Type::kFill;
+        CF_EXPECT(PReadExact(*sparse, reinterpret_cast<char*>(chunk.fill),
+                             sizeof(chunk.fill), data_offset));
+        break;
+      case kChunkTypeDontCare:
+        chunk.type = Chunk::Type::kDontCare;
+        break;
+      case kChunkTypeCrc32:
+        // Checksums are not verified, and cover no output data.
+        sparse_offset += total_sz;
+        continue;
+      default:
+        return CF_ERRF("Unknown type {:#x} for chunk {}",
+                       le16toh(chunk_header.chunk_type), i);
+    }
+    sparse_offset += total_sz;
+    if (chunk.length > 0) {
+      chunks.emplace(expanded_offset, chunk);
+      expanded_offset += chunk.length;
+    }
+  }
+  const uint64_t expected_length =
+      uint64_t{le32toh(header.total_blks)} * blk_sz;
+  CF_EXPECT_EQ(expanded_offset, expected_length,
+               "Chunks do not add up to the image size");
+
+  return std::make_unique<AndroidSparseReaderSeeker>(
+      std::move(sparse), std::move(chunks), expanded_offset);
+}
+
+}  // namespace cuttlefish
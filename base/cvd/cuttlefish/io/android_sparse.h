@@ -0,0 +1,41 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+
+// Returns whether the data starts with the Android sparse image magic. Does not
+// move the seek position.
+Result<bool> IsAndroidSparse(const ReaderSeeker&);
+
+// Presents the expanded contents of an Android sparse image.
+//
+// Only the chunk headers are read up front, to build an index from expanded
+// offsets to chunks. Raw chunks are read from the wrapped instance on demand,
+// while fill and "don't care" chunks are generated without reading. "Don't
+// care" chunks read as zeroes, so copying the result with `SparseCopy` leaves
+// them as holes.
+//
+// https://android.googlesource.com/platform/system/core/+/refs/heads/main/libsparse/sparse_format.h
+Result<std::unique_ptr<ReaderSeeker>> AndroidSparseReader(
+    std::unique_ptr<ReaderSeeker>);
+
+}  // namespace cuttlefish
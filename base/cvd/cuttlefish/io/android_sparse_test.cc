@@ -0,0 +1,124 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/android_sparse.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/io/in_memory.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/string.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint32_t kBlockSize = 8;
+
+void Append16(std::string& out, uint16_t value) {
+  out.push_back(value & 0xff);
+  out.push_back(value >> 8);
+}
+
+void Append32(std::string& out, uint32_t value) {
+  Append16(out, value & 0xffff);
+  Append16(out, value >> 16);
+}
+
+std::string SparseHeader(uint32_t total_blocks, uint32_t total_chunks) {
+  std::string out;
+  Append32(out, 0xed26ff3a);
+  Append16(out, 1);   // major_version
+  Append16(out, 0);   // minor_version
+  Append16(out, 28);  // file_hdr_sz
+  Append16(out, 12);  // chunk_hdr_sz
+  Append32(out, kBlockSize);
+  Append32(out, total_blocks);
+  Append32(out, total_chunks);
+  Append32(out, 0);  // image_checksum
+  return out;
+}
+
+std::string Chunk(uint16_t type, uint32_t blocks, const std::string& data) {
+  std::string out;
+  Append16(out, type);
+  Append16(out, 0);
+  Append32(out, blocks);
+  Append32(out, 12 + data.size());
+  return out + data;
+}
+
+// raw "rawdata!" | fill "abcd" x2 blocks | don't care | crc | raw "12345678"
+std::string TestImage() {
+  return SparseHeader(5, 5) + Chunk(0xCAC1, 1, "rawdata!") +
+         Chunk(0xCAC2, 2, "abcd") + Chunk(0xCAC3, 1, "") +
+         Chunk(0xCAC4, 0, "\x01\x02\x03\x04") + Chunk(0xCAC1, 1, "12345678");
+}
+
+std::string TestImageExpanded() {
+  return "rawdata!" "abcdabcdabcdabcd" + std::string(8, '\0') + "12345678";
+}
+
+TEST(AndroidSparseTest, DetectsMagic) {
+  EXPECT_THAT(IsAndroidSparse(*InMemoryIo(TestImage())), IsOkAndValue(true));
+  EXPECT_THAT(IsAndroidSparse(*InMemoryIo("not sparse")), IsOkAndValue(false));
+  EXPECT_THAT(IsAndroidSparse(*InMemoryIo("")), IsOkAndValue(false));
+}
+
+TEST(AndroidSparseTest, ReadsExpandedContents) {
+  Result<std::unique_ptr<ReaderSeeker>> reader =
+      AndroidSparseReader(InMemoryIo(TestImage()));
+  ASSERT_THAT(reader, IsOk());
+
+  EXPECT_THAT(ReadToString(**reader), IsOkAndValue(TestImageExpanded()));
+}
+
+TEST(AndroidSparseTest, ReadsAtArbitraryOffsets) {
+  Result<std::unique_ptr<ReaderSeeker>> reader =
+      AndroidSparseReader(InMemoryIo(TestImage()));
+  ASSERT_THAT(reader, IsOk());
+  const std::string expanded = TestImageExpanded();
+
+  for (uint64_t offset = 0; offset < expanded.size(); offset++) {
+    const uint64_t size = expanded.size() - offset;
+    std::string data(size, ' ');
+    ASSERT_THAT(PReadExact(**reader, data.data(), size, offset), IsOk());
+    EXPECT_EQ(data, expanded.substr(offset)) << "offset " << offset;
+  }
+  EXPECT_THAT((*reader)->SeekEnd(0), IsOkAndValue(expanded.size()));
+}
+
+TEST(AndroidSparseTest, RejectsTruncatedImage) {
+  std::string image = TestImage();
+  image.resize(image.size() - 1);
+
+  EXPECT_THAT(AndroidSparseReader(InMemoryIo(image)), IsError());
+}
+
+TEST(AndroidSparseTest, RejectsWrongBlockCount) {
+  std::string image = SparseHeader(2, 1) + Chunk(0xCAC3, 1, "");
+
+  EXPECT_THAT(AndroidSparseReader(InMemoryIo(image)), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -15,65 +15,275 @@
 
 #include "cuttlefish/io/copy.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
 
-#include <array>
-#include <memory>
+#include <algorithm>
+#include <optional>
+#include <vector>
 
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/io/default_visitor.h"
 #include "cuttlefish/io/io.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/zeroes.h"
 #include "cuttlefish/result/expect.h"
 #include "cuttlefish/result/result_type.h"
 
 namespace cuttlefish {
+namespace {
 
-static constexpr size_t kBufferSize = 1 << 26;
+// Upper bound on a single copy_file_range(2) or splice(2) call, to keep each
+// syscall interruptible.
+constexpr size_t kKernelCopyChunk = 1 << 30;
+
+// Granularity at which SparseCopy looks for zeroes, matching the usual
+// filesystem block size.
+constexpr uint64_t kSparseBlockSize = 4096;
+
+/** Finds the file descriptor behind an IO object, if there is one. */
+class SharedFdVisitor : public DefaultIoVisitor {
+ public:
+  using DefaultIoVisitor::Accept;
+
+  Result<void> Accept(Reader&) override { return {}; }
+  Result<void> Accept(Seeker&) override { return {}; }
+  Result<void> Accept(SharedFdIo& io) override {
+    fd_ = io.GetSharedFd();
+    return {};
+  }
+  Result<void> Accept(Writer&) override { return {}; }
+
+  const std::optional<SharedFD>& Fd() const { return fd_; }
+
+ private:
+  std::optional<SharedFD> fd_;
+};
+
+Result<std::optional<SharedFD>> UnderlyingFd(IoVisitable& io) {
+  SharedFdVisitor visitor;
+  CF_EXPECT(io.Visit(visitor));
+  return visitor.Fd();
+}
+
+/*
+ * The Offload* functions below return false when the kernel could not finish
+ * the copy. They always leave the file positions consistent with the data that
+ * was moved, so the caller can continue with the next strategy.
+ */
+
+// Shares the extents from the position of `in` to its end with `out` at the
+// position of `out` through FICLONERANGE. This is only possible when both
+// files are on the same filesystem, the filesystem supports reflinks and the
+// offsets are block-aligned.
+bool OffloadClone(Fd& in, Fd& out) {
+  if (!in.IsRegular() || !out.IsRegular()) {
+    return false;
+  }
+  const off_t in_start = in.LSeek(0, SEEK_CUR);
+  const off_t out_start = out.LSeek(0, SEEK_CUR);
+  const off_t in_end = in.LSeek(0, SEEK_END);
+  if (in_start < 0 || out_start < 0 || in_end < 0) {
+    return false;
+  }
+  if (in_end <= in_start) {
+    return in.LSeek(in_start, SEEK_SET) == in_start;
+  }
+  if (out.CloneRange(in, in_start, 0, out_start) < 0) {
+    in.LSeek(in_start, SEEK_SET);
+    return false;
+  }
+  const off_t out_end = out_start + (in_end - in_start);
+  return out.LSeek(out_end, SEEK_SET) == out_end;
+}
+
+bool OffloadCopyFileRange(Fd& in, Fd& out) {
+  if (!in.IsRegular() || !out.IsRegular()) {
+    return false;
+  }
+  ssize_t copied;
+  while ((copied = out.CopyFileRange(in, nullptr, nullptr, kKernelCopyChunk)) >
+         0) {
+  }
+  return copied == 0;
+}
+
+// Only succeeds when at least one side is a pipe.
+bool OffloadSplice(Fd& in, Fd& out) {
+  ssize_t copied;
+  while ((copied = out.Splice(in, nullptr, nullptr, kKernelCopyChunk,
+                              SPLICE_F_MOVE)) > 0) {
+  }
+  return copied == 0;
+}
+
+// Copies the data extents reported by SEEK_DATA/SEEK_HOLE from the position of
+// `in` to its end into the start of `out`, preferring a reflink of the whole
+// range. Holes in `in` are left as holes in `out`. Unlike the other Offload*
+// functions, the contents of `out` are unspecified on failure.
+bool OffloadSparse(Fd& in, Fd& out) {
+  const off_t in_start = in.LSeek(0, SEEK_CUR);
+  const off_t in_end = in.LSeek(0, SEEK_END);
+  if (in_start < 0 || in_end < 0) {
+    return false;
+  }
+  const off_t size = in_end > in_start ? in_end - in_start : 0;
+  if (size > 0 && out.CloneRange(in, in_start, 0, 0) < 0) {
+    // Only the data extents are written, so anything already in `out` would
+    // show through the holes.
+    if (!out.Truncate(0)) {
+      return false;
+    }
+    off_t data = in_start;
+    while (data < in_end) {
+      data = in.LSeek(data, SEEK_DATA);
+      if (data < 0) {
+        if (in.GetErrno() == ENXIO) {  // No data after the offset
+          break;
+        }
+        return false;
+      }
+      const off_t hole = in.LSeek(data, SEEK_HOLE);
+      if (hole < 0) {
+        return false;
+      }
+      off_t in_offset = data;
+      off_t out_offset = data - in_start;
+      while (in_offset < hole) {
+        const size_t remaining = hole - in_offset;
+        if (out.CopyFileRange(in, &in_offset, &out_offset,
+                              std::min(remaining, kKernelCopyChunk)) <= 0) {
+          return false;
+        }
+      }
+      data = hole;
+    }
+  }
+  if (!out.Truncate(size)) {
+    return false;
+  }
+  return in.LSeek(in_start + size, SEEK_SET) == in_start + size &&
+         out.LSeek(size, SEEK_SET) == size;
+}
+
+Result<void> WriteAll(Writer& writer, const char* data, uint64_t size) {
+  uint64_t chunk_written = 0;
+  while (chunk_written < size) {
+    uint64_t written =
+        CF_EXPECT(writer.Write(&data[chunk_written], size - chunk_written));
+    CF_EXPECT_GT(written, 0, "Premature EOF on writer");
+    chunk_written += written;
+  }
+  return {};
+}
+
+// Moves the writer past `length` bytes of zeroes at `zeroes` without
+// allocating space for them. File-backed writers get a hole punched over the
+// range so that any previous contents do not show through.
+Result<void> SkipZeroes(WriterSeeker& writer,
+                        const std::optional<SharedFD>& out, const char* zeroes,
+                        uint64_t length) {
+  if (out) {
+    const uint64_t offset = CF_EXPECT(writer.SeekCur(0));
+    if ((*out)->Fallocate(FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset,
+                          length) < 0) {
+      // The filesystem can't deallocate blocks, so correctness wins over
+      // sparseness.
+      CF_EXPECT(WriteAll(writer, zeroes, length));
+      return {};
+    }
+  }
+  CF_EXPECT(writer.SeekCur(length));
+  return {};
+}
+
+}  // namespace
 
 Result<void> Copy(Reader& reader, Writer& writer, const size_t buffer_size) {
-  std::unique_ptr<std::array<char, kBufferSize>> buf(
-      new std::array<char, kBufferSize>);
-  uint64_t chunk_read;
-  while ((chunk_read = CF_EXPECT(reader.Read(buf.get(), buf->size()))) > 0) {
-    uint64_t chunk_written = 0;
-    while (chunk_written < chunk_read) {
-      uint64_t written = CF_EXPECT(writer.Write(&buf->data()[chunk_written],
-                                                chunk_read - chunk_written));
-      CF_EXPECT_GT(written, 0, "Premature EOF on writer");
-      chunk_written += written;
+  std::optional<SharedFD> in = CF_EXPECT(UnderlyingFd(reader));
+  std::optional<SharedFD> out = CF_EXPECT(UnderlyingFd(writer));
+  if (in && out) {
+    if (OffloadClone(**in, **out) || OffloadCopyFileRange(**in, **out) ||
+        OffloadSplice(**in, **out)) {
+      return {};
     }
   }
+
+  CF_EXPECT_GT(buffer_size, 0);
+  std::vector<char> buf(buffer_size);
+  uint64_t chunk_read;
+  while ((chunk_read = CF_EXPECT(reader.Read(buf.data(), buf.size()))) > 0) {
+    CF_EXPECT(WriteAll(writer, buf.data(), chunk_read));
+  }
   return {};
 }
 
 Result<void> SparseCopy(Reader& reader, WriterSeeker& writer,
                         size_t buffer_size) {
   CF_EXPECT(writer.SeekSet(0));
-  std::unique_ptr<std::array<char, kBufferSize>> buf(
-      new std::array<char, kBufferSize>);
+  std::optional<SharedFD> in = CF_EXPECT(UnderlyingFd(reader));
+  std::optional<SharedFD> out = CF_EXPECT(UnderlyingFd(writer));
+  if (in && out && (*in)->IsRegular() && (*out)->IsRegular()) {
+    const off_t in_start = (*in)->LSeek(0, SEEK_CUR);
+    CF_EXPECT_GE(in_start, 0, (*in)->StrError());
+    if (OffloadSparse(**in, **out)) {
+      CF_EXPECT(writer.Write(nullptr, 0));
+      return {};
+    }
+    CF_EXPECT_EQ((*in)->LSeek(in_start, SEEK_SET), in_start,
+                 (*in)->StrError());
+    CF_EXPECT(writer.Truncate(0));
+    CF_EXPECT(writer.SeekSet(0));
+  }
+
+  CF_EXPECT_GT(buffer_size, 0);
+  std::vector<char> buf(buffer_size);
   uint64_t chunk_read;
   uint64_t total_size = 0;
-  while ((chunk_read = CF_EXPECT(reader.Read(buf.get(), buf->size()))) > 0) {
-    total_size += chunk_read;
-    if ((*buf)[0] == '\0' && (*buf)[chunk_read - 1] == 0) {
-      bool zero_chunk = true;
-      for (const char c : *buf) {
-        if (c != '\0') {
-          zero_chunk = false;
+  bool ends_in_hole = false;
+  while ((chunk_read = CF_EXPECT(reader.Read(buf.data(), buf.size()))) > 0) {
+    // Blocks are aligned to offsets in the output rather than to the buffer,
+    // as short reads can start a chunk anywhere.
+    auto block_size = [&](uint64_t pos) {
+      const uint64_t to_boundary =
+          kSparseBlockSize - (total_size + pos) % kSparseBlockSize;
+      return std::min(to_boundary, chunk_read - pos);
+    };
+    uint64_t run_start = 0;
+    while (run_start < chunk_read) {
+      uint64_t run_end = run_start + block_size(run_start);
+      const bool zeroes = IsAllZeroes(&buf[run_start], run_end - run_start);
+      while (run_end < chunk_read) {
+        const uint64_t next = block_size(run_end);
+        if (IsAllZeroes(&buf[run_end], next) != zeroes) {
           break;
         }
+        run_end += next;
       }
-      if (zero_chunk) {
-        CF_EXPECT(writer.Truncate(total_size));
-        CF_EXPECT(writer.SeekCur(chunk_read));
-        continue;
+      if (zeroes) {
+        CF_EXPECT(
+            SkipZeroes(writer, out, &buf[run_start], run_end - run_start));
+      } else {
+        CF_EXPECT(WriteAll(writer, &buf[run_start], run_end - run_start));
       }
+      ends_in_hole = zeroes;
+      run_start = run_end;
     }
-    uint64_t chunk_written = 0;
-    while (chunk_written < chunk_read) {
-      uint64_t written = CF_EXPECT(writer.Write(&buf->data()[chunk_written],
-                                                chunk_read - chunk_written));
-      CF_EXPECT_GT(written, 0, "Premature EOF on writer");
-      chunk_written += written;
+    total_size += chunk_read;
+  }
+  if (ends_in_hole) {
+    if (out && (*out)->IsRegular()) {
+      CF_EXPECT(writer.Truncate(total_size));
+    } else {
+      // Other writers may not support truncation, but all of them grow on a
+      // write.
+      const char zero = '\0';
+      CF_EXPECT(writer.SeekCur(-1));
+      CF_EXPECT(WriteAll(writer, &zero, 1));
     }
   }
   CF_EXPECT(writer.Write(nullptr, 0));
@@ -25,14 +25,20 @@ namespace cuttlefish {
 // Moves data from the Reader to the Writer, without doing additional seeking on
 // either. This means if either has seek pointers set somewhere in the middle of
 // the data, reading and writing starts from that point.
+//
+// When both sides are backed by file descriptors, the copy is offloaded to the
+// kernel with a reflink, copy_file_range(2) or splice(2) where possible, and
+// only goes through a `buffer_size` user-space buffer otherwise.
 Result<void> Copy(Reader&, Writer&, size_t buffer_size = 1 << 26);
 
-// Moves data from the Reader to the WriterSeeker. Uses heuristics to detect
-// large chunks of zeroes, and performs forward seeks on the output rather than
-// writing the zeroes.
+// Moves data from the Reader to the WriterSeeker. Detects 4 KiB blocks of
+// zeroes, and performs forward seeks on the output (punching holes in files)
+// rather than writing the zeroes. Only the non-zero runs are written.
 //
 // This is helpful for writing large files to the filesystem, as it can use the
-// linux-sparse mechanism to not fully allocate blocks.
+// linux-sparse mechanism to not fully allocate blocks. When both sides are
+// regular files, the holes already present in the input are found with
+// SEEK_DATA/SEEK_HOLE and only the data extents are copied by the kernel.
 Result<void> SparseCopy(Reader&, WriterSeeker&, size_t buffer_size = 1 << 26);
 
 }  // namespace cuttlefish
@@ -0,0 +1,181 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Copies a `--size_mib` image file in `--directory` with `Copy` and
+// `SparseCopy`, once with both ends visible as file descriptors so that the
+// copy is offloaded to the kernel, and once with the input hidden behind a
+// plain `Reader` so that it goes through the user-space buffer. Only
+// `--data_percent` of the 1 MiB chunks of the image hold data, the rest are
+// holes, the way a freshly built disk image looks.
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/log/log.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/utils/known_paths.h"
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/io/copy.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/write_exact.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kChunkSize = 1 << 20;
+
+// Hides the file descriptor of `reader` from `Copy` and `SparseCopy`.
+class OpaqueReader : public Reader {
+ public:
+  explicit OpaqueReader(Reader& reader) : reader_(reader) {}
+
+  Result<uint64_t> Read(void* buf, uint64_t count) override {
+    return reader_.Read(buf, count);
+  }
+
+ private:
+  Reader& reader_;
+};
+
+Result<void> CreateImage(const std::string& path, size_t size_mib,
+                         size_t data_percent) {
+  SharedFD fd = SharedFD::Open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  CF_EXPECTF(fd->IsOpen(), "Failed to create '{}': {}", path, fd->StrError());
+  SharedFdIo image(fd);
+  CF_EXPECT(image.Truncate(static_cast<uint64_t>(size_mib) * kChunkSize));
+  std::vector<char> chunk(kChunkSize, 'a');
+  for (size_t i = 0; i < size_mib; i++) {
+    // Spreads the data chunks evenly over the image.
+    if ((i * data_percent) % 100 < data_percent) {
+      CF_EXPECT(PWriteExact(image, chunk.data(), chunk.size(), i * kChunkSize));
+    }
+  }
+  return {};
+}
+
+using CopyFunction = std::function<Result<void>(Reader&, WriterSeeker&)>;
+
+Result<void> Report(const std::string& name, const std::string& input_path,
+                    const std::string& output_path, size_t size_mib,
+                    size_t iterations, bool hide_input,
+                    const CopyFunction& copy) {
+  std::vector<Clock::duration> samples;
+  for (size_t i = 0; i < iterations; i++) {
+    SharedFD input_fd = SharedFD::Open(input_path, O_RDONLY);
+    CF_EXPECTF(input_fd->IsOpen(), "Failed to open '{}': {}", input_path,
+               input_fd->StrError());
+    SharedFD output_fd =
+        SharedFD::Open(output_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    CF_EXPECTF(output_fd->IsOpen(), "Failed to open '{}': {}", output_path,
+               output_fd->StrError());
+    SharedFdIo input(input_fd);
+    SharedFdIo output(output_fd);
+    OpaqueReader opaque_input(input);
+
+    Clock::time_point begin = Clock::now();
+    CF_EXPECT(copy(hide_input ? static_cast<Reader&>(opaque_input) : input,
+                   output));
+    samples.emplace_back(Clock::now() - begin);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  auto millis = [](Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+  const double median = millis(samples[samples.size() / 2]);
+  std::cout << name << ": min " << millis(samples.front()) << "ms, median "
+            << median << "ms, " << size_mib * 1000 / median << " MiB/s\n";
+  return {};
+}
+
+Result<void> CopyBenchmarkMain(int argc, char** argv) {
+  std::string directory = TempDir();
+  size_t size_mib = 1024;
+  size_t data_percent = 25;
+  size_t iterations = 5;
+  std::vector<Flag> flags;
+  flags.emplace_back(GflagsCompatFlag("directory", directory)
+                         .Help("Where to create the image and its copies."));
+  flags.emplace_back(GflagsCompatFlag("size_mib", size_mib)
+                         .Help("Size of the image in mebibytes."));
+  flags.emplace_back(
+      GflagsCompatFlag("data_percent", data_percent)
+          .Help("Percentage of the image that holds data, not holes."));
+  flags.emplace_back(GflagsCompatFlag("iterations", iterations)
+                         .Help("How many times to copy the image per method."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(size_mib, 0u);
+  CF_EXPECT_LE(data_percent, 100u);
+  CF_EXPECT_GT(iterations, 0u);
+
+  const std::string input_path = directory + "/copy_benchmark_input.img";
+  const std::string output_path = directory + "/copy_benchmark_output.img";
+  CF_EXPECT(CreateImage(input_path, size_mib, data_percent));
+
+  std::cout << "Copying a " << size_mib << " MiB image with " << data_percent
+            << "% data in " << directory << " " << iterations
+            << " times per method\n";
+  const CopyFunction copy = [](Reader& input, WriterSeeker& output) {
+    return Copy(input, output);
+  };
+  const CopyFunction sparse_copy = [](Reader& input, WriterSeeker& output) {
+    return SparseCopy(input, output);
+  };
+  Result<void> result = [&]() -> Result<void> {
+    CF_EXPECT(Report("Copy, kernel", input_path, output_path, size_mib,
+                     iterations, false, copy));
+    CF_EXPECT(Report("Copy, buffered", input_path, output_path, size_mib,
+                     iterations, true, copy));
+    CF_EXPECT(Report("SparseCopy, extents", input_path, output_path, size_mib,
+                     iterations, false, sparse_copy));
+    CF_EXPECT(Report("SparseCopy, buffered", input_path, output_path, size_mib,
+                     iterations, true, sparse_copy));
+    return {};
+  }();
+  unlink(input_path.c_str());
+  unlink(output_path.c_str());
+  CF_EXPECT(std::move(result));
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result = cuttlefish::CopyBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
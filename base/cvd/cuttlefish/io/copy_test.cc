@@ -15,15 +15,20 @@
 
 #include "cuttlefish/io/copy.h"
 
+#include <stdio.h>
+
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "gmock/gmock-matchers.h"
 #include "gtest/gtest.h"
 
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/io/in_memory.h"
 #include "cuttlefish/io/io.h"
 #include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/shared_fd.h"
 #include "cuttlefish/result/result_matchers.h"
 
 namespace cuttlefish {
@@ -43,5 +48,161 @@ TEST(CopyTest, CopySmallBuffer) {
   EXPECT_EQ(data, data_out);
 }
 
+TEST(CopyTest, CopyRespectsBufferSize) {
+  std::vector<char> data = {1, 2, 3, 4, 5};
+
+  std::unique_ptr<ReaderWriterSeeker> in = InMemoryIo(data);
+  std::unique_ptr<ReaderWriterSeeker> out = InMemoryIo();
+
+  EXPECT_THAT(Copy(*in, *out, 2), IsOk());
+
+  std::vector<char> data_out(data.size());
+
+  EXPECT_THAT(PReadExact(*out, data_out.data(), data_out.size(), 0), IsOk());
+  EXPECT_EQ(data, data_out);
+}
+
+TEST(CopyTest, CopyBetweenFilesStartsAtSeekPointers) {
+  SharedFD in_fd = SharedFD::MemfdCreateWithData("in", "hello world");
+  ASSERT_TRUE(in_fd->IsOpen()) << in_fd->StrError();
+  SharedFD out_fd = SharedFD::MemfdCreateWithData("out", "say ");
+  ASSERT_TRUE(out_fd->IsOpen()) << out_fd->StrError();
+  SharedFdIo in(in_fd);
+  SharedFdIo out(out_fd);
+
+  ASSERT_THAT(in.SeekSet(6), IsOk());
+  ASSERT_THAT(out.SeekEnd(0), IsOk());
+
+  EXPECT_THAT(Copy(in, out), IsOk());
+
+  EXPECT_THAT(in.SeekCur(0), IsOkAndValue(11));
+  EXPECT_THAT(out.SeekCur(0), IsOkAndValue(9));
+  std::string data_out(9, '\0');
+  EXPECT_THAT(PReadExact(out, data_out.data(), data_out.size(), 0), IsOk());
+  EXPECT_EQ(data_out, "say world");
+}
+
+TEST(CopyTest, CopyFromPipe) {
+  SharedFD read_end;
+  SharedFD write_end;
+  ASSERT_TRUE(SharedFD::Pipe(&read_end, &write_end));
+  const std::string data = "piped data";
+  ASSERT_THAT(write_end->Write(data.data(), data.size()),
+              IsOkAndValue(data.size()));
+  write_end->Close();
+  SharedFD out_fd = SharedFD::MemfdCreateWithData("out", "");
+  ASSERT_TRUE(out_fd->IsOpen()) << out_fd->StrError();
+  SharedFdIo in(read_end);
+  SharedFdIo out(out_fd);
+
+  EXPECT_THAT(Copy(in, out), IsOk());
+
+  std::string data_out(data.size(), '\0');
+  EXPECT_THAT(PReadExact(out, data_out.data(), data_out.size(), 0), IsOk());
+  EXPECT_EQ(data_out, data);
+}
+
+TEST(CopyTest, SparseCopyBetweenFilesKeepsHoles) {
+  constexpr uint64_t kSize = 4 << 20;
+  constexpr uint64_t kSecondDataOffset = 1 << 20;
+  SharedFD in_fd = SharedFD::MemfdCreateWithData("in", "");
+  ASSERT_TRUE(in_fd->IsOpen()) << in_fd->StrError();
+  SharedFD out_fd = SharedFD::MemfdCreateWithData("out", "");
+  ASSERT_TRUE(out_fd->IsOpen()) << out_fd->StrError();
+  SharedFdIo in(in_fd);
+  SharedFdIo out(out_fd);
+  ASSERT_THAT(in.PWrite("a", 1, 0), IsOkAndValue(1));
+  ASSERT_THAT(in.PWrite("b", 1, kSecondDataOffset), IsOkAndValue(1));
+  ASSERT_THAT(in.Truncate(kSize), IsOk());
+
+  EXPECT_THAT(SparseCopy(in, out), IsOk());
+
+  EXPECT_THAT(out.SeekEnd(0), IsOkAndValue(kSize));
+  char data_out = 0;
+  EXPECT_THAT(PReadExact(out, &data_out, 1, 0), IsOk());
+  EXPECT_EQ(data_out, 'a');
+  EXPECT_THAT(PReadExact(out, &data_out, 1, kSecondDataOffset), IsOk());
+  EXPECT_EQ(data_out, 'b');
+  EXPECT_THAT(PReadExact(out, &data_out, 1, kSize - 1), IsOk());
+  EXPECT_EQ(data_out, '\0');
+  EXPECT_LT(out_fd->LSeek(0, SEEK_HOLE), kSecondDataOffset);
+}
+
+TEST(CopyTest, SparseCopyWritesOnlyNonZeroBlocks) {
+  constexpr uint64_t kBlock = 4096;
+  std::vector<char> data(16 * kBlock);
+  data[5 * kBlock + 10] = 'x';
+  data[6 * kBlock] = 'y';
+  std::unique_ptr<ReaderWriterSeeker> in = InMemoryIo(data);
+  SharedFD out_fd = SharedFD::MemfdCreateWithData("out", "");
+  ASSERT_TRUE(out_fd->IsOpen()) << out_fd->StrError();
+  SharedFdIo out(out_fd);
+
+  EXPECT_THAT(SparseCopy(*in, out), IsOk());
+
+  std::vector<char> data_out(data.size());
+  EXPECT_THAT(out.SeekEnd(0), IsOkAndValue(data.size()));
+  EXPECT_THAT(PReadExact(out, data_out.data(), data_out.size(), 0), IsOk());
+  EXPECT_EQ(data, data_out);
+  EXPECT_EQ(out_fd->LSeek(0, SEEK_DATA), 5 * kBlock);
+  EXPECT_EQ(out_fd->LSeek(5 * kBlock, SEEK_HOLE), 7 * kBlock);
+}
+
+TEST(CopyTest, SparseCopyUnalignedBufferSize) {
+  std::vector<char> data(20000);
+  data[4095] = 1;
+  data[9000] = 2;
+  data[12288] = 3;
+  std::unique_ptr<ReaderWriterSeeker> in = InMemoryIo(data);
+  std::unique_ptr<ReaderWriterSeeker> out = InMemoryIo();
+
+  EXPECT_THAT(SparseCopy(*in, *out, 1000), IsOk());
+
+  std::vector<char> data_out(data.size());
+  EXPECT_THAT(out->SeekEnd(0), IsOkAndValue(data.size()));
+  EXPECT_THAT(PReadExact(*out, data_out.data(), data_out.size(), 0), IsOk());
+  EXPECT_EQ(data, data_out);
+}
+
+TEST(CopyTest, SparseCopyOverwritesPreviousContents) {
+  constexpr uint64_t kBlock = 4096;
+  std::vector<char> data(3 * kBlock);
+  data[kBlock] = 'x';
+  std::unique_ptr<ReaderWriterSeeker> in = InMemoryIo(data);
+  SharedFD out_fd = SharedFD::MemfdCreateWithData(
+      "out", std::string(3 * kBlock, 'z'));
+  ASSERT_TRUE(out_fd->IsOpen()) << out_fd->StrError();
+  SharedFdIo out(out_fd);
+
+  EXPECT_THAT(SparseCopy(*in, out), IsOk());
+
+  std::vector<char> data_out(data.size());
+  EXPECT_THAT(PReadExact(out, data_out.data(), data_out.size(), 0), IsOk());
+  EXPECT_EQ(data, data_out);
+}
+
+TEST(CopyTest, SparseCopyBetweenFilesClearsLargerDestination) {
+  constexpr uint64_t kSize = 1 << 20;
+  constexpr uint64_t kDataOffset = 512 << 10;
+  SharedFD in_fd = SharedFD::MemfdCreateWithData("in", "");
+  ASSERT_TRUE(in_fd->IsOpen()) << in_fd->StrError();
+  SharedFD out_fd =
+      SharedFD::MemfdCreateWithData("out", std::string(2 * kSize, 'z'));
+  ASSERT_TRUE(out_fd->IsOpen()) << out_fd->StrError();
+  SharedFdIo in(in_fd);
+  SharedFdIo out(out_fd);
+  ASSERT_THAT(in.PWrite("a", 1, kDataOffset), IsOkAndValue(1));
+  ASSERT_THAT(in.Truncate(kSize), IsOk());
+
+  EXPECT_THAT(SparseCopy(in, out), IsOk());
+
+  std::string expected(kSize, '\0');
+  expected[kDataOffset] = 'a';
+  std::string data_out(kSize, 'x');
+  EXPECT_THAT(out.SeekEnd(0), IsOkAndValue(kSize));
+  EXPECT_THAT(PReadExact(out, data_out.data(), data_out.size(), 0), IsOk());
+  EXPECT_EQ(data_out, expected);
+}
+
 }  // namespace
 }  // namespace cuttlefish
@@ -15,60 +15,33 @@
 
 #include "cuttlefish/io/disjoint_range_set.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <algorithm>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <optional>
-#include <set>
 #include <utility>
 #include <vector>
 
 #include "absl/log/check.h"
 
 namespace cuttlefish {
-namespace {
-
-class Range {
- public:
-  Range(uint64_t start, uint64_t end) : start_(start), end_(end) {}
-
-  bool Contains(const Range& other) const {
-    return start_ <= other.start_ && end_ >= other.end_;
-  }
-
-  bool CanMerge(const Range& other) const {
-    return start_ <= other.end_ && other.start_ <= end_;
-  }
-
-  // Preconditions: `CanMerge(other)`
-  Range Merge(const Range& other) const {
-    return Range(std::min(start_, other.start_), std::max(end_, other.end_));
-  }
-
-  bool operator<(const Range& other) const {
-    return start_ < other.start_ ||
-           (start_ == other.start_ && end_ > other.end_);
-  }
-  bool operator==(const Range&) const = default;
-
-  std::pair<uint64_t, uint64_t> AsPair() const {
-    return std::make_pair(start_, end_);
-  }
-
-  uint64_t End() const { return end_; }
-
- private:
-  uint64_t start_;
-  uint64_t end_;
-};
-
-using Iterator = std::set<Range>::iterator;
-
-}  // namespace
 
 struct DisjointRangeSet::Impl {
-  std::set<Range> ranges_;
+  // Maps the start of each range to its end. Ranges never overlap or touch.
+  std::map<uint64_t, uint64_t> ranges_;
+
+  // Returns the range with the greatest start that is <= `value`.
+  std::optional<const_iterator> RangeAtOrBefore(uint64_t value) const {
+    const_iterator it = ranges_.upper_bound(value);
+    if (it == ranges_.begin()) {
+      return std::nullopt;
+    }
+    return std::prev(it);
+  }
 };
 
 DisjointRangeSet::DisjointRangeSet() : impl_(new Impl) {}
@@ -98,75 +71,81 @@ DisjointRangeSet::~DisjointRangeSet() = default;
 bool DisjointRangeSet::ContainsRange(uint64_t start, uint64_t end) const {
   CHECK_LE(start, end) << "Invalid range: expected start <= end";
 
-  const std::set<Range>& ranges = impl_->ranges_;
-
-  if (ranges.empty()) {
-    return false;
-  }
-  Range range(start, end);
-
-  Iterator range_it = ranges.upper_bound(range);
-  if (range_it != ranges.begin()) {
-    range_it--;
-  }
-  return range_it->Contains(range);
+  std::optional<const_iterator> range = impl_->RangeAtOrBefore(start);
+  return range.has_value() && (*range)->second >= end;
 }
 
 void DisjointRangeSet::InsertRange(uint64_t start, uint64_t end) {
   CHECK_LE(start, end) << "Invalid range: expected start <= end";
 
-  if (ContainsRange(start, end)) {
+  if (start == end || ContainsRange(start, end)) {
     return;
   }
 
-  std::set<Range>& ranges = impl_->ranges_;
-  Range new_range(start, end);
+  std::map<uint64_t, uint64_t>& ranges = impl_->ranges_;
 
-  // Merge in ranges that start after the newly inserted range starts, if the
-  // newly inserted range would overlap with them. `it` always points to the
-  // range with the next highest starting location.
-  Iterator it = ranges.upper_bound(new_range);
-  while (it != ranges.end() && new_range.CanMerge(*it)) {
-    new_range = new_range.Merge(*it);
+  // There can be at most one range before the new one that it overlaps with
+  // or touches, and the new range absorbs it.
+  std::map<uint64_t, uint64_t>::iterator it = ranges.upper_bound(start);
+  if (it != ranges.begin() && std::prev(it)->second >= start) {
+    --it;
+    start = it->first;
+    end = std::max(end, it->second);
     it = ranges.erase(it);
   }
-  // Merge a range that start before the newly inserted range, if the newly
-  // inserted range overlaps with the previous one. `it` initially points at the
-  // range with the next highest starting location, and `--it` moves it to point
-  // to the element directly before that. This works differently than the
-  // forwards merge because while `it` can safely be the `end()` sentinel past
-  // the end of the collection, there is no equivalent before-the-start sentinel
-  // value. There can be at most one range before that overlaps with this one.
-  if (it != ranges.begin() && new_range.CanMerge(*(--it))) {
-    new_range = new_range.Merge(*it);
+  // Any number of ranges after it can be absorbed as well.
+  while (it != ranges.end() && it->first <= end) {
+    end = std::max(end, it->second);
     it = ranges.erase(it);
   }
-  ranges.emplace(new_range);
+  ranges.emplace_hint(it, start, end);
 }
 
 std::optional<uint64_t> DisjointRangeSet::EndOfContainingRange(
     uint64_t start) const {
-  const std::set<Range>& ranges = impl_->ranges_;
+  std::optional<const_iterator> range = impl_->RangeAtOrBefore(start);
+  if (range.has_value() && (*range)->second > start) {
+    return (*range)->second;
+  }
+  return std::nullopt;
+}
 
-  Range test(start, start + 1);
+std::vector<std::pair<uint64_t, uint64_t>> DisjointRangeSet::Holes(
+    uint64_t start, uint64_t end) const {
+  CHECK_LE(start, end) << "Invalid range: expected start <= end";
 
-  Iterator it = ranges.upper_bound(test);
-  if (it == ranges.begin()) {
-    return std::nullopt;
+  std::vector<std::pair<uint64_t, uint64_t>> holes;
+  uint64_t pos = start;
+  if (std::optional<const_iterator> range = impl_->RangeAtOrBefore(start)) {
+    pos = std::max(pos, (*range)->second);
   }
-  it--;
-  return it->Contains(test) ? std::make_optional(it->End()) : std::nullopt;
+  for (const_iterator it = impl_->ranges_.upper_bound(start);
+       it != impl_->ranges_.end() && it->first < end; ++it) {
+    if (it->first > pos) {
+      holes.emplace_back(pos, it->first);
+    }
+    pos = it->second;
+  }
+  if (pos < end) {
+    holes.emplace_back(pos, end);
+  }
+  return holes;
 }
 
 std::vector<std::pair<uint64_t, uint64_t>> DisjointRangeSet::AllRanges() const {
-  std::vector<std::pair<uint64_t, uint64_t>> pairs;
-  pairs.reserve(impl_->ranges_.size());
-  for (const Range& range : impl_->ranges_) {
-    pairs.emplace_back(range.AsPair());
-  }
-  return pairs;
+  return std::vector<std::pair<uint64_t, uint64_t>>(begin(), end());
+}
+
+DisjointRangeSet::const_iterator DisjointRangeSet::begin() const {
+  return impl_->ranges_.begin();
+}
+
+DisjointRangeSet::const_iterator DisjointRangeSet::end() const {
+  return impl_->ranges_.end();
 }
 
+size_t DisjointRangeSet::size() const { return impl_->ranges_.size(); }
+
 bool DisjointRangeSet::operator==(const DisjointRangeSet& other) const {
   return impl_->ranges_ == other.impl_->ranges_;
 }
@@ -14,8 +14,10 @@
 // limitations under the License.
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <map>
 #include <memory>
 #include <optional>
 #include <utility>
@@ -23,8 +25,16 @@
 
 namespace cuttlefish {
 
+/**
+ * A set of integers stored as sorted, non-overlapping [start,end) ranges.
+ *
+ * Lookups and insertions take logarithmic time in the number of ranges.
+ */
 class DisjointRangeSet {
  public:
+  // Iterates over (start, end) pairs in ascending order.
+  using const_iterator = std::map<uint64_t, uint64_t>::const_iterator;
+
   DisjointRangeSet();
   DisjointRangeSet(const DisjointRangeSet&);
   DisjointRangeSet(DisjointRangeSet&&);
@@ -39,9 +49,18 @@ class DisjointRangeSet {
   // Returns the end of the range that `start` is a member of. Returns
   // std::nullopt if `start` is not within a range.
   std::optional<uint64_t> EndOfContainingRange(uint64_t start) const;
+  // Returns the parts of [start,end) that are not contained, in order.
+  std::vector<std::pair<uint64_t, uint64_t>> Holes(uint64_t start,
+                                                   uint64_t end) const;
 
+  // Copies every range out. Prefer iterating for large sets.
   std::vector<std::pair<uint64_t, uint64_t>> AllRanges() const;
 
+  const_iterator begin() const;
+  const_iterator end() const;
+  // The number of disjoint ranges, not of members.
+  size_t size() const;
+
   bool operator==(const DisjointRangeSet&) const;
 
  private:
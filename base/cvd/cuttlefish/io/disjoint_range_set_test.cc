@@ -18,6 +18,7 @@
 #include <stdint.h>
 
 #include <optional>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -181,5 +182,80 @@ TEST(DisjointRangeSet, MergingSameEnd) {
   EXPECT_EQ(set.AllRanges(), expected);
 }
 
+TEST(DisjointRangeSet, HolesBetweenMembers) {
+  DisjointRangeSet set;
+
+  set.InsertRange(5, 10);
+  set.InsertRange(15, 20);
+
+  using Holes = std::vector<std::pair<uint64_t, uint64_t>>;
+  EXPECT_EQ(set.Holes(0, 25), (Holes{{0, 5}, {10, 15}, {20, 25}}));
+  EXPECT_EQ(set.Holes(7, 17), (Holes{{10, 15}}));
+  EXPECT_EQ(set.Holes(5, 10), Holes{});
+  EXPECT_EQ(set.Holes(6, 8), Holes{});
+  EXPECT_EQ(set.Holes(11, 14), (Holes{{11, 14}}));
+  EXPECT_EQ(set.Holes(12, 12), Holes{});
+}
+
+TEST(DisjointRangeSet, IteratesInOrder) {
+  DisjointRangeSet set;
+
+  set.InsertRange(15, 20);
+  set.InsertRange(5, 10);
+  set.InsertRange(25, 30);
+  set.InsertRange(12, 12);
+
+  std::vector<std::pair<uint64_t, uint64_t>> iterated;
+  for (const auto& [start, end] : set) {
+    iterated.emplace_back(start, end);
+  }
+  std::vector<std::pair<uint64_t, uint64_t>> expected = {
+      {5, 10}, {15, 20}, {25, 30}};
+  EXPECT_EQ(iterated, expected);
+  EXPECT_EQ(set.size(), 3);
+}
+
+TEST(DisjointRangeSet, MatchesBitmapModel) {
+  static constexpr uint64_t kSize = 512;
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<uint64_t> position(0, kSize);
+
+  DisjointRangeSet set;
+  std::vector<bool> model(kSize);
+  for (int i = 0; i < 200; i++) {
+    uint64_t start = position(rng);
+    uint64_t end = position(rng);
+    if (start > end) {
+      std::swap(start, end);
+    }
+    end = std::min(end, start + 16);
+    set.InsertRange(start, end);
+    for (uint64_t j = start; j < end; j++) {
+      model[j] = true;
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> model_ranges;
+    std::vector<std::pair<uint64_t, uint64_t>> model_holes;
+    for (uint64_t j = 0; j < kSize; j++) {
+      auto& list = model[j] ? model_ranges : model_holes;
+      if (!list.empty() && list.back().second == j) {
+        list.back().second++;
+      } else {
+        list.emplace_back(j, j + 1);
+      }
+      std::optional<uint64_t> end_of_range;
+      if (model[j]) {
+        end_of_range = j;
+        while (*end_of_range < kSize && model[*end_of_range]) {
+          ++*end_of_range;
+        }
+      }
+      ASSERT_EQ(set.EndOfContainingRange(j), end_of_range);
+    }
+    ASSERT_EQ(set.AllRanges(), model_ranges);
+    ASSERT_EQ(set.Holes(0, kSize), model_holes);
+  }
+}
+
 }  // namespace
 }  // namespace cuttlefish
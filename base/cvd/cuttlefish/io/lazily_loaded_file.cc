@@ -18,13 +18,15 @@
 #include <fcntl.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <string.h>
-#include <unistd.h>  // NOLINT(misc-include-cleaner): SEEK_SET
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -35,44 +37,135 @@
 #include "cuttlefish/common/libs/utils/files.h"
 #include "cuttlefish/io/disjoint_range_set.h"
 #include "cuttlefish/io/io.h"
+#include "cuttlefish/io/read_exact.h"
 #include "cuttlefish/io/serialize_disjoint_range_set.h"
 #include "cuttlefish/io/string.h"
+#include "cuttlefish/io/write_exact.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
+namespace {
 
-static constexpr size_t kMinReadSize = 1 << 26;
+using Range = std::pair<uint64_t, uint64_t>;
+
+// Holes separated by less than this much present data are fetched as one
+// request, as a round trip costs more than downloading a little data twice.
+constexpr uint64_t kMergeGap = 1 << 20;
+
+// The metadata file is an append-only log of fetched ranges. It is only
+// rewritten once it is this large and most of it is redundant.
+constexpr size_t kMinMetadataCompactionSize = 1 << 12;
+
+// Returns the parts of `range` outside of the sorted, possibly overlapping
+// `covered` ranges.
+std::vector<Range> Uncovered(Range range, const std::vector<Range>& covered) {
+  std::vector<Range> uncovered;
+  uint64_t pos = range.first;
+  for (const auto& [begin, end] : covered) {
+    if (pos >= range.second) {
+      break;
+    }
+    if (begin > pos) {
+      uncovered.emplace_back(pos, std::min(begin, range.second));
+    }
+    pos = std::max(pos, end);
+  }
+  if (pos < range.second) {
+    uncovered.emplace_back(pos, range.second);
+  }
+  return uncovered;
+}
+
+}  // namespace
 
 struct LazilyLoadedFile::Impl {
+  // A request for [begin, end) from one of the sources.
+  struct Fetch {
+    uint64_t begin;
+    uint64_t end;
+    bool done = false;
+    Result<void> status;
+  };
+
+  ~Impl();
+
   std::string MetadataFile() const;
   Result<void> ReadMetadata();
   Result<void> WriteMetadata();
+  Result<void> CompactMetadata();
+  // Requires `mutex_` to be held.
+  Result<void> AppendMetadata(uint64_t begin, uint64_t end);
 
-  Result<size_t> Read(char*, size_t);
+  Result<size_t> ReadAt(char*, size_t, size_t offset);
+
+  Result<void> Start();
+  void Stop();
+  void Worker(const ReaderSeeker& source, SharedFD contents);
+  Result<void> FetchRange(const ReaderSeeker& source, SharedFD& contents,
+                          std::vector<char>& buffer, uint64_t begin,
+                          uint64_t end);
+
+  // The following require `mutex_` to be held.
+  std::vector<Range> Holes(uint64_t begin, uint64_t end) const;
+  std::shared_ptr<Fetch> FetchCovering(uint64_t pos) const;
+  void Enqueue(uint64_t begin, uint64_t end);
+  std::shared_ptr<Fetch> EnqueueUrgent(uint64_t pos);
 
   std::string filename_;
   SharedFD contents_file_;
-  std::unique_ptr<ReaderSeeker> callback_;
-  DisjointRangeSet already_downloaded_;
+  std::vector<std::unique_ptr<ReaderSeeker>> sources_;
+  ReadAheadOptions options_;
   size_t seek_pos_;
   size_t size_;
-  std::vector<char> extended_read_buffer_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  // Where the last read stopped, to detect sequential access.
+  std::optional<size_t> last_read_end_;
+  // The end of the data requested by sequential read-ahead so far.
+  size_t read_ahead_end_ = 0;
+  DisjointRangeSet already_downloaded_;
+  SharedFD metadata_log_;
+  size_t metadata_size_ = 0;
+  std::deque<std::shared_ptr<Fetch>> pending_;
+  std::vector<std::shared_ptr<Fetch>> in_flight_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
 };
 
 Result<LazilyLoadedFile> LazilyLoadedFile::Create(
     std::string filename, size_t size, std::unique_ptr<ReaderSeeker> callback) {
+  std::vector<std::unique_ptr<ReaderSeeker>> sources;
+  sources.emplace_back(std::move(callback));
+  return CF_EXPECT(Create(std::move(filename), size, std::move(sources)));
+}
+
+Result<LazilyLoadedFile> LazilyLoadedFile::Create(
+    std::string filename, size_t size,
+    std::vector<std::unique_ptr<ReaderSeeker>> sources,
+    ReadAheadOptions options) {
+  CF_EXPECT(!sources.empty(), "At least one source is required");
+  for (const std::unique_ptr<ReaderSeeker>& source : sources) {
+    CF_EXPECT(source.get());
+  }
+  CF_EXPECT_GT(options.fetch_size, 0);
+
   std::unique_ptr<Impl> impl = std::make_unique<Impl>();
   CF_EXPECT(impl.get());
 
   impl->contents_file_ = SharedFD::Open(filename, O_CREAT | O_RDWR, 0644);
+  CF_EXPECTF(impl->contents_file_->IsOpen(), "Failed to open {}: {}", filename,
+             impl->contents_file_->StrError());
   impl->filename_ = std::move(filename);
-  impl->callback_ = std::move(callback);
+  impl->sources_ = std::move(sources);
+  impl->options_ = options;
   impl->seek_pos_ = 0;
   impl->size_ = size;
-  impl->extended_read_buffer_ = std::vector<char>(kMinReadSize);
 
   CF_EXPECT(impl->ReadMetadata());
 
+  CF_EXPECT(impl->Start());
+
   return LazilyLoadedFile(std::move(impl));
 }
 
@@ -87,7 +180,8 @@ LazilyLoadedFile::~LazilyLoadedFile() {
   if (!impl_) {
     return;
   }
-  Result<void> res = impl_->WriteMetadata();
+  impl_->Stop();
+  Result<void> res = impl_->CompactMetadata();
   if (!res.has_value()) {
     LOG(WARNING) << "fragment update failure: " << res.error();
   }
@@ -101,7 +195,15 @@ LazilyLoadedFile& LazilyLoadedFile::operator=(LazilyLoadedFile&& other) {
 
 Result<size_t> LazilyLoadedFile::Read(char* data, size_t size) {
   CF_EXPECT(impl_.get());
-  return CF_EXPECT(impl_->Read(data, size));
+  size_t data_read = CF_EXPECT(impl_->ReadAt(data, size, impl_->seek_pos_));
+  impl_->seek_pos_ += data_read;
+  return data_read;
+}
+
+Result<size_t> LazilyLoadedFile::PRead(char* data, size_t size,
+                                       size_t offset) const {
+  CF_EXPECT(impl_.get());
+  return CF_EXPECT(impl_->ReadAt(data, size, offset));
 }
 
 Result<void> LazilyLoadedFile::Seek(size_t location) {
@@ -111,6 +213,17 @@ Result<void> LazilyLoadedFile::Seek(size_t location) {
   return {};
 }
 
+Result<void> LazilyLoadedFile::Prefetch(size_t offset, size_t length) {
+  CF_EXPECT(impl_.get());
+  CF_EXPECT_LE(offset, impl_->size_);
+  VLOG(1) << "Prefetching " << length << " at " << offset;
+  std::lock_guard lock(impl_->mutex_);
+  impl_->Enqueue(offset, offset + std::min(length, impl_->size_ - offset));
+  return {};
+}
+
+LazilyLoadedFile::Impl::~Impl() { Stop(); }
+
 std::string LazilyLoadedFile::Impl::MetadataFile() const {
   return filename_ + ".frag_data";
 }
@@ -122,13 +235,22 @@ Result<void> LazilyLoadedFile::Impl::ReadMetadata() {
 
   const std::string data = CF_EXPECT(ReadToString(*metadata_fd));
 
-  Result<DisjointRangeSet> parsed_res = DeserializeDisjointRangeSet(data);
-  if (parsed_res.has_value()) {
-    already_downloaded_ = std::move(*parsed_res);
-  } else {
-    LOG(WARNING) << "Invalid fragments: " << parsed_res.error();
+  // A crash while a record was being appended leaves a partial record at the
+  // end. The records before it are still valid.
+  DisjointRangeSetPrefix parsed = DeserializeDisjointRangeSetPrefix(data);
+  already_downloaded_ = std::move(parsed.set);
+  metadata_size_ = parsed.size;
+  if (parsed.size < data.size()) {
+    LOG(WARNING) << "Dropping " << data.size() - parsed.size
+                 << " bytes of invalid fragments from " << MetadataFile();
+    // Records appended after invalid data would be unreadable too.
+    CF_EXPECT(metadata_fd->Truncate(parsed.size));
   }
 
+  metadata_log_ = SharedFD::Open(MetadataFile(), O_WRONLY | O_APPEND);
+  CF_EXPECTF(metadata_log_->IsOpen(), "Failed to open {}: {}", MetadataFile(),
+             metadata_log_->StrError());
+
   return {};
 }
 
@@ -142,60 +264,212 @@ Result<void> LazilyLoadedFile::Impl::WriteMetadata() {
                fd_name.first->StrError());
 
   CF_EXPECT(RenameFile(fd_name.second, MetadataFile()));
+  metadata_size_ = data.size();
+
+  return {};
+}
+
+Result<void> LazilyLoadedFile::Impl::CompactMetadata() {
+  const size_t compact_size = Serialize(already_downloaded_).size();
+  if (metadata_size_ > std::max(2 * compact_size, kMinMetadataCompactionSize)) {
+    CF_EXPECT(WriteMetadata());
+  }
+  return {};
+}
 
+Result<void> LazilyLoadedFile::Impl::AppendMetadata(uint64_t begin,
+                                                    uint64_t end) {
+  const std::string record = SerializeInsertion(begin, end);
+  CF_EXPECT_EQ(WriteAll(metadata_log_, record), record.size(),
+               metadata_log_->StrError());
+  metadata_size_ += record.size();
   return {};
 }
 
-Result<size_t> LazilyLoadedFile::Impl::Read(char* data, size_t size) {
-  VLOG(1) << "Reading " << size << ", seek pos " << seek_pos_;
-  // NOLINTNEXTLINE(misc-include-cleaner): SEEK_SET
-  CF_EXPECT_EQ(contents_file_->LSeek(seek_pos_, SEEK_SET), seek_pos_,
-               contents_file_->StrError());
-  auto all_ranges = already_downloaded_.AllRanges();
-  for (const auto& range : all_ranges) {
-    VLOG(1) << "Already downloaded: [" << range.first << ", " << range.second
-            << ")";
-  }
-  std::optional<uint64_t> end_of_present_data =
-      already_downloaded_.EndOfContainingRange(seek_pos_);
-  // In terms of IO performance, this aims to minimize round trips over
-  // minimizing bandwidth usage.
-  if (end_of_present_data.has_value()) {
-    size_t read_request = std::min(*end_of_present_data - seek_pos_, size);
-    size_t data_read = CF_EXPECT(contents_file_->Read(data, read_request));
-    VLOG(1) << "Read " << data_read << " from local storage, seek pos was "
-            << seek_pos_;
-    seek_pos_ += data_read;
-    return data_read;
-  }
-  CF_EXPECT(callback_->SeekSet(seek_pos_));
-  if (size < kMinReadSize) {
-    size_t extended_read_size = std::min(kMinReadSize, size_ - seek_pos_);
-    VLOG(1) << "Extending read request from " << size << " to "
-            << extended_read_size;
-    size_t data_read = CF_EXPECT(
-        callback_->Read(extended_read_buffer_.data(), extended_read_size));
-    CF_EXPECT_EQ(
-        WriteAll(contents_file_, extended_read_buffer_.data(), data_read),
-        data_read, contents_file_->StrError());
-    already_downloaded_.InsertRange(seek_pos_, seek_pos_ + data_read);
-    VLOG(1) << "Read " << data_read << " from source, seek pos was "
-            << seek_pos_;
-    size_t reported_size = std::min(data_read, size);
-    memcpy(data, extended_read_buffer_.data(), reported_size);
-    seek_pos_ += reported_size;
-    return reported_size;
-  } else {
-    VLOG(1) << "Passing down read request of " << size;
-    size_t data_read = CF_EXPECT(callback_->Read(data, size));
-    CF_EXPECT_EQ(WriteAll(contents_file_, data, data_read), data_read,
-                 contents_file_->StrError());
-    already_downloaded_.InsertRange(seek_pos_, seek_pos_ + data_read);
-    VLOG(1) << "Read " << data_read << " from source, seek pos was "
-            << seek_pos_;
-    seek_pos_ += data_read;
-    return data_read;
+Result<size_t> LazilyLoadedFile::Impl::ReadAt(char* data, size_t size,
+                                              size_t offset) {
+  VLOG(1) << "Reading " << size << " at " << offset;
+  if (size == 0 || offset >= size_) {
+    return 0;
+  }
+  std::unique_lock lock(mutex_);
+  if (last_read_end_ == offset &&
+      offset + options_.window / 2 >= read_ahead_end_) {
+    read_ahead_end_ = std::min(size_, offset + options_.window);
+    Enqueue(offset, read_ahead_end_);
+  }
+  std::optional<uint64_t> end_of_present_data;
+  while (!(end_of_present_data =
+               already_downloaded_.EndOfContainingRange(offset))) {
+    std::shared_ptr<Fetch> fetch = EnqueueUrgent(offset);
+    condition_.wait(lock, [&fetch] { return fetch->done; });
+    Result<void> status = fetch->status;
+    CF_EXPECTF(std::move(status), "Failed to fetch data at {} for {}", offset,
+               filename_);
+  }
+  const size_t read_request = std::min(*end_of_present_data - offset, size);
+  last_read_end_ = offset + read_request;
+  lock.unlock();
+
+  CF_EXPECT(PReadExact(*contents_file_, data, read_request, offset));
+  return read_request;
+}
+
+Result<void> LazilyLoadedFile::Impl::Start() {
+  for (const std::unique_ptr<ReaderSeeker>& source : sources_) {
+    // A descriptor per worker, as `Fd` records the last error of each call.
+    SharedFD contents = SharedFD::Open(filename_, O_RDWR);
+    CF_EXPECTF(contents->IsOpen(), "Failed to open {}: {}", filename_,
+               contents->StrError());
+    workers_.emplace_back([this, &source, contents]() {
+      Worker(*source, std::move(contents));
+    });
+  }
+  return {};
+}
+
+void LazilyLoadedFile::Impl::Stop() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+    pending_.clear();
+  }
+  condition_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void LazilyLoadedFile::Impl::Worker(const ReaderSeeker& source,
+                                    SharedFD contents) {
+  std::vector<char> buffer;
+  std::unique_lock lock(mutex_);
+  while (true) {
+    condition_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    std::shared_ptr<Fetch> fetch = std::move(pending_.front());
+    pending_.pop_front();
+    in_flight_.emplace_back(fetch);
+    lock.unlock();
+
+    VLOG(1) << "Fetching [" << fetch->begin << ", " << fetch->end << ")";
+    Result<void> status =
+        FetchRange(source, contents, buffer, fetch->begin, fetch->end);
+    if (!status.has_value()) {
+      LOG(WARNING) << "Failed to fetch [" << fetch->begin << ", " << fetch->end
+                   << ") of " << filename_ << ": " << status.error();
+    }
+
+    lock.lock();
+    if (status.has_value()) {
+      already_downloaded_.InsertRange(fetch->begin, fetch->end);
+      Result<void> logged = AppendMetadata(fetch->begin, fetch->end);
+      if (!logged.has_value()) {
+        LOG(WARNING) << "fragment update failure: " << logged.error();
+      }
+    }
+    std::erase(in_flight_, fetch);
+    fetch->status = std::move(status);
+    fetch->done = true;
+    condition_.notify_all();
+  }
+}
+
+Result<void> LazilyLoadedFile::Impl::FetchRange(const ReaderSeeker& source,
+                                                SharedFD& contents,
+                                                std::vector<char>& buffer,
+                                                uint64_t begin, uint64_t end) {
+  buffer.resize(end - begin);
+  CF_EXPECT(PReadExact(source, buffer.data(), buffer.size(), begin));
+  CF_EXPECT(PWriteExact(*contents, buffer.data(), buffer.size(), begin));
+  return {};
+}
+
+std::vector<Range> LazilyLoadedFile::Impl::Holes(uint64_t begin,
+                                                 uint64_t end) const {
+  std::vector<Range> requested;
+  for (const std::shared_ptr<Fetch>& fetch : in_flight_) {
+    requested.emplace_back(fetch->begin, fetch->end);
+  }
+  for (const std::shared_ptr<Fetch>& fetch : pending_) {
+    requested.emplace_back(fetch->begin, fetch->end);
+  }
+  std::sort(requested.begin(), requested.end());
+
+  std::vector<Range> missing;
+  for (const Range& hole : already_downloaded_.Holes(begin, end)) {
+    if (!missing.empty() && hole.first - missing.back().second < kMergeGap) {
+      missing.back().second = hole.second;
+    } else {
+      missing.emplace_back(hole);
+    }
+  }
+  std::vector<Range> holes;
+  for (const Range& range : missing) {
+    // Data that is already on its way must not be requested twice.
+    for (const Range& hole : Uncovered(range, requested)) {
+      holes.emplace_back(hole);
+    }
+  }
+  return holes;
+}
+
+std::shared_ptr<LazilyLoadedFile::Impl::Fetch>
+LazilyLoadedFile::Impl::FetchCovering(uint64_t pos) const {
+  for (const std::shared_ptr<Fetch>& fetch : in_flight_) {
+    if (fetch->begin <= pos && pos < fetch->end) {
+      return fetch;
+    }
+  }
+  for (const std::shared_ptr<Fetch>& fetch : pending_) {
+    if (fetch->begin <= pos && pos < fetch->end) {
+      return fetch;
+    }
+  }
+  return nullptr;
+}
+
+void LazilyLoadedFile::Impl::Enqueue(uint64_t begin, uint64_t end) {
+  for (auto [hole_begin, hole_end] : Holes(begin, end)) {
+    while (hole_begin < hole_end) {
+      if (!pending_.empty() && pending_.back()->end == hole_begin &&
+          pending_.back()->end - pending_.back()->begin < options_.fetch_size) {
+        Fetch& back = *pending_.back();
+        back.end = std::min(hole_end, back.begin + options_.fetch_size);
+        hole_begin = back.end;
+        continue;
+      }
+      const uint64_t fetch_end =
+          std::min(hole_end, hole_begin + options_.fetch_size);
+      pending_.emplace_back(std::make_shared<Fetch>(hole_begin, fetch_end));
+      hole_begin = fetch_end;
+    }
+  }
+  condition_.notify_all();
+}
+
+std::shared_ptr<LazilyLoadedFile::Impl::Fetch>
+LazilyLoadedFile::Impl::EnqueueUrgent(uint64_t pos) {
+  std::shared_ptr<Fetch> fetch = FetchCovering(pos);
+  if (fetch) {
+    // Jump the queue if the data is still waiting for a worker.
+    auto it = std::find(pending_.begin(), pending_.end(), fetch);
+    if (it != pending_.end()) {
+      pending_.erase(it);
+      pending_.emplace_front(fetch);
+    }
+    return fetch;
   }
+  const uint64_t end = std::min<uint64_t>(size_, pos + options_.fetch_size);
+  std::vector<Range> holes = Holes(pos, end);
+  // `pos` is neither present nor requested, so the first hole starts there.
+  fetch = std::make_shared<Fetch>(pos, holes.front().second);
+  pending_.emplace_front(fetch);
+  condition_.notify_all();
+  return fetch;
 }
 
 }  // namespace cuttlefish
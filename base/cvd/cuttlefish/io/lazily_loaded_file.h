@@ -18,16 +18,37 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "cuttlefish/io/io.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
+/** Controls how `LazilyLoadedFile` fetches data it does not have yet. */
+struct ReadAheadOptions {
+  // Upper bound on the size of a single request to a source.
+  size_t fetch_size = 1 << 24;
+  // How far past the read position to fetch once reads are sequential.
+  size_t window = 1 << 26;
+};
+
+/**
+ * A local file that is filled in from a slower source as it is read.
+ *
+ * Missing data is fetched by background threads, one per source. Sequential
+ * reads keep `ReadAheadOptions::window` bytes ahead of the read position in
+ * flight, and `Prefetch` queues other ranges known to be needed soon.
+ */
 class LazilyLoadedFile {
  public:
   static Result<LazilyLoadedFile> Create(std::string filename, size_t size,
                                          std::unique_ptr<ReaderSeeker>);
+  /* Every source must present the same `size` bytes. */
+  static Result<LazilyLoadedFile> Create(
+      std::string filename, size_t size,
+      std::vector<std::unique_ptr<ReaderSeeker>> sources,
+      ReadAheadOptions options = {});
 
   LazilyLoadedFile(LazilyLoadedFile&&);
   ~LazilyLoadedFile();
@@ -35,6 +56,10 @@ class LazilyLoadedFile {
 
   Result<size_t> Read(char*, size_t);
   Result<void> Seek(size_t);
+  /* Reads at `offset` without moving the position used by `Read`. */
+  Result<size_t> PRead(char*, size_t, size_t offset) const;
+  /* Queues [offset, offset + length) behind any earlier prefetches. */
+  Result<void> Prefetch(size_t offset, size_t length);
 
  private:
   struct Impl;
@@ -0,0 +1,279 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/lazily_loaded_file.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/io/disjoint_range_set.h"
+#include "cuttlefish/io/in_memory.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/serialize_disjoint_range_set.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+using Range = std::pair<uint64_t, uint64_t>;
+
+// Records the ranges requested from a shared in-memory source. Requests can be
+// held back until `Release` to control what is in flight.
+class RecordingSource {
+ public:
+  explicit RecordingSource(std::string data) : data_(std::move(data)) {}
+
+  Result<uint64_t> PRead(void* buf, uint64_t count, uint64_t offset) {
+    std::unique_lock lock(mutex_);
+    requests_.emplace_back(offset, offset + count);
+    condition_.notify_all();
+    condition_.wait(lock, [this]() { return released_; });
+    CF_EXPECT(!fail_, "Injected failure");
+    std::unique_ptr<ReaderWriterSeeker> io = InMemoryIo(data_);
+    return CF_EXPECT(io->PRead(buf, count, offset));
+  }
+
+  void Hold() {
+    std::lock_guard lock(mutex_);
+    released_ = false;
+  }
+  void Release() {
+    std::lock_guard lock(mutex_);
+    released_ = true;
+    condition_.notify_all();
+  }
+  void Fail() {
+    std::lock_guard lock(mutex_);
+    fail_ = true;
+  }
+
+  std::vector<Range> WaitForRequests(size_t count) {
+    std::unique_lock lock(mutex_);
+    condition_.wait_for(lock, std::chrono::seconds(10),
+                        [this, count]() { return requests_.size() >= count; });
+    return requests_;
+  }
+
+ private:
+  std::string data_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<Range> requests_;
+  bool released_ = true;
+  bool fail_ = false;
+};
+
+class SourceView : public ReaderSeeker {
+ public:
+  explicit SourceView(RecordingSource& source) : source_(source) {}
+
+  Result<uint64_t> Read(void*, uint64_t) override {
+    return CF_ERR("Only PRead is supported");
+  }
+  Result<uint64_t> SeekSet(uint64_t) override {
+    return CF_ERR("Only PRead is supported");
+  }
+  Result<uint64_t> SeekCur(int64_t) override {
+    return CF_ERR("Only PRead is supported");
+  }
+  Result<uint64_t> SeekEnd(int64_t) override {
+    return CF_ERR("Only PRead is supported");
+  }
+  Result<uint64_t> PRead(void* buf, uint64_t count,
+                         uint64_t offset) const override {
+    return CF_EXPECT(source_.PRead(buf, count, offset));
+  }
+
+ private:
+  RecordingSource& source_;
+};
+
+class LazilyLoadedFileTest : public ::testing::Test {
+ protected:
+  LazilyLoadedFileTest() : data_(Data()), source_(data_) {}
+
+  static std::string Data() {
+    std::string data;
+    for (int i = 0; i < 100; i++) {
+      data.push_back(static_cast<char>(i));
+    }
+    return data;
+  }
+
+  Result<LazilyLoadedFile> Open(size_t sources, ReadAheadOptions options) {
+    std::vector<std::unique_ptr<ReaderSeeker>> views;
+    for (size_t i = 0; i < sources; i++) {
+      views.emplace_back(std::make_unique<SourceView>(source_));
+    }
+    return CF_EXPECT(LazilyLoadedFile::Create(
+        Path(), data_.size(), std::move(views), options));
+  }
+
+  std::string Path() const { return std::string(temp_dir_.path) + "/file"; }
+
+  static Result<std::string> ReadAt(LazilyLoadedFile& file, size_t offset,
+                                    size_t size) {
+    CF_EXPECT(file.Seek(offset));
+    std::string data(size, '\0');
+    size_t total = 0;
+    while (total < size) {
+      const size_t read = CF_EXPECT(file.Read(&data[total], size - total));
+      CF_EXPECT_GT(read, 0);
+      total += read;
+    }
+    return data;
+  }
+
+  TemporaryDir temp_dir_;
+  std::string data_;
+  RecordingSource source_;
+};
+
+TEST_F(LazilyLoadedFileTest, ReadsEverythingWithManySources) {
+  Result<LazilyLoadedFile> file = Open(4, {.fetch_size = 7, .window = 30});
+  ASSERT_THAT(file, IsOk());
+
+  EXPECT_THAT(ReadAt(*file, 0, data_.size()), IsOkAndValue(data_));
+  EXPECT_THAT(ReadAt(*file, 50, 10), IsOkAndValue(data_.substr(50, 10)));
+}
+
+TEST_F(LazilyLoadedFileTest, SequentialReadsFetchAhead) {
+  Result<LazilyLoadedFile> file = Open(1, {.fetch_size = 10, .window = 40});
+  ASSERT_THAT(file, IsOk());
+
+  ASSERT_THAT(ReadAt(*file, 0, 10), IsOk());
+  std::string next(5, '\0');
+  ASSERT_THAT(file->Read(next.data(), next.size()), IsOkAndValue(5));
+  EXPECT_EQ(next, data_.substr(10, 5));
+
+  EXPECT_THAT(source_.WaitForRequests(5),
+              testing::ElementsAre(Range(0, 10), Range(10, 20), Range(20, 30),
+                                   Range(30, 40), Range(40, 50)));
+}
+
+TEST_F(LazilyLoadedFileTest, RandomReadsDoNotFetchAhead) {
+  Result<LazilyLoadedFile> file = Open(1, {.fetch_size = 10, .window = 40});
+  ASSERT_THAT(file, IsOk());
+
+  ASSERT_THAT(ReadAt(*file, 50, 10), IsOk());
+  ASSERT_THAT(ReadAt(*file, 20, 10), IsOk());
+
+  EXPECT_THAT(source_.WaitForRequests(2),
+              testing::ElementsAre(Range(50, 60), Range(20, 30)));
+}
+
+TEST_F(LazilyLoadedFileTest, MergesAdjacentPrefetches) {
+  Result<LazilyLoadedFile> file = Open(1, {.fetch_size = 50, .window = 0});
+  ASSERT_THAT(file, IsOk());
+
+  source_.Hold();
+  ASSERT_THAT(file->Prefetch(0, 10), IsOk());
+  source_.WaitForRequests(1);
+  // The only worker is busy, so these queue up behind it as one request.
+  ASSERT_THAT(file->Prefetch(10, 10), IsOk());
+  ASSERT_THAT(file->Prefetch(20, 10), IsOk());
+  ASSERT_THAT(file->Prefetch(5, 30), IsOk());
+  source_.Release();
+
+  EXPECT_THAT(ReadAt(*file, 0, 35), IsOkAndValue(data_.substr(0, 35)));
+  EXPECT_THAT(source_.WaitForRequests(2),
+              testing::ElementsAre(Range(0, 10), Range(10, 35)));
+}
+
+TEST_F(LazilyLoadedFileTest, PReadKeepsReadPosition) {
+  Result<LazilyLoadedFile> file = Open(1, {.fetch_size = 10, .window = 10});
+  ASSERT_THAT(file, IsOk());
+
+  ASSERT_THAT(file->Seek(10), IsOk());
+  std::string data(5, '\0');
+  ASSERT_THAT(file->PRead(data.data(), data.size(), 50), IsOkAndValue(5));
+  EXPECT_EQ(data, data_.substr(50, 5));
+  ASSERT_THAT(file->Read(data.data(), data.size()), IsOkAndValue(5));
+  EXPECT_EQ(data, data_.substr(10, 5));
+}
+
+TEST_F(LazilyLoadedFileTest, FetchedRangesPersist) {
+  {
+    Result<LazilyLoadedFile> file = Open(2, {.fetch_size = 10, .window = 10});
+    ASSERT_THAT(file, IsOk());
+    ASSERT_THAT(ReadAt(*file, 20, 20), IsOk());
+  }
+  source_.Fail();
+
+  Result<LazilyLoadedFile> file = Open(2, {.fetch_size = 10, .window = 10});
+  ASSERT_THAT(file, IsOk());
+  EXPECT_THAT(ReadAt(*file, 20, 20), IsOkAndValue(data_.substr(20, 20)));
+}
+
+TEST_F(LazilyLoadedFileTest, FetchesAreLoggedAsTheyComplete) {
+  Result<LazilyLoadedFile> file = Open(1, {.fetch_size = 10, .window = 10});
+  ASSERT_THAT(file, IsOk());
+  ASSERT_THAT(ReadAt(*file, 30, 10), IsOk());
+
+  std::string metadata;
+  ASSERT_TRUE(android::base::ReadFileToString(Path() + ".frag_data", &metadata));
+  Result<DisjointRangeSet> fetched = DeserializeDisjointRangeSet(metadata);
+  ASSERT_THAT(fetched, IsOk());
+  EXPECT_TRUE(fetched->ContainsRange(30, 40));
+}
+
+TEST_F(LazilyLoadedFileTest, PartialMetadataRecordIsDropped) {
+  {
+    Result<LazilyLoadedFile> file = Open(2, {.fetch_size = 10, .window = 10});
+    ASSERT_THAT(file, IsOk());
+    ASSERT_THAT(ReadAt(*file, 20, 20), IsOk());
+  }
+  std::string metadata;
+  ASSERT_TRUE(
+      android::base::ReadFileToString(Path() + ".frag_data", &metadata));
+  std::string torn = SerializeInsertion(60, 70);
+  torn.pop_back();
+  ASSERT_TRUE(android::base::WriteStringToFile(metadata + torn,
+                                               Path() + ".frag_data"));
+  source_.Fail();
+
+  Result<LazilyLoadedFile> file = Open(2, {.fetch_size = 10, .window = 10});
+  ASSERT_THAT(file, IsOk());
+  EXPECT_THAT(ReadAt(*file, 20, 20), IsOkAndValue(data_.substr(20, 20)));
+
+  std::string truncated;
+  ASSERT_TRUE(
+      android::base::ReadFileToString(Path() + ".frag_data", &truncated));
+  EXPECT_EQ(truncated, metadata);
+}
+
+TEST_F(LazilyLoadedFileTest, FailedFetchIsReported) {
+  source_.Fail();
+  Result<LazilyLoadedFile> file = Open(2, {.fetch_size = 10, .window = 10});
+  ASSERT_THAT(file, IsOk());
+
+  EXPECT_THAT(ReadAt(*file, 0, 10), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
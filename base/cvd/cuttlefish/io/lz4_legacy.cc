@@ -123,6 +123,38 @@ Result<std::unique_ptr<Reader>> Lz4LegacyReader(
   return std::make_unique<Lz4LegacyReaderImpl>(std::move(source));
 }
 
+Result<std::unique_ptr<Reader>> Lz4LegacyReaderAt(
+    std::unique_ptr<ReaderSeeker> source, uint64_t offset) {
+  CF_EXPECT(source.get());
+  uint32_t magic = le32toh(CF_EXPECT(ReadExactBinary<uint32_t>(*source)));
+  CF_EXPECT_EQ(magic, kLz4LegacyFrameMagic);
+  for (; offset >= kLz4LegacyFrameBlockSize;
+       offset -= kLz4LegacyFrameBlockSize) {
+    uint32_t length = 0;
+    if (CF_EXPECT(source->Read(&length, 1)) == 0) {
+      break;
+    }
+    CF_EXPECT(ReadExact(*source, reinterpret_cast<char*>(&length) + 1, 3));
+    length = le32toh(length);
+    if (length == 0) {
+      break;
+    }
+    CF_EXPECT(source->SeekCur(length));
+  }
+  std::unique_ptr<Reader> reader =
+      std::make_unique<Lz4LegacyReaderImpl>(std::move(source));
+  std::vector<char> discard(std::min<uint64_t>(offset, 1 << 16));
+  while (offset > 0) {
+    const uint64_t chunk = std::min<uint64_t>(offset, discard.size());
+    const uint64_t skipped = CF_EXPECT(reader->Read(discard.data(), chunk));
+    if (skipped == 0) {
+      break;
+    }
+    offset -= skipped;
+  }
+  return reader;
+}
+
 Result<std::unique_ptr<Writer>> Lz4LegacyWriter(std::unique_ptr<Writer> sink) {
   CF_EXPECT(sink.get());
   const uint32_t magic_le = htole32(kLz4LegacyFrameMagic);
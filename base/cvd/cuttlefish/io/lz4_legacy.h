@@ -30,6 +30,13 @@ constexpr uint32_t kLz4LegacyFrameBlockSize = 8 << 20;
 
 Result<std::unique_ptr<Reader>> Lz4LegacyReader(std::unique_ptr<Reader>);
 
+// Reads the decompressed data starting `offset` bytes in. Every block but the
+// last holds exactly kLz4LegacyFrameBlockSize bytes, so the blocks before the
+// one holding `offset` are skipped using their length headers without being
+// decompressed.
+Result<std::unique_ptr<Reader>> Lz4LegacyReaderAt(std::unique_ptr<ReaderSeeker>,
+                                                  uint64_t offset);
+
 // LZ4 Legacy frames are terminated by a 4-byte 0 length block. This
 // implementation handles this by assuming that any write call with a size less
 // than or equal to the block size (8 MB) is intended to be the last block in
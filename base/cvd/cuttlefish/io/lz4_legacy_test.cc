@@ -138,5 +138,39 @@ TEST(Lz4LegacyTest, ExactlyBlockSizeTriggersFooter) {
   EXPECT_THAT(decompressed_data, IsOkAndValue(data));
 }
 
+TEST(Lz4LegacyTest, ReaderAtSkipsBlocks) {
+  static constexpr size_t kTotalSize = 2 * kLz4LegacyFrameBlockSize + 1000;
+  std::string original_data(kTotalSize, '\0');
+  for (size_t i = 0; i < original_data.size(); i++) {
+    original_data[i] = static_cast<char>(i % 251);
+  }
+
+  std::unique_ptr<ReadWriteFilesystem> fs = InMemoryFilesystem();
+
+  Result<std::unique_ptr<ReaderWriterSeeker>> writer_sink =
+      fs->CreateFile(kTestFile);
+  ASSERT_THAT(writer_sink, IsOk());
+  Result<std::unique_ptr<Writer>> writer =
+      Lz4LegacyWriter(std::move(*writer_sink));
+  ASSERT_THAT(writer, IsOk());
+  EXPECT_THAT(WriteExact(**writer, original_data.data(), original_data.size()),
+              IsOk());
+
+  for (size_t offset :
+       {size_t{0}, size_t{12345}, size_t{kLz4LegacyFrameBlockSize},
+        size_t{2 * kLz4LegacyFrameBlockSize + 10}, kTotalSize}) {
+    Result<std::unique_ptr<ReaderSeeker>> reader_source =
+        fs->OpenReadOnly(kTestFile);
+    ASSERT_THAT(reader_source, IsOk());
+    Result<std::unique_ptr<Reader>> reader =
+        Lz4LegacyReaderAt(std::move(*reader_source), offset);
+    ASSERT_THAT(reader, IsOk());
+
+    EXPECT_THAT(ReadToString(**reader),
+                IsOkAndValue(original_data.substr(offset)))
+        << offset;
+  }
+}
+
 }  // namespace
 }  // namespace cuttlefish
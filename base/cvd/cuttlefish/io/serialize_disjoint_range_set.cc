@@ -14,36 +14,107 @@
 // limitations under the License.
 #include "cuttlefish/io/serialize_disjoint_range_set.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
+
+#include "google/protobuf/io/coded_stream.h"
 
 #include "cuttlefish/io/disjoint_range_set.h"
 #include "cuttlefish/io/disjoint_range_set.pb.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
+namespace {
+
+// Both fields of `DisjointRangeList` are written as one length-delimited
+// record each: the packed ranges by `Serialize` and every member by
+// `SerializeInsertion`.
+constexpr uint32_t kLengthDelimitedWireType = 2;
+
+using Range = std::pair<uint64_t, uint64_t>;
+
+Result<std::vector<Range>> Ranges(const DisjointRangeList& proto) {
+  CF_EXPECT_EQ(proto.packed_ranges_size() % 2, 0, "Truncated packed ranges");
+  std::vector<Range> ranges;
+  uint64_t previous_end = 0;
+  for (int i = 0; i < proto.packed_ranges_size(); i += 2) {
+    const uint64_t start = previous_end + proto.packed_ranges(i);
+    const uint64_t end = start + proto.packed_ranges(i + 1);
+    CF_EXPECT(previous_end <= start && start <= end, "Overflowing range");
+    ranges.emplace_back(start, end);
+    previous_end = end;
+  }
+  for (const DisjointRangeListMember& range : proto.ranges()) {
+    CF_EXPECT_LE(range.start(), range.end());
+    ranges.emplace_back(range.start(), range.end());
+  }
+  return ranges;
+}
+
+}  // namespace
 
 std::string Serialize(const DisjointRangeSet& range_set) {
   DisjointRangeList proto;
-  for (std::pair<uint64_t, uint64_t> range : range_set.AllRanges()) {
-    DisjointRangeListMember* member = proto.add_ranges();
-    member->set_start(range.first);
-    member->set_end(range.second);
+  uint64_t previous_end = 0;
+  for (const auto& [start, end] : range_set) {
+    proto.add_packed_ranges(start - previous_end);
+    proto.add_packed_ranges(end - start);
+    previous_end = end;
   }
   return proto.SerializeAsString();
 }
 
+std::string SerializeInsertion(uint64_t start, uint64_t end) {
+  DisjointRangeList proto;
+  DisjointRangeListMember* member = proto.add_ranges();
+  member->set_start(start);
+  member->set_end(end);
+  return proto.SerializeAsString();
+}
+
 Result<DisjointRangeSet> DeserializeDisjointRangeSet(std::string_view data) {
   DisjointRangeList proto;
   CF_EXPECT(proto.ParseFromString(data));
+  std::vector<Range> ranges = CF_EXPECT(Ranges(proto));
   DisjointRangeSet set;
-  for (const DisjointRangeListMember& range : proto.ranges()) {
-    set.InsertRange(range.start(), range.end());
+  for (const auto& [start, end] : ranges) {
+    set.InsertRange(start, end);
   }
   return set;
 }
 
+DisjointRangeSetPrefix DeserializeDisjointRangeSetPrefix(
+    std::string_view data) {
+  DisjointRangeSetPrefix prefix = {.size = 0};
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size());
+  while (const uint32_t tag = input.ReadTag()) {
+    uint32_t length = 0;
+    if ((tag & 0x7) != kLengthDelimitedWireType ||
+        !input.ReadVarint32(&length) || !input.Skip(length)) {
+      break;
+    }
+    const size_t record_end = input.CurrentPosition();
+    DisjointRangeList proto;
+    if (!proto.ParseFromArray(data.data() + prefix.size,
+                              record_end - prefix.size)) {
+      break;
+    }
+    Result<std::vector<Range>> ranges = Ranges(proto);
+    if (!ranges.has_value()) {
+      break;
+    }
+    for (const auto& [start, end] : *ranges) {
+      prefix.set.InsertRange(start, end);
+    }
+    prefix.size = record_end;
+  }
+  return prefix;
+}
+
 }  // namespace cuttlefish
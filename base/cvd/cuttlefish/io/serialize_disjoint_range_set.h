@@ -14,6 +14,9 @@
 // limitations under the License.
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
 #include <string_view>
 
@@ -24,6 +27,21 @@ namespace cuttlefish {
 
 std::string Serialize(const DisjointRangeSet&);
 
+/* Appending the result to serialized data adds [start,end) to the set that
+ * the data deserializes to. */
+std::string SerializeInsertion(uint64_t start, uint64_t end);
+
 Result<DisjointRangeSet> DeserializeDisjointRangeSet(std::string_view);
 
+struct DisjointRangeSetPrefix {
+  DisjointRangeSet set;
+  // How many bytes at the start of the data were deserialized.
+  size_t size;
+};
+
+/* Deserializes records from the start of the data up to the first one that is
+ * incomplete or invalid, such as an appended insertion that was only partly
+ * written. */
+DisjointRangeSetPrefix DeserializeDisjointRangeSetPrefix(std::string_view);
+
 }  // namespace cuttlefish
@@ -15,6 +15,9 @@
 
 #include "cuttlefish/io/serialize_disjoint_range_set.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
 
 #include "gmock/gmock-matchers.h"
@@ -55,5 +58,56 @@ TEST(DisjointRangeSet, SerializeTwoMembers) {
   EXPECT_THAT(DeserializeDisjointRangeSet(str), IsOkAndValue(set));
 }
 
+TEST(DisjointRangeSet, SerializeAppendedInsertions) {
+  DisjointRangeSet set;
+
+  set.InsertRange(5, 15);
+  set.InsertRange(25, 35);
+
+  std::string str = Serialize(set);
+  str += SerializeInsertion(15, 20);
+  str += SerializeInsertion(40, 45);
+
+  DisjointRangeSet expected;
+  expected.InsertRange(5, 20);
+  expected.InsertRange(25, 35);
+  expected.InsertRange(40, 45);
+
+  EXPECT_THAT(DeserializeDisjointRangeSet(str), IsOkAndValue(expected));
+}
+
+TEST(DisjointRangeSet, DeserializePrefixStopsAtPartialInsertion) {
+  DisjointRangeSet set;
+
+  set.InsertRange(5, 15);
+
+  std::string str = Serialize(set);
+  str += SerializeInsertion(25, 35);
+  const size_t valid_size = str.size();
+  str += SerializeInsertion(40, 45);
+  str.pop_back();
+
+  DisjointRangeSet expected;
+  expected.InsertRange(5, 15);
+  expected.InsertRange(25, 35);
+
+  EXPECT_THAT(DeserializeDisjointRangeSet(str), IsError());
+  DisjointRangeSetPrefix prefix = DeserializeDisjointRangeSetPrefix(str);
+  EXPECT_EQ(prefix.set, expected);
+  EXPECT_EQ(prefix.size, valid_size);
+}
+
+TEST(DisjointRangeSet, SerializeManyMembers) {
+  DisjointRangeSet set;
+
+  for (uint64_t i = 0; i < 10000; i++) {
+    set.InsertRange((i << 32) + i, (i << 32) + 2 * i + 1);
+  }
+
+  std::string str = Serialize(set);
+
+  EXPECT_THAT(DeserializeDisjointRangeSet(str), IsOkAndValue(set));
+}
+
 }  // namespace
 }  // namespace cuttlefish
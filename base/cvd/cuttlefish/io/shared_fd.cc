@@ -74,4 +74,6 @@ Result<void> SharedFdIo::Truncate(uint64_t size) {
   return {};
 }
 
+const SharedFD& SharedFdIo::GetSharedFd() const { return fd_; }
+
 }  // namespace cuttlefish
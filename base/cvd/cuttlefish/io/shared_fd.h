@@ -39,6 +39,8 @@ class SharedFdIo : public ReaderWriterSeeker {
                           uint64_t offset) override;
   Result<void> Truncate(uint64_t size) override;
 
+  const SharedFD& GetSharedFd() const;
+
  private:
   SharedFD fd_;
 };
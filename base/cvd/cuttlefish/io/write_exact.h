@@ -31,4 +31,7 @@ Result<void> WriteExactBinary(Writer& writer, const T& data) {
   return WriteExact(writer, data_char, sizeof(data));
 }
 
+Result<void> PWriteExact(WriterSeeker&, const char* buf, size_t size,
+                         uint64_t offset);
+
 }  // namespace cuttlefish
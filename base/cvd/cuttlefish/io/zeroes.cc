@@ -0,0 +1,98 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/zeroes.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace cuttlefish {
+namespace {
+
+bool IsAllZeroesScalar(const unsigned char* data, size_t size) {
+  uint64_t acc = 0;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, &data[i], sizeof(word));
+    acc |= word;
+  }
+  for (; i < size; i++) {
+    acc |= data[i];
+  }
+  return acc == 0;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2"))) bool IsAllZeroesAvx2(const unsigned char* data,
+                                                     size_t size) {
+  constexpr size_t kStride = 4 * sizeof(__m256i);
+  size_t i = 0;
+  for (; i + kStride <= size; i += kStride) {
+    const __m256i* vectors = reinterpret_cast<const __m256i*>(&data[i]);
+    __m256i acc = _mm256_or_si256(
+        _mm256_or_si256(_mm256_loadu_si256(&vectors[0]),
+                        _mm256_loadu_si256(&vectors[1])),
+        _mm256_or_si256(_mm256_loadu_si256(&vectors[2]),
+                        _mm256_loadu_si256(&vectors[3])));
+    if (!_mm256_testz_si256(acc, acc)) {
+      return false;
+    }
+  }
+  return IsAllZeroesScalar(&data[i], size - i);
+}
+
+#elif defined(__aarch64__)
+
+bool IsAllZeroesNeon(const unsigned char* data, size_t size) {
+  constexpr size_t kStride = 4 * sizeof(uint8x16_t);
+  size_t i = 0;
+  for (; i + kStride <= size; i += kStride) {
+    uint8x16_t acc =
+        vorrq_u8(vorrq_u8(vld1q_u8(&data[i]), vld1q_u8(&data[i + 16])),
+                 vorrq_u8(vld1q_u8(&data[i + 32]), vld1q_u8(&data[i + 48])));
+    if (vmaxvq_u8(acc) != 0) {
+      return false;
+    }
+  }
+  return IsAllZeroesScalar(&data[i], size - i);
+}
+
+#endif
+
+}  // namespace
+
+bool IsAllZeroes(const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+#if defined(__x86_64__)
+  static const bool kHasAvx2 = __builtin_cpu_supports("avx2");
+  if (kHasAvx2) {
+    return IsAllZeroesAvx2(bytes, size);
+  }
+#elif defined(__aarch64__)
+  return IsAllZeroesNeon(bytes, size);
+#endif
+  return IsAllZeroesScalar(bytes, size);
+}
+
+}  // namespace cuttlefish
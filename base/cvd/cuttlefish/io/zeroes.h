@@ -0,0 +1,28 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+
+namespace cuttlefish {
+
+// Returns true if every byte in `[data, data + size)` is zero.
+//
+// Uses AVX2 or NEON where the CPU supports it. Intended for scanning
+// filesystem-block sized regions of disk images for sparse writes.
+bool IsAllZeroes(const void* data, size_t size);
+
+}  // namespace cuttlefish
@@ -0,0 +1,129 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Scans a `--size_mib` buffer for zero blocks of `--block_size` bytes, the
+// way `SparseCopy` does, with `IsAllZeroes` and with the char at a time loop
+// it replaced. The buffer is scanned once all zeroes, where every byte has
+// to be read, and once with only the last byte of every block set, the worst
+// case for a scan that stops at the first non-zero byte.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/log/log.h"
+
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/io/zeroes.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+using ZeroScan = std::function<bool(const char*, size_t)>;
+
+bool CharLoop(const char* data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (data[i] != '\0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t CountZeroBlocks(const std::vector<char>& buffer, size_t block_size,
+                       const ZeroScan& scan) {
+  size_t zero_blocks = 0;
+  for (size_t i = 0; i < buffer.size(); i += block_size) {
+    zero_blocks += scan(&buffer[i], block_size) ? 1 : 0;
+  }
+  return zero_blocks;
+}
+
+void Report(const std::string& name, const std::vector<char>& buffer,
+            size_t block_size, size_t iterations, const ZeroScan& scan) {
+  std::vector<Clock::duration> samples;
+  size_t zero_blocks = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    Clock::time_point begin = Clock::now();
+    zero_blocks = CountZeroBlocks(buffer, block_size, scan);
+    samples.emplace_back(Clock::now() - begin);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  const double median_seconds =
+      std::chrono::duration<double>(samples[samples.size() / 2]).count();
+  std::cout << name << ": " << zero_blocks << " zero blocks, median "
+            << median_seconds * 1000 << "ms, "
+            << buffer.size() / median_seconds / (1 << 30) << " GiB/s\n";
+}
+
+Result<void> ZeroesBenchmarkMain(int argc, char** argv) {
+  size_t size_mib = 256;
+  size_t block_size = 4096;
+  size_t iterations = 10;
+  std::vector<Flag> flags;
+  flags.emplace_back(GflagsCompatFlag("size_mib", size_mib)
+                         .Help("Size of the scanned buffer in mebibytes."));
+  flags.emplace_back(GflagsCompatFlag("block_size", block_size)
+                         .Help("Size of the blocks checked for zeroes."));
+  flags.emplace_back(
+      GflagsCompatFlag("iterations", iterations)
+          .Help("How many times to scan the buffer per method."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(size_mib, 0u);
+  CF_EXPECT_GT(block_size, 0u);
+  CF_EXPECT_EQ((size_mib << 20) % block_size, 0u,
+               "The buffer must hold a whole number of blocks");
+  CF_EXPECT_GT(iterations, 0u);
+
+  std::vector<char> buffer(size_mib << 20, '\0');
+  std::cout << "Scanning " << size_mib << " MiB in " << block_size
+            << " byte blocks " << iterations << " times per method\n";
+  Report("zeroes, char loop", buffer, block_size, iterations, CharLoop);
+  Report("zeroes, IsAllZeroes", buffer, block_size, iterations, IsAllZeroes);
+
+  for (size_t i = block_size - 1; i < buffer.size(); i += block_size) {
+    buffer[i] = 1;
+  }
+  Report("last byte set, char loop", buffer, block_size, iterations, CharLoop);
+  Report("last byte set, IsAllZeroes", buffer, block_size, iterations,
+         IsAllZeroes);
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::ZeroesBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
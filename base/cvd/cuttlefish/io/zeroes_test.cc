@@ -0,0 +1,57 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/zeroes.h"
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cuttlefish {
+namespace {
+
+TEST(ZeroesTest, Empty) { EXPECT_TRUE(IsAllZeroes(nullptr, 0)); }
+
+TEST(ZeroesTest, AllZeroes) {
+  std::vector<char> data(4096 + 7);
+
+  EXPECT_TRUE(IsAllZeroes(data.data(), data.size()));
+}
+
+TEST(ZeroesTest, FindsAnyNonZeroByte) {
+  std::vector<char> data(4096 + 7);
+
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = 1;
+    EXPECT_FALSE(IsAllZeroes(data.data(), data.size())) << "index " << i;
+    data[i] = 0;
+  }
+}
+
+TEST(ZeroesTest, IgnoresBytesOutsideRange) {
+  std::vector<char> data(300, 1);
+  for (size_t i = 3; i < 290; i++) {
+    data[i] = 0;
+  }
+
+  EXPECT_TRUE(IsAllZeroes(&data[3], 287));
+  EXPECT_FALSE(IsAllZeroes(&data[2], 288));
+  EXPECT_FALSE(IsAllZeroes(&data[3], 288));
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -18,10 +18,14 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <cerrno>
@@ -45,9 +49,11 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 
+#include "cuttlefish/common/libs/fs/fd.h"
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/utils/contains.h"
 #include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/process/subprocess.h"
 #include "cuttlefish/process/subprocess_options.h"
 #include "cuttlefish/result/result.h"
@@ -92,6 +98,123 @@ void do_redirects(const std::map<Command::StdIoChannel, int>& redirects) {
   }
 }
 
+// Everything the child needs between fork or clone and exec, prepared by the
+// parent. The child may share memory with the parent, so it must not allocate
+// or take locks: only async-signal-safe calls are allowed.
+struct ChildSetup {
+  const char* executable;
+  char* const* argv;
+  char* const* envp;
+  const std::map<Command::StdIoChannel, int>* redirects;
+  const std::map<SharedFD, int>* inherited_fds;
+  int working_directory;  // -1 to stay in the working directory of the parent
+  bool in_group;
+  bool exit_with_parent;
+  // Looking up the executable in PATH may allocate.
+  bool search_path;
+  // The signal mask of the parent, restored by a cloned child before exec.
+  sigset_t signal_mask;
+  // Written by the child when it fails before exec, or exec fails.
+  int error;
+};
+
+// Only returns on failure, with the exit code for the child.
+int SetUpAndExec(ChildSetup& setup) {
+#ifdef __linux__
+  if (setup.exit_with_parent) {
+    prctl(PR_SET_PDEATHSIG, SIGHUP);  // Die when parent dies
+  }
+#endif
+
+  do_redirects(*setup.redirects);
+
+  if (setup.in_group) {
+    // This call should never fail (see SETPGID(2))
+    if (setpgid(0, 0) != 0) {
+      setup.error = errno;
+      return -errno;
+    }
+  }
+  for (const auto& entry : *setup.inherited_fds) {
+    if (fcntl(entry.second, F_SETFD, 0)) {
+      setup.error = errno;
+      return -errno;
+    }
+  }
+  if (setup.working_directory >= 0) {
+    if (fchdir(setup.working_directory) != 0) {
+      setup.error = errno;
+      return -errno;
+    }
+  }
+  int rval;
+#ifdef __linux__
+  if (setup.search_path) {
+    rval = execvpe(setup.executable, setup.argv, setup.envp);
+  } else {
+    rval = execve(setup.executable, setup.argv, setup.envp);
+  }
+#elif defined(__APPLE__)
+  rval = execve(setup.executable, setup.argv, setup.envp);
+#else
+#error "Unsupported architecture"
+#endif
+  // No need to check for error, execvpe/execve don't return on success.
+  setup.error = errno;
+  return rval;
+}
+
+#ifdef __linux__
+#ifndef CLONE_PIDFD
+#define CLONE_PIDFD 0x00001000
+#endif
+
+int CloneChild(void* arg) {
+  ChildSetup& setup = *static_cast<ChildSetup*>(arg);
+  // The parent's signal handlers would run on the parent's memory, and exec
+  // only resets them once it succeeds.
+  for (int sig = 1; sig < NSIG; sig++) {
+    struct sigaction action;
+    if (sigaction(sig, nullptr, &action) != 0 ||
+        action.sa_handler == SIG_IGN || action.sa_handler == SIG_DFL) {
+      continue;
+    }
+    action = {};
+    action.sa_handler = SIG_DFL;
+    sigaction(sig, &action, nullptr);
+  }
+  sigprocmask(SIG_SETMASK, &setup.signal_mask, nullptr);
+  _exit(SetUpAndExec(setup));
+}
+
+// Starts the child the way posix_spawn does, in the address space of the
+// parent, which is suspended until the child calls exec or exits. Unlike fork
+// this doesn't copy the page tables, which gets expensive for large parents.
+// Returns -1 with errno set when the kernel doesn't support it.
+pid_t CloneAndExec(ChildSetup& setup, int* pidfd) {
+  constexpr size_t kStackSize = 64 << 10;
+  void* stack = mmap(nullptr, kStackSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  if (stack == MAP_FAILED) {
+    return -1;
+  }
+  // Signals are unblocked in the child once it stops sharing the handlers of
+  // the parent.
+  sigset_t all_signals;
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_BLOCK, &all_signals, &setup.signal_mask);
+  // The stack grows down on all supported architectures.
+  pid_t pid = clone(CloneChild, static_cast<char*>(stack) + kStackSize,
+                    CLONE_VM | CLONE_VFORK | CLONE_PIDFD | SIGCHLD, &setup,
+                    pidfd);
+  const int clone_error = errno;
+  pthread_sigmask(SIG_SETMASK, &setup.signal_mask, nullptr);
+  munmap(stack, kStackSize);
+  errno = clone_error;
+  return pid;
+}
+#endif
+
 std::vector<const char*> ToCharPointers(const std::vector<std::string>& vect) {
   std::vector<const char*> ret = {};
   for (const auto& str : vect) {
@@ -274,50 +397,74 @@ Subprocess Command::Start(SubprocessOptions options) const {
 
   // ToCharPointers allocates memory so it can't be called in the child process.
   auto envp = ToCharPointers(env_);
-  pid_t pid = fork();
-  if (!pid) {
-    // LOG(...) can't be used in the child process because it may block waiting
-    // for other threads which don't exist in the child process.
+  const char* executable = executable_ ? executable_->c_str() : cmd[0];
+  ChildSetup setup = {
+      .executable = executable,
+      .argv = const_cast<char* const*>(cmd.data()),
+      .envp = const_cast<char* const*>(envp.data()),
+      .redirects = &redirects_,
+      .inherited_fds = &inherited_fds_,
+      .working_directory = -1,
+      .in_group = options.InGroup(),
 #ifdef __linux__
-    if (options.ExitWithParent()) {
-      prctl(PR_SET_PDEATHSIG, SIGHUP);  // Die when parent dies
-    }
+      .exit_with_parent = options.ExitWithParent(),
+#else
+      .exit_with_parent = false,
 #endif
-
-    do_redirects(redirects_);
-
-    if (options.InGroup()) {
-      // This call should never fail (see SETPGID(2))
-      if (setpgid(0, 0) != 0) {
-        exit(-errno);
-      }
+      // Only execvpe resolves names without a slash.
+      .search_path = strchr(executable, '/') == nullptr,
+      .signal_mask = {},
+      .error = 0,
+  };
+  // Fd::Fchdir records errno in the Fd, which a cloned child shares with the
+  // parent, so the child gets a plain file descriptor.
+  if (working_directory_->IsOpen()) {
+    setup.working_directory = working_directory_->Fcntl(F_DUPFD_CLOEXEC, 3);
+    if (setup.working_directory < 0) {
+      LOG(ERROR) << "Could not acquire a new file descriptor: "
+                 << working_directory_->StrError();
+      return Subprocess(-1, {});
     }
-    for (const auto& entry : inherited_fds_) {
-      if (fcntl(entry.second, F_SETFD, 0)) {
-        exit(-errno);
-      }
+  }
+
+  pid_t pid = -1;
+  SharedFD pidfd;
+#ifdef __linux__
+  if (!setup.search_path) {
+    int clone_pidfd = -1;
+    pid = CloneAndExec(setup, &clone_pidfd);
+    if (pid > 0) {
+      pidfd = SharedFD::Dup(clone_pidfd);
+      close(clone_pidfd);
+    } else {
+      // CLONE_PIDFD needs Linux 5.2, fall back to fork on older kernels.
+      VLOG(1) << "clone failed (" << StrError(errno) << "), using fork";
     }
-    if (working_directory_->IsOpen()) {
-      if (working_directory_->Fchdir() != 0) {
-        exit(-errno);
-      }
+  }
+#endif
+  if (pid <= 0) {
+    pid = fork();
+    if (!pid) {
+      // LOG(...) can't be used in the child process because it may block
+      // waiting for other threads which don't exist in the child process.
+      exit(SetUpAndExec(setup));
     }
-    int rval;
-    const char* executable = executable_ ? executable_->c_str() : cmd[0];
 #ifdef __linux__
-    rval = execvpe(executable, const_cast<char* const*>(cmd.data()),
-                   const_cast<char* const*>(envp.data()));
-#elif defined(__APPLE__)
-    rval = execve(executable, const_cast<char* const*>(cmd.data()),
-                  const_cast<char* const*>(envp.data()));
-#else
-#error "Unsupported architecture"
+    if (pid > 0) {
+      pidfd = Fd::PidfdOpen(pid).value_or(Fd());
+    }
 #endif
-    // No need to check for error, execvpe/execve don't return on success.
-    exit(rval);
   }
   if (pid == -1) {
     LOG(ERROR) << "fork failed (" << strerror(errno) << ")";
+  } else if (setup.error != 0) {
+    // Only a cloned child can report this, as it shares `setup` with the
+    // parent. It has exited already, and is reaped by the caller.
+    LOG(ERROR) << "Failed to execute " << executable << " (pid: " << pid
+               << "): " << StrError(setup.error);
+  }
+  if (setup.working_directory >= 0) {
+    close(setup.working_directory);
   }
   if (options.Verbose()) {  // "more verbose", and VLOG(0) > VLOG(1)
     VLOG(0) << "Started (pid: " << pid << "): " << cmd[0];
@@ -330,7 +477,7 @@ Subprocess Command::Start(SubprocessOptions options) const {
       VLOG(1) << cmd[i];
     }
   }
-  return Subprocess(pid, subprocess_stopper_);
+  return Subprocess(pid, std::move(pidfd), subprocess_stopper_);
 }
 
 std::ostream& operator<<(std::ostream& out, const Command& command) {
@@ -0,0 +1,121 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/process/command.h"
+
+#include <poll.h>
+#include <stdint.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/io/string.h"
+#include "cuttlefish/process/subprocess.h"
+#include "cuttlefish/process/subprocess_options.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+std::string ReadOutput(SharedFD read_end) {
+  Result<std::string> output = ReadToString(*read_end);
+  EXPECT_THAT(output, IsOk());
+  return output.value_or("");
+}
+
+TEST(CommandTest, RedirectsAndChangesDirectory) {
+  SharedFD read_end;
+  SharedFD write_end;
+  ASSERT_TRUE(SharedFD::Pipe(&read_end, &write_end));
+
+  Subprocess subprocess = Command("/bin/sh")
+                              .AddParameter("-c")
+                              .AddParameter("echo hello; pwd")
+                              .RedirectStdIO(Command::StdIoChannel::kStdOut,
+                                             write_end)
+                              .SetWorkingDirectory("/")
+                              .Start();
+  write_end->Close();
+
+  ASSERT_TRUE(subprocess.Started());
+  EXPECT_EQ(ReadOutput(read_end), "hello\n/\n");
+  EXPECT_EQ(subprocess.Wait(), 0);
+}
+
+TEST(CommandTest, InheritsFileDescriptors) {
+  SharedFD read_end;
+  SharedFD write_end;
+  ASSERT_TRUE(SharedFD::Pipe(&read_end, &write_end));
+
+  Command command("/bin/sh");
+  command.AddParameter("-c");
+  command.AddParameter("echo inherited > \"$0\"");
+  command.AddParameter("/proc/self/fd/", write_end);
+  Subprocess subprocess = command.Start();
+  write_end->Close();
+
+  ASSERT_TRUE(subprocess.Started());
+  // The Command holds on to its own copy of the write end.
+  std::vector<PollSharedFd> poll = {{read_end, POLLIN, 0}};
+  ASSERT_EQ(SharedFD::Poll(poll, 10000), 1);
+  char buffer[64];
+  Result<uint64_t> size = read_end->Read(buffer, sizeof(buffer));
+  ASSERT_THAT(size, IsOk());
+  EXPECT_EQ(std::string(buffer, *size), "inherited\n");
+  EXPECT_EQ(subprocess.Wait(), 0);
+}
+
+TEST(CommandTest, StartsInGroupWithPidfd) {
+  Subprocess subprocess =
+      Command("/bin/sleep").AddParameter("10").Start(
+          SubprocessOptions().InGroup(true));
+
+  ASSERT_TRUE(subprocess.Started());
+  EXPECT_EQ(getpgid(subprocess.pid()), subprocess.pid());
+  SharedFD pidfd = subprocess.pidfd();
+  ASSERT_TRUE(pidfd->IsOpen());
+  std::vector<PollSharedFd> poll = {{pidfd, POLLIN, 0}};
+  EXPECT_EQ(SharedFD::Poll(poll, 0), 0);
+
+  EXPECT_EQ(subprocess.Stop(), StopperResult::kSuccess);
+  EXPECT_EQ(SharedFD::Poll(poll, 10000), 1);
+  Result<siginfo_t> infop = subprocess.Wait(WEXITED);
+  ASSERT_THAT(infop, IsOk());
+  EXPECT_EQ(infop->si_code, CLD_KILLED);
+}
+
+TEST(CommandTest, SearchesPath) {
+  Subprocess subprocess = Command("true").Start();
+
+  ASSERT_TRUE(subprocess.Started());
+  EXPECT_EQ(subprocess.Wait(), 0);
+}
+
+TEST(CommandTest, MissingExecutableExits) {
+  Subprocess subprocess = Command("/nonexistent/executable").Start();
+
+  ASSERT_TRUE(subprocess.Started());
+  EXPECT_NE(subprocess.Wait(), 0);
+}
+
+}  // namespace
+}  // namespace cuttlefish
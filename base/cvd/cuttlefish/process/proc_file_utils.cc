@@ -17,10 +17,12 @@
 #include "cuttlefish/process/proc_file_utils.h"
 
 #include <fcntl.h>
+#include <stdint.h>
 #include <sys/stat.h>  // IWYU pragma: keep
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <regex>
 #include <string>
 #include <string_view>
@@ -291,4 +293,42 @@ Result<pid_t> Ppid(const pid_t pid) {
   return CF_ERR("Status file does not have PPid: line in the right format");
 }
 
+Result<ProcStat> ParseProcStat(std::string_view contents) {
+  // The command name is in parentheses and may itself contain spaces and
+  // parentheses, so the fields after it are found from the last ')'.
+  const size_t comm_end = contents.rfind(')');
+  CF_EXPECT(comm_end != std::string_view::npos, "No command name in stat");
+  int pid;
+  CF_EXPECT(absl::SimpleAtoi(contents.substr(0, contents.find(' ')), &pid));
+  // fields[0] is field 3 in proc_pid_stat(5), the process state
+  std::vector<std::string_view> fields = absl::StrSplit(
+      contents.substr(comm_end + 1), ' ', absl::SkipWhitespace());
+  CF_EXPECT_GE(fields.size(), 22, "Too few fields in stat");
+  auto field = [&fields](int number) -> Result<int64_t> {
+    int64_t value;
+    CF_EXPECTF(absl::SimpleAtoi(fields[number - 3], &value),
+               "Field {} of stat is not a number: '{}'", number,
+               fields[number - 3]);
+    return value;
+  };
+  const int64_t pgrp = CF_EXPECT(field(5));
+  int64_t cpu_ticks = 0;
+  // utime, stime, cutime, cstime
+  for (int number = 14; number <= 17; number++) {
+    cpu_ticks += std::max<int64_t>(CF_EXPECT(field(number)), 0);
+  }
+  const int64_t rss_pages = CF_EXPECT(field(24));
+  return ProcStat{
+      .pid = static_cast<pid_t>(pid),
+      .pgrp = static_cast<pid_t>(pgrp),
+      .cpu_ticks = static_cast<uint64_t>(cpu_ticks),
+      .rss_pages = static_cast<uint64_t>(std::max<int64_t>(rss_pages, 0)),
+  };
+}
+
+Result<ProcStat> GetProcStat(const pid_t pid) {
+  const std::string stat_path = fmt::format("/proc/{}/stat", pid);
+  return CF_EXPECT(ParseProcStat(CF_EXPECT(ReadFileContents(stat_path))));
+}
+
 }  // namespace cuttlefish
@@ -17,9 +17,11 @@
 #pragma once
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <unistd.h>
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -86,4 +88,15 @@ Result<std::unordered_map<std::string, std::string>> GetEnvs(pid_t pid);
 
 Result<pid_t> Ppid(pid_t pid);
 
+// Accounting fields of /proc/<pid>/stat, see proc_pid_stat(5)
+struct ProcStat {
+  pid_t pid;
+  pid_t pgrp;
+  // user and system time of the process and of its waited-for children
+  uint64_t cpu_ticks;
+  uint64_t rss_pages;
+};
+Result<ProcStat> ParseProcStat(std::string_view contents);
+Result<ProcStat> GetProcStat(pid_t pid);
+
 }  // namespace cuttlefish
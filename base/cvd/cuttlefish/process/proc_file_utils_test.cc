@@ -42,4 +42,34 @@ TEST(ProcFilePid, CurrentPidCollected) {
   ASSERT_TRUE(Contains(*pids_result, this_pid));
 }
 
+TEST(ProcFileStat, ParsesStat) {
+  // A command name with spaces and parentheses, as seen in proc_pid_stat(5).
+  constexpr char kStat[] =
+      "1234 (a b) c)) S 1 1230 1230 0 -1 4194560 2000 0 0 0 150 50 7 3 20 0 "
+      "4 0 1000 123456789 2048 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 "
+      "3 0 0 0 0 0\n";
+
+  Result<ProcStat> stat = ParseProcStat(kStat);
+
+  ASSERT_THAT(stat, IsOk());
+  EXPECT_EQ(stat->pid, 1234);
+  EXPECT_EQ(stat->pgrp, 1230);
+  EXPECT_EQ(stat->cpu_ticks, 210);
+  EXPECT_EQ(stat->rss_pages, 2048);
+}
+
+TEST(ProcFileStat, TruncatedStatIsError) {
+  EXPECT_THAT(ParseProcStat("1234 (cmd) S 1 1230"), IsError());
+  EXPECT_THAT(ParseProcStat("1234 cmd S 1 1230"), IsError());
+}
+
+TEST(ProcFileStat, SelfStat) {
+  Result<ProcStat> stat = GetProcStat(getpid());
+
+  ASSERT_THAT(stat, IsOk());
+  EXPECT_EQ(stat->pid, getpid());
+  EXPECT_EQ(stat->pgrp, getpgrp());
+  EXPECT_GT(stat->rss_pages, 0);
+}
+
 }  // namespace cuttlefish
@@ -0,0 +1,138 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how long it takes to start and reap a trivial subprocess through
+// `Command`, compared with a plain fork and execve. The cost of fork grows
+// with the size of the parent's address space, so `--ballast_mib` maps and
+// touches that much memory before measuring, the way a launcher holding the
+// configuration and several monitors would.
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+
+#include "cuttlefish/flag_parser/flag.h"
+#include "cuttlefish/flag_parser/gflags_compat.h"
+#include "cuttlefish/process/command.h"
+#include "cuttlefish/process/subprocess.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr char kExecutable[] = "/bin/true";
+
+void ForkExecve() {
+  char* const argv[] = {const_cast<char*>(kExecutable), nullptr};
+  pid_t pid = fork();
+  if (pid == 0) {
+    execve(kExecutable, argv, environ);
+    _exit(127);
+  }
+  CHECK_GT(pid, 0) << "fork failed: " << strerror(errno);
+  int status = 0;
+  CHECK_EQ(waitpid(pid, &status, 0), pid);
+  CHECK_EQ(status, 0);
+}
+
+void CommandStart() { CHECK_EQ(Command(kExecutable).Start().Wait(), 0); }
+
+void Report(const std::string& name, size_t iterations,
+            const std::function<void()>& spawn) {
+  std::vector<std::chrono::nanoseconds> samples;
+  samples.reserve(iterations);
+  for (size_t i = 0; i < iterations; i++) {
+    Clock::time_point start = Clock::now();
+    spawn();
+    samples.emplace_back(Clock::now() - start);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  auto micros = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  };
+  std::chrono::nanoseconds total{};
+  for (std::chrono::nanoseconds sample : samples) {
+    total += sample;
+  }
+  std::cout << name << ": min " << micros(samples.front()) << "us, median "
+            << micros(samples[samples.size() / 2]) << "us, p99 "
+            << micros(samples[samples.size() * 99 / 100]) << "us, mean "
+            << micros(total / samples.size()) << "us\n";
+}
+
+Result<int> SpawnBenchmarkMain(int argc, char** argv) {
+  size_t iterations = 1000;
+  size_t ballast_mib = 0;
+  std::vector<Flag> flags;
+  flags.emplace_back(GflagsCompatFlag("iterations", iterations)
+                         .Help("How many subprocesses to start per method."));
+  flags.emplace_back(
+      GflagsCompatFlag("ballast_mib", ballast_mib)
+          .Help("Mebibytes of memory to map and touch before measuring."));
+  flags.emplace_back(HelpFlag(flags));
+  std::vector<std::string> args(argv + 1, argv + argc);  // Skip argv[0]
+  CF_EXPECT(ConsumeFlags(flags, args, {.fail_on_unexpected_argument = true}));
+  CF_EXPECT_GT(iterations, 0u);
+
+  size_t ballast_size = ballast_mib << 20;
+  void* ballast = nullptr;
+  if (ballast_size > 0) {
+    ballast = mmap(nullptr, ballast_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CF_EXPECTF(ballast != MAP_FAILED, "mmap failed: {}", strerror(errno));
+    memset(ballast, 1, ballast_size);
+  }
+
+  std::cout << "Starting " << kExecutable << " " << iterations
+            << " times with " << ballast_mib << " MiB of ballast\n";
+  Report("fork+execve", iterations, ForkExecve);
+  Report("Command::Start", iterations, CommandStart);
+
+  if (ballast) {
+    munmap(ballast, ballast_size);
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<int> result =
+      cuttlefish::SpawnBenchmarkMain(argc, argv);
+  if (!result.has_value()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return *result;
+}
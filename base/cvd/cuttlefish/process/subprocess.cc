@@ -24,6 +24,7 @@
 #include <unistd.h>
 
 #include <functional>
+#include <utility>
 
 #include "absl/log/log.h"
 
@@ -38,7 +39,8 @@ namespace cuttlefish {
 Subprocess::Subprocess(Subprocess&& subprocess)
     : pid_(subprocess.pid_.load()),
       started_(subprocess.started_),
-      stopper_(subprocess.stopper_) {
+      stopper_(subprocess.stopper_),
+      pidfd_(std::move(subprocess.pidfd_)) {
   // Make sure the moved object no longer controls this subprocess
   subprocess.pid_ = -1;
   subprocess.started_ = false;
@@ -48,6 +50,7 @@ Subprocess& Subprocess::operator=(Subprocess&& other) {
   pid_ = other.pid_.load();
   started_ = other.started_;
   stopper_ = other.stopper_;
+  pidfd_ = std::move(other.pidfd_);
 
   other.pid_ = -1;
   other.started_ = false;
@@ -20,7 +20,9 @@
 
 #include <atomic>
 #include <functional>
+#include <utility>
 
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/result/result_type.h"
 
 namespace cuttlefish {
@@ -46,6 +48,11 @@ class Subprocess {
  public:
   Subprocess(pid_t pid, SubprocessStopper stopper = KillSubprocess)
       : pid_(pid), started_(pid > 0), stopper_(stopper) {}
+  Subprocess(pid_t pid, SharedFD pidfd, SubprocessStopper stopper)
+      : pid_(pid),
+        started_(pid > 0),
+        stopper_(stopper),
+        pidfd_(std::move(pidfd)) {}
   // The default implementation won't do because we need to reset the pid of the
   // moved object.
   Subprocess(Subprocess&&);
@@ -61,6 +68,9 @@ class Subprocess {
   // completion of the command, that's what Wait is for.
   bool Started() const { return started_; }
   pid_t pid() const { return pid_; }
+  // Becomes readable when the process exits. Closed if the kernel doesn't
+  // support pidfds.
+  SharedFD pidfd() const { return pidfd_; }
   StopperResult Stop() { return stopper_(this); }
 
   Result<void> SendSignal(int signal);
@@ -75,6 +85,7 @@ class Subprocess {
   std::atomic<pid_t> pid_ = -1;
   bool started_ = false;
   SubprocessStopper stopper_;
+  SharedFD pidfd_;
 };
 
 }  // namespace cuttlefish